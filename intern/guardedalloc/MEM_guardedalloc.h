@@ -131,6 +131,22 @@ extern void *(*MEM_mallocN_aligned)(size_t len,
                                     const char *str) /* ATTR_MALLOC */ ATTR_WARN_UNUSED_RESULT
     ATTR_ALLOC_SIZE(1) ATTR_NONNULL(3);
 
+/**
+ * Allocate a block of memory of size len, whose content is a private copy-on-write mapping of
+ * the file \a filedes starting at \a offset. Pages are only read from the file when accessed,
+ * and only copied when written to. The block is freed with #MEM_freeN like any other block,
+ * the file descriptor doesn't have to stay open.
+ *
+ * The file must not be modified in place while the block exists.
+ *
+ * \return NULL if memory mapping isn't supported (on Windows or with guarded allocation),
+ * or failed. The caller is expected to fall back to a regular allocation then.
+ */
+extern void *(*MEM_mmap_file_privateN)(int filedes,
+                                       size_t offset,
+                                       size_t len,
+                                       const char *str) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(4);
+
 /**
  * Print a list of the names and sizes of all allocated memory
  * blocks. as a python dict for easy investigation.
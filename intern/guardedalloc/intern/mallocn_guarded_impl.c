@@ -841,6 +841,17 @@ void MEM_guarded_printmemlist(void)
 {
   MEM_guarded_printmemlist_internal(0);
 }
+void *MEM_guarded_mmap_file_privateN(int filedes, size_t offset, size_t len, const char *str)
+{
+  /* Mapped blocks would bypass the guards and the list of blocks, always let the caller make a
+   * regular allocation instead. */
+  (void)filedes;
+  (void)offset;
+  (void)len;
+  (void)str;
+  return NULL;
+}
+
 void MEM_guarded_printmemlist_pydict(void)
 {
   MEM_guarded_printmemlist_internal(1);
@@ -12,6 +12,11 @@
 #include <string.h> /* memcpy */
 #include <sys/types.h>
 
+#ifndef WIN32
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+
 #include "MEM_guardedalloc.h"
 
 /* to ensure strict conversions */
@@ -30,6 +35,14 @@ typedef struct MemHeadAligned {
   size_t len;
 } MemHeadAligned;
 
+/** Header of blocks allocated by #MEM_lockfree_mmap_file_privateN. */
+typedef struct MemHeadMmap {
+  /* Start and length of the whole mapped region, including the header. */
+  void *region;
+  size_t region_len;
+  size_t len;
+} MemHeadMmap;
+
 static unsigned int totblock = 0;
 static size_t mem_in_use = 0, peak_mem = 0;
 static bool malloc_debug_memset = false;
@@ -38,12 +51,15 @@ static void (*error_callback)(const char *) = NULL;
 
 enum {
   MEMHEAD_ALIGN_FLAG = 1,
+  MEMHEAD_MMAP_FLAG = 2,
 };
 
 #define MEMHEAD_FROM_PTR(ptr) (((MemHead *)ptr) - 1)
 #define PTR_FROM_MEMHEAD(memhead) (memhead + 1)
 #define MEMHEAD_ALIGNED_FROM_PTR(ptr) (((MemHeadAligned *)ptr) - 1)
+#define MEMHEAD_MMAP_FROM_PTR(ptr) (((MemHeadMmap *)ptr) - 1)
 #define MEMHEAD_IS_ALIGNED(memhead) ((memhead)->len & (size_t)MEMHEAD_ALIGN_FLAG)
+#define MEMHEAD_IS_MMAP(memhead) ((memhead)->len & (size_t)MEMHEAD_MMAP_FLAG)
 
 /* Uncomment this to have proper peak counter. */
 #define USE_ATOMIC_MAX
@@ -79,7 +95,7 @@ print_error(const char *str, ...)
 size_t MEM_lockfree_allocN_len(const void *vmemh)
 {
   if (vmemh) {
-    return MEMHEAD_FROM_PTR(vmemh)->len & ~((size_t)(MEMHEAD_ALIGN_FLAG));
+    return MEMHEAD_FROM_PTR(vmemh)->len & ~((size_t)(MEMHEAD_ALIGN_FLAG | MEMHEAD_MMAP_FLAG));
   }
 
   return 0;
@@ -105,6 +121,15 @@ void MEM_lockfree_freeN(void *vmemh)
   atomic_sub_and_fetch_u(&totblock, 1);
   atomic_sub_and_fetch_z(&mem_in_use, len);
 
+#ifndef WIN32
+  if (UNLIKELY(MEMHEAD_IS_MMAP(memh))) {
+    /* No debug memset, it would copy every page of the mapping only to release it. */
+    MemHeadMmap *memh_mmap = MEMHEAD_MMAP_FROM_PTR(vmemh);
+    munmap(memh_mmap->region, memh_mmap->region_len);
+    return;
+  }
+#endif
+
   if (UNLIKELY(malloc_debug_memset && len)) {
     memset(memh + 1, 255, len);
   }
@@ -352,6 +377,65 @@ void *MEM_lockfree_mallocN_aligned(size_t len, size_t alignment, const char *str
   return NULL;
 }
 
+#define SIZET_ALIGN_PAGE(len, page_size) ((((len) + (page_size)-1) / (page_size)) * (page_size))
+
+void *MEM_lockfree_mmap_file_privateN(int filedes, size_t offset, size_t len, const char *str)
+{
+#ifdef WIN32
+  (void)filedes;
+  (void)offset;
+  (void)len;
+  (void)str;
+  return NULL;
+#else
+  /* Only support the alignment #MEM_lockfree_mallocN guarantees, the data has the same
+   * alignment as its offset in the file. */
+  if ((offset % 8) != 0 || len == 0) {
+    return NULL;
+  }
+
+  const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+  const size_t offset_in_page = offset % page_size;
+  const size_t len_aligned = SIZET_ALIGN_4(len);
+  /* One extra page in front for the header. Only the part of the region that overlaps with the
+   * requested range of the file maps it, so padding never reads past the end of the file. */
+  const size_t file_map_len = SIZET_ALIGN_PAGE(offset_in_page + len, page_size);
+  const size_t region_len = page_size + SIZET_ALIGN_PAGE(offset_in_page + len_aligned, page_size);
+
+  char *region = (char *)mmap(
+      NULL, region_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (region == MAP_FAILED) {
+    return NULL;
+  }
+  if (mmap(region + page_size,
+           file_map_len,
+           PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_FIXED,
+           filedes,
+           (off_t)(offset - offset_in_page)) == MAP_FAILED) {
+    print_error("Mmap of file failed: len=" SIZET_FORMAT " in %s, total %u\n",
+                SIZET_ARG(len),
+                str,
+                (unsigned int)mem_in_use);
+    munmap(region, region_len);
+    return NULL;
+  }
+
+  /* Writing the header copies its page when it overlaps with the file mapping, that only costs
+   * one page per block. */
+  void *vmemh = region + page_size + offset_in_page;
+  MemHeadMmap *memh = MEMHEAD_MMAP_FROM_PTR(vmemh);
+  memh->region = region;
+  memh->region_len = region_len;
+  memh->len = len_aligned | (size_t)MEMHEAD_MMAP_FLAG;
+  atomic_add_and_fetch_u(&totblock, 1);
+  atomic_add_and_fetch_z(&mem_in_use, len_aligned);
+  update_maximum(&peak_mem, mem_in_use);
+
+  return vmemh;
+#endif
+}
+
 void MEM_lockfree_printmemlist_pydict(void)
 {
 }
@@ -0,0 +1,102 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#ifndef WIN32
+#  include <unistd.h>
+#endif
+
+#include "MEM_guardedalloc.h"
+#include "guardedalloc_test_base.h"
+
+#ifndef WIN32
+
+namespace {
+
+class MmapFile {
+ public:
+  FILE *file;
+  std::vector<unsigned char> content;
+
+  MmapFile(const size_t size) : content(size)
+  {
+    for (size_t i = 0; i < size; i++) {
+      content[i] = (unsigned char)(i * 7 + i / 251);
+    }
+    file = tmpfile();
+    fwrite(content.data(), 1, size, file);
+    fflush(file);
+  }
+
+  ~MmapFile()
+  {
+    fclose(file);
+  }
+
+  int filedes() const
+  {
+    return fileno(file);
+  }
+};
+
+void DoMmapChecks(const MmapFile &file, const size_t offset, const size_t len)
+{
+  const size_t mem_in_use = MEM_get_memory_in_use();
+  const unsigned int blocks = MEM_get_memory_blocks_in_use();
+
+  unsigned char *data = (unsigned char *)MEM_mmap_file_privateN(
+      file.filedes(), offset, len, __func__);
+  ASSERT_NE(data, nullptr);
+  EXPECT_EQ((size_t)data % 8, 0);
+  EXPECT_GE(MEM_allocN_len(data), len);
+  EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks + 1);
+  EXPECT_EQ(memcmp(data, file.content.data() + offset, len), 0);
+
+  /* Writing only changes the private copy. */
+  data[0] ^= 0xff;
+  data[len - 1] ^= 0xff;
+  unsigned char file_byte;
+  EXPECT_EQ(pread(file.filedes(), &file_byte, 1, (off_t)offset), 1);
+  EXPECT_EQ(file_byte, file.content[offset]);
+
+  unsigned char *copy = (unsigned char *)MEM_dupallocN(data);
+  EXPECT_EQ(memcmp(copy, data, len), 0);
+  MEM_freeN(copy);
+
+  data = (unsigned char *)MEM_reallocN(data, len + 16);
+  EXPECT_EQ(data[0], (unsigned char)(file.content[offset] ^ 0xff));
+  MEM_freeN(data);
+
+  EXPECT_EQ(MEM_get_memory_in_use(), mem_in_use);
+  EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks);
+}
+
+}  // namespace
+
+TEST_F(LockFreeAllocatorTest, MEM_mmap_file_privateN)
+{
+  const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+  MmapFile file(page_size * 4 + 100);
+
+  DoMmapChecks(file, 0, 2);
+  DoMmapChecks(file, 8, page_size);
+  DoMmapChecks(file, page_size - 8, 16);
+  DoMmapChecks(file, page_size, page_size * 2);
+  /* Up to the end of the file, with a length that isn't a multiple of 4. */
+  DoMmapChecks(file, page_size * 3 + 8, page_size + 100 - 8);
+
+  /* Unaligned offsets aren't supported. */
+  EXPECT_EQ(MEM_mmap_file_privateN(file.filedes(), 4, 16, __func__), nullptr);
+}
+
+TEST_F(GuardedAllocatorTest, MEM_mmap_file_privateN)
+{
+  MmapFile file(64);
+  EXPECT_EQ(MEM_mmap_file_privateN(file.filedes(), 0, 64, __func__), nullptr);
+}
+
+#endif
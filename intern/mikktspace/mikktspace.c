@@ -172,6 +172,25 @@ typedef struct {
   tbool bOrient;
 } STSpace;
 
+typedef struct {
+  SMikkTSpaceParallelForFunc fnParallelFor;
+  void *pParallelUserData;
+} SParallel;
+
+// runs fnRange() over all items, serially when no parallel-for function is given
+static void ParallelFor(const SParallel *pParallel,
+                        const int iNrItems,
+                        SMikkTSpaceRangeFunc fnRange,
+                        void *pRangeData)
+{
+  if (iNrItems <= 0)
+    return;
+  if (pParallel->fnParallelFor != NULL)
+    pParallel->fnParallelFor(pParallel->pParallelUserData, iNrItems, fnRange, pRangeData);
+  else
+    fnRange(pRangeData, 0, iNrItems);
+}
+
 static int GenerateInitialVerticesIndexList(STriInfo pTriInfos[],
                                             int piTriList_out[],
                                             const SMikkTSpaceContext *pContext,
@@ -182,7 +201,8 @@ static void GenerateSharedVerticesIndexList(int piTriList_in_and_out[],
 static void InitTriInfo(STriInfo pTriInfos[],
                         const int piTriListIn[],
                         const SMikkTSpaceContext *pContext,
-                        const int iNrTrianglesIn);
+                        const int iNrTrianglesIn,
+                        const SParallel *pParallel);
 static int Build4RuleGroups(STriInfo pTriInfos[],
                             SGroup pGroups[],
                             int piGroupTrianglesBuffer[],
@@ -192,9 +212,11 @@ static tbool GenerateTSpaces(STSpace psTspace[],
                              const STriInfo pTriInfos[],
                              const SGroup pGroups[],
                              const int iNrActiveGroups,
+                             const int piGroupTrianglesBuffer[],
                              const int piTriListIn[],
                              const float fThresCos,
-                             const SMikkTSpaceContext *pContext);
+                             const SMikkTSpaceContext *pContext,
+                             const SParallel *pParallel);
 
 MIKK_INLINE int MakeIndex(const int iFace, const int iVert)
 {
@@ -255,7 +277,37 @@ tbool genTangSpaceDefault(const SMikkTSpaceContext *pContext)
   return genTangSpace(pContext, 180.0f);
 }
 
+typedef struct {
+  STriInfo *pTriInfos;
+  const int *piTriListIn;
+  const SMikkTSpaceContext *pContext;
+} SMarkDegenerateData;
+
+static void MarkDegenerateRange(void *pRangeData, const int iStart, const int iEnd)
+{
+  const SMarkDegenerateData *pData = (const SMarkDegenerateData *)pRangeData;
+  int t = 0;
+  for (t = iStart; t < iEnd; t++) {
+    const int i0 = pData->piTriListIn[t * 3 + 0];
+    const int i1 = pData->piTriListIn[t * 3 + 1];
+    const int i2 = pData->piTriListIn[t * 3 + 2];
+    const SVec3 p0 = GetPosition(pData->pContext, i0);
+    const SVec3 p1 = GetPosition(pData->pContext, i1);
+    const SVec3 p2 = GetPosition(pData->pContext, i2);
+    if (veq(p0, p1) || veq(p0, p2) || veq(p1, p2))  // degenerate
+      pData->pTriInfos[t].iFlag |= MARK_DEGENERATE;
+  }
+}
+
 tbool genTangSpace(const SMikkTSpaceContext *pContext, const float fAngularThreshold)
+{
+  return genTangSpaceParallel(pContext, fAngularThreshold, NULL, NULL);
+}
+
+tbool genTangSpaceParallel(const SMikkTSpaceContext *pContext,
+                           const float fAngularThreshold,
+                           SMikkTSpaceParallelForFunc fnParallelFor,
+                           void *pParallelUserData)
 {
   // count nr_triangles
   int *piTriListIn = NULL, *piGroupTrianglesBuffer = NULL;
@@ -268,6 +320,9 @@ tbool genTangSpace(const SMikkTSpaceContext *pContext, const float fAngularThres
   const int iNrFaces = pContext->m_pInterface->m_getNumFaces(pContext);
   tbool bRes = TFALSE;
   const float fThresCos = cosf((fAngularThreshold * (float)M_PI) / 180.0f);
+  SParallel sParallel;
+  sParallel.fnParallelFor = fnParallelFor;
+  sParallel.pParallelUserData = pParallelUserData;
 
   // verify all call-backs have been set
   if (pContext->m_pInterface->m_getNumFaces == NULL ||
@@ -309,18 +364,16 @@ tbool genTangSpace(const SMikkTSpaceContext *pContext, const float fAngularThres
   // Mark all degenerate triangles
   iTotTris = iNrTrianglesIn;
   iDegenTriangles = 0;
+  {
+    SMarkDegenerateData sData;
+    sData.pTriInfos = pTriInfos;
+    sData.piTriListIn = piTriListIn;
+    sData.pContext = pContext;
+    ParallelFor(&sParallel, iTotTris, MarkDegenerateRange, &sData);
+  }
   for (t = 0; t < iTotTris; t++) {
-    const int i0 = piTriListIn[t * 3 + 0];
-    const int i1 = piTriListIn[t * 3 + 1];
-    const int i2 = piTriListIn[t * 3 + 2];
-    const SVec3 p0 = GetPosition(pContext, i0);
-    const SVec3 p1 = GetPosition(pContext, i1);
-    const SVec3 p2 = GetPosition(pContext, i2);
-    if (veq(p0, p1) || veq(p0, p2) || veq(p1, p2))  // degenerate
-    {
-      pTriInfos[t].iFlag |= MARK_DEGENERATE;
+    if ((pTriInfos[t].iFlag & MARK_DEGENERATE) != 0)
       ++iDegenTriangles;
-    }
   }
   iNrTrianglesIn = iTotTris - iDegenTriangles;
 
@@ -333,7 +386,7 @@ tbool genTangSpace(const SMikkTSpaceContext *pContext, const float fAngularThres
 
   // evaluate triangle level attributes and neighbor list
   // printf("gen neighbors list begin\n");
-  InitTriInfo(pTriInfos, piTriListIn, pContext, iNrTrianglesIn);
+  InitTriInfo(pTriInfos, piTriListIn, pContext, iNrTrianglesIn, &sParallel);
   // printf("gen neighbors list end\n");
 
   // based on the 4 rules, identify groups based on connectivity
@@ -380,8 +433,15 @@ tbool genTangSpace(const SMikkTSpaceContext *pContext, const float fAngularThres
   // based on fAngularThreshold. Finally a tangent space is made for
   // every resulting subgroup
   // printf("gen tspaces begin\n");
-  bRes = GenerateTSpaces(
-      psTspace, pTriInfos, pGroups, iNrActiveGroups, piTriListIn, fThresCos, pContext);
+  bRes = GenerateTSpaces(psTspace,
+                         pTriInfos,
+                         pGroups,
+                         iNrActiveGroups,
+                         piGroupTrianglesBuffer,
+                         piTriListIn,
+                         fThresCos,
+                         pContext,
+                         &sParallel);
   // printf("gen tspaces end\n");
 
   // clean up
@@ -831,36 +891,21 @@ static float CalcTexArea(const SMikkTSpaceContext *pContext, const int indices[]
   return fSignedAreaSTx2 < 0 ? (-fSignedAreaSTx2) : fSignedAreaSTx2;
 }
 
-static void InitTriInfo(STriInfo pTriInfos[],
-                        const int piTriListIn[],
-                        const SMikkTSpaceContext *pContext,
-                        const int iNrTrianglesIn)
-{
-  int f = 0, i = 0, t = 0;
-  // pTriInfos[f].iFlag is cleared in GenerateInitialVerticesIndexList()
-  // which is called before this function.
-
-  // generate neighbor info list
-  for (f = 0; f < iNrTrianglesIn; f++)
-    for (i = 0; i < 3; i++) {
-      pTriInfos[f].FaceNeighbors[i] = -1;
-      pTriInfos[f].AssignedGroup[i] = NULL;
-
-      pTriInfos[f].vOs.x = 0.0f;
-      pTriInfos[f].vOs.y = 0.0f;
-      pTriInfos[f].vOs.z = 0.0f;
-      pTriInfos[f].vOt.x = 0.0f;
-      pTriInfos[f].vOt.y = 0.0f;
-      pTriInfos[f].vOt.z = 0.0f;
-      pTriInfos[f].fMagS = 0;
-      pTriInfos[f].fMagT = 0;
-
-      // assumed bad
-      pTriInfos[f].iFlag |= GROUP_WITH_ANY;
-    }
+typedef struct {
+  STriInfo *pTriInfos;
+  const int *piTriListIn;
+  const SMikkTSpaceContext *pContext;
+} SInitTriInfoData;
 
-  // evaluate first order derivatives
-  for (f = 0; f < iNrTrianglesIn; f++) {
+// evaluate first order derivatives
+static void InitTriInfoRange(void *pRangeData, const int iStart, const int iEnd)
+{
+  const SInitTriInfoData *pData = (const SInitTriInfoData *)pRangeData;
+  STriInfo *pTriInfos = pData->pTriInfos;
+  const int *piTriListIn = pData->piTriListIn;
+  const SMikkTSpaceContext *pContext = pData->pContext;
+  int f = 0;
+  for (f = iStart; f < iEnd; f++) {
     // initial values
     const SVec3 v1 = GetPosition(pContext, piTriListIn[f * 3 + 0]);
     const SVec3 v2 = GetPosition(pContext, piTriListIn[f * 3 + 1]);
@@ -902,6 +947,45 @@ static void InitTriInfo(STriInfo pTriInfos[],
         pTriInfos[f].iFlag &= (~GROUP_WITH_ANY);
     }
   }
+}
+
+static void InitTriInfo(STriInfo pTriInfos[],
+                        const int piTriListIn[],
+                        const SMikkTSpaceContext *pContext,
+                        const int iNrTrianglesIn,
+                        const SParallel *pParallel)
+{
+  int f = 0, i = 0, t = 0;
+  // pTriInfos[f].iFlag is cleared in GenerateInitialVerticesIndexList()
+  // which is called before this function.
+
+  // generate neighbor info list
+  for (f = 0; f < iNrTrianglesIn; f++)
+    for (i = 0; i < 3; i++) {
+      pTriInfos[f].FaceNeighbors[i] = -1;
+      pTriInfos[f].AssignedGroup[i] = NULL;
+
+      pTriInfos[f].vOs.x = 0.0f;
+      pTriInfos[f].vOs.y = 0.0f;
+      pTriInfos[f].vOs.z = 0.0f;
+      pTriInfos[f].vOt.x = 0.0f;
+      pTriInfos[f].vOt.y = 0.0f;
+      pTriInfos[f].vOt.z = 0.0f;
+      pTriInfos[f].fMagS = 0;
+      pTriInfos[f].fMagT = 0;
+
+      // assumed bad
+      pTriInfos[f].iFlag |= GROUP_WITH_ANY;
+    }
+
+  // evaluate first order derivatives
+  {
+    SInitTriInfoData sData;
+    sData.pTriInfos = pTriInfos;
+    sData.piTriListIn = piTriListIn;
+    sData.pContext = pContext;
+    ParallelFor(pParallel, iNrTrianglesIn, InitTriInfoRange, &sData);
+  }
 
   // force otherwise healthy quads to a fixed orientation
   while (t < (iNrTrianglesIn - 1)) {
@@ -1103,171 +1187,261 @@ static STSpace EvalTspace(const int face_indices[],
                           const SMikkTSpaceContext *pContext,
                           const int iVertexRepresentitive);
 
+typedef struct {
+  STSpace *psGroupTspace;
+  const STriInfo *pTriInfos;
+  const SGroup *pGroups;
+  const int *piGroupTrianglesBuffer;
+  const int *piTriListIn;
+  float fThresCos;
+  const SMikkTSpaceContext *pContext;
+  int iMaxNrFaces;
+} SGenerateTSpacesData;
+
+// returns which corner of the triangle is part of the group
+MIKK_INLINE int GetGroupCorner(const STriInfo *pTriInfo, const SGroup *pGroup)
+{
+  int index = -1;
+  if (pTriInfo->AssignedGroup[0] == pGroup)
+    index = 0;
+  else if (pTriInfo->AssignedGroup[1] == pGroup)
+    index = 1;
+  else if (pTriInfo->AssignedGroup[2] == pGroup)
+    index = 2;
+  assert(index >= 0 && index < 3);
+  return index;
+}
+
+// the tangent spaces of the group members are stored at the same offset as their face indices
+MIKK_INLINE STSpace *GetGroupTSpaces(STSpace psGroupTspace[],
+                                     const int piGroupTrianglesBuffer[],
+                                     const SGroup *pGroup)
+{
+  return &psGroupTspace[pGroup->pFaceIndices - piGroupTrianglesBuffer];
+}
+
+// evaluate the tangent space of every member of the group into psGroupTspaceOut[],
+// the scratch buffers have to fit the largest group
+static tbool EvalGroupTSpaces(STSpace psGroupTspaceOut[],
+                              const SGroup *pGroup,
+                              STSpace pSubGroupTspace[],
+                              SSubGroup pUniSubGroups[],
+                              int pTmpMembers[],
+                              const SGenerateTSpacesData *pData)
+{
+  const STriInfo *pTriInfos = pData->pTriInfos;
+  const int *piTriListIn = pData->piTriListIn;
+  const float fThresCos = pData->fThresCos;
+  const SMikkTSpaceContext *pContext = pData->pContext;
+  int iUniqueSubGroups = 0, s = 0, i = 0;
+
+  for (i = 0; i < pGroup->iNrFaces; i++)  // triangles
+  {
+    const int f = pGroup->pFaceIndices[i];  // triangle number
+    const int index = GetGroupCorner(&pTriInfos[f], pGroup);
+    int iVertIndex = -1, iOF_1 = -1, iMembers = 0, j = 0, l = 0;
+    SSubGroup tmp_group;
+    tbool bFound;
+    SVec3 n, vOs, vOt;
+
+    iVertIndex = piTriListIn[f * 3 + index];
+    assert(iVertIndex == pGroup->iVertexRepresentitive);
+
+    // is normalized already
+    n = GetNormal(pContext, iVertIndex);
+
+    // project
+    vOs = NormalizeSafe(vsub(pTriInfos[f].vOs, vscale(vdot(n, pTriInfos[f].vOs), n)));
+    vOt = NormalizeSafe(vsub(pTriInfos[f].vOt, vscale(vdot(n, pTriInfos[f].vOt), n)));
+
+    // original face number
+    iOF_1 = pTriInfos[f].iOrgFaceNumber;
+
+    iMembers = 0;
+    for (j = 0; j < pGroup->iNrFaces; j++) {
+      const int t = pGroup->pFaceIndices[j];  // triangle number
+      const int iOF_2 = pTriInfos[t].iOrgFaceNumber;
+
+      // project
+      SVec3 vOs2 = NormalizeSafe(vsub(pTriInfos[t].vOs, vscale(vdot(n, pTriInfos[t].vOs), n)));
+      SVec3 vOt2 = NormalizeSafe(vsub(pTriInfos[t].vOt, vscale(vdot(n, pTriInfos[t].vOt), n)));
+
+      {
+        const tbool bAny = ((pTriInfos[f].iFlag | pTriInfos[t].iFlag) & GROUP_WITH_ANY) != 0 ?
+                               TTRUE :
+                               TFALSE;
+        // make sure triangles which belong to the same quad are joined.
+        const tbool bSameOrgFace = iOF_1 == iOF_2 ? TTRUE : TFALSE;
+
+        const float fCosS = vdot(vOs, vOs2);
+        const float fCosT = vdot(vOt, vOt2);
+
+        assert(f != t || bSameOrgFace);  // sanity check
+        if (bAny || bSameOrgFace || (fCosS > fThresCos && fCosT > fThresCos))
+          pTmpMembers[iMembers++] = t;
+      }
+    }
+
+    // sort pTmpMembers
+    tmp_group.iNrFaces = iMembers;
+    tmp_group.pTriMembers = pTmpMembers;
+    if (iMembers > 1) {
+      unsigned int uSeed = INTERNAL_RND_SORT_SEED;  // could replace with a random seed?
+      QuickSort(pTmpMembers, 0, iMembers - 1, uSeed);
+    }
+
+    // look for an existing match
+    bFound = TFALSE;
+    l = 0;
+    while (l < iUniqueSubGroups && !bFound) {
+      bFound = CompareSubGroups(&tmp_group, &pUniSubGroups[l]);
+      if (!bFound)
+        ++l;
+    }
+
+    assert(bFound || l == iUniqueSubGroups);
+
+    // if no match was found we allocate a new subgroup
+    if (!bFound) {
+      // insert new subgroup
+      int *pIndices = (int *)malloc(sizeof(int) * iMembers);
+      if (pIndices == NULL) {
+        // clean up and return false
+        for (s = 0; s < iUniqueSubGroups; s++)
+          free(pUniSubGroups[s].pTriMembers);
+        return TFALSE;
+      }
+      pUniSubGroups[iUniqueSubGroups].iNrFaces = iMembers;
+      pUniSubGroups[iUniqueSubGroups].pTriMembers = pIndices;
+      memcpy(pIndices, tmp_group.pTriMembers, sizeof(int) * iMembers);
+      pSubGroupTspace[iUniqueSubGroups] = EvalTspace(tmp_group.pTriMembers,
+                                                     iMembers,
+                                                     piTriListIn,
+                                                     pTriInfos,
+                                                     pContext,
+                                                     pGroup->iVertexRepresentitive);
+      ++iUniqueSubGroups;
+    }
+
+    psGroupTspaceOut[i] = pSubGroupTspace[l];
+    psGroupTspaceOut[i].iCounter = 1;
+  }
+
+  // clean up
+  for (s = 0; s < iUniqueSubGroups; s++)
+    free(pUniSubGroups[s].pTriMembers);
+
+  return TTRUE;
+}
+
+static void GenerateTSpacesRange(void *pRangeData, const int iStart, const int iEnd)
+{
+  const SGenerateTSpacesData *pData = (const SGenerateTSpacesData *)pRangeData;
+  const int iMaxNrFaces = pData->iMaxNrFaces;
+  int g = 0;
+
+  // make allocations for this range
+  STSpace *pSubGroupTspace = (STSpace *)malloc(sizeof(STSpace) * iMaxNrFaces);
+  SSubGroup *pUniSubGroups = (SSubGroup *)malloc(sizeof(SSubGroup) * iMaxNrFaces);
+  int *pTmpMembers = (int *)malloc(sizeof(int) * iMaxNrFaces);
+  tbool bRes = pSubGroupTspace != NULL && pUniSubGroups != NULL && pTmpMembers != NULL;
+
+  for (g = iStart; g < iEnd; g++) {
+    const SGroup *pGroup = &pData->pGroups[g];
+    STSpace *psGroupTspaceOut = GetGroupTSpaces(
+        pData->psGroupTspace, pData->piGroupTrianglesBuffer, pGroup);
+    if (bRes)
+      bRes = EvalGroupTSpaces(
+          psGroupTspaceOut, pGroup, pSubGroupTspace, pUniSubGroups, pTmpMembers, pData);
+    if (!bRes) {
+      // tag as failed, groups always have at least one member
+      psGroupTspaceOut[0].iCounter = -1;
+    }
+  }
+
+  // clean up
+  if (pSubGroupTspace != NULL)
+    free(pSubGroupTspace);
+  if (pUniSubGroups != NULL)
+    free(pUniSubGroups);
+  if (pTmpMembers != NULL)
+    free(pTmpMembers);
+}
+
 static tbool GenerateTSpaces(STSpace psTspace[],
                              const STriInfo pTriInfos[],
                              const SGroup pGroups[],
                              const int iNrActiveGroups,
+                             const int piGroupTrianglesBuffer[],
                              const int piTriListIn[],
                              const float fThresCos,
-                             const SMikkTSpaceContext *pContext)
+                             const SMikkTSpaceContext *pContext,
+                             const SParallel *pParallel)
 {
-  STSpace *pSubGroupTspace = NULL;
-  SSubGroup *pUniSubGroups = NULL;
-  int *pTmpMembers = NULL;
-  int iMaxNrFaces = 0, g = 0, i = 0;
-  for (g = 0; g < iNrActiveGroups; g++)
+  STSpace *psGroupTspace = NULL;
+  SGenerateTSpacesData sData;
+  int iMaxNrFaces = 0, iNrGroupFaces = 0, g = 0, i = 0;
+  for (g = 0; g < iNrActiveGroups; g++) {
     if (iMaxNrFaces < pGroups[g].iNrFaces)
       iMaxNrFaces = pGroups[g].iNrFaces;
+    iNrGroupFaces += pGroups[g].iNrFaces;
+  }
 
   if (iMaxNrFaces == 0)
     return TTRUE;
 
-  // make initial allocations
-  pSubGroupTspace = (STSpace *)malloc(sizeof(STSpace) * iMaxNrFaces);
-  pUniSubGroups = (SSubGroup *)malloc(sizeof(SSubGroup) * iMaxNrFaces);
-  pTmpMembers = (int *)malloc(sizeof(int) * iMaxNrFaces);
-  if (pSubGroupTspace == NULL || pUniSubGroups == NULL || pTmpMembers == NULL) {
-    if (pSubGroupTspace != NULL)
-      free(pSubGroupTspace);
-    if (pUniSubGroups != NULL)
-      free(pUniSubGroups);
-    if (pTmpMembers != NULL)
-      free(pTmpMembers);
+  psGroupTspace = (STSpace *)malloc(sizeof(STSpace) * iNrGroupFaces);
+  if (psGroupTspace == NULL)
     return TFALSE;
-  }
 
+  // groups are independent, evaluate the tangent spaces of all their members first
+  sData.psGroupTspace = psGroupTspace;
+  sData.pTriInfos = pTriInfos;
+  sData.pGroups = pGroups;
+  sData.piGroupTrianglesBuffer = piGroupTrianglesBuffer;
+  sData.piTriListIn = piTriListIn;
+  sData.fThresCos = fThresCos;
+  sData.pContext = pContext;
+  sData.iMaxNrFaces = iMaxNrFaces;
+  ParallelFor(pParallel, iNrActiveGroups, GenerateTSpacesRange, &sData);
+
+  // output tspaces, a vertex of a quad can be shared by two groups so this is done
+  // in group order to get the same result independent of the threading
   for (g = 0; g < iNrActiveGroups; g++) {
     const SGroup *pGroup = &pGroups[g];
-    int iUniqueSubGroups = 0, s = 0;
-
-    for (i = 0; i < pGroup->iNrFaces; i++)  // triangles
-    {
-      const int f = pGroup->pFaceIndices[i];  // triangle number
-      int index = -1, iVertIndex = -1, iOF_1 = -1, iMembers = 0, j = 0, l = 0;
-      SSubGroup tmp_group;
-      tbool bFound;
-      SVec3 n, vOs, vOt;
-      if (pTriInfos[f].AssignedGroup[0] == pGroup)
-        index = 0;
-      else if (pTriInfos[f].AssignedGroup[1] == pGroup)
-        index = 1;
-      else if (pTriInfos[f].AssignedGroup[2] == pGroup)
-        index = 2;
-      assert(index >= 0 && index < 3);
-
-      iVertIndex = piTriListIn[f * 3 + index];
-      assert(iVertIndex == pGroup->iVertexRepresentitive);
-
-      // is normalized already
-      n = GetNormal(pContext, iVertIndex);
-
-      // project
-      vOs = NormalizeSafe(vsub(pTriInfos[f].vOs, vscale(vdot(n, pTriInfos[f].vOs), n)));
-      vOt = NormalizeSafe(vsub(pTriInfos[f].vOt, vscale(vdot(n, pTriInfos[f].vOt), n)));
-
-      // original face number
-      iOF_1 = pTriInfos[f].iOrgFaceNumber;
-
-      iMembers = 0;
-      for (j = 0; j < pGroup->iNrFaces; j++) {
-        const int t = pGroup->pFaceIndices[j];  // triangle number
-        const int iOF_2 = pTriInfos[t].iOrgFaceNumber;
+    const STSpace *psGroupTspaceIn = GetGroupTSpaces(
+        psGroupTspace, piGroupTrianglesBuffer, pGroup);
 
-        // project
-        SVec3 vOs2 = NormalizeSafe(vsub(pTriInfos[t].vOs, vscale(vdot(n, pTriInfos[t].vOs), n)));
-        SVec3 vOt2 = NormalizeSafe(vsub(pTriInfos[t].vOt, vscale(vdot(n, pTriInfos[t].vOt), n)));
-
-        {
-          const tbool bAny = ((pTriInfos[f].iFlag | pTriInfos[t].iFlag) & GROUP_WITH_ANY) != 0 ?
-                                 TTRUE :
-                                 TFALSE;
-          // make sure triangles which belong to the same quad are joined.
-          const tbool bSameOrgFace = iOF_1 == iOF_2 ? TTRUE : TFALSE;
-
-          const float fCosS = vdot(vOs, vOs2);
-          const float fCosT = vdot(vOt, vOt2);
-
-          assert(f != t || bSameOrgFace);  // sanity check
-          if (bAny || bSameOrgFace || (fCosS > fThresCos && fCosT > fThresCos))
-            pTmpMembers[iMembers++] = t;
-        }
-      }
-
-      // sort pTmpMembers
-      tmp_group.iNrFaces = iMembers;
-      tmp_group.pTriMembers = pTmpMembers;
-      if (iMembers > 1) {
-        unsigned int uSeed = INTERNAL_RND_SORT_SEED;  // could replace with a random seed?
-        QuickSort(pTmpMembers, 0, iMembers - 1, uSeed);
-      }
-
-      // look for an existing match
-      bFound = TFALSE;
-      l = 0;
-      while (l < iUniqueSubGroups && !bFound) {
-        bFound = CompareSubGroups(&tmp_group, &pUniSubGroups[l]);
-        if (!bFound)
-          ++l;
-      }
+    if (psGroupTspaceIn[0].iCounter < 0) {
+      // an allocation failed
+      free(psGroupTspace);
+      return TFALSE;
+    }
 
-      assert(bFound || l == iUniqueSubGroups);
-
-      // if no match was found we allocate a new subgroup
-      if (!bFound) {
-        // insert new subgroup
-        int *pIndices = (int *)malloc(sizeof(int) * iMembers);
-        if (pIndices == NULL) {
-          // clean up and return false
-          int s = 0;
-          for (s = 0; s < iUniqueSubGroups; s++)
-            free(pUniSubGroups[s].pTriMembers);
-          free(pUniSubGroups);
-          free(pTmpMembers);
-          free(pSubGroupTspace);
-          return TFALSE;
-        }
-        pUniSubGroups[iUniqueSubGroups].iNrFaces = iMembers;
-        pUniSubGroups[iUniqueSubGroups].pTriMembers = pIndices;
-        memcpy(pIndices, tmp_group.pTriMembers, sizeof(int) * iMembers);
-        pSubGroupTspace[iUniqueSubGroups] = EvalTspace(tmp_group.pTriMembers,
-                                                       iMembers,
-                                                       piTriListIn,
-                                                       pTriInfos,
-                                                       pContext,
-                                                       pGroup->iVertexRepresentitive);
-        ++iUniqueSubGroups;
+    for (i = 0; i < pGroup->iNrFaces; i++) {
+      const int f = pGroup->pFaceIndices[i];  // triangle number
+      const int index = GetGroupCorner(&pTriInfos[f], pGroup);
+      const int iOffs = pTriInfos[f].iTSpacesOffs;
+      const int iVert = pTriInfos[f].vert_num[index];
+      STSpace *pTS_out = &psTspace[iOffs + iVert];
+      assert(pTS_out->iCounter < 2);
+      assert(((pTriInfos[f].iFlag & ORIENT_PRESERVING) != 0) == pGroup->bOrientPreservering);
+      if (pTS_out->iCounter == 1) {
+        *pTS_out = AvgTSpace(pTS_out, &psGroupTspaceIn[i]);
+        pTS_out->iCounter = 2;  // update counter
+        pTS_out->bOrient = pGroup->bOrientPreservering;
       }
-
-      // output tspace
-      {
-        const int iOffs = pTriInfos[f].iTSpacesOffs;
-        const int iVert = pTriInfos[f].vert_num[index];
-        STSpace *pTS_out = &psTspace[iOffs + iVert];
-        assert(pTS_out->iCounter < 2);
-        assert(((pTriInfos[f].iFlag & ORIENT_PRESERVING) != 0) == pGroup->bOrientPreservering);
-        if (pTS_out->iCounter == 1) {
-          *pTS_out = AvgTSpace(pTS_out, &pSubGroupTspace[l]);
-          pTS_out->iCounter = 2;  // update counter
-          pTS_out->bOrient = pGroup->bOrientPreservering;
-        }
-        else {
-          assert(pTS_out->iCounter == 0);
-          *pTS_out = pSubGroupTspace[l];
-          pTS_out->iCounter = 1;  // update counter
-          pTS_out->bOrient = pGroup->bOrientPreservering;
-        }
+      else {
+        assert(pTS_out->iCounter == 0);
+        *pTS_out = psGroupTspaceIn[i];
+        pTS_out->iCounter = 1;  // update counter
+        pTS_out->bOrient = pGroup->bOrientPreservering;
       }
     }
-
-    // clean up
-    for (s = 0; s < iUniqueSubGroups; s++)
-      free(pUniSubGroups[s].pTriMembers);
   }
 
   // clean up
-  free(pUniSubGroups);
-  free(pTmpMembers);
-  free(pSubGroupTspace);
+  free(psGroupTspace);
 
   return TTRUE;
 }
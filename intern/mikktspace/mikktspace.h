@@ -120,6 +120,26 @@ struct SMikkTSpaceContext {
 tbool genTangSpaceDefault(const SMikkTSpaceContext *pContext);
 tbool genTangSpace(const SMikkTSpaceContext *pContext, const float fAngularThreshold);
 
+// Optional multi-threading support.
+// A parallel-for function has to call fnRange(pRangeData, iStart, iEnd) for disjoint ranges
+// that together cover {0, 1, ..., iNrItems-1}. The ranges can be processed by multiple threads
+// at the same time, in any order. The function must only return once all ranges are done.
+typedef void (*SMikkTSpaceRangeFunc)(void *pRangeData, const int iStart, const int iEnd);
+typedef void (*SMikkTSpaceParallelForFunc)(void *pParallelUserData,
+                                           const int iNrItems,
+                                           SMikkTSpaceRangeFunc fnRange,
+                                           void *pRangeData);
+
+// Same as genTangSpace(), but the per-triangle and per-group evaluation is distributed
+// with fnParallelFor, which is called with pParallelUserData as first argument.
+// The m_getXXX() call-backs may then be called from multiple threads at the same time,
+// the m_setTSpaceXXX() call-backs are only called from the calling thread.
+// The generated tangent spaces are exactly the same as the ones from genTangSpace().
+tbool genTangSpaceParallel(const SMikkTSpaceContext *pContext,
+                           const float fAngularThreshold,
+                           SMikkTSpaceParallelForFunc fnParallelFor,
+                           void *pParallelUserData);
+
 // To avoid visual errors (distortions/unwanted hard edges in lighting), when using sampled normal
 // maps, the normal map sampler must use the exact inverse of the pixel shader transformation.
 // The most efficient transformation we can possibly do in the pixel shader is achieved by using,
@@ -447,6 +447,8 @@ class TOPBAR_MT_file_import(Menu):
     bl_owner_use_filter = False
 
     def draw(self, _context):
+        self.layout.operator("wm.obj_import", text="Wavefront OBJ (.obj)")
+        self.layout.operator("wm.stl_import", text="STL (.stl) (experimental)")
         if bpy.app.build_options.collada:
             self.layout.operator("wm.collada_import", text="Collada (.dae)")
         if bpy.app.build_options.alembic:
@@ -465,6 +467,7 @@ class TOPBAR_MT_file_export(Menu):
 
     def draw(self, _context):
         self.layout.operator("wm.obj_export", text="Wavefront OBJ (.obj)")
+        self.layout.operator("wm.stl_export", text="STL (.stl) (experimental)")
         if bpy.app.build_options.collada:
             self.layout.operator("wm.collada_export", text="Collada (.dae)")
         if bpy.app.build_options.alembic:
@@ -630,6 +630,11 @@ class USERPREF_PT_system_memory(SystemPanel, CenterAlignMixIn, Panel):
 
         layout.separator()
 
+        col = layout.column()
+        col.prop(system, "geometry_nodes_cache_limit", text="Geometry Nodes Cache Limit")
+
+        layout.separator()
+
         col = layout.column()
         col.prop(system, "scrollback", text="Console Scrollback Lines")
 
@@ -2300,6 +2305,8 @@ class USERPREF_PT_experimental_debugging(ExperimentalPanel, Panel):
                 ({"property": "use_cycles_debug"}, None),
                 ({"property": "show_asset_debug_info"}, None),
                 ({"property": "use_asset_indexing"}, None),
+                ({"property": "use_mmap_file_read"}, None),
+                ({"property": "use_undo_compression"}, None),
             ),
         )
 
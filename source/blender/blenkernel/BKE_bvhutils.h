@@ -185,6 +185,7 @@ BVHTree *bvhtree_from_mesh_edges_ex(struct BVHTreeFromMesh *data,
  * \param faces_mask: if not null, true elements give which faces to add to BVH-tree.
  * \param faces_num_active: if >= 0, number of active faces to add to BVH-tree
  * (else will be computed from mask).
+ * \param balance_flag: Passed to #BLI_bvhtree_balance_ex when a new tree is built.
  */
 BVHTree *bvhtree_from_mesh_faces_ex(struct BVHTreeFromMesh *data,
                                     const struct MVert *vert,
@@ -197,6 +198,7 @@ BVHTree *bvhtree_from_mesh_faces_ex(struct BVHTreeFromMesh *data,
                                     float epsilon,
                                     int tree_type,
                                     int axis,
+                                    int balance_flag,
                                     BVHCacheType bvh_cache_type,
                                     struct BVHCache **bvh_cache_p,
                                     ThreadMutex *mesh_eval_mutex);
@@ -206,6 +208,7 @@ BVHTree *bvhtree_from_editmesh_looptri(
 
 /**
  * Builds a BVH-tree where nodes are the `looptri` faces of the given `bm`.
+ * \param balance_flag: Passed to #BLI_bvhtree_balance_ex when a new tree is built.
  */
 BVHTree *bvhtree_from_editmesh_looptri_ex(BVHTreeFromEditMesh *data,
                                           struct BMEditMesh *em,
@@ -214,6 +217,7 @@ BVHTree *bvhtree_from_editmesh_looptri_ex(BVHTreeFromEditMesh *data,
                                           float epsilon,
                                           int tree_type,
                                           int axis,
+                                          int balance_flag,
                                           BVHCacheType bvh_cache_type,
                                           struct BVHCache **bvh_cache_p,
                                           ThreadMutex *mesh_eval_mutex);
@@ -222,6 +226,7 @@ BVHTree *bvhtree_from_editmesh_looptri_ex(BVHTreeFromEditMesh *data,
  * Builds a BVH-tree where nodes are the looptri faces of the given mesh.
  *
  * \note for edit-mesh this is currently a duplicate of #bvhtree_from_mesh_faces_ex
+ * \param balance_flag: Passed to #BLI_bvhtree_balance_ex when a new tree is built.
  */
 BVHTree *bvhtree_from_mesh_looptri_ex(struct BVHTreeFromMesh *data,
                                       const struct MVert *vert,
@@ -236,6 +241,7 @@ BVHTree *bvhtree_from_mesh_looptri_ex(struct BVHTreeFromMesh *data,
                                       float epsilon,
                                       int tree_type,
                                       int axis,
+                                      int balance_flag,
                                       BVHCacheType bvh_cache_type,
                                       struct BVHCache **bvh_cache_p,
                                       ThreadMutex *mesh_eval_mutex);
@@ -251,6 +257,17 @@ BVHTree *BKE_bvhtree_from_mesh_get(struct BVHTreeFromMesh *data,
                                    BVHCacheType bvh_cache_type,
                                    int tree_type);
 
+/**
+ * Same as #BKE_bvhtree_from_mesh_get, with a \a balance_flag for #BLI_bvhtree_balance_ex.
+ * Triangle trees built with #BVH_BALANCE_SAH are faster for ray-casts and nearest surface
+ * queries, but take longer to build. The flag is only used when the tree isn't cached yet.
+ */
+BVHTree *BKE_bvhtree_from_mesh_get_ex(struct BVHTreeFromMesh *data,
+                                      const struct Mesh *mesh,
+                                      BVHCacheType bvh_cache_type,
+                                      int tree_type,
+                                      int balance_flag);
+
 /**
  * Builds or queries a BVH-cache for the cache BVH-tree of the request type.
  */
@@ -308,6 +325,12 @@ struct BVHCache *bvhcache_init(void);
  * Frees a BVH-cache.
  */
 void bvhcache_free(struct BVHCache *bvh_cache);
+/**
+ * Call when the positions of the mesh changed, but not its topology. Trees of the mesh are refit
+ * to the new positions the next time they are used, or built again when refitting would make
+ * them too slow. Edit-mesh trees are freed.
+ */
+void bvhcache_tag_coords_changed(struct BVHCache *bvh_cache);
 
 #ifdef __cplusplus
 }
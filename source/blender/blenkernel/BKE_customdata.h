@@ -41,6 +41,14 @@ extern const CustomData_MeshMasks CD_MASK_EVERYTHING;
 /* for ORIGINDEX layer type, indicates no original index for this element */
 #define ORIGINDEX_NONE -1
 
+/**
+ * Layer data allocated by CustomData starts at a multiple of this many bytes and its allocation
+ * is padded to a multiple of it, so that vectorized loops can use aligned loads for the whole
+ * array. The padding is zero-initialized. Layers added with #CD_ASSIGN or #CD_REFERENCE keep the
+ * pointer they were given, see #blender::bke::custom_data_layer_is_aligned.
+ */
+#define CUSTOMDATA_LAYER_ALIGNMENT 64
+
 /* initializes a CustomData object with the same layer setup as source and
  * memory space for totelem elements. mask must be an array of length
  * CD_NUMTYPES elements, that indicate if a layer can be copied. */
@@ -53,7 +61,11 @@ typedef enum eCDAllocType {
   CD_CALLOC = 1,
   /** Allocate and set to default. */
   CD_DEFAULT = 2,
-  /** Use data pointers, set layer flag NOFREE. */
+  /**
+   * Share the data of the source layers, set layer flag NOFREE. Shared data stays valid until all
+   * layers using it are freed, but it must be made mutable before it is modified, see
+   * #CustomData_duplicate_referenced_layer.
+   */
   CD_REFERENCE = 3,
   /** Do a full copy of all layers, only allowed if source has same number of elements. */
   CD_DUPLICATE = 4,
@@ -252,7 +264,9 @@ int CustomData_number_of_layers(const struct CustomData *data, int type);
 int CustomData_number_of_layers_typemask(const struct CustomData *data, CustomDataMask mask);
 
 /**
- * Duplicate data of a layer with flag NOFREE, and remove that flag.
+ * Make the data of a layer mutable. Data of a layer with flag NOFREE or data that is shared with
+ * other layers is duplicated, and that flag is removed. Shared data that is not used by any other
+ * layer anymore is taken over without copying it.
  * \return the layer data.
  */
 void *CustomData_duplicate_referenced_layer(struct CustomData *data, int type, int totelem);
@@ -269,7 +283,7 @@ void *CustomData_duplicate_referenced_layer_anonymous(
 bool CustomData_is_referenced_layer(struct CustomData *data, int type);
 
 /**
- * Duplicate all the layers with flag NOFREE, and remove the flag from duplicated layers.
+ * Make all layers mutable, see #CustomData_duplicate_referenced_layer.
  */
 void CustomData_duplicate_referenced_layers(CustomData *data, int totelem);
 
@@ -754,9 +768,26 @@ void CustomData_debug_info_from_layers(const struct CustomData *data,
 
 #ifdef __cplusplus
 #  include "BLI_cpp_type.hh"
+#  include "BLI_generic_span.hh"
 
 namespace blender::bke {
 const CPPType *custom_data_type_to_cpp_type(const CustomDataType type);
 CustomDataType cpp_type_to_custom_data_type(const CPPType &type);
+
+/**
+ * Typed access to the data of a layer with \a size elements. The layer type must have a
+ * corresponding #CPPType. Writing to a layer that is referenced from elsewhere requires calling
+ * one of the `CustomData_duplicate_referenced_layer` functions first.
+ */
+GSpan custom_data_layer_span(const CustomDataLayer &layer, int64_t size);
+GMutableSpan custom_data_layer_span_for_write(CustomDataLayer &layer, int64_t size);
+
+/**
+ * True when the layer data is known to be aligned and padded to #CUSTOMDATA_LAYER_ALIGNMENT,
+ * which is the case for all layers owned by the #CustomData unless they were read from a file or
+ * assigned from elsewhere. Loops can then process the data in full vector-sized blocks, reading
+ * the padding after the last element.
+ */
+bool custom_data_layer_is_aligned(const CustomDataLayer &layer, int64_t size);
 }  // namespace blender::bke
 #endif
@@ -206,6 +206,11 @@ enum {
 enum {
   G_FILE_AUTOPACK = (1 << 0),
   G_FILE_COMPRESS = (1 << 1),
+  /**
+   * Write an index of all blocks at the end of the file, so that linking from it doesn't need
+   * to scan the whole file.
+   */
+  G_FILE_BLOCK_INDEX = (1 << 2),
 
   // G_FILE_DEPRECATED_9 = (1 << 9),
   G_FILE_NO_UI = (1 << 10),
@@ -149,6 +149,9 @@ void BKE_mesh_eval_delete(struct Mesh *mesh_eval);
 /**
  * Performs copy for use during evaluation,
  * optional referencing original arrays to reduce memory.
+ * Referenced arrays are shared with the source and stay valid when the source is freed. They have
+ * to be made mutable with `CustomData_duplicate_referenced_layer` before they are modified, which
+ * only copies them when they are still used by another mesh.
  */
 struct Mesh *BKE_mesh_copy_for_eval(const struct Mesh *source, bool reference);
 
@@ -391,6 +394,18 @@ const float (*BKE_mesh_poly_normals_ensure(const struct Mesh *mesh))[3];
  */
 void BKE_mesh_normals_tag_dirty(struct Mesh *mesh);
 
+/**
+ * Call after changing vertex positions without changing the topology of the mesh. Tags normals
+ * dirty and lets cached BVH trees be refit to the new positions instead of being built again.
+ */
+void BKE_mesh_tag_coords_changed(struct Mesh *mesh);
+
+/**
+ * Like #BKE_mesh_tag_coords_changed, for when all vertices moved by the same translation, which
+ * doesn't change the normals.
+ */
+void BKE_mesh_tag_coords_changed_uniformly(struct Mesh *mesh);
+
 /**
  * Check that a mesh with non-dirty normals has vertex and face custom data layers.
  * If these asserts fail, it means some area cleared the dirty flag but didn't copy or add the
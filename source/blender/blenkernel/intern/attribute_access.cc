@@ -454,8 +454,7 @@ ReadAttributeLookup CustomDataAttributeProvider::try_get_for_read(
     if (type == nullptr) {
       continue;
     }
-    GSpan data{*type, layer.data, domain_size};
-    return {GVArray::ForSpan(data), domain_};
+    return {GVArray::ForSpan(custom_data_layer_span(layer, domain_size)), domain_};
   }
   return {};
 }
@@ -484,8 +483,8 @@ WriteAttributeLookup CustomDataAttributeProvider::try_get_for_write(
     if (type == nullptr) {
       continue;
     }
-    GMutableSpan data{*type, layer.data, domain_size};
-    return {GVMutableArray::ForSpan(data), domain_};
+    return {GVMutableArray::ForSpan(custom_data_layer_span_for_write(layer, domain_size)),
+            domain_};
   }
   return {};
 }
@@ -685,9 +684,7 @@ std::optional<GSpan> CustomDataAttributes::get_for_read(const AttributeIDRef &at
 {
   for (const CustomDataLayer &layer : Span(data.layers, data.totlayer)) {
     if (custom_data_layer_matches_attribute_id(layer, attribute_id)) {
-      const CPPType *cpp_type = custom_data_type_to_cpp_type((CustomDataType)layer.type);
-      BLI_assert(cpp_type != nullptr);
-      return GSpan(*cpp_type, layer.data, size_);
+      return custom_data_layer_span(layer, size_);
     }
   }
   return {};
@@ -718,9 +715,7 @@ std::optional<GMutableSpan> CustomDataAttributes::get_for_write(const AttributeI
 {
   for (CustomDataLayer &layer : MutableSpan(data.layers, data.totlayer)) {
     if (custom_data_layer_matches_attribute_id(layer, attribute_id)) {
-      const CPPType *cpp_type = custom_data_type_to_cpp_type((CustomDataType)layer.type);
-      BLI_assert(cpp_type != nullptr);
-      return GMutableSpan(*cpp_type, layer.data, size_);
+      return custom_data_layer_span_for_write(layer, size_);
     }
   }
   return {};
@@ -40,6 +40,9 @@
 #include "BKE_studiolight.h"
 
 #include "DEG_depsgraph.h"
+#include "DEG_depsgraph_debug.h"
+
+#include "MOD_nodes.h"
 
 #include "RE_pipeline.h"
 #include "RE_texture.h"
@@ -73,6 +76,8 @@ void BKE_blender_free(void)
 
   IMB_exit();
   BKE_cachefiles_exit();
+  /* Write the profile requested from the command line, all evaluations have finished. */
+  DEG_debug_profile_end();
   DEG_free_node_types();
 
   BKE_brush_system_exit();
@@ -81,6 +86,7 @@ void BKE_blender_free(void)
   BKE_callback_global_finalize();
 
   IMB_moviecache_destruct();
+  MOD_nodes_cache_free();
 
   BKE_node_system_exit();
 }
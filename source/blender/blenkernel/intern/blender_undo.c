@@ -129,7 +129,7 @@ MemFileUndoData *BKE_memfile_undo_encode(Main *bmain, MemFileUndoData *mfu_prev)
       BLO_memfile_clear_future(prevfile);
     }
     /* success = */ /* UNUSED */ BLO_write_file_mem(bmain, prevfile, &mfu->memfile, fileflags);
-    mfu->undo_size = mfu->memfile.size;
+    mfu->undo_size = BLO_memfile_size_get(&mfu->memfile);
   }
 
   bmain->is_memfile_undo_written = true;
@@ -52,6 +52,8 @@
 #include "BLO_readfile.h"
 #include "BLO_writefile.h"
 
+#include "MOD_nodes.h"
+
 #include "RNA_access.h"
 
 #include "RE_pipeline.h"
@@ -286,6 +288,9 @@ static void setup_app_data(bContext *C,
     }
   }
 
+  /* Cached geometry node outputs reference data of the old Main, like materials. */
+  MOD_nodes_cache_free();
+
   /* free G_MAIN Main database */
   //  CTX_wm_manager_set(C, NULL);
   BKE_blender_globals_clear();
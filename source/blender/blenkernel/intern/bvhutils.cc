@@ -32,6 +32,10 @@
 
 struct BVHCacheItem {
   bool is_filled;
+  /** The positions changed since the tree was built or refit, see #bvhcache_refit. */
+  bool is_dirty;
+  /** #BLI_bvhtree_surface_area_cost of the tree when it was built. */
+  float build_cost;
   BVHTree *tree;
 };
 
@@ -129,6 +133,31 @@ static void bvhcache_insert(BVHCache *bvh_cache, BVHTree *tree, BVHCacheType typ
   BLI_assert(!item->is_filled);
   item->tree = tree;
   item->is_filled = true;
+  item->is_dirty = false;
+  item->build_cost = tree ? BLI_bvhtree_surface_area_cost(tree) : 0.0f;
+}
+
+void bvhcache_tag_coords_changed(BVHCache *bvh_cache)
+{
+  if (bvh_cache == nullptr) {
+    return;
+  }
+  BLI_mutex_lock(&bvh_cache->mutex);
+  for (int index = 0; index < BVHTREE_MAX_ITEM; index++) {
+    BVHCacheItem *item = &bvh_cache->items[index];
+    if (!item->is_filled || item->tree == nullptr) {
+      continue;
+    }
+    if (ELEM(index, BVHTREE_FROM_EM_VERTS, BVHTREE_FROM_EM_EDGES, BVHTREE_FROM_EM_LOOPTRI)) {
+      /* Edit-mesh trees are not refit, their positions are not part of the mesh. */
+      BLI_bvhtree_free(item->tree);
+      item->tree = nullptr;
+      item->is_filled = false;
+      continue;
+    }
+    item->is_dirty = true;
+  }
+  BLI_mutex_unlock(&bvh_cache->mutex);
 }
 
 void bvhcache_free(BVHCache *bvh_cache)
@@ -147,23 +176,158 @@ void bvhcache_free(BVHCache *bvh_cache)
  * is multithreaded, and we do not want the current thread to start another task
  * that may involve acquiring the same mutex lock that it is waiting for.
  */
+struct BVHTreeBalanceData {
+  BVHTree *tree;
+  int flag;
+};
+
 static void bvhtree_balance_isolated(void *userdata)
 {
-  BLI_bvhtree_balance((BVHTree *)userdata);
+  const BVHTreeBalanceData *data = (const BVHTreeBalanceData *)userdata;
+  BLI_bvhtree_balance_ex(data->tree, data->flag);
 }
 
-static void bvhtree_balance(BVHTree *tree, const bool isolate)
+/**
+ * \param flag: Passed to #BLI_bvhtree_balance_ex, the median split is used by default because it
+ * builds trees faster.
+ */
+static void bvhtree_balance(BVHTree *tree, const bool isolate, const int flag = 0)
 {
   if (tree) {
     if (isolate) {
-      BLI_task_isolate(bvhtree_balance_isolated, tree);
+      BVHTreeBalanceData data = {tree, flag};
+      BLI_task_isolate(bvhtree_balance_isolated, &data);
     }
     else {
-      BLI_bvhtree_balance(tree);
+      BLI_bvhtree_balance_ex(tree, flag);
     }
   }
 }
 
+/**
+ * Rebuild a refit tree instead when ray-casts and nearest point queries are expected to be this
+ * much slower than with a new tree.
+ */
+static constexpr float bvh_refit_cost_factor_max = 1.5f;
+
+struct BVHRefitMeshData {
+  const MVert *vert;
+  const MEdge *edge;
+  const MFace *face;
+  const MLoop *loop;
+  const MLoopTri *looptri;
+  BVHTree *tree;
+  BVHTree_LeafPointsCallback callback;
+};
+
+static int bvhtree_refit_verts_cb(void *userdata, int index, float r_co[BVH_LEAF_POINTS_MAX][3])
+{
+  const BVHRefitMeshData *data = (const BVHRefitMeshData *)userdata;
+  copy_v3_v3(r_co[0], data->vert[index].co);
+  return 1;
+}
+
+static int bvhtree_refit_edges_cb(void *userdata, int index, float r_co[BVH_LEAF_POINTS_MAX][3])
+{
+  const BVHRefitMeshData *data = (const BVHRefitMeshData *)userdata;
+  const MEdge &edge = data->edge[index];
+  copy_v3_v3(r_co[0], data->vert[edge.v1].co);
+  copy_v3_v3(r_co[1], data->vert[edge.v2].co);
+  return 2;
+}
+
+static int bvhtree_refit_faces_cb(void *userdata, int index, float r_co[BVH_LEAF_POINTS_MAX][3])
+{
+  const BVHRefitMeshData *data = (const BVHRefitMeshData *)userdata;
+  const MFace &face = data->face[index];
+  copy_v3_v3(r_co[0], data->vert[face.v1].co);
+  copy_v3_v3(r_co[1], data->vert[face.v2].co);
+  copy_v3_v3(r_co[2], data->vert[face.v3].co);
+  if (face.v4) {
+    copy_v3_v3(r_co[3], data->vert[face.v4].co);
+    return 4;
+  }
+  return 3;
+}
+
+static int bvhtree_refit_looptri_cb(void *userdata, int index, float r_co[BVH_LEAF_POINTS_MAX][3])
+{
+  const BVHRefitMeshData *data = (const BVHRefitMeshData *)userdata;
+  const MLoopTri &lt = data->looptri[index];
+  copy_v3_v3(r_co[0], data->vert[data->loop[lt.tri[0]].v].co);
+  copy_v3_v3(r_co[1], data->vert[data->loop[lt.tri[1]].v].co);
+  copy_v3_v3(r_co[2], data->vert[data->loop[lt.tri[2]].v].co);
+  return 3;
+}
+
+static void bvhtree_refit_isolated(void *userdata)
+{
+  BVHRefitMeshData *data = (BVHRefitMeshData *)userdata;
+  BLI_bvhtree_refit(data->tree, data->callback, data);
+}
+
+/**
+ * Update a tree that was tagged by #bvhcache_tag_coords_changed to the current positions of the
+ * mesh. Like balancing, refitting is multithreaded and runs in isolation inside the lock. The
+ * dirty state is only accessed inside the lock, a tree which is not dirty is returned as is.
+ *
+ * \return False when the tree was removed from the cache because refitting made it too slow,
+ * it has to be built again.
+ */
+static bool bvhcache_refit(BVHCache *bvh_cache,
+                           const BVHCacheType type,
+                           const Mesh *mesh,
+                           BVHTree **r_tree)
+{
+  BVHRefitMeshData data{};
+  data.vert = mesh->mvert;
+  data.edge = mesh->medge;
+  data.face = mesh->mface;
+  data.loop = mesh->mloop;
+  switch (type) {
+    case BVHTREE_FROM_VERTS:
+    case BVHTREE_FROM_LOOSEVERTS:
+      data.callback = bvhtree_refit_verts_cb;
+      break;
+    case BVHTREE_FROM_EDGES:
+    case BVHTREE_FROM_LOOSEEDGES:
+      data.callback = bvhtree_refit_edges_cb;
+      break;
+    case BVHTREE_FROM_FACES:
+      data.callback = bvhtree_refit_faces_cb;
+      break;
+    case BVHTREE_FROM_LOOPTRI:
+    case BVHTREE_FROM_LOOPTRI_NO_HIDDEN:
+      data.looptri = BKE_mesh_runtime_looptri_ensure(mesh);
+      data.callback = bvhtree_refit_looptri_cb;
+      break;
+    case BVHTREE_FROM_EM_VERTS:
+    case BVHTREE_FROM_EM_EDGES:
+    case BVHTREE_FROM_EM_LOOPTRI:
+    case BVHTREE_MAX_ITEM:
+      BLI_assert_unreachable();
+      break;
+  }
+
+  BVHCacheItem *item = &bvh_cache->items[type];
+  BLI_mutex_lock(&bvh_cache->mutex);
+  /* Another thread may have updated the tree while waiting for the lock. */
+  if (item->is_filled && item->is_dirty) {
+    data.tree = item->tree;
+    BLI_task_isolate(bvhtree_refit_isolated, &data);
+    if (BLI_bvhtree_surface_area_cost(item->tree) > item->build_cost * bvh_refit_cost_factor_max) {
+      BLI_bvhtree_free(item->tree);
+      item->tree = nullptr;
+      item->is_filled = false;
+    }
+    item->is_dirty = false;
+  }
+  const bool is_filled = item->is_filled;
+  *r_tree = item->tree;
+  BLI_mutex_unlock(&bvh_cache->mutex);
+  return is_filled;
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -1047,6 +1211,7 @@ BVHTree *bvhtree_from_mesh_faces_ex(BVHTreeFromMesh *data,
                                     float epsilon,
                                     int tree_type,
                                     int axis,
+                                    const int balance_flag,
                                     const BVHCacheType bvh_cache_type,
                                     BVHCache **bvh_cache_p,
                                     ThreadMutex *mesh_eval_mutex)
@@ -1061,7 +1226,7 @@ BVHTree *bvhtree_from_mesh_faces_ex(BVHTreeFromMesh *data,
   if (in_cache == false) {
     tree = bvhtree_from_mesh_faces_create_tree(
         epsilon, tree_type, axis, vert, face, numFaces, faces_mask, faces_num_active);
-    bvhtree_balance(tree, bvh_cache_p != nullptr);
+    bvhtree_balance(tree, bvh_cache_p != nullptr, balance_flag);
 
     if (bvh_cache_p) {
       /* Save on cache for later use */
@@ -1216,6 +1381,7 @@ BVHTree *bvhtree_from_editmesh_looptri_ex(BVHTreeFromEditMesh *data,
                                           float epsilon,
                                           int tree_type,
                                           int axis,
+                                          const int balance_flag,
                                           const BVHCacheType bvh_cache_type,
                                           BVHCache **bvh_cache_p,
                                           ThreadMutex *mesh_eval_mutex)
@@ -1232,7 +1398,7 @@ BVHTree *bvhtree_from_editmesh_looptri_ex(BVHTreeFromEditMesh *data,
     if (in_cache == false) {
       tree = bvhtree_from_editmesh_looptri_create_tree(
           epsilon, tree_type, axis, em, looptri_mask, looptri_num_active);
-      bvhtree_balance(tree, true);
+      bvhtree_balance(tree, true, balance_flag);
 
       /* Save on cache for later use */
       // printf("BVHTree built and saved on cache\n");
@@ -1243,7 +1409,7 @@ BVHTree *bvhtree_from_editmesh_looptri_ex(BVHTreeFromEditMesh *data,
   else {
     tree = bvhtree_from_editmesh_looptri_create_tree(
         epsilon, tree_type, axis, em, looptri_mask, looptri_num_active);
-    bvhtree_balance(tree, false);
+    bvhtree_balance(tree, false, balance_flag);
   }
 
   if (tree) {
@@ -1260,7 +1426,7 @@ BVHTree *bvhtree_from_editmesh_looptri(
     BVHTreeFromEditMesh *data, BMEditMesh *em, float epsilon, int tree_type, int axis)
 {
   return bvhtree_from_editmesh_looptri_ex(
-      data, em, nullptr, -1, epsilon, tree_type, axis, BVHTREE_FROM_VERTS, nullptr, nullptr);
+      data, em, nullptr, -1, epsilon, tree_type, axis, 0, BVHTREE_FROM_VERTS, nullptr, nullptr);
 }
 
 BVHTree *bvhtree_from_mesh_looptri_ex(BVHTreeFromMesh *data,
@@ -1276,6 +1442,7 @@ BVHTree *bvhtree_from_mesh_looptri_ex(BVHTreeFromMesh *data,
                                       float epsilon,
                                       int tree_type,
                                       int axis,
+                                      const int balance_flag,
                                       const BVHCacheType bvh_cache_type,
                                       BVHCache **bvh_cache_p,
                                       ThreadMutex *mesh_eval_mutex)
@@ -1299,7 +1466,7 @@ BVHTree *bvhtree_from_mesh_looptri_ex(BVHTreeFromMesh *data,
                                                  looptri_mask,
                                                  looptri_num_active);
 
-    bvhtree_balance(tree, bvh_cache_p != nullptr);
+    bvhtree_balance(tree, bvh_cache_p != nullptr, balance_flag);
 
     if (bvh_cache_p) {
       BVHCache *bvh_cache = *bvh_cache_p;
@@ -1405,16 +1572,20 @@ static BLI_bitmap *looptri_no_hidden_map_get(const MPoly *mpoly,
   return looptri_mask;
 }
 
-BVHTree *BKE_bvhtree_from_mesh_get(struct BVHTreeFromMesh *data,
-                                   const struct Mesh *mesh,
-                                   const BVHCacheType bvh_cache_type,
-                                   const int tree_type)
+BVHTree *BKE_bvhtree_from_mesh_get_ex(struct BVHTreeFromMesh *data,
+                                      const struct Mesh *mesh,
+                                      const BVHCacheType bvh_cache_type,
+                                      const int tree_type,
+                                      const int balance_flag)
 {
   BVHTree *tree = nullptr;
   BVHCache **bvh_cache_p = (BVHCache **)&mesh->runtime.bvh_cache;
   ThreadMutex *mesh_eval_mutex = (ThreadMutex *)mesh->runtime.eval_mutex;
 
-  const bool is_cached = bvhcache_find(bvh_cache_p, bvh_cache_type, &tree, nullptr, nullptr);
+  bool is_cached = bvhcache_find(bvh_cache_p, bvh_cache_type, &tree, nullptr, nullptr);
+  if (is_cached) {
+    is_cached = bvhcache_refit(*bvh_cache_p, bvh_cache_type, mesh, &tree);
+  }
 
   if (is_cached && tree == nullptr) {
     memset(data, 0, sizeof(*data));
@@ -1510,6 +1681,7 @@ BVHTree *BKE_bvhtree_from_mesh_get(struct BVHTreeFromMesh *data,
                                           0.0,
                                           tree_type,
                                           6,
+                                          balance_flag,
                                           bvh_cache_type,
                                           bvh_cache_p,
                                           mesh_eval_mutex);
@@ -1547,6 +1719,7 @@ BVHTree *BKE_bvhtree_from_mesh_get(struct BVHTreeFromMesh *data,
                                             0.0,
                                             tree_type,
                                             6,
+                                            balance_flag,
                                             bvh_cache_type,
                                             bvh_cache_p,
                                             mesh_eval_mutex);
@@ -1590,6 +1763,14 @@ BVHTree *BKE_bvhtree_from_mesh_get(struct BVHTreeFromMesh *data,
   return tree;
 }
 
+BVHTree *BKE_bvhtree_from_mesh_get(struct BVHTreeFromMesh *data,
+                                   const struct Mesh *mesh,
+                                   const BVHCacheType bvh_cache_type,
+                                   const int tree_type)
+{
+  return BKE_bvhtree_from_mesh_get_ex(data, mesh, bvh_cache_type, tree_type, 0);
+}
+
 BVHTree *BKE_bvhtree_from_editmesh_get(BVHTreeFromEditMesh *data,
                                        struct BMEditMesh *em,
                                        const int tree_type,
@@ -1662,6 +1843,7 @@ BVHTree *BKE_bvhtree_from_editmesh_get(BVHTreeFromEditMesh *data,
                                                 0.0f,
                                                 tree_type,
                                                 6,
+                                                0,
                                                 bvh_cache_type,
                                                 bvh_cache_p,
                                                 mesh_eval_mutex);
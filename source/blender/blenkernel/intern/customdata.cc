@@ -20,6 +20,7 @@
 #include "BLI_bitmap.h"
 #include "BLI_color.hh"
 #include "BLI_endian_switch.h"
+#include "BLI_implicit_sharing.hh"
 #include "BLI_math.h"
 #include "BLI_math_color_blend.h"
 #include "BLI_math_vector.hh"
@@ -51,6 +52,8 @@
 
 #include "CLG_log.h"
 
+#include "atomic_ops.h"
+
 /* only for customdata_data_transfer_interp_normal_normals */
 #include "data_transfer_intern.h"
 
@@ -2207,6 +2210,159 @@ static bool customdata_typemap_is_valid(const CustomData *data)
 }
 #endif
 
+static size_t customData_layer_data_alloc_size(const size_t size)
+{
+  return (size + CUSTOMDATA_LAYER_ALIGNMENT - 1) & ~(size_t)(CUSTOMDATA_LAYER_ALIGNMENT - 1);
+}
+
+/**
+ * Allocate layer data of \a size bytes, see #CUSTOMDATA_LAYER_ALIGNMENT. The padding is always
+ * cleared, the rest of the data only when \a clear is true.
+ */
+static void *customData_layer_data_alloc(const size_t size, const bool clear, const char *name)
+{
+  const size_t alloc_size = customData_layer_data_alloc_size(size);
+  void *data = MEM_mallocN_aligned(alloc_size, CUSTOMDATA_LAYER_ALIGNMENT, name);
+  if (clear) {
+    memset(data, 0, alloc_size);
+  }
+  else {
+    memset(POINTER_OFFSET(data, size), 0, alloc_size - size);
+  }
+  return data;
+}
+
+/* -------------------------------------------------------------------- */
+/** \name Layer Sharing
+ *
+ * Layers copied with #CD_REFERENCE share the data of the source layer instead of copying it.
+ * The shared data is owned by a #CustomDataLayerSharingInfo that all layers using it are users
+ * of, so it stays valid when the source is freed first. The data is only copied when a layer is
+ * made mutable with one of the `CustomData_duplicate_referenced_layer` functions while it still
+ * has other users.
+ * \{ */
+
+class CustomDataLayerSharingInfo : public blender::ImplicitSharingInfo {
+ public:
+  void *data;
+  int type;
+  int totelem;
+
+  CustomDataLayerSharingInfo(void *data, const int type, const int totelem)
+      : data(data), type(type), totelem(totelem)
+  {
+  }
+
+ private:
+  void delete_self_with_data() override
+  {
+    if (data != nullptr) {
+      const LayerTypeInfo *typeInfo = layerType_getInfo(type);
+      if (typeInfo->free) {
+        typeInfo->free(data, totelem, typeInfo->size);
+      }
+      MEM_freeN(data);
+    }
+    MEM_delete(this);
+  }
+};
+
+static const CustomDataLayerSharingInfo *customData_layer_sharing_info(
+    const CustomDataLayer &layer)
+{
+  return static_cast<const CustomDataLayerSharingInfo *>(
+      static_cast<const blender::ImplicitSharingInfo *>(layer.sharing_info));
+}
+
+static bool customData_layer_is_shared(const CustomDataLayer &layer)
+{
+  const CustomDataLayerSharingInfo *sharing_info = customData_layer_sharing_info(layer);
+  return sharing_info != nullptr && !sharing_info->is_mutable();
+}
+
+/**
+ * Add a user to the data of the layer, so that another layer can use it as well. The sharing info
+ * is only created when the layer is shared for the first time. Multiple threads can share the
+ * same layer at the same time.
+ */
+static const ImplicitSharingInfoHandle *customData_layer_share(const CustomDataLayer &layer,
+                                                               const int totelem)
+{
+  const CustomDataLayerSharingInfo *sharing_info = customData_layer_sharing_info(layer);
+  if (sharing_info == nullptr) {
+    CustomDataLayerSharingInfo *new_sharing_info = MEM_new<CustomDataLayerSharingInfo>(
+        __func__, layer.data, layer.type, totelem);
+    ImplicitSharingInfoHandle *new_handle = new_sharing_info;
+    void *old_handle = atomic_cas_ptr((void **)&layer.sharing_info, nullptr, new_handle);
+    if (old_handle == nullptr) {
+      sharing_info = new_sharing_info;
+    }
+    else {
+      /* Another thread shared the layer first, don't free the data with the unused info. */
+      MEM_delete(new_sharing_info);
+      sharing_info = customData_layer_sharing_info(layer);
+    }
+  }
+  sharing_info->user_add();
+  return layer.sharing_info;
+}
+
+/**
+ * Stop sharing the layer data without copying it. When the layer was the last user, it owns the
+ * data afterwards. Otherwise the data stays owned by the other users.
+ */
+static void customData_layer_unshare(CustomDataLayer &layer)
+{
+  const CustomDataLayerSharingInfo *sharing_info = customData_layer_sharing_info(layer);
+  if (sharing_info->is_mutable()) {
+    const_cast<CustomDataLayerSharingInfo *>(sharing_info)->data = nullptr;
+  }
+  sharing_info->user_remove();
+  layer.sharing_info = nullptr;
+}
+
+static void *customData_layer_data_copy(const CustomDataLayer &layer, const int totelem)
+{
+  /* A plain copy won't work in case of complex layers, like e.g.
+   * CD_MDEFORMVERT, which has pointers to allocated data...
+   * So in case a custom copy function is defined, use it!
+   */
+  const LayerTypeInfo *typeInfo = layerType_getInfo(layer.type);
+
+  void *dst_data = customData_layer_data_alloc(
+      (size_t)totelem * typeInfo->size, false, "CD duplicate ref layer");
+  if (typeInfo->copy) {
+    typeInfo->copy(layer.data, dst_data, totelem);
+  }
+  else {
+    memcpy(dst_data, layer.data, (size_t)totelem * typeInfo->size);
+  }
+  return dst_data;
+}
+
+/**
+ * Make sure that the layer owns its data and that no other layer uses it anymore, so that it can
+ * be modified. The data is only copied when it is still used elsewhere.
+ */
+static void customData_layer_ensure_mutable(CustomDataLayer &layer, const int totelem)
+{
+  if (customData_layer_is_shared(layer)) {
+    void *data = customData_layer_data_copy(layer, totelem);
+    customData_layer_sharing_info(layer)->user_remove();
+    layer.sharing_info = nullptr;
+    layer.data = data;
+  }
+  else if (layer.sharing_info != nullptr) {
+    customData_layer_unshare(layer);
+  }
+  else if (layer.flag & CD_FLAG_NOFREE) {
+    layer.data = customData_layer_data_copy(layer, totelem);
+  }
+  layer.flag &= ~CD_FLAG_NOFREE;
+}
+
+/** \} */
+
 bool CustomData_merge(const struct CustomData *source,
                       struct CustomData *dest,
                       CustomDataMask mask,
@@ -2272,6 +2428,17 @@ bool CustomData_merge(const struct CustomData *source,
       newlayer = customData_add_layer__internal(dest, type, alloctype, data, totelem, layer->name);
     }
 
+    if (newlayer && data && newlayer->data == data) {
+      if (alloctype == CD_ASSIGN) {
+        /* The new layer replaces the source layer as user of the shared data. */
+        newlayer->sharing_info = layer->sharing_info;
+      }
+      else if (alloctype == CD_REFERENCE &&
+               (layer->sharing_info != nullptr || !(flag & CD_FLAG_NOFREE))) {
+        newlayer->sharing_info = customData_layer_share(*layer, totelem);
+      }
+    }
+
     if (newlayer) {
       newlayer->uid = layer->uid;
 
@@ -2297,14 +2464,31 @@ void CustomData_realloc(CustomData *data, int totelem)
 {
   for (int i = 0; i < data->totlayer; i++) {
     CustomDataLayer *layer = &data->layers[i];
-    const LayerTypeInfo *typeInfo;
-    if (layer->flag & CD_FLAG_NOFREE) {
-      continue;
+    const LayerTypeInfo *typeInfo = layerType_getInfo(layer->type);
+    /* Layers which reference data that is used elsewhere get their own copy first, otherwise the
+     * size of the data wouldn't match the number of elements anymore. */
+    if (layer->sharing_info != nullptr) {
+      customData_layer_ensure_mutable(*layer, customData_layer_sharing_info(*layer)->totelem);
+    }
+    else if ((layer->flag & CD_FLAG_NOFREE) && layer->data != nullptr) {
+      customData_layer_ensure_mutable(*layer,
+                                      int(MEM_allocN_len(layer->data) / typeInfo->size));
+    }
+    /* Clear the new data to avoid the need to manually initialize new data in layers.
+     * Useful for types like #MDeformVert which contain a pointer. Don't use #MEM_recallocN,
+     * layers read from files are not aligned yet. */
+    const size_t size = (size_t)totelem * typeInfo->size;
+    void *new_data = customData_layer_data_alloc(size, false, layerType_getName(layer->type));
+    size_t copy_size = 0;
+    if (layer->data) {
+      copy_size = std::min(size, MEM_allocN_len(layer->data));
+      memcpy(new_data, layer->data, copy_size);
+      MEM_freeN(layer->data);
     }
-    typeInfo = layerType_getInfo(layer->type);
-    /* Use calloc to avoid the need to manually initialize new data in layers.
-     * Useful for types like #MDeformVert which contain a pointer. */
-    layer->data = MEM_recallocN(layer->data, (size_t)totelem * typeInfo->size);
+    memset(POINTER_OFFSET(new_data, copy_size),
+           0,
+           customData_layer_data_alloc_size(size) - copy_size);
+    layer->data = new_data;
   }
 }
 
@@ -2331,7 +2515,11 @@ static void customData_free_layer__internal(CustomDataLayer *layer, int totelem)
     BKE_anonymous_attribute_id_decrement_weak(layer->anonymous_id);
     layer->anonymous_id = nullptr;
   }
-  if (!(layer->flag & CD_FLAG_NOFREE) && layer->data) {
+  if (layer->sharing_info != nullptr) {
+    customData_layer_sharing_info(*layer)->user_remove();
+    layer->sharing_info = nullptr;
+  }
+  else if (!(layer->flag & CD_FLAG_NOFREE) && layer->data) {
     typeInfo = layerType_getInfo(layer->type);
 
     if (typeInfo->free) {
@@ -2660,12 +2848,9 @@ static CustomDataLayer *customData_add_layer__internal(CustomData *data,
     newlayerdata = layerdata;
   }
   else if (totelem > 0 && typeInfo->size > 0) {
-    if (alloctype == CD_DUPLICATE && layerdata) {
-      newlayerdata = MEM_malloc_arrayN((size_t)totelem, typeInfo->size, layerType_getName(type));
-    }
-    else {
-      newlayerdata = MEM_calloc_arrayN((size_t)totelem, typeInfo->size, layerType_getName(type));
-    }
+    newlayerdata = customData_layer_data_alloc((size_t)totelem * typeInfo->size,
+                                               !(alloctype == CD_DUPLICATE && layerdata),
+                                               layerType_getName(type));
 
     if (!newlayerdata) {
       return nullptr;
@@ -2932,25 +3117,7 @@ static void *customData_duplicate_referenced_layer_index(CustomData *data,
 
   CustomDataLayer *layer = &data->layers[layer_index];
 
-  if (layer->flag & CD_FLAG_NOFREE) {
-    /* MEM_dupallocN won't work in case of complex layers, like e.g.
-     * CD_MDEFORMVERT, which has pointers to allocated data...
-     * So in case a custom copy function is defined, use it!
-     */
-    const LayerTypeInfo *typeInfo = layerType_getInfo(layer->type);
-
-    if (typeInfo->copy) {
-      void *dst_data = MEM_malloc_arrayN(
-          (size_t)totelem, typeInfo->size, "CD duplicate ref layer");
-      typeInfo->copy(layer->data, dst_data, totelem);
-      layer->data = dst_data;
-    }
-    else {
-      layer->data = MEM_dupallocN(layer->data);
-    }
-
-    layer->flag &= ~CD_FLAG_NOFREE;
-  }
+  customData_layer_ensure_mutable(*layer, totelem);
 
   return layer->data;
 }
@@ -3017,7 +3184,7 @@ bool CustomData_is_referenced_layer(struct CustomData *data, int type)
 
   CustomDataLayer *layer = &data->layers[layer_index];
 
-  return (layer->flag & CD_FLAG_NOFREE) != 0;
+  return (layer->flag & CD_FLAG_NOFREE) != 0 || customData_layer_is_shared(*layer);
 }
 
 void CustomData_free_temporary(CustomData *data, int totelem)
@@ -3192,6 +3359,10 @@ void CustomData_free_elem(CustomData *data, int index, int count)
       const LayerTypeInfo *typeInfo = layerType_getInfo(data->layers[i].type);
 
       if (typeInfo->free) {
+        if (data->layers[i].sharing_info != nullptr) {
+          customData_layer_ensure_mutable(
+              data->layers[i], customData_layer_sharing_info(data->layers[i])->totelem);
+        }
         size_t offset = (size_t)index * typeInfo->size;
 
         typeInfo->free(POINTER_OFFSET(data->layers[i].data, offset), count, typeInfo->size);
@@ -3439,6 +3610,9 @@ void *CustomData_set_layer(const CustomData *data, int type, void *ptr)
     return nullptr;
   }
 
+  if (data->layers[layer_index].sharing_info != nullptr) {
+    customData_layer_unshare(data->layers[layer_index]);
+  }
   data->layers[layer_index].data = ptr;
 
   return ptr;
@@ -3452,6 +3626,9 @@ void *CustomData_set_layer_n(const struct CustomData *data, int type, int n, voi
     return nullptr;
   }
 
+  if (data->layers[layer_index].sharing_info != nullptr) {
+    customData_layer_unshare(data->layers[layer_index]);
+  }
   data->layers[layer_index].data = ptr;
 
   return ptr;
@@ -4378,7 +4555,9 @@ void CustomData_blend_write_prepare(CustomData *data,
         }
         write_layers_size += chunk_size;
       }
-      write_layers[j++] = *layer;
+      write_layers[j] = *layer;
+      write_layers[j].sharing_info = nullptr;
+      j++;
     }
   }
   BLI_assert(j == data->totlayer);
@@ -5312,6 +5491,7 @@ void CustomData_blend_read(BlendDataReader *reader, CustomData *data, int count)
     }
 
     layer->flag &= ~CD_FLAG_NOFREE;
+    layer->sharing_info = nullptr;
 
     if (CustomData_verify_versions(data, i)) {
       BLO_read_data_address(reader, &layer->data);
@@ -5432,6 +5612,37 @@ CustomDataType cpp_type_to_custom_data_type(const blender::CPPType &type)
   return static_cast<CustomDataType>(-1);
 }
 
+GSpan custom_data_layer_span(const CustomDataLayer &layer, const int64_t size)
+{
+  const CPPType *type = custom_data_type_to_cpp_type(CustomDataType(layer.type));
+  BLI_assert(type != nullptr);
+  return GSpan(*type, layer.data, size);
+}
+
+GMutableSpan custom_data_layer_span_for_write(CustomDataLayer &layer, const int64_t size)
+{
+  const CPPType *type = custom_data_type_to_cpp_type(CustomDataType(layer.type));
+  BLI_assert(type != nullptr);
+  return GMutableSpan(*type, layer.data, size);
+}
+
+bool custom_data_layer_is_aligned(const CustomDataLayer &layer, const int64_t size)
+{
+  if (layer.data == nullptr) {
+    return size == 0;
+  }
+  if (uintptr_t(layer.data) % CUSTOMDATA_LAYER_ALIGNMENT != 0) {
+    return false;
+  }
+  /* Only owned layers are known to be allocated with #MEM_guardedalloc. */
+  if (layer.flag & CD_FLAG_NOFREE) {
+    return false;
+  }
+  const LayerTypeInfo *type_info = layerType_getInfo(layer.type);
+  const size_t padded_size = customData_layer_data_alloc_size(size_t(size) * type_info->size);
+  return MEM_allocN_len(layer.data) >= padded_size;
+}
+
 /** \} */
 
 }  // namespace blender::bke
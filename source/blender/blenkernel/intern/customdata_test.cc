@@ -0,0 +1,364 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bke
+ */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_float4x4.hh"
+#include "BLI_generic_virtual_array.hh"
+#include "BLI_math_vector.hh"
+#include "BLI_rand.hh"
+#include "BLI_timeit.hh"
+
+#include "DNA_meshdata_types.h"
+
+#include "BKE_customdata.h"
+
+#define DO_PERF_TESTS 0
+
+namespace blender::bke::tests {
+
+static bool data_is_aligned(const void *data)
+{
+  return uintptr_t(data) % CUSTOMDATA_LAYER_ALIGNMENT == 0;
+}
+
+static CustomDataLayer &get_layer_named(CustomData &data, const int type, const char *name)
+{
+  const int index = CustomData_get_named_layer_index(&data, type, name);
+  BLI_assert(index != -1);
+  return data.layers[index];
+}
+
+TEST(customdata, LayerAlignment)
+{
+  CustomData data;
+  CustomData_reset(&data);
+  const int size = 7;
+
+  float *floats = static_cast<float *>(
+      CustomData_add_layer_named(&data, CD_PROP_FLOAT, CD_CALLOC, nullptr, size, "a"));
+  int8_t *bytes = static_cast<int8_t *>(
+      CustomData_add_layer_named(&data, CD_PROP_INT8, CD_DEFAULT, nullptr, size, "b"));
+  EXPECT_TRUE(data_is_aligned(floats));
+  EXPECT_TRUE(data_is_aligned(bytes));
+  EXPECT_GE(MEM_allocN_len(floats), CUSTOMDATA_LAYER_ALIGNMENT);
+  EXPECT_TRUE(custom_data_layer_is_aligned(get_layer_named(data, CD_PROP_FLOAT, "a"), size));
+  EXPECT_TRUE(custom_data_layer_is_aligned(get_layer_named(data, CD_PROP_INT8, "b"), size));
+
+  /* The padding is cleared, so it can be processed like regular elements. */
+  for (const int i : IndexRange(CUSTOMDATA_LAYER_ALIGNMENT / sizeof(float))) {
+    EXPECT_EQ(floats[i], 0.0f);
+  }
+
+  GSpan span = custom_data_layer_span(get_layer_named(data, CD_PROP_FLOAT, "a"), size);
+  EXPECT_TRUE(span.type().is<float>());
+  EXPECT_EQ(span.size(), size);
+  EXPECT_EQ(span.data(), floats);
+
+  CustomData_free(&data, size);
+}
+
+TEST(customdata, LayerAlignmentRealloc)
+{
+  CustomData data;
+  CustomData_reset(&data);
+  const int size = 5;
+
+  int *ints = static_cast<int *>(
+      CustomData_add_layer_named(&data, CD_PROP_INT32, CD_CALLOC, nullptr, size, "a"));
+  for (const int i : IndexRange(size)) {
+    ints[i] = i + 1;
+  }
+
+  CustomData_realloc(&data, 100);
+  CustomDataLayer &layer = get_layer_named(data, CD_PROP_INT32, "a");
+  EXPECT_TRUE(custom_data_layer_is_aligned(layer, 100));
+  Span<int> grown = custom_data_layer_span(layer, 100).typed<int>();
+  for (const int i : IndexRange(size)) {
+    EXPECT_EQ(grown[i], i + 1);
+  }
+  for (const int i : grown.index_range().drop_front(size)) {
+    EXPECT_EQ(grown[i], 0);
+  }
+
+  CustomData_realloc(&data, 3);
+  EXPECT_TRUE(custom_data_layer_is_aligned(layer, 3));
+  EXPECT_EQ(custom_data_layer_span(layer, 3).typed<int>()[2], 3);
+
+  CustomData_free(&data, 3);
+}
+
+TEST(customdata, LayerAlignmentCopy)
+{
+  CustomData src;
+  CustomData_reset(&src);
+  const int size = 33;
+
+  /* Assigned data is not known to be aligned. */
+  float3 *positions = static_cast<float3 *>(MEM_malloc_arrayN(size, sizeof(float3), __func__));
+  for (const int i : IndexRange(size)) {
+    positions[i] = float3(i);
+  }
+  CustomData_add_layer_named(&src, CD_PROP_FLOAT3, CD_ASSIGN, positions, size, "position");
+  EXPECT_FALSE(custom_data_layer_is_aligned(src.layers[0], size));
+
+  /* Referenced layers become aligned when they are made mutable. */
+  CustomData ref;
+  CustomData_copy(&src, &ref, CD_MASK_ALL, CD_REFERENCE, size);
+  EXPECT_FALSE(custom_data_layer_is_aligned(ref.layers[0], size));
+  CustomData_duplicate_referenced_layer_named(&ref, CD_PROP_FLOAT3, "position", size);
+  EXPECT_TRUE(custom_data_layer_is_aligned(ref.layers[0], size));
+  EXPECT_NE(ref.layers[0].data, positions);
+
+  CustomData dup;
+  CustomData_copy(&src, &dup, CD_MASK_ALL, CD_DUPLICATE, size);
+  EXPECT_TRUE(custom_data_layer_is_aligned(dup.layers[0], size));
+  Span<float3> copied = custom_data_layer_span(dup.layers[0], size).typed<float3>();
+  for (const int i : IndexRange(size)) {
+    EXPECT_EQ(copied[i], float3(i));
+  }
+
+  CustomData_free(&src, size);
+  CustomData_free(&ref, size);
+  CustomData_free(&dup, size);
+}
+
+TEST(customdata, ReferenceSharesData)
+{
+  CustomData src;
+  CustomData_reset(&src);
+  const int size = 10;
+
+  int *src_data = static_cast<int *>(
+      CustomData_add_layer_named(&src, CD_PROP_INT32, CD_CALLOC, nullptr, size, "a"));
+  src_data[3] = 3;
+
+  CustomData ref;
+  CustomData_copy(&src, &ref, CD_MASK_ALL, CD_REFERENCE, size);
+  EXPECT_EQ(ref.layers[0].data, src_data);
+  EXPECT_TRUE(CustomData_is_referenced_layer(&src, CD_PROP_INT32));
+  EXPECT_TRUE(CustomData_is_referenced_layer(&ref, CD_PROP_INT32));
+
+  /* The shared data stays valid when the source is freed first. */
+  CustomData_free(&src, size);
+  EXPECT_EQ(static_cast<int *>(ref.layers[0].data)[3], 3);
+
+  /* The reference is the only user now, so it takes over the data without copying it. */
+  void *ref_data = CustomData_duplicate_referenced_layer_named(&ref, CD_PROP_INT32, "a", size);
+  EXPECT_EQ(ref_data, src_data);
+  EXPECT_FALSE(CustomData_is_referenced_layer(&ref, CD_PROP_INT32));
+  EXPECT_EQ(ref.layers[0].sharing_info, nullptr);
+
+  CustomData_free(&ref, size);
+}
+
+TEST(customdata, ReferenceCopyOnWrite)
+{
+  CustomData src;
+  CustomData_reset(&src);
+  const int size = 10;
+
+  float *src_data = static_cast<float *>(
+      CustomData_add_layer_named(&src, CD_PROP_FLOAT, CD_CALLOC, nullptr, size, "a"));
+  CustomData ref_a;
+  CustomData ref_b;
+  CustomData_copy(&src, &ref_a, CD_MASK_ALL, CD_REFERENCE, size);
+  CustomData_copy(&ref_a, &ref_b, CD_MASK_ALL, CD_REFERENCE, size);
+  EXPECT_EQ(ref_b.layers[0].data, src_data);
+  EXPECT_EQ(ref_b.layers[0].sharing_info, src.layers[0].sharing_info);
+
+  /* Modifying a shared layer copies it first. */
+  float *a_data = static_cast<float *>(
+      CustomData_duplicate_referenced_layer_named(&ref_a, CD_PROP_FLOAT, "a", size));
+  EXPECT_NE(a_data, src_data);
+  a_data[0] = 1.0f;
+  EXPECT_EQ(src_data[0], 0.0f);
+
+  /* The source layer makes its data mutable the same way. */
+  float *new_src_data = static_cast<float *>(
+      CustomData_duplicate_referenced_layer_named(&src, CD_PROP_FLOAT, "a", size));
+  EXPECT_NE(new_src_data, src_data);
+  new_src_data[1] = 2.0f;
+  EXPECT_EQ(static_cast<float *>(ref_b.layers[0].data)[1], 0.0f);
+
+  /* Resizing the source doesn't affect layers that still use the old data. */
+  CustomData_free(&ref_a, size);
+  CustomData_copy(&src, &ref_a, CD_MASK_ALL, CD_REFERENCE, size);
+  CustomData_realloc(&src, size * 2);
+  EXPECT_EQ(ref_a.layers[0].data, new_src_data);
+  EXPECT_NE(src.layers[0].data, new_src_data);
+  EXPECT_EQ(static_cast<float *>(src.layers[0].data)[1], 2.0f);
+  EXPECT_EQ(static_cast<float *>(ref_a.layers[0].data)[1], 2.0f);
+
+  CustomData_free(&src, size * 2);
+  CustomData_free(&ref_a, size);
+  CustomData_free(&ref_b, size);
+}
+
+TEST(customdata, ReferenceRealloc)
+{
+  CustomData src;
+  CustomData_reset(&src);
+  const int size = 10;
+
+  int *src_data = static_cast<int *>(
+      CustomData_add_layer_named(&src, CD_PROP_INT32, CD_CALLOC, nullptr, size, "a"));
+  src_data[size - 1] = 3;
+  CustomData ref;
+  CustomData_copy(&src, &ref, CD_MASK_ALL, CD_REFERENCE, size);
+  EXPECT_TRUE(CustomData_is_referenced_layer(&ref, CD_PROP_INT32));
+
+  /* Resizing the referencing copy gives it its own data of the new size. */
+  CustomData_realloc(&ref, size * 2);
+  int *ref_data = static_cast<int *>(ref.layers[0].data);
+  EXPECT_NE(ref_data, src_data);
+  EXPECT_FALSE(CustomData_is_referenced_layer(&ref, CD_PROP_INT32));
+  EXPECT_GE(MEM_allocN_len(ref_data), sizeof(int) * size * 2);
+  EXPECT_EQ(ref_data[size - 1], 3);
+  EXPECT_EQ(ref_data[size * 2 - 1], 0);
+  ref_data[0] = 1;
+  EXPECT_EQ(src_data[0], 0);
+  EXPECT_EQ(src.layers[0].data, src_data);
+
+  /* Shrinking works the same way. */
+  CustomData ref_small;
+  CustomData_copy(&src, &ref_small, CD_MASK_ALL, CD_REFERENCE, size);
+  CustomData_realloc(&ref_small, size / 2);
+  EXPECT_NE(ref_small.layers[0].data, src_data);
+  EXPECT_EQ(src_data[size - 1], 3);
+
+  CustomData_free(&src, size);
+  CustomData_free(&ref, size * 2);
+  CustomData_free(&ref_small, size / 2);
+}
+
+TEST(customdata, ReferenceDeformVert)
+{
+  CustomData src;
+  CustomData_reset(&src);
+  const int size = 2;
+
+  MDeformVert *dverts = static_cast<MDeformVert *>(
+      CustomData_add_layer(&src, CD_MDEFORMVERT, CD_CALLOC, nullptr, size));
+  dverts[1].dw = static_cast<MDeformWeight *>(MEM_callocN(sizeof(MDeformWeight), __func__));
+  dverts[1].dw[0].weight = 0.5f;
+  dverts[1].totweight = 1;
+
+  CustomData ref;
+  CustomData_copy(&src, &ref, CD_MASK_ALL, CD_REFERENCE, size);
+  MDeformVert *ref_dverts = static_cast<MDeformVert *>(
+      CustomData_duplicate_referenced_layer(&ref, CD_MDEFORMVERT, size));
+  EXPECT_NE(ref_dverts[1].dw, dverts[1].dw);
+  EXPECT_EQ(ref_dverts[1].dw[0].weight, 0.5f);
+
+  /* Both copies free their own weights, the guarded allocator checks for leaks. */
+  CustomData_free(&src, size);
+  CustomData_free(&ref, size);
+}
+
+#if DO_PERF_TESTS
+
+/* -------------------------------------------------------------------- */
+/** \name Attribute Operation Benchmarks
+ *
+ * Common operations on attributes, comparing direct access to the typed spans of the layers with
+ * the per-element access through virtual arrays.
+ * \{ */
+
+static void benchmark_attribute_operations(const int size)
+{
+  CustomData data;
+  CustomData_reset(&data);
+  float3 *positions = static_cast<float3 *>(
+      CustomData_add_layer_named(&data, CD_PROP_FLOAT3, CD_CALLOC, nullptr, size, "position"));
+  CustomData_add_layer_named(&data, CD_PROP_FLOAT, CD_CALLOC, nullptr, size, "weight");
+  CustomData_add_layer_named(&data, CD_PROP_FLOAT3, CD_CALLOC, nullptr, size, "offset");
+
+  RandomNumberGenerator rng(0);
+  for (const int i : IndexRange(size)) {
+    positions[i] = rng.get_unit_float3();
+  }
+
+  CustomDataLayer &position_layer = get_layer_named(data, CD_PROP_FLOAT3, "position");
+  CustomDataLayer &weight_layer = get_layer_named(data, CD_PROP_FLOAT, "weight");
+  CustomDataLayer &offset_layer = get_layer_named(data, CD_PROP_FLOAT3, "offset");
+  EXPECT_TRUE(custom_data_layer_is_aligned(position_layer, size));
+  EXPECT_TRUE(custom_data_layer_is_aligned(weight_layer, size));
+  EXPECT_TRUE(custom_data_layer_is_aligned(offset_layer, size));
+
+  MutableSpan<float3> positions_span =
+      custom_data_layer_span_for_write(position_layer, size).typed<float3>();
+  MutableSpan<float> weights = custom_data_layer_span_for_write(weight_layer, size).typed<float>();
+  MutableSpan<float3> offsets =
+      custom_data_layer_span_for_write(offset_layer, size).typed<float3>();
+
+  {
+    SCOPED_TIMER("Translate");
+    const float3 translation(1.0f, 2.0f, 3.0f);
+    for (float3 &position : positions_span) {
+      position += translation;
+    }
+  }
+  {
+    SCOPED_TIMER("Transform");
+    const float4x4 matrix = float4x4::from_loc_eul_scale(
+        {1.0f, 2.0f, 3.0f}, {0.1f, 0.2f, 0.3f}, {2.0f, 2.0f, 2.0f});
+    for (float3 &position : positions_span) {
+      position = matrix * position;
+    }
+  }
+  {
+    SCOPED_TIMER("Length");
+    for (const int i : IndexRange(size)) {
+      weights[i] = math::length(positions_span[i]);
+    }
+  }
+  {
+    SCOPED_TIMER("Scale by weight");
+    for (const int i : IndexRange(size)) {
+      offsets[i] = positions_span[i] * weights[i];
+    }
+  }
+  {
+    SCOPED_TIMER("Scale by weight (virtual array)");
+    const VArray<float3> positions_varray =
+        GVArray::ForSpan(custom_data_layer_span(position_layer, size)).typed<float3>();
+    const VArray<float> weights_varray =
+        GVArray::ForSpan(custom_data_layer_span(weight_layer, size)).typed<float>();
+    for (const int i : IndexRange(size)) {
+      offsets[i] = positions_varray[i] * weights_varray[i];
+    }
+  }
+
+  float sum = 0.0f;
+  {
+    SCOPED_TIMER("Sum");
+    for (const float weight : weights) {
+      sum += weight;
+    }
+  }
+  /* Print the value for simple error checking and to avoid some compiler optimizations. */
+  std::cout << "Sum: " << sum << "\n";
+
+  CustomData_free(&data, size);
+}
+
+TEST(customdata_performance, attribute_operations_1000)
+{
+  benchmark_attribute_operations(1000);
+}
+TEST(customdata_performance, attribute_operations_1000000)
+{
+  benchmark_attribute_operations(1000000);
+}
+
+/** \} */
+
+#endif /* DO_PERF_TESTS */
+
+}  // namespace blender::bke::tests
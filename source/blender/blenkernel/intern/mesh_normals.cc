@@ -17,6 +17,7 @@
 #include "DNA_meshdata_types.h"
 
 #include "BLI_alloca.h"
+#include "BLI_array.hh"
 #include "BLI_bitmap.h"
 
 #include "BLI_linklist.h"
@@ -24,11 +25,13 @@
 #include "BLI_math.h"
 #include "BLI_math_vec_types.hh"
 #include "BLI_memarena.h"
+#include "BLI_simd.h"
 #include "BLI_span.hh"
 #include "BLI_stack.h"
 #include "BLI_task.h"
 #include "BLI_task.hh"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "BKE_customdata.h"
 #include "BKE_editmesh_cache.h"
@@ -37,7 +40,11 @@
 
 #include "atomic_ops.h"
 
+using blender::Array;
+using blender::IndexRange;
+using blender::MutableSpan;
 using blender::Span;
+using blender::Vector;
 
 // #define DEBUG_TIME
 
@@ -169,22 +176,123 @@ void BKE_mesh_assert_normals_dirty_or_calculated(const Mesh *mesh)
 /** \name Mesh Normal Calculation (Polygons)
  * \{ */
 
-struct MeshCalcNormalsData_Poly {
-  const MVert *mvert;
-  const MLoop *mloop;
-  const MPoly *mpoly;
+#ifdef BLI_HAVE_SSE2
 
-  /** Polygon normal output. */
-  float (*pnors)[3];
+/** Number of triangles and quads that have their normal calculated at the same time. */
+#  define POLY_NORMAL_BATCH_SIZE 4
+
+/**
+ * The normals of triangles and quads are both the normalized cross product of two vectors
+ * `a - b` and `c - d` between their corners, see #normal_tri_v3 and #normal_quad_v3.
+ * The corners are stored per component, so that every SIMD lane calculates one normal.
+ */
+struct PolyNormalBatch {
+  float a[3][POLY_NORMAL_BATCH_SIZE];
+  float b[3][POLY_NORMAL_BATCH_SIZE];
+  float c[3][POLY_NORMAL_BATCH_SIZE];
+  float d[3][POLY_NORMAL_BATCH_SIZE];
+  float (*r_normals[POLY_NORMAL_BATCH_SIZE])[3];
+  int size;
 };
 
-static void mesh_calc_normals_poly_fn(void *__restrict userdata,
-                                      const int pidx,
-                                      const TaskParallelTLS *__restrict UNUSED(tls))
+static void poly_normal_batch_add(PolyNormalBatch &batch,
+                                  const float a[3],
+                                  const float b[3],
+                                  const float c[3],
+                                  const float d[3],
+                                  float (*r_normal)[3])
 {
-  const MeshCalcNormalsData_Poly *data = (MeshCalcNormalsData_Poly *)userdata;
-  const MPoly *mp = &data->mpoly[pidx];
-  BKE_mesh_calc_poly_normal(mp, data->mloop + mp->loopstart, data->mvert, data->pnors[pidx]);
+  const int lane = batch.size++;
+  for (int axis = 0; axis < 3; axis++) {
+    batch.a[axis][lane] = a[axis];
+    batch.b[axis][lane] = b[axis];
+    batch.c[axis][lane] = c[axis];
+    batch.d[axis][lane] = d[axis];
+  }
+  batch.r_normals[lane] = r_normal;
+}
+
+/**
+ * Does exactly the same floating point operations as #normal_tri_v3 and #normal_quad_v3 in every
+ * lane, so the result is bit-identical to #BKE_mesh_calc_poly_normal.
+ */
+static void poly_normal_batch_calc(PolyNormalBatch &batch)
+{
+  __m128 n1[3], n2[3];
+  for (int axis = 0; axis < 3; axis++) {
+    n1[axis] = _mm_sub_ps(_mm_loadu_ps(batch.a[axis]), _mm_loadu_ps(batch.b[axis]));
+    n2[axis] = _mm_sub_ps(_mm_loadu_ps(batch.c[axis]), _mm_loadu_ps(batch.d[axis]));
+  }
+  __m128 n[3];
+  n[0] = _mm_sub_ps(_mm_mul_ps(n1[1], n2[2]), _mm_mul_ps(n1[2], n2[1]));
+  n[1] = _mm_sub_ps(_mm_mul_ps(n1[2], n2[0]), _mm_mul_ps(n1[0], n2[2]));
+  n[2] = _mm_sub_ps(_mm_mul_ps(n1[0], n2[1]), _mm_mul_ps(n1[1], n2[0]));
+
+  /* Inline version of #normalize_v3, vectors that are too short become zero. */
+  const __m128 len_squared = _mm_add_ps(
+      _mm_add_ps(_mm_mul_ps(n[0], n[0]), _mm_mul_ps(n[1], n[1])), _mm_mul_ps(n[2], n[2]));
+  const __m128 is_valid = _mm_cmpgt_ps(len_squared, _mm_set1_ps(1.0e-35f));
+  const __m128 len_inv = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(len_squared));
+
+  float result[3][POLY_NORMAL_BATCH_SIZE];
+  for (int axis = 0; axis < 3; axis++) {
+    _mm_storeu_ps(result[axis], _mm_and_ps(_mm_mul_ps(n[axis], len_inv), is_valid));
+  }
+  for (int lane = 0; lane < batch.size; lane++) {
+    float *r_normal = *batch.r_normals[lane];
+    r_normal[0] = result[0][lane];
+    r_normal[1] = result[1][lane];
+    r_normal[2] = result[2][lane];
+  }
+  batch.size = 0;
+}
+
+#endif /* BLI_HAVE_SSE2 */
+
+static void mesh_calc_normals_poly_range(const MVert *mvert,
+                                         const MLoop *mloop,
+                                         const MPoly *mpoly,
+                                         const IndexRange range,
+                                         float (*r_poly_normals)[3])
+{
+#ifdef BLI_HAVE_SSE2
+  PolyNormalBatch batch;
+  /* Unused lanes are calculated too, keep them initialized. */
+  memset(&batch, 0, sizeof(batch));
+
+  for (const int pidx : range) {
+    const MPoly *mp = &mpoly[pidx];
+    const MLoop *ml = &mloop[mp->loopstart];
+    if (mp->totloop == 3) {
+      const float *v1 = mvert[ml[0].v].co;
+      const float *v2 = mvert[ml[1].v].co;
+      const float *v3 = mvert[ml[2].v].co;
+      poly_normal_batch_add(batch, v1, v2, v2, v3, &r_poly_normals[pidx]);
+    }
+    else if (mp->totloop == 4) {
+      const float *v1 = mvert[ml[0].v].co;
+      const float *v2 = mvert[ml[1].v].co;
+      const float *v3 = mvert[ml[2].v].co;
+      const float *v4 = mvert[ml[3].v].co;
+      poly_normal_batch_add(batch, v1, v3, v2, v4, &r_poly_normals[pidx]);
+    }
+    else {
+      BKE_mesh_calc_poly_normal(mp, ml, mvert, r_poly_normals[pidx]);
+      continue;
+    }
+    if (batch.size == POLY_NORMAL_BATCH_SIZE) {
+      poly_normal_batch_calc(batch);
+    }
+  }
+  if (batch.size > 0) {
+    poly_normal_batch_calc(batch);
+  }
+#else
+  for (const int pidx : range) {
+    const MPoly *mp = &mpoly[pidx];
+    BKE_mesh_calc_poly_normal(mp, &mloop[mp->loopstart], mvert, r_poly_normals[pidx]);
+  }
+#endif
 }
 
 void BKE_mesh_calc_normals_poly(const MVert *mvert,
@@ -195,19 +303,11 @@ void BKE_mesh_calc_normals_poly(const MVert *mvert,
                                 int mpoly_len,
                                 float (*r_poly_normals)[3])
 {
-  TaskParallelSettings settings;
-  BLI_parallel_range_settings_defaults(&settings);
-  settings.min_iter_per_thread = 1024;
-
   BLI_assert((r_poly_normals != nullptr) || (mpoly_len == 0));
 
-  MeshCalcNormalsData_Poly data = {};
-  data.mpoly = mpoly;
-  data.mloop = mloop;
-  data.mvert = mvert;
-  data.pnors = r_poly_normals;
-
-  BLI_task_parallel_range(0, mpoly_len, &data, mesh_calc_normals_poly_fn, &settings);
+  blender::threading::parallel_for(IndexRange(mpoly_len), 1024, [&](const IndexRange range) {
+    mesh_calc_normals_poly_range(mvert, mloop, mpoly, range, r_poly_normals);
+  });
 }
 
 /** \} */
@@ -820,6 +920,7 @@ struct LoopSplitTaskDataCommon {
   const float (*polynors)[3];
   const float (*vert_normals)[3];
 
+  int numVerts;
   int numEdges;
   int numLoops;
   int numPolys;
@@ -1312,63 +1413,32 @@ static void loop_split_worker_do(LoopSplitTaskDataCommon *common_data,
   }
 }
 
-static void loop_split_worker(TaskPool *__restrict pool, void *taskdata)
-{
-  LoopSplitTaskDataCommon *common_data = (LoopSplitTaskDataCommon *)BLI_task_pool_user_data(pool);
-  LoopSplitTaskData *data = (LoopSplitTaskData *)taskdata;
-
-  /* Temp edge vectors stack, only used when computing lnor spacearr. */
-  BLI_Stack *edge_vectors = common_data->lnors_spacearr ?
-                                BLI_stack_new(sizeof(float[3]), __func__) :
-                                nullptr;
-
-#ifdef DEBUG_TIME
-  TIMEIT_START_AVERAGED(loop_split_worker);
-#endif
-
-  for (int i = 0; i < LOOP_SPLIT_TASK_BLOCK_SIZE; i++, data++) {
-    /* A nullptr ml_curr is used to tag ended data! */
-    if (data->ml_curr == nullptr) {
-      break;
-    }
-
-    loop_split_worker_do(common_data, data, edge_vectors);
-  }
-
-  if (edge_vectors) {
-    BLI_stack_free(edge_vectors);
-  }
-
-#ifdef DEBUG_TIME
-  TIMEIT_END_AVERAGED(loop_split_worker);
-#endif
-}
-
 /**
- * Check whether given loop is part of an unknown-so-far cyclic smooth fan, or not.
- * Needed because cyclic smooth fans have no obvious 'entry point',
- * and yet we need to walk them once, and only once.
+ * Walk around the smooth fan of a loop that doesn't use a sharp edge, and tag the loops that are
+ * walked over as visited. The walk stops at sharp edges and at loops that were visited before,
+ * because the rest of the fan was walked over already then.
+ *
+ * \return true when the fan is a cyclic smooth fan.
  */
-static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
-                                                         const MPoly *mpolys,
-                                                         const int (*edge_to_loops)[2],
-                                                         const int *loop_to_poly,
-                                                         const int *e2l_prev,
-                                                         BLI_bitmap *skip_loops,
-                                                         const MLoop *ml_curr,
-                                                         const MLoop *ml_prev,
-                                                         const int ml_curr_index,
-                                                         const int ml_prev_index,
-                                                         const int mp_curr_index)
+static bool loop_split_generator_walk_fan(const MLoop *mloops,
+                                          const MPoly *mpolys,
+                                          const int (*edge_to_loops)[2],
+                                          const int *loop_to_poly,
+                                          const int vert_loops_num,
+                                          const int ml_curr_index,
+                                          const int ml_prev_index,
+                                          const int mp_curr_index,
+                                          MutableSpan<bool> is_visited)
 {
-  const uint mv_pivot_index = ml_curr->v; /* The vertex we are "fanning" around! */
+  const MLoop *ml_prev = &mloops[ml_prev_index];
+  const uint mv_pivot_index = mloops[ml_curr_index].v; /* The vertex we are "fanning" around! */
   const int *e2lfan_curr;
   const MLoop *mlfan_curr;
   /* `mlfan_vert_index` the loop of our current edge might not be the loop of our current vertex!
    */
   int mlfan_curr_index, mlfan_vert_index, mpfan_curr_index;
 
-  e2lfan_curr = e2l_prev;
+  e2lfan_curr = edge_to_loops[ml_prev->e];
   if (IS_EDGE_SHARP(e2lfan_curr)) {
     /* Sharp loop, so not a cyclic smooth fan. */
     return false;
@@ -1383,10 +1453,8 @@ static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
   BLI_assert(mlfan_vert_index >= 0);
   BLI_assert(mpfan_curr_index >= 0);
 
-  BLI_assert(!BLI_BITMAP_TEST(skip_loops, mlfan_vert_index));
-  BLI_BITMAP_ENABLE(skip_loops, mlfan_vert_index);
-
-  while (true) {
+  /* A fan can not contain more loops than its vertex, this only guards against invalid meshes. */
+  for (int i = 0; i < vert_loops_num; i++) {
     /* Find next loop of the smooth fan. */
     BKE_mesh_loop_manifold_fan_around_vert_next(mloops,
                                                 mpolys,
@@ -1404,141 +1472,140 @@ static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
       /* Sharp loop/edge, so not a cyclic smooth fan. */
       return false;
     }
-    /* Smooth loop/edge. */
-    if (BLI_BITMAP_TEST(skip_loops, mlfan_vert_index)) {
-      if (mlfan_vert_index == ml_curr_index) {
-        /* We walked around a whole cyclic smooth fan without finding any already-processed loop,
-         * means we can use initial `ml_curr` / `ml_prev` edge as start for this smooth fan. */
-        return true;
-      }
-      /* Already checked in some previous looping, we can abort. */
+    if (mlfan_vert_index == ml_curr_index) {
+      /* We walked around a whole cyclic smooth fan, `ml_curr` / `ml_prev` edge is the start of
+       * this fan. */
+      return true;
+    }
+    if (mloops[mlfan_vert_index].v != mv_pivot_index || is_visited[mlfan_vert_index]) {
       return false;
     }
+    is_visited[mlfan_vert_index] = true;
+  }
+  return false;
+}
 
-    /* We can skip it in future, and keep checking the smooth fan. */
-    BLI_BITMAP_ENABLE(skip_loops, mlfan_vert_index);
+/**
+ * Find the loops that are the entry point of a smooth fan, or 'single' loops.
+ *
+ * Loops using a sharp edge start a fan. All other loops are part of such a fan, or of a cyclic
+ * smooth fan. Since cyclic smooth fans have no obvious 'entry point', their loop that comes first
+ * in polygon order is used (like a serial walk over all polygons would do).
+ *
+ * The loops around every vertex are checked in polygon order, and the fans are only walked over
+ * until a loop is reached that was visited before. That keeps the work linear in the number of
+ * loops of the vertex. Vertices are independent of each other, and the result does not depend on
+ * multi-threading.
+ */
+static void loop_split_generator_find_fan_starts(const LoopSplitTaskDataCommon &common_data,
+                                                 MutableSpan<bool> r_is_fan_start)
+{
+  const MLoop *mloops = common_data.mloops;
+  const MPoly *mpolys = common_data.mpolys;
+  const int *loop_to_poly = common_data.loop_to_poly;
+  const int(*edge_to_loops)[2] = common_data.edge_to_loops;
+  const int numVerts = common_data.numVerts;
+  const int numLoops = common_data.numLoops;
+  const int numPolys = common_data.numPolys;
+
+  /* Sort the loops by vertex, in polygon order. */
+  Array<int> vert_loop_offsets(numVerts + 1, 0);
+  for (const int mp_index : IndexRange(numPolys)) {
+    const MPoly &mp = mpolys[mp_index];
+    for (const int ml_index : IndexRange(mp.loopstart, mp.totloop)) {
+      vert_loop_offsets[mloops[ml_index].v + 1]++;
+    }
+  }
+  for (const int mv_index : IndexRange(numVerts)) {
+    vert_loop_offsets[mv_index + 1] += vert_loop_offsets[mv_index];
   }
+  Array<int> vert_loops(vert_loop_offsets.last());
+  Array<int> vert_loops_fill(vert_loop_offsets.as_span().drop_back(1));
+  for (const int mp_index : IndexRange(numPolys)) {
+    const MPoly &mp = mpolys[mp_index];
+    for (const int ml_index : IndexRange(mp.loopstart, mp.totloop)) {
+      vert_loops[vert_loops_fill[mloops[ml_index].v]++] = ml_index;
+    }
+  }
+
+  r_is_fan_start.fill(false);
+  /* Loops are only accessed by the task of their vertex. */
+  Array<bool> is_visited(numLoops, false);
+  blender::threading::parallel_for(IndexRange(numVerts), 1024, [&](const IndexRange range) {
+    for (const int mv_index : range) {
+      const IndexRange loops_range(vert_loop_offsets[mv_index],
+                                   vert_loop_offsets[mv_index + 1] - vert_loop_offsets[mv_index]);
+      const Span<int> loops = vert_loops.as_span().slice(loops_range);
+      for (const int ml_curr_index : loops) {
+        if (is_visited[ml_curr_index]) {
+          continue;
+        }
+        is_visited[ml_curr_index] = true;
+        if (IS_EDGE_SHARP(edge_to_loops[mloops[ml_curr_index].e])) {
+          r_is_fan_start[ml_curr_index] = true;
+          continue;
+        }
+        const int mp_index = loop_to_poly[ml_curr_index];
+        const MPoly &mp = mpolys[mp_index];
+        const int ml_prev_index = (ml_curr_index == mp.loopstart) ?
+                                      mp.loopstart + mp.totloop - 1 :
+                                      ml_curr_index - 1;
+        r_is_fan_start[ml_curr_index] = loop_split_generator_walk_fan(mloops,
+                                                                      mpolys,
+                                                                      edge_to_loops,
+                                                                      loop_to_poly,
+                                                                      int(loops.size()),
+                                                                      ml_curr_index,
+                                                                      ml_prev_index,
+                                                                      mp_index,
+                                                                      is_visited);
+      }
+    }
+  });
 }
 
-static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common_data)
+static void loop_split_generator(LoopSplitTaskDataCommon *common_data)
 {
   MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
   float(*loopnors)[3] = common_data->loopnors;
 
   const MLoop *mloops = common_data->mloops;
   const MPoly *mpolys = common_data->mpolys;
-  const int *loop_to_poly = common_data->loop_to_poly;
   const int(*edge_to_loops)[2] = common_data->edge_to_loops;
   const int numLoops = common_data->numLoops;
   const int numPolys = common_data->numPolys;
 
-  const MPoly *mp;
-  int mp_index;
-
-  const MLoop *ml_curr;
-  const MLoop *ml_prev;
-  int ml_curr_index;
-  int ml_prev_index;
-
-  BLI_bitmap *skip_loops = BLI_BITMAP_NEW(numLoops, __func__);
-
-  LoopSplitTaskData *data_buff = nullptr;
-  int data_idx = 0;
-
-  /* Temp edge vectors stack, only used when computing lnor spacearr
-   * (and we are not multi-threading). */
-  BLI_Stack *edge_vectors = nullptr;
-
 #ifdef DEBUG_TIME
   TIMEIT_START_AVERAGED(loop_split_generator);
 #endif
 
-  if (!pool) {
-    if (lnors_spacearr) {
-      edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
-    }
-  }
-
   /* We now know edges that can be smoothed (with their vector, and their two loops),
-   * and edges that will be hard! Now, time to generate the normals.
-   */
-  for (mp = mpolys, mp_index = 0; mp_index < numPolys; mp++, mp_index++) {
-    float(*lnors)[3];
+   * and edges that will be hard! First find the loops from which normals are generated,
+   * the loops around every vertex can be checked on their own. */
+  Array<bool> is_fan_start(numLoops);
+  loop_split_generator_find_fan_starts(*common_data, is_fan_start);
+
+  /* Gather the tasks in polygon order, this is also where lnor spaces are created since
+   * #MemArena is not thread-safe. */
+  Vector<LoopSplitTaskData> tasks;
+  for (int mp_index = 0; mp_index < numPolys; mp_index++) {
+    const MPoly *mp = &mpolys[mp_index];
     const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
-    ml_curr_index = mp->loopstart;
-    ml_prev_index = ml_last_index;
-
-    ml_curr = &mloops[ml_curr_index];
-    ml_prev = &mloops[ml_prev_index];
-    lnors = &loopnors[ml_curr_index];
-
-    for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++, lnors++) {
-      const int *e2l_curr = edge_to_loops[ml_curr->e];
-      const int *e2l_prev = edge_to_loops[ml_prev->e];
-
-#if 0
-      printf("Checking loop %d / edge %u / vert %u (sharp edge: %d, skiploop: %d)",
-             ml_curr_index,
-             ml_curr->e,
-             ml_curr->v,
-             IS_EDGE_SHARP(e2l_curr),
-             BLI_BITMAP_TEST_BOOL(skip_loops, ml_curr_index));
-#endif
-
-      /* A smooth edge, we have to check for cyclic smooth fan case.
-       * If we find a new, never-processed cyclic smooth fan, we can do it now using that loop/edge
-       * as 'entry point', otherwise we can skip it. */
-
-      /* NOTE: In theory, we could make #loop_split_generator_check_cyclic_smooth_fan() store
-       * mlfan_vert_index'es and edge indexes in two stacks, to avoid having to fan again around
-       * the vert during actual computation of `clnor` & `clnorspace`.
-       * However, this would complicate the code, add more memory usage, and despite its logical
-       * complexity, #loop_manifold_fan_around_vert_next() is quite cheap in term of CPU cycles,
-       * so really think it's not worth it. */
-      if (!IS_EDGE_SHARP(e2l_curr) && (BLI_BITMAP_TEST(skip_loops, ml_curr_index) ||
-                                       !loop_split_generator_check_cyclic_smooth_fan(mloops,
-                                                                                     mpolys,
-                                                                                     edge_to_loops,
-                                                                                     loop_to_poly,
-                                                                                     e2l_prev,
-                                                                                     skip_loops,
-                                                                                     ml_curr,
-                                                                                     ml_prev,
-                                                                                     ml_curr_index,
-                                                                                     ml_prev_index,
-                                                                                     mp_index))) {
-        // printf("SKIPPING!\n");
-      }
-      else {
-        LoopSplitTaskData *data, data_local;
-
-        // printf("PROCESSING!\n");
-
-        if (pool) {
-          if (data_idx == 0) {
-            data_buff = (LoopSplitTaskData *)MEM_calloc_arrayN(
-                LOOP_SPLIT_TASK_BLOCK_SIZE, sizeof(*data_buff), __func__);
-          }
-          data = &data_buff[data_idx];
-        }
-        else {
-          data = &data_local;
-          memset(data, 0, sizeof(*data));
-        }
-
+    int ml_prev_index = ml_last_index;
+    for (int ml_curr_index = mp->loopstart; ml_curr_index <= ml_last_index; ml_curr_index++) {
+      if (is_fan_start[ml_curr_index]) {
+        const MLoop *ml_curr = &mloops[ml_curr_index];
+        const MLoop *ml_prev = &mloops[ml_prev_index];
+        const int *e2l_curr = edge_to_loops[ml_curr->e];
+        const int *e2l_prev = edge_to_loops[ml_prev->e];
+
+        LoopSplitTaskData data = {nullptr};
         if (IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev)) {
-          data->lnor = lnors;
-          data->ml_curr = ml_curr;
-          data->ml_prev = ml_prev;
-          data->ml_curr_index = ml_curr_index;
-#if 0 /* Not needed for 'single' loop. */
-          data->ml_prev_index = ml_prev_index;
-          data->e2l_prev = nullptr; /* Tag as 'single' task. */
-#endif
-          data->mp_index = mp_index;
-          if (lnors_spacearr) {
-            data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-          }
+          data.lnor = &loopnors[ml_curr_index];
+          data.ml_curr = ml_curr;
+          data.ml_prev = ml_prev;
+          data.ml_curr_index = ml_curr_index;
+          data.mp_index = mp_index;
         }
         /* We *do not need* to check/tag loops as already computed!
          * Due to the fact a loop only links to one of its two edges,
@@ -1550,47 +1617,36 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
          * All this due/thanks to link between normals and loop ordering (i.e. winding).
          */
         else {
-#if 0 /* Not needed for 'fan' loops. */
-          data->lnor = lnors;
-#endif
-          data->ml_curr = ml_curr;
-          data->ml_prev = ml_prev;
-          data->ml_curr_index = ml_curr_index;
-          data->ml_prev_index = ml_prev_index;
-          data->e2l_prev = e2l_prev; /* Also tag as 'fan' task. */
-          data->mp_index = mp_index;
-          if (lnors_spacearr) {
-            data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-          }
+          data.ml_curr = ml_curr;
+          data.ml_prev = ml_prev;
+          data.ml_curr_index = ml_curr_index;
+          data.ml_prev_index = ml_prev_index;
+          data.e2l_prev = e2l_prev; /* Also tag as 'fan' task. */
+          data.mp_index = mp_index;
         }
-
-        if (pool) {
-          data_idx++;
-          if (data_idx == LOOP_SPLIT_TASK_BLOCK_SIZE) {
-            BLI_task_pool_push(pool, loop_split_worker, data_buff, true, nullptr);
-            data_idx = 0;
-          }
-        }
-        else {
-          loop_split_worker_do(common_data, data, edge_vectors);
+        if (lnors_spacearr) {
+          data.lnor_space = BKE_lnor_space_create(lnors_spacearr);
         }
+        tasks.append(data);
       }
-
-      ml_prev = ml_curr;
       ml_prev_index = ml_curr_index;
     }
   }
 
-  /* Last block of data. Since it is calloc'ed and we use first nullptr item as stopper,
-   * everything is fine. */
-  if (pool && data_idx) {
-    BLI_task_pool_push(pool, loop_split_worker, data_buff, true, nullptr);
-  }
-
-  if (edge_vectors) {
-    BLI_stack_free(edge_vectors);
-  }
-  MEM_freeN(skip_loops);
+  /* Two different fans *always* affect different loops, so they can be computed in parallel
+   * without any synchronization. */
+  blender::threading::parallel_for(
+      tasks.index_range(), LOOP_SPLIT_TASK_BLOCK_SIZE, [&](const IndexRange range) {
+        /* Temp edge vectors stack, only used when computing lnor spacearr. */
+        BLI_Stack *edge_vectors = lnors_spacearr ? BLI_stack_new(sizeof(float[3]), __func__) :
+                                                   nullptr;
+        for (const int i : range) {
+          loop_split_worker_do(common_data, &tasks[i], edge_vectors);
+        }
+        if (edge_vectors) {
+          BLI_stack_free(edge_vectors);
+        }
+      });
 
 #ifdef DEBUG_TIME
   TIMEIT_END_AVERAGED(loop_split_generator);
@@ -1599,7 +1655,7 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
 
 void BKE_mesh_normals_loop_split(const MVert *mverts,
                                  const float (*vert_normals)[3],
-                                 const int UNUSED(numVerts),
+                                 const int numVerts,
                                  MEdge *medges,
                                  const int numEdges,
                                  MLoop *mloops,
@@ -1700,6 +1756,7 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
   common_data.loop_to_poly = loop_to_poly;
   common_data.polynors = polynors;
   common_data.vert_normals = vert_normals;
+  common_data.numVerts = numVerts;
   common_data.numEdges = numEdges;
   common_data.numLoops = numLoops;
   common_data.numPolys = numPolys;
@@ -1707,19 +1764,7 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
   /* This first loop check which edges are actually smooth, and compute edge vectors. */
   mesh_edges_sharp_tag(&common_data, check_angle, split_angle, false);
 
-  if (numLoops < LOOP_SPLIT_TASK_BLOCK_SIZE * 8) {
-    /* Not enough loops to be worth the whole threading overhead. */
-    loop_split_generator(nullptr, &common_data);
-  }
-  else {
-    TaskPool *task_pool = BLI_task_pool_create(&common_data, TASK_PRIORITY_HIGH);
-
-    loop_split_generator(task_pool, &common_data);
-
-    BLI_task_pool_work_and_wait(task_pool);
-
-    BLI_task_pool_free(task_pool);
-  }
+  loop_split_generator(&common_data);
 
   MEM_freeN(edge_to_loops);
   if (!r_loop_to_poly) {
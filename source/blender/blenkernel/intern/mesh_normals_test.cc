@@ -0,0 +1,425 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bke
+ */
+
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+#include "BLI_math.h"
+#include "BLI_math_vec_types.hh"
+#include "BLI_math_vector.hh"
+#include "BLI_vector.hh"
+
+#include "DNA_meshdata_types.h"
+
+#include "BKE_mesh.h"
+
+#include "mikktspace.h"
+
+namespace blender::bke::tests {
+
+/**
+ * A bumpy grid of quads, some of which are split into triangles. Without sharp edges, its inner
+ * vertices have cyclic smooth fans.
+ */
+struct TestGrid {
+  Vector<MVert> verts;
+  Vector<MEdge> edges;
+  Vector<MLoop> loops;
+  Vector<MPoly> polys;
+  Vector<float2> uvs;
+};
+
+static TestGrid create_test_grid(const int size)
+{
+  TestGrid grid;
+  const int row_verts = size + 1;
+  for (const int y : IndexRange(row_verts)) {
+    for (const int x : IndexRange(row_verts)) {
+      MVert vert = {{0}};
+      vert.co[0] = float(x);
+      vert.co[1] = float(y);
+      vert.co[2] = sinf(float(x) * 0.7f) * cosf(float(y) * 0.5f) * 2.0f;
+      grid.verts.append(vert);
+    }
+  }
+  auto vert_index = [&](const int x, const int y) { return y * row_verts + x; };
+  auto add_edge = [&](const int v1, const int v2) {
+    MEdge edge = {0};
+    edge.v1 = v1;
+    edge.v2 = v2;
+    grid.edges.append(edge);
+    return int(grid.edges.size() - 1);
+  };
+  auto add_poly = [&](const Span<int> verts, const Span<int> edges) {
+    MPoly poly = {0};
+    poly.loopstart = int(grid.loops.size());
+    poly.totloop = int(verts.size());
+    poly.flag = ME_SMOOTH;
+    grid.polys.append(poly);
+    for (const int i : verts.index_range()) {
+      MLoop loop;
+      loop.v = verts[i];
+      loop.e = edges[i];
+      grid.loops.append(loop);
+      const MVert &vert = grid.verts[verts[i]];
+      grid.uvs.append(float2(vert.co[0], vert.co[1]) / float(size));
+    }
+  };
+
+  /* Edges along the X axis are indexed by row, edges along the Y axis by column. */
+  Array<int> edges_x(row_verts * size);
+  Array<int> edges_y(row_verts * size);
+  for (const int line : IndexRange(row_verts)) {
+    for (const int i : IndexRange(size)) {
+      edges_x[line * size + i] = add_edge(vert_index(i, line), vert_index(i + 1, line));
+      edges_y[line * size + i] = add_edge(vert_index(line, i), vert_index(line, i + 1));
+    }
+  }
+  for (const int y : IndexRange(size)) {
+    for (const int x : IndexRange(size)) {
+      const int v00 = vert_index(x, y);
+      const int v10 = vert_index(x + 1, y);
+      const int v11 = vert_index(x + 1, y + 1);
+      const int v01 = vert_index(x, y + 1);
+      const int e_bottom = edges_x[y * size + x];
+      const int e_top = edges_x[(y + 1) * size + x];
+      const int e_left = edges_y[x * size + y];
+      const int e_right = edges_y[(x + 1) * size + y];
+      if ((x + y) % 3 == 0) {
+        const int e_diagonal = add_edge(v00, v11);
+        add_poly({v00, v10, v11}, {e_bottom, e_right, e_diagonal});
+        add_poly({v00, v11, v01}, {e_diagonal, e_top, e_left});
+      }
+      else {
+        add_poly({v00, v10, v11, v01}, {e_bottom, e_right, e_top, e_left});
+      }
+    }
+  }
+  return grid;
+}
+
+static Array<float3> calc_poly_normals(const TestGrid &grid)
+{
+  Array<float3> poly_normals(grid.polys.size());
+  BKE_mesh_calc_normals_poly(grid.verts.data(),
+                             grid.verts.size(),
+                             grid.loops.data(),
+                             grid.loops.size(),
+                             grid.polys.data(),
+                             grid.polys.size(),
+                             reinterpret_cast<float(*)[3]>(poly_normals.data()));
+  return poly_normals;
+}
+
+static Array<float3> calc_loop_normals(TestGrid &grid,
+                                       const float split_angle,
+                                       Array<float3> *r_poly_normals = nullptr)
+{
+  Array<float3> poly_normals(grid.polys.size());
+  Array<float3> vert_normals(grid.verts.size());
+  BKE_mesh_calc_normals_poly_and_vertex(grid.verts.data(),
+                                        grid.verts.size(),
+                                        grid.loops.data(),
+                                        grid.loops.size(),
+                                        grid.polys.data(),
+                                        grid.polys.size(),
+                                        reinterpret_cast<float(*)[3]>(poly_normals.data()),
+                                        reinterpret_cast<float(*)[3]>(vert_normals.data()));
+  Array<float3> loop_normals(grid.loops.size());
+  BKE_mesh_normals_loop_split(grid.verts.data(),
+                              reinterpret_cast<const float(*)[3]>(vert_normals.data()),
+                              grid.verts.size(),
+                              grid.edges.data(),
+                              grid.edges.size(),
+                              grid.loops.data(),
+                              reinterpret_cast<float(*)[3]>(loop_normals.data()),
+                              grid.loops.size(),
+                              grid.polys.data(),
+                              reinterpret_cast<const float(*)[3]>(poly_normals.data()),
+                              grid.polys.size(),
+                              true,
+                              split_angle,
+                              nullptr,
+                              nullptr,
+                              nullptr);
+  if (r_poly_normals) {
+    *r_poly_normals = std::move(poly_normals);
+  }
+  return loop_normals;
+}
+
+TEST(mesh_normals, PolyNormalsMatchSingle)
+{
+  const TestGrid grid = create_test_grid(13);
+  const Array<float3> poly_normals = calc_poly_normals(grid);
+  for (const int i : grid.polys.index_range()) {
+    const MPoly &poly = grid.polys[i];
+    float3 expected;
+    BKE_mesh_calc_poly_normal(&poly, &grid.loops[poly.loopstart], grid.verts.data(), expected);
+    /* The batched calculation must give exactly the same result. */
+    EXPECT_EQ(poly_normals[i].x, expected.x);
+    EXPECT_EQ(poly_normals[i].y, expected.y);
+    EXPECT_EQ(poly_normals[i].z, expected.z);
+  }
+}
+
+TEST(mesh_normals, SplitNormalsSharp)
+{
+  TestGrid grid = create_test_grid(13);
+  /* Tag all edges but the diagonals as sharp, the loops of quads then use the quad's normal. */
+  for (MEdge &edge : grid.edges) {
+    const float *co1 = grid.verts[edge.v1].co;
+    const float *co2 = grid.verts[edge.v2].co;
+    if (co1[0] == co2[0] || co1[1] == co2[1]) {
+      edge.flag |= ME_SHARP;
+    }
+  }
+  Array<float3> poly_normals;
+  const Array<float3> loop_normals = calc_loop_normals(grid, float(M_PI), &poly_normals);
+  for (const int i : grid.polys.index_range()) {
+    const MPoly &poly = grid.polys[i];
+    if (poly.totloop != 4) {
+      continue;
+    }
+    for (const int loop : IndexRange(poly.loopstart, poly.totloop)) {
+      EXPECT_EQ(loop_normals[loop], poly_normals[i]);
+    }
+  }
+}
+
+TEST(mesh_normals, SplitNormalsSmooth)
+{
+  TestGrid grid = create_test_grid(13);
+  const Array<float3> loop_normals = calc_loop_normals(grid, float(M_PI));
+  /* Without sharp edges, all loops of a vertex are part of the same smooth fan. */
+  Array<float3> vert_loop_normals(grid.verts.size(), float3(0.0f));
+  for (const int loop : grid.loops.index_range()) {
+    const int vert = grid.loops[loop].v;
+    if (is_zero_v3(vert_loop_normals[vert])) {
+      vert_loop_normals[vert] = loop_normals[loop];
+    }
+    EXPECT_EQ(loop_normals[loop], vert_loop_normals[vert]);
+    EXPECT_NEAR(len_v3(loop_normals[loop]), 1.0f, 1e-6f);
+  }
+}
+
+/**
+ * A cone of triangles around a single vertex with a high valence (vertex 0). The spokes with the
+ * given indices are sharp.
+ */
+static TestGrid create_test_fan(const int size, const Span<int> sharp_spokes)
+{
+  TestGrid fan;
+  MVert center = {{0}};
+  center.co[2] = 1.0f;
+  fan.verts.append(center);
+  for (const int i : IndexRange(size)) {
+    const float angle = float(i) / float(size) * float(M_PI) * 2.0f;
+    MVert vert = {{0}};
+    vert.co[0] = cosf(angle);
+    vert.co[1] = sinf(angle);
+    vert.co[2] = sinf(angle * 5.0f) * 0.3f;
+    fan.verts.append(vert);
+  }
+  for (const int i : IndexRange(size)) {
+    MEdge spoke = {0};
+    spoke.v1 = 0;
+    spoke.v2 = i + 1;
+    if (sharp_spokes.contains(i)) {
+      spoke.flag |= ME_SHARP;
+    }
+    fan.edges.append(spoke);
+  }
+  for (const int i : IndexRange(size)) {
+    MEdge rim = {0};
+    rim.v1 = i + 1;
+    rim.v2 = (i + 1) % size + 1;
+    fan.edges.append(rim);
+  }
+  for (const int i : IndexRange(size)) {
+    MPoly poly = {0};
+    poly.loopstart = int(fan.loops.size());
+    poly.totloop = 3;
+    poly.flag = ME_SMOOTH;
+    fan.polys.append(poly);
+    const int next = (i + 1) % size;
+    fan.loops.append({0, uint(i)});
+    fan.loops.append({uint(i + 1), uint(size + i)});
+    fan.loops.append({uint(next + 1), uint(next)});
+  }
+  return fan;
+}
+
+TEST(mesh_normals, SplitNormalsHighValenceCyclic)
+{
+  TestGrid fan = create_test_fan(20000, {});
+  Array<float3> poly_normals;
+  const Array<float3> loop_normals = calc_loop_normals(fan, float(M_PI), &poly_normals);
+  /* All loops of the center form a single cyclic smooth fan. */
+  float3 expected(0.0f);
+  for (const int i : fan.polys.index_range()) {
+    const int loop = fan.polys[i].loopstart;
+    const float angle = angle_v3v3v3(
+        fan.verts[fan.loops[loop + 2].v].co, fan.verts[0].co, fan.verts[fan.loops[loop + 1].v].co);
+    expected += poly_normals[i] * angle;
+  }
+  expected = math::normalize(expected);
+  for (const int i : fan.polys.index_range()) {
+    const int loop = fan.polys[i].loopstart;
+    EXPECT_EQ(loop_normals[loop], loop_normals[0]);
+  }
+  /* The angles of such thin triangles are not precise in single precision. */
+  EXPECT_V3_NEAR(loop_normals[0], expected, 0.02f);
+}
+
+TEST(mesh_normals, SplitNormalsHighValenceSharp)
+{
+  const int size = 20000;
+  TestGrid fan = create_test_fan(size, {100, 7000, 15000});
+  const Array<float3> loop_normals = calc_loop_normals(fan, float(M_PI));
+  /* The sharp spokes split the loops of the center into three smooth fans, the last one wraps
+   * around the first polygon. */
+  auto fan_of_poly = [&](const int poly) {
+    if (poly >= 100 && poly < 7000) {
+      return 1;
+    }
+    if (poly >= 7000 && poly < 15000) {
+      return 2;
+    }
+    return 0;
+  };
+  const float3 fan_normals[3] = {loop_normals[fan.polys[0].loopstart],
+                                 loop_normals[fan.polys[100].loopstart],
+                                 loop_normals[fan.polys[7000].loopstart]};
+  EXPECT_NE(fan_normals[0], fan_normals[1]);
+  EXPECT_NE(fan_normals[1], fan_normals[2]);
+  EXPECT_NE(fan_normals[2], fan_normals[0]);
+  for (const int i : IndexRange(size)) {
+    const int loop = fan.polys[i].loopstart;
+    EXPECT_EQ(loop_normals[loop], fan_normals[fan_of_poly(i)]);
+    EXPECT_NEAR(len_v3(loop_normals[loop]), 1.0f, 1e-6f);
+  }
+}
+
+/* -------------------------------------------------------------------- */
+/** \name Mikktspace
+ * \{ */
+
+struct TestGridTangents {
+  const TestGrid *grid;
+  const float3 *loop_normals;
+  Array<float4> tangents;
+};
+
+static const TestGridTangents &get_tangent_data(const SMikkTSpaceContext *context)
+{
+  return *static_cast<const TestGridTangents *>(context->m_pUserData);
+}
+
+static int get_num_faces(const SMikkTSpaceContext *context)
+{
+  return int(get_tangent_data(context).grid->polys.size());
+}
+
+static int get_num_verts_of_face(const SMikkTSpaceContext *context, const int face)
+{
+  return get_tangent_data(context).grid->polys[face].totloop;
+}
+
+static int get_loop(const SMikkTSpaceContext *context, const int face, const int vert)
+{
+  return get_tangent_data(context).grid->polys[face].loopstart + vert;
+}
+
+static void get_position(const SMikkTSpaceContext *context,
+                         float r_co[3],
+                         const int face,
+                         const int vert)
+{
+  const TestGrid &grid = *get_tangent_data(context).grid;
+  copy_v3_v3(r_co, grid.verts[grid.loops[get_loop(context, face, vert)].v].co);
+}
+
+static void get_normal(const SMikkTSpaceContext *context,
+                       float r_no[3],
+                       const int face,
+                       const int vert)
+{
+  copy_v3_v3(r_no, get_tangent_data(context).loop_normals[get_loop(context, face, vert)]);
+}
+
+static void get_texture_coordinate(const SMikkTSpaceContext *context,
+                                   float r_uv[2],
+                                   const int face,
+                                   const int vert)
+{
+  copy_v2_v2(r_uv, get_tangent_data(context).grid->uvs[get_loop(context, face, vert)]);
+}
+
+static void set_tspace(const SMikkTSpaceContext *context,
+                       const float tangent[3],
+                       const float sign,
+                       const int face,
+                       const int vert)
+{
+  TestGridTangents &data = *static_cast<TestGridTangents *>(context->m_pUserData);
+  data.tangents[get_loop(context, face, vert)] = float4(tangent[0], tangent[1], tangent[2], sign);
+}
+
+/** Process single items in reverse order, to make sure the result does not depend on it. */
+static void reverse_parallel_for(void * /*parallel_user_data*/,
+                                 const int items_num,
+                                 SMikkTSpaceRangeFunc fn_range,
+                                 void *range_data)
+{
+  for (int i = items_num - 1; i >= 0; i--) {
+    fn_range(range_data, i, i + 1);
+  }
+}
+
+static Array<float4> calc_tangents(const TestGrid &grid,
+                                   const Span<float3> loop_normals,
+                                   const bool use_parallel)
+{
+  TestGridTangents data;
+  data.grid = &grid;
+  data.loop_normals = loop_normals.data();
+  data.tangents.reinitialize(grid.loops.size());
+
+  SMikkTSpaceInterface interface = {nullptr};
+  interface.m_getNumFaces = get_num_faces;
+  interface.m_getNumVerticesOfFace = get_num_verts_of_face;
+  interface.m_getPosition = get_position;
+  interface.m_getNormal = get_normal;
+  interface.m_getTexCoord = get_texture_coordinate;
+  interface.m_setTSpaceBasic = set_tspace;
+  SMikkTSpaceContext context = {nullptr};
+  context.m_pInterface = &interface;
+  context.m_pUserData = &data;
+
+  if (use_parallel) {
+    EXPECT_TRUE(genTangSpaceParallel(&context, 180.0f, reverse_parallel_for, nullptr));
+  }
+  else {
+    EXPECT_TRUE(genTangSpaceDefault(&context));
+  }
+  return data.tangents;
+}
+
+TEST(mesh_normals, MikktspaceParallelMatchesSerial)
+{
+  TestGrid grid = create_test_grid(13);
+  const Array<float3> loop_normals = calc_loop_normals(grid, DEG2RADF(30.0f));
+  const Array<float4> expected = calc_tangents(grid, loop_normals, false);
+  const Array<float4> tangents = calc_tangents(grid, loop_normals, true);
+  for (const int i : grid.loops.index_range()) {
+    EXPECT_EQ(tangents[i], expected[i]);
+  }
+}
+
+/** \} */
+
+}  // namespace blender::bke::tests
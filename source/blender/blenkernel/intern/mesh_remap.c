@@ -1561,6 +1561,7 @@ void BKE_mesh_remap_calc_loops_from_mesh(const int mode,
                                        2,
                                        6,
                                        0,
+                                       0,
                                        NULL,
                                        NULL);
         }
@@ -262,6 +262,17 @@ void BKE_mesh_runtime_clear_geometry(Mesh *mesh)
   BKE_shrinkwrap_discard_boundary_data(mesh);
 }
 
+void BKE_mesh_tag_coords_changed(Mesh *mesh)
+{
+  BKE_mesh_normals_tag_dirty(mesh);
+  bvhcache_tag_coords_changed(mesh->runtime.bvh_cache);
+}
+
+void BKE_mesh_tag_coords_changed_uniformly(Mesh *mesh)
+{
+  bvhcache_tag_coords_changed(mesh->runtime.bvh_cache);
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -29,6 +29,60 @@
 #include "atomic_ops.h"
 #include "mikktspace.h"
 
+/* -------------------------------------------------------------------- */
+/** \name Mikktspace Threading
+ * \{ */
+
+/* Number of triangles or groups handled by one task, small ranges are not worth the overhead. */
+#define MIKK_PARALLEL_CHUNK_SIZE 1024
+
+typedef struct MikkParallelForData {
+  SMikkTSpaceRangeFunc fn_range;
+  void *range_data;
+  int items_num;
+} MikkParallelForData;
+
+static void mikk_parallel_for_chunk_fn(void *__restrict userdata,
+                                       const int chunk,
+                                       const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const MikkParallelForData *data = (const MikkParallelForData *)userdata;
+  const int start = chunk * MIKK_PARALLEL_CHUNK_SIZE;
+  const int end = min_ii(start + MIKK_PARALLEL_CHUNK_SIZE, data->items_num);
+  data->fn_range(data->range_data, start, end);
+}
+
+/**
+ * Parallel-for callback for #genTangSpaceParallel. The result does not depend on the way the
+ * work is distributed, so it matches the single-threaded #genTangSpace exactly.
+ */
+static void mikk_parallel_for(void *UNUSED(parallel_user_data),
+                              const int items_num,
+                              SMikkTSpaceRangeFunc fn_range,
+                              void *range_data)
+{
+  MikkParallelForData data;
+  data.fn_range = fn_range;
+  data.range_data = range_data;
+  data.items_num = items_num;
+
+  const int chunks_num = (items_num + MIKK_PARALLEL_CHUNK_SIZE - 1) / MIKK_PARALLEL_CHUNK_SIZE;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  settings.use_threading = chunks_num > 1;
+  BLI_task_parallel_range(0, chunks_num, &data, mikk_parallel_for_chunk_fn, &settings);
+}
+
+static tbool mikk_gen_tangent_space(const SMikkTSpaceContext *context)
+{
+  /* Same angular threshold as #genTangSpaceDefault. */
+  return genTangSpaceParallel(context, 180.0f, mikk_parallel_for, NULL);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Mesh Tangent Calculations (Single Layer)
  * \{ */
@@ -145,7 +199,7 @@ void BKE_mesh_calc_loop_tangent_single_ex(const MVert *mverts,
   s_interface.m_setTSpaceBasic = set_tspace;
 
   /* 0 if failed */
-  if (genTangSpaceDefault(&s_context) == false) {
+  if (mikk_gen_tangent_space(&s_context) == false) {
     BKE_report(reports, RPT_ERROR, "Mikktspace failed to generate tangents for this mesh!");
   }
 }
@@ -442,7 +496,7 @@ static void DM_calc_loop_tangents_thread(TaskPool *__restrict UNUSED(pool), void
     sInterface.m_setTSpaceBasic = dm_ts_SetTSpace;
 
     /* 0 if failed */
-    genTangSpaceDefault(&sContext);
+    mikk_gen_tangent_space(&sContext);
   }
 }
 
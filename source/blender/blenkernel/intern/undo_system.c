@@ -27,6 +27,8 @@
 #include "BKE_main.h"
 #include "BKE_undo_system.h"
 
+#include "BLO_undofile.h"
+
 #include "MEM_guardedalloc.h"
 
 #define undo_stack _wm_undo_stack_disallow /* pass in as a variable always. */
@@ -958,7 +960,7 @@ void BKE_undosys_print(UndoStack *ustack)
          BLI_listbase_count(&ustack->steps));
   int index = 0;
   LISTBASE_FOREACH (UndoStep *, us, &ustack->steps) {
-    printf("[%c%c%c%c] %3d {%p} type='%s', name='%s'\n",
+    printf("[%c%c%c%c] %3d {%p} type='%s', name='%s', size=%zu\n",
            (us == ustack->step_active) ? '*' : ' ',
            us->is_applied ? '#' : ' ',
            (us == ustack->step_active_memfile) ? 'M' : ' ',
@@ -966,9 +968,18 @@ void BKE_undosys_print(UndoStack *ustack)
            index,
            (void *)us,
            us->type->name,
-           us->name);
+           us->name,
+           us->data_size);
     index++;
   }
+
+  int buffers_num;
+  size_t memory, memory_used;
+  BLO_memfile_memory_stats(&buffers_num, &memory, &memory_used);
+  printf("Global undo: %d unique buffers, size=%zu, memory=%zu (with compression)\n",
+         buffers_num,
+         memory,
+         memory_used);
 }
 
 /** \} */
@@ -0,0 +1,105 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ *
+ * A version of #DisjointSet that can be used from multiple threads at the same time. Instead of
+ * union by rank, the root with the larger index is always linked to the other root. That way the
+ * root of every set is its smallest element, independent of the order of the #join calls.
+ */
+
+#include <atomic>
+
+#include "BLI_array.hh"
+#include "BLI_task.hh"
+
+namespace blender {
+
+class AtomicDisjointSet {
+ private:
+  Array<std::atomic<int>> parents_;
+
+ public:
+  /**
+   * Create a new disjoint set with the given size. Initially, every element is in a separate set.
+   */
+  AtomicDisjointSet(const int size) : parents_(size)
+  {
+    BLI_assert(size >= 0);
+    threading::parallel_for(IndexRange(size), 4096, [&](const IndexRange range) {
+      for (const int i : range) {
+        parents_[i].store(i, std::memory_order_relaxed);
+      }
+    });
+  }
+
+  /**
+   * Join the sets containing elements x and y. Nothing happens when they have been in the same set
+   * before.
+   */
+  void join(int x, int y)
+  {
+    while (true) {
+      x = this->find_root(x);
+      y = this->find_root(y);
+
+      if (x == y) {
+        /* They are in the same set already. */
+        return;
+      }
+      if (x < y) {
+        std::swap(x, y);
+      }
+      /* Link the root with the larger index to the other root. This fails when another thread
+       * changed the parent of x since it was found as root, try again in that case. */
+      int expected = x;
+      if (parents_[x].compare_exchange_weak(expected, y, std::memory_order_acq_rel)) {
+        return;
+      }
+    }
+  }
+
+  /**
+   * Return true when x and y are in the same set.
+   */
+  bool in_same_set(int x, int y)
+  {
+    while (true) {
+      x = this->find_root(x);
+      y = this->find_root(y);
+      if (x == y) {
+        return true;
+      }
+      /* The sets may have been joined by another thread while searching the roots. They are
+       * separate if x is still a root. */
+      if (parents_[x].load(std::memory_order_acquire) == x) {
+        return false;
+      }
+    }
+  }
+
+  /**
+   * Find the element that represents the set containing x currently.
+   */
+  int find_root(int x)
+  {
+    while (true) {
+      const int parent = parents_[x].load(std::memory_order_acquire);
+      if (parent == x) {
+        return x;
+      }
+      /* Path halving: skip one element on the path, the parent of the parent is in the same set
+       * as x in any case. */
+      int grandparent = parents_[parent].load(std::memory_order_acquire);
+      if (grandparent != parent) {
+        int expected = parent;
+        parents_[x].compare_exchange_weak(expected, grandparent, std::memory_order_acq_rel);
+      }
+      x = grandparent;
+    }
+  }
+};
+
+}  // namespace blender
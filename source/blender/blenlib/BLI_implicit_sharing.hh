@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ *
+ * Implicit sharing allows multiple owners to use the same data without copying it. The data is
+ * only copied when one owner wants to modify it while it is still used by others (copy-on-write).
+ */
+
+#include <atomic>
+
+#include "BLI_assert.h"
+#include "BLI_utility_mixins.hh"
+
+/**
+ * Opaque type that can be referenced from C structs, e.g. in DNA. It is always a
+ * #blender::ImplicitSharingInfo.
+ */
+struct ImplicitSharingInfoHandle {
+};
+
+namespace blender {
+
+/**
+ * Counts the users of some shared data. The data is freed together with this object when the last
+ * user is removed. Data that has more than one user must not be modified.
+ */
+class ImplicitSharingInfo : public ImplicitSharingInfoHandle, NonCopyable, NonMovable {
+ private:
+  mutable std::atomic<int> users_;
+
+ public:
+  ImplicitSharingInfo(const int initial_users = 1) : users_(initial_users)
+  {
+  }
+
+  virtual ~ImplicitSharingInfo()
+  {
+    BLI_assert(this->is_mutable());
+  }
+
+  /** The only user of the data is allowed to modify it. */
+  bool is_mutable() const
+  {
+    return users_.load(std::memory_order_acquire) <= 1;
+  }
+
+  void user_add() const
+  {
+    users_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void user_remove() const
+  {
+    const int old_users = users_.fetch_sub(1, std::memory_order_acq_rel);
+    BLI_assert(old_users >= 1);
+    if (old_users == 1) {
+      const_cast<ImplicitSharingInfo *>(this)->delete_self_with_data();
+    }
+  }
+
+ private:
+  /** Free the shared data and this object. */
+  virtual void delete_self_with_data() = 0;
+};
+
+}  // namespace blender
@@ -81,6 +81,11 @@ enum {
   /* Use a priority queue to process nodes in the optimal order (for slow callbacks) */
   BVH_NEAREST_OPTIMAL_ORDER = (1 << 0),
 };
+enum {
+  /* Choose splits by the surface area heuristic, for trees that get many ray-casts or nearest
+   * queries. Building takes a bit longer than the default split at the median. */
+  BVH_BALANCE_SAH = (1 << 0),
+};
 enum {
   /* calculate IsectRayPrecalc data */
   BVH_RAYCAST_WATERTIGHT = (1 << 0),
@@ -109,6 +114,17 @@ typedef void (*BVHTree_RayCastCallback)(void *userdata,
  */
 typedef bool (*BVHTree_OverlapCallback)(void *userdata, int index_a, int index_b, int thread);
 
+/** Maximum number of points a #BVHTree_LeafPointsCallback can return. */
+#define BVH_LEAF_POINTS_MAX 4
+
+/**
+ * Callback to get the points of a leaf for #BLI_bvhtree_refit, like they were passed to
+ * #BLI_bvhtree_insert. Return the number of points.
+ */
+typedef int (*BVHTree_LeafPointsCallback)(void *userdata,
+                                          int index,
+                                          float r_co[BVH_LEAF_POINTS_MAX][3]);
+
 /**
  * Callback to range search query.
  */
@@ -154,6 +170,11 @@ void BLI_bvhtree_free(BVHTree *tree);
  */
 void BLI_bvhtree_insert(BVHTree *tree, int index, const float co[3], int numpoints);
 void BLI_bvhtree_balance(BVHTree *tree);
+/**
+ * \param flag: #BVH_BALANCE_SAH to use the surface area heuristic builder. It's only supported
+ * for k-DOP's that contain the x, y and z axis, other trees are balanced as usual.
+ */
+void BLI_bvhtree_balance_ex(BVHTree *tree, int flag);
 
 /**
  * Update: first update points/nodes, then call update_tree to refit the bounding volumes.
@@ -165,6 +186,19 @@ bool BLI_bvhtree_update_node(
  * Call #BLI_bvhtree_update_node() first for every node/point/triangle.
  */
 void BLI_bvhtree_update_tree(BVHTree *tree);
+/**
+ * Update the bounding volumes of all leafs and branches after the leafs moved, keeping the
+ * structure of the tree. This is much faster than building a new tree, but the tree gets worse
+ * when the leafs move relative to each other, see #BLI_bvhtree_surface_area_cost.
+ * \note The callback is called from multiple threads.
+ */
+void BLI_bvhtree_refit(BVHTree *tree, BVHTree_LeafPointsCallback callback, void *userdata);
+/**
+ * The expected cost of a ray-cast through the tree: the summed surface area of all branches,
+ * relative to the area of the root. Compare it with the cost after building the tree to decide
+ * when a refit tree should be built again.
+ */
+float BLI_bvhtree_surface_area_cost(const BVHTree *tree);
 
 /**
  * Use to check the total number of threads #BLI_bvhtree_overlap will use.
@@ -277,6 +311,24 @@ void BLI_bvhtree_ray_cast_all(BVHTree *tree,
                               BVHTree_RayCastCallback callback,
                               void *userdata);
 
+/**
+ * Cast many rays, with the same results as calling #BLI_bvhtree_ray_cast_ex for every ray.
+ * Rays with similar origins and the same direction signs traverse the tree together in packets,
+ * which loads every node once per packet and tests the packet against it with SIMD instructions.
+ *
+ * \param hits: One per ray, initialized like the `hit` argument of #BLI_bvhtree_ray_cast_ex.
+ * \note The callback is called from multiple threads.
+ */
+void BLI_bvhtree_ray_cast_batch(BVHTree *tree,
+                                const float (*co)[3],
+                                const float (*dir)[3],
+                                int rays_num,
+                                float radius,
+                                BVHTreeRayHit *hits,
+                                BVHTree_RayCastCallback callback,
+                                void *userdata,
+                                int flag);
+
 float BLI_bvhtree_bb_raycast(const float bv[6],
                              const float light_start[3],
                              const float light_end[3],
@@ -30,6 +30,11 @@ int BLI_kdtree_nd_(find_nearest)(const KDTree *tree,
                                  const float co[KD_DIMS],
                                  KDTreeNearest *r_nearest) ATTR_NONNULL(1, 2);
 
+void BLI_kdtree_nd_(find_nearest_batch)(const KDTree *tree,
+                                        const float (*co)[KD_DIMS],
+                                        uint co_len,
+                                        KDTreeNearest *r_nearest) ATTR_NONNULL(1, 2, 4);
+
 int BLI_kdtree_nd_(find_nearest_n)(const KDTree *tree,
                                    const float co[KD_DIMS],
                                    KDTreeNearest *r_nearest,
@@ -57,6 +62,12 @@ int BLI_kdtree_nd_(calc_duplicates_fast)(const KDTree *tree,
                                          float range,
                                          bool use_index_order,
                                          int *doubles);
+int BLI_kdtree_nd_(calc_duplicates_fast_step)(const KDTree *tree,
+                                              const float co[KD_DIMS],
+                                              int index,
+                                              float range,
+                                              int *duplicates) ATTR_NONNULL(1, 2, 5);
+void BLI_kdtree_nd_(indices_in_tree_order)(const KDTree *tree, int *r_indices) ATTR_NONNULL(1, 2);
 
 int BLI_kdtree_nd_(deduplicate)(KDTree *tree);
 
@@ -37,6 +37,14 @@ int incircle_fast(const double2 &a, const double2 &b, const double2 &c, const do
 int orient3d(const double3 &a, const double3 &b, const double3 &c, const double3 &d);
 int orient3d_fast(const double3 &a, const double3 &b, const double3 &c, const double3 &d);
 
+/**
+ * Return the sign #orient3d would give for the exact points that a, b, c and d approximate,
+ * if it can be decided from the approximations alone. Every approximate coordinate has to be
+ * within one unit in the last place of the exact one.
+ * Return 0 when the result is too close to zero to decide, the exact predicate is needed then.
+ */
+int filter_orient3d(const double3 &a, const double3 &b, const double3 &c, const double3 &d);
+
 int insphere(
     const double3 &a, const double3 &b, const double3 &c, const double3 &d, const double3 &e);
 int insphere_fast(
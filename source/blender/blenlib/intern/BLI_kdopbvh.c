@@ -28,6 +28,7 @@
 #include "BLI_heap_simple.h"
 #include "BLI_kdopbvh.h"
 #include "BLI_math.h"
+#include "BLI_simd.h"
 #include "BLI_stack.h"
 #include "BLI_task.h"
 #include "BLI_utildefines.h"
@@ -847,6 +848,544 @@ static void non_recursive_bvh_div_nodes(const BVHTree *tree,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name SAH Builder
+ *
+ * Optional top-down build that chooses the split of every node with the surface area heuristic
+ * (SAH), evaluated for a fixed number of bins of the leaf centers along the x, y and z axis.
+ * Splitting at the median of the largest axis creates large overlapping nodes on meshes with
+ * unevenly sized or distributed elements, which makes ray-casts and nearest queries slower.
+ *
+ * The builder works on a compact copy of the leaf bounding boxes that is partitioned in-place,
+ * so every node owns a contiguous range of leafs. A binary tree is built first, stored in
+ * pre-order: a node with N leafs is followed by the N - 1 nodes of its sub-trees. That way the
+ * index of every node is known without synchronization, and sub-trees are built in parallel.
+ *
+ * The binary tree is converted to the final branches afterwards, opening the children with the
+ * largest area until a branch has `tree_type` children. Branches are stored in breadth-first
+ * order, so all children of a branch are next to each other in memory.
+ * \{ */
+
+/** Number of bins per axis that the leaf centers are sorted into to evaluate the SAH. */
+#define BVH_SAH_BINS 16
+
+typedef struct BVHSAHLeaf {
+  float min[3], max[3];
+  BVHNode *node;
+} BVHSAHLeaf;
+
+typedef struct BVHSAHNode {
+  float min[3], max[3];
+  /** The leafs of the node, the second child starts at `leafs_split`. */
+  int leafs_begin, leafs_end, leafs_split;
+  /** Axis used to split this node. */
+  char main_axis;
+} BVHSAHNode;
+
+typedef struct BVHSAHBuilder {
+  const BVHTree *tree;
+  BVHSAHLeaf *leafs;
+  /** The binary tree, one node less than there are leafs. */
+  BVHSAHNode *nodes;
+
+  /** Binary node of every branch, and the branch of every binary node that is kept. */
+  int *branch_nodes;
+  int *node_branches;
+} BVHSAHBuilder;
+
+typedef struct BVHSAHBounds {
+  float min[3], max[3];
+  float center_min[3], center_max[3];
+} BVHSAHBounds;
+
+typedef struct BVHSAHBin {
+  int count;
+  float min[3], max[3];
+} BVHSAHBin;
+
+typedef struct BVHSAHBins {
+  BVHSAHBin bins[3][BVH_SAH_BINS];
+} BVHSAHBins;
+
+typedef struct BVHSAHSplitData {
+  const BVHSAHLeaf *leafs;
+  float center_min[3];
+  float center_scale[3];
+} BVHSAHSplitData;
+
+typedef struct BVHSAHTask {
+  int node_index;
+  int leafs_begin, leafs_end;
+} BVHSAHTask;
+
+BLI_INLINE float bvh_sah_leaf_center(const BVHSAHLeaf *leaf, const int axis)
+{
+  return (leaf->min[axis] + leaf->max[axis]) * 0.5f;
+}
+
+BLI_INLINE int bvh_sah_bin_index(const BVHSAHSplitData *data,
+                                 const BVHSAHLeaf *leaf,
+                                 const int axis)
+{
+  const int bin = (int)((bvh_sah_leaf_center(leaf, axis) - data->center_min[axis]) *
+                        data->center_scale[axis]);
+  return min_ii(max_ii(bin, 0), BVH_SAH_BINS - 1);
+}
+
+BLI_INLINE void bvh_sah_box_init(float min[3], float max[3])
+{
+  copy_v3_fl(min, FLT_MAX);
+  copy_v3_fl(max, -FLT_MAX);
+}
+
+BLI_INLINE void bvh_sah_box_join(float min[3],
+                                 float max[3],
+                                 const float other_min[3],
+                                 const float other_max[3])
+{
+  for (int i = 0; i < 3; i++) {
+    min[i] = min_ff(min[i], other_min[i]);
+    max[i] = max_ff(max[i], other_max[i]);
+  }
+}
+
+/** Half the surface area of a box, which is enough to compare costs. */
+BLI_INLINE float bvh_sah_box_half_area(const float min[3], const float max[3])
+{
+  const float x = max[0] - min[0];
+  const float y = max[1] - min[1];
+  const float z = max[2] - min[2];
+  return x * y + y * z + z * x;
+}
+
+static void bvh_sah_leafs_task_cb(void *__restrict userdata,
+                                  const int i,
+                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BVHSAHBuilder *builder = userdata;
+  BVHSAHLeaf *leaf = &builder->leafs[i];
+  BVHNode *node = builder->tree->nodes[i];
+
+  for (int axis = 0; axis < 3; axis++) {
+    leaf->min[axis] = node->bv[2 * axis];
+    leaf->max[axis] = node->bv[(2 * axis) + 1];
+  }
+  leaf->node = node;
+}
+
+static void bvh_sah_bounds_task_cb(void *__restrict userdata,
+                                   const int i,
+                                   const TaskParallelTLS *__restrict tls)
+{
+  const BVHSAHSplitData *data = userdata;
+  BVHSAHBounds *bounds = tls->userdata_chunk;
+  const BVHSAHLeaf *leaf = &data->leafs[i];
+
+  bvh_sah_box_join(bounds->min, bounds->max, leaf->min, leaf->max);
+  for (int axis = 0; axis < 3; axis++) {
+    const float center = bvh_sah_leaf_center(leaf, axis);
+    bounds->center_min[axis] = min_ff(bounds->center_min[axis], center);
+    bounds->center_max[axis] = max_ff(bounds->center_max[axis], center);
+  }
+}
+
+static void bvh_sah_bounds_reduce(const void *__restrict UNUSED(userdata),
+                                  void *__restrict chunk_join,
+                                  void *__restrict chunk)
+{
+  BVHSAHBounds *join = chunk_join;
+  const BVHSAHBounds *bounds = chunk;
+  bvh_sah_box_join(join->min, join->max, bounds->min, bounds->max);
+  bvh_sah_box_join(join->center_min, join->center_max, bounds->center_min, bounds->center_max);
+}
+
+static void bvh_sah_bins_task_cb(void *__restrict userdata,
+                                 const int i,
+                                 const TaskParallelTLS *__restrict tls)
+{
+  const BVHSAHSplitData *data = userdata;
+  BVHSAHBins *bins = tls->userdata_chunk;
+  const BVHSAHLeaf *leaf = &data->leafs[i];
+
+  for (int axis = 0; axis < 3; axis++) {
+    BVHSAHBin *bin = &bins->bins[axis][bvh_sah_bin_index(data, leaf, axis)];
+    bin->count++;
+    bvh_sah_box_join(bin->min, bin->max, leaf->min, leaf->max);
+  }
+}
+
+static void bvh_sah_bins_reduce(const void *__restrict UNUSED(userdata),
+                                void *__restrict chunk_join,
+                                void *__restrict chunk)
+{
+  BVHSAHBins *join = chunk_join;
+  const BVHSAHBins *bins = chunk;
+
+  for (int axis = 0; axis < 3; axis++) {
+    for (int i = 0; i < BVH_SAH_BINS; i++) {
+      BVHSAHBin *bin = &join->bins[axis][i];
+      bin->count += bins->bins[axis][i].count;
+      bvh_sah_box_join(bin->min, bin->max, bins->bins[axis][i].min, bins->bins[axis][i].max);
+    }
+  }
+}
+
+static void bvh_sah_range_settings(TaskParallelSettings *settings, const int leafs_num)
+{
+  BLI_parallel_range_settings_defaults(settings);
+  settings->use_threading = (leafs_num > KDOPBVH_THREAD_LEAF_THRESHOLD);
+  settings->min_iter_per_thread = 1024;
+}
+
+/**
+ * Find the split with the lowest SAH cost between two bins.
+ * \return False when all leaf centers are in the same bin on every axis.
+ */
+static bool bvh_sah_find_split(const BVHSAHBins *bins, int *r_axis, int *r_bin)
+{
+  float best_cost = FLT_MAX;
+  *r_axis = -1;
+
+  for (int axis = 0; axis < 3; axis++) {
+    const BVHSAHBin *axis_bins = bins->bins[axis];
+
+    /* Area and number of leafs on the right side of a split before every bin. */
+    float right_area[BVH_SAH_BINS];
+    int right_count[BVH_SAH_BINS];
+    float min[3], max[3];
+    int count = 0;
+    bvh_sah_box_init(min, max);
+    for (int i = BVH_SAH_BINS - 1; i > 0; i--) {
+      count += axis_bins[i].count;
+      bvh_sah_box_join(min, max, axis_bins[i].min, axis_bins[i].max);
+      right_area[i] = (count > 0) ? bvh_sah_box_half_area(min, max) : 0.0f;
+      right_count[i] = count;
+    }
+
+    count = 0;
+    bvh_sah_box_init(min, max);
+    for (int i = 1; i < BVH_SAH_BINS; i++) {
+      count += axis_bins[i - 1].count;
+      bvh_sah_box_join(min, max, axis_bins[i - 1].min, axis_bins[i - 1].max);
+      if (count == 0 || right_count[i] == 0) {
+        continue;
+      }
+      const float cost = bvh_sah_box_half_area(min, max) * (float)count +
+                         right_area[i] * (float)right_count[i];
+      if (cost < best_cost) {
+        best_cost = cost;
+        *r_axis = axis;
+        *r_bin = i;
+      }
+    }
+  }
+
+  return *r_axis != -1;
+}
+
+/** Move the leafs with centers in the bins before `split_bin` to the front of the range. */
+static int bvh_sah_partition(
+    const BVHSAHSplitData *data, BVHSAHLeaf *leafs, int begin, int end, int axis, int split_bin)
+{
+  int i = begin, j = end - 1;
+  while (true) {
+    while (i <= j && bvh_sah_bin_index(data, &leafs[i], axis) < split_bin) {
+      i++;
+    }
+    while (i <= j && bvh_sah_bin_index(data, &leafs[j], axis) >= split_bin) {
+      j--;
+    }
+    if (i >= j) {
+      return i;
+    }
+    SWAP(BVHSAHLeaf, leafs[i], leafs[j]);
+    i++;
+    j--;
+  }
+}
+
+/**
+ * Compute the bounds of a binary node and partition its leafs.
+ * \return The first leaf of the second child.
+ */
+static int bvh_sah_split_node(BVHSAHBuilder *builder, const int node_index, int begin, int end)
+{
+  BVHSAHNode *node = &builder->nodes[node_index];
+  BVHSAHSplitData data = {.leafs = builder->leafs};
+
+  TaskParallelSettings settings;
+  bvh_sah_range_settings(&settings, end - begin);
+
+  BVHSAHBounds bounds;
+  bvh_sah_box_init(bounds.min, bounds.max);
+  bvh_sah_box_init(bounds.center_min, bounds.center_max);
+  settings.userdata_chunk = &bounds;
+  settings.userdata_chunk_size = sizeof(bounds);
+  settings.func_reduce = bvh_sah_bounds_reduce;
+  BLI_task_parallel_range(begin, end, &data, bvh_sah_bounds_task_cb, &settings);
+
+  copy_v3_v3(node->min, bounds.min);
+  copy_v3_v3(node->max, bounds.max);
+  copy_v3_v3(data.center_min, bounds.center_min);
+  for (int axis = 0; axis < 3; axis++) {
+    const float extent = bounds.center_max[axis] - bounds.center_min[axis];
+    data.center_scale[axis] = (extent > 0.0f) ? (float)BVH_SAH_BINS / extent : 0.0f;
+  }
+
+  BVHSAHBins bins;
+  for (int axis = 0; axis < 3; axis++) {
+    for (int i = 0; i < BVH_SAH_BINS; i++) {
+      bins.bins[axis][i].count = 0;
+      bvh_sah_box_init(bins.bins[axis][i].min, bins.bins[axis][i].max);
+    }
+  }
+  settings.userdata_chunk = &bins;
+  settings.userdata_chunk_size = sizeof(bins);
+  settings.func_reduce = bvh_sah_bins_reduce;
+  BLI_task_parallel_range(begin, end, &data, bvh_sah_bins_task_cb, &settings);
+
+  int split_axis, split_bin, split;
+  if (bvh_sah_find_split(&bins, &split_axis, &split_bin)) {
+    split = bvh_sah_partition(&data, builder->leafs, begin, end, split_axis, split_bin);
+    node->main_axis = (char)split_axis;
+  }
+  else {
+    /* All leaf centers are at the same position, any split is as good as another. */
+    split = (begin + end) / 2;
+    node->main_axis = 0;
+  }
+
+  node->leafs_begin = begin;
+  node->leafs_end = end;
+  node->leafs_split = split;
+  return split;
+}
+
+static void bvh_sah_build_task(TaskPool *__restrict pool, void *taskdata);
+
+static void bvh_sah_build_subtree(
+    BVHSAHBuilder *builder, TaskPool *pool, int node_index, int begin, int end)
+{
+  /* Continue with the larger child in this loop and recurse into the smaller one,
+   * so the recursion depth stays logarithmic, even with degenerate splits. */
+  while (end - begin > 1) {
+    const int split = bvh_sah_split_node(builder, node_index, begin, end);
+
+    BVHSAHTask small;
+    if (split - begin < end - split) {
+      small = (BVHSAHTask){node_index + 1, begin, split};
+      node_index += split - begin;
+      begin = split;
+    }
+    else {
+      small = (BVHSAHTask){node_index + (split - begin), split, end};
+      node_index += 1;
+      end = split;
+    }
+
+    const int small_leafs_num = small.leafs_end - small.leafs_begin;
+    if (small_leafs_num < 2) {
+      continue;
+    }
+    if (pool && small_leafs_num > KDOPBVH_THREAD_LEAF_THRESHOLD) {
+      BVHSAHTask *task = MEM_mallocN(sizeof(*task), __func__);
+      *task = small;
+      BLI_task_pool_push(pool, bvh_sah_build_task, task, true, NULL);
+    }
+    else {
+      bvh_sah_build_subtree(builder, pool, small.node_index, small.leafs_begin, small.leafs_end);
+    }
+  }
+}
+
+static void bvh_sah_build_task(TaskPool *__restrict pool, void *taskdata)
+{
+  BVHSAHBuilder *builder = BLI_task_pool_user_data(pool);
+  const BVHSAHTask *task = taskdata;
+  bvh_sah_build_subtree(builder, pool, task->node_index, task->leafs_begin, task->leafs_end);
+}
+
+/** Children of a binary node: indices of binary nodes, or `-1 - leaf_index` for single leafs. */
+static void bvh_sah_node_split_children(const BVHSAHBuilder *builder,
+                                        const int node_index,
+                                        int r_children[2])
+{
+  const BVHSAHNode *node = &builder->nodes[node_index];
+  const int left_num = node->leafs_split - node->leafs_begin;
+  const int right_num = node->leafs_end - node->leafs_split;
+  r_children[0] = (left_num > 1) ? node_index + 1 : -1 - node->leafs_begin;
+  r_children[1] = (right_num > 1) ? node_index + left_num : -1 - node->leafs_split;
+}
+
+/**
+ * Children of the branch created from a binary node. The child with the largest area is opened
+ * until there are `tree_type` children, this keeps the order of the leafs along the split axes.
+ */
+static int bvh_sah_node_children(const BVHSAHBuilder *builder,
+                                 const int node_index,
+                                 int r_children[MAX_TREETYPE])
+{
+  int children_num = 2;
+  bvh_sah_node_split_children(builder, node_index, r_children);
+
+  while (children_num < builder->tree->tree_type) {
+    int open_index = -1;
+    float open_area = -1.0f;
+    for (int i = 0; i < children_num; i++) {
+      if (r_children[i] >= 0) {
+        const BVHSAHNode *child = &builder->nodes[r_children[i]];
+        const float area = bvh_sah_box_half_area(child->min, child->max);
+        if (area > open_area) {
+          open_index = i;
+          open_area = area;
+        }
+      }
+    }
+    if (open_index == -1) {
+      break;
+    }
+    memmove(&r_children[open_index + 2],
+            &r_children[open_index + 1],
+            sizeof(int) * (size_t)(children_num - open_index - 1));
+    bvh_sah_node_split_children(builder, r_children[open_index], &r_children[open_index]);
+    children_num++;
+  }
+  return children_num;
+}
+
+/**
+ * Make sure there is space for the given number of leafs and branches. Every branch of the
+ * implicit tree is full, so with tree types larger than two, a SAH tree can need more.
+ */
+static void bvhtree_nodes_ensure(BVHTree *tree, const int numnodes)
+{
+  const int numnodes_old = (int)(MEM_allocN_len(tree->nodearray) / sizeof(BVHNode));
+  if (numnodes <= numnodes_old) {
+    return;
+  }
+
+  BVHNode *nodearray = MEM_callocN(sizeof(BVHNode) * (size_t)numnodes, "BVHNodeArray");
+  memcpy(nodearray, tree->nodearray, sizeof(BVHNode) * (size_t)numnodes_old);
+  for (int i = 0; i < tree->leaf_num; i++) {
+    tree->nodes[i] = nodearray + (tree->nodes[i] - tree->nodearray);
+  }
+  MEM_freeN(tree->nodearray);
+  tree->nodearray = nodearray;
+
+  tree->nodes = MEM_recallocN(tree->nodes, sizeof(BVHNode *) * (size_t)numnodes);
+  tree->nodebv = MEM_recallocN(tree->nodebv, sizeof(float) * (size_t)(tree->axis * numnodes));
+  tree->nodechild = MEM_recallocN(tree->nodechild,
+                                  sizeof(BVHNode *) * (size_t)(tree->tree_type * numnodes));
+
+  for (int i = 0; i < numnodes; i++) {
+    tree->nodearray[i].bv = &tree->nodebv[i * tree->axis];
+    tree->nodearray[i].children = &tree->nodechild[i * tree->tree_type];
+  }
+}
+
+typedef struct BVHSAHBranchesData {
+  BVHTree *tree;
+  const BVHSAHBuilder *builder;
+} BVHSAHBranchesData;
+
+static void bvh_sah_branches_task_cb(void *__restrict userdata,
+                                     const int i,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const BVHSAHBranchesData *data = userdata;
+  BVHTree *tree = data->tree;
+  const BVHSAHBuilder *builder = data->builder;
+  const int node_index = builder->branch_nodes[i];
+  BVHNode *branch = &tree->nodearray[tree->leaf_num + i];
+
+  int children[MAX_TREETYPE];
+  const int children_num = bvh_sah_node_children(builder, node_index, children);
+  for (int k = 0; k < children_num; k++) {
+    BVHNode *child = (children[k] >= 0) ?
+                         &tree->nodearray[tree->leaf_num + builder->node_branches[children[k]]] :
+                         tree->nodes[-1 - children[k]];
+    branch->children[k] = child;
+    child->parent = branch;
+  }
+  branch->node_num = (char)children_num;
+  branch->main_axis = builder->nodes[node_index].main_axis;
+}
+
+/**
+ * Build the branches of a tree with at least two leafs.
+ * \return The number of branches.
+ */
+static int bvh_sah_build(BVHTree *tree)
+{
+  const int leafs_num = tree->leaf_num;
+  const int nodes_num = leafs_num - 1;
+
+  BVHSAHBuilder builder = {
+      .tree = tree,
+      .leafs = MEM_mallocN(sizeof(BVHSAHLeaf) * (size_t)leafs_num, __func__),
+      .nodes = MEM_mallocN(sizeof(BVHSAHNode) * (size_t)nodes_num, __func__),
+      .branch_nodes = MEM_mallocN(sizeof(int) * (size_t)nodes_num, __func__),
+      .node_branches = MEM_mallocN(sizeof(int) * (size_t)nodes_num, __func__),
+  };
+
+  TaskParallelSettings settings;
+  bvh_sah_range_settings(&settings, leafs_num);
+  BLI_task_parallel_range(0, leafs_num, &builder, bvh_sah_leafs_task_cb, &settings);
+
+  if (leafs_num > KDOPBVH_THREAD_LEAF_THRESHOLD) {
+    TaskPool *pool = BLI_task_pool_create(&builder, TASK_PRIORITY_HIGH);
+    bvh_sah_build_subtree(&builder, pool, 0, 0, leafs_num);
+    BLI_task_pool_work_and_wait(pool);
+    BLI_task_pool_free(pool);
+  }
+  else {
+    bvh_sah_build_subtree(&builder, NULL, 0, 0, leafs_num);
+  }
+
+  for (int i = 0; i < leafs_num; i++) {
+    tree->nodes[i] = builder.leafs[i].node;
+  }
+
+  /* Decide which binary nodes become branches, in breadth-first order. */
+  int branch_num = 1;
+  builder.branch_nodes[0] = 0;
+  builder.node_branches[0] = 0;
+  for (int i = 0; i < branch_num; i++) {
+    int children[MAX_TREETYPE];
+    const int children_num = bvh_sah_node_children(&builder, builder.branch_nodes[i], children);
+    for (int k = 0; k < children_num; k++) {
+      if (children[k] >= 0) {
+        builder.node_branches[children[k]] = branch_num;
+        builder.branch_nodes[branch_num++] = children[k];
+      }
+    }
+  }
+
+  bvhtree_nodes_ensure(tree, leafs_num + branch_num);
+
+  BVHSAHBranchesData data = {
+      .tree = tree,
+      .builder = &builder,
+  };
+  BLI_task_parallel_range(0, branch_num, &data, bvh_sah_branches_task_cb, &settings);
+  tree->nodearray[leafs_num].parent = NULL;
+
+  /* The binary nodes only have the x, y and z axis, join the bounding volumes of all axes
+   * bottom-up. Children are always stored after their parent. */
+  for (int i = branch_num - 1; i >= 0; i--) {
+    node_join(tree, &tree->nodearray[leafs_num + i]);
+  }
+
+  MEM_freeN(builder.leafs);
+  MEM_freeN(builder.nodes);
+  MEM_freeN(builder.branch_nodes);
+  MEM_freeN(builder.node_branches);
+
+  return branch_num;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree API
  * \{ */
@@ -934,7 +1473,7 @@ void BLI_bvhtree_free(BVHTree *tree)
   }
 }
 
-void BLI_bvhtree_balance(BVHTree *tree)
+void BLI_bvhtree_balance_ex(BVHTree *tree, const int flag)
 {
   BVHNode **leafs_array = tree->nodes;
 
@@ -942,13 +1481,19 @@ void BLI_bvhtree_balance(BVHTree *tree)
    * (some big bug goes here if its being called more than once per tree) */
   BLI_assert(tree->branch_num == 0);
 
-  /* Build the implicit tree */
-  non_recursive_bvh_div_nodes(
-      tree, tree->nodearray + (tree->leaf_num - 1), leafs_array, tree->leaf_num);
+  /* The SAH is evaluated on the x, y and z axis, which only exist when starting at axis zero. */
+  if ((flag & BVH_BALANCE_SAH) && (tree->leaf_num > 1) && (tree->start_axis == 0)) {
+    tree->branch_num = bvh_sah_build(tree);
+  }
+  else {
+    /* Build the implicit tree */
+    non_recursive_bvh_div_nodes(
+        tree, tree->nodearray + (tree->leaf_num - 1), leafs_array, tree->leaf_num);
+    tree->branch_num = implicit_needed_branches(tree->tree_type, tree->leaf_num);
+  }
 
   /* current code expects the branches to be linked to the nodes array
    * we perform that linkage here */
-  tree->branch_num = implicit_needed_branches(tree->tree_type, tree->leaf_num);
   for (int i = 0; i < tree->branch_num; i++) {
     tree->nodes[tree->leaf_num + i] = &tree->nodearray[tree->leaf_num + i];
   }
@@ -966,6 +1511,11 @@ void BLI_bvhtree_balance(BVHTree *tree)
 #endif
 }
 
+void BLI_bvhtree_balance(BVHTree *tree)
+{
+  BLI_bvhtree_balance_ex(tree, 0);
+}
+
 static void bvhtree_node_inflate(const BVHTree *tree, BVHNode *node, const float dist)
 {
   axis_t axis_iter;
@@ -1064,6 +1614,134 @@ void BLI_bvhtree_get_bounding_box(BVHTree *tree, float r_bb_min[3], float r_bb_m
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name BLI_bvhtree_refit
+ *
+ * Update the bounding volumes of a tree whose leafs moved, keeping the structure of the tree.
+ * The tree is split into independent subtrees that are refit in parallel, the branches above
+ * them are joined afterwards.
+ * \{ */
+
+/** Split the tree until there are at least this many subtrees to refit in parallel. */
+#define BVH_REFIT_SUBTREES_MIN 256
+
+typedef struct BVHRefitData {
+  BVHTree *tree;
+  BVHNode **subtrees;
+  BVHTree_LeafPointsCallback callback;
+  void *userdata;
+} BVHRefitData;
+
+static void bvhtree_refit_subtree(const BVHRefitData *data, BVHNode *node)
+{
+  BVHTree *tree = data->tree;
+  if (node->node_num == 0) {
+    float co[BVH_LEAF_POINTS_MAX][3];
+    const int points_num = data->callback(data->userdata, node->index, co);
+    BLI_assert(points_num > 0 && points_num <= BVH_LEAF_POINTS_MAX);
+    create_kdop_hull(tree, node, co[0], points_num, 0);
+    bvhtree_node_inflate(tree, node, tree->epsilon);
+    return;
+  }
+  for (int i = 0; i < node->node_num; i++) {
+    bvhtree_refit_subtree(data, node->children[i]);
+  }
+  node_join(tree, node);
+}
+
+static void bvhtree_refit_task_cb(void *__restrict userdata,
+                                  const int i,
+                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const BVHRefitData *data = (const BVHRefitData *)userdata;
+  bvhtree_refit_subtree(data, data->subtrees[i]);
+}
+
+void BLI_bvhtree_refit(BVHTree *tree, BVHTree_LeafPointsCallback callback, void *userdata)
+{
+  if (tree->leaf_num == 0) {
+    return;
+  }
+
+  /* Walk the tree breadth first until there are enough subtrees. Splitting stops at leafs, they
+   * are refit as subtrees of their own. */
+  const int subtrees_max = BVH_REFIT_SUBTREES_MIN * tree->tree_type;
+  BVHNode **subtrees = MEM_malloc_arrayN((size_t)subtrees_max, sizeof(BVHNode *), __func__);
+  BVHNode **subtrees_next = MEM_malloc_arrayN((size_t)subtrees_max, sizeof(BVHNode *), __func__);
+  BVHNode **top = MEM_malloc_arrayN((size_t)tree->branch_num, sizeof(BVHNode *), __func__);
+  int subtrees_num = 1;
+  int top_num = 0;
+  subtrees[0] = tree->nodes[tree->leaf_num];
+
+  bool has_branches = true;
+  while (subtrees_num < BVH_REFIT_SUBTREES_MIN && has_branches) {
+    int subtrees_next_num = 0;
+    has_branches = false;
+    for (int i = 0; i < subtrees_num; i++) {
+      BVHNode *node = subtrees[i];
+      if (node->node_num == 0) {
+        subtrees_next[subtrees_next_num++] = node;
+        continue;
+      }
+      top[top_num++] = node;
+      for (int j = 0; j < node->node_num; j++) {
+        subtrees_next[subtrees_next_num++] = node->children[j];
+        has_branches |= node->children[j]->node_num > 0;
+      }
+    }
+    SWAP(BVHNode **, subtrees, subtrees_next);
+    subtrees_num = subtrees_next_num;
+  }
+
+  BVHRefitData data = {
+      .tree = tree,
+      .subtrees = subtrees,
+      .callback = callback,
+      .userdata = userdata,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = tree->leaf_num > KDOPBVH_THREAD_LEAF_THRESHOLD;
+  BLI_task_parallel_range(0, subtrees_num, &data, bvhtree_refit_task_cb, &settings);
+
+  /* Parents come before their children in breadth first order. */
+  for (int i = top_num - 1; i >= 0; i--) {
+    node_join(tree, top[i]);
+  }
+
+  MEM_freeN(subtrees);
+  MEM_freeN(subtrees_next);
+  MEM_freeN(top);
+}
+
+float BLI_bvhtree_surface_area_cost(const BVHTree *tree)
+{
+  const BVHNode *root = tree->leaf_num ? tree->nodes[tree->leaf_num] : NULL;
+  if (root == NULL) {
+    return 0.0f;
+  }
+
+  /* Use the first three axes of the k-DOP, which are x, y and z for most trees. */
+  const axis_t axis = tree->start_axis;
+  float sum = 0.0f;
+  float root_area = 0.0f;
+  for (int i = 0; i < tree->branch_num; i++) {
+    const float *bv = tree->nodes[tree->leaf_num + i]->bv + 2 * axis;
+    const float x = bv[1] - bv[0];
+    const float y = bv[3] - bv[2];
+    const float z = bv[5] - bv[4];
+    const float area = x * y + y * z + z * x;
+    sum += area;
+    if (i == 0) {
+      root_area = area;
+    }
+  }
+  return (root_area > 0.0f) ? sum / root_area : 1.0f;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree_overlap
  * \{ */
@@ -2026,6 +2704,331 @@ void BLI_bvhtree_ray_cast_all(BVHTree *tree,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name BLI_bvhtree_ray_cast_batch
+ *
+ * Rays are sorted by the signs of their direction and the Morton code of their origin, and cast
+ * in packets of consecutive rays with the same signs. All rays of a packet traverse the tree
+ * together, every ray only tests the nodes that it would test when cast on its own, in the same
+ * order. So the results are the same as with #BLI_bvhtree_ray_cast_ex, but every node is loaded
+ * once per packet, and the ray/box tests of a packet run in parallel with SIMD instructions.
+ * \{ */
+
+#define BVH_RAYCAST_PACKET_SIZE 4
+
+/** Number of bits of every coordinate of the Morton code of ray origins. */
+#define BVH_RAYCAST_MORTON_BITS 9
+
+typedef struct BVHRayCastPacket {
+  BVHRayCastData rays[BVH_RAYCAST_PACKET_SIZE];
+  int rays_num;
+  /** Copy of the hit distances of all rays, for loading them at once. */
+  float hit_dist[BVH_RAYCAST_PACKET_SIZE];
+#ifdef BLI_HAVE_SSE2
+  __m128 origin[3];
+  __m128 idot_axis[3];
+#endif
+} BVHRayCastPacket;
+
+typedef struct BVHRayCastBatchData {
+  BVHTree *tree;
+  const float (*co)[3];
+  const float (*dir)[3];
+  float radius;
+  BVHTreeRayHit *hits;
+  BVHTree_RayCastCallback callback;
+  void *userdata;
+  int flag;
+
+  /** Ray indices sorted by #bvhtree_ray_cast_batch_keys, and the first ray of every packet. */
+  const int *sorted_rays;
+  const int *packet_offsets;
+} BVHRayCastBatchData;
+
+/**
+ * Compute the distance to the node for all rays in the mask.
+ * \return The mask of rays that hit the node before their current hit.
+ */
+static int packet_ray_nearest_hit(const BVHRayCastPacket *packet,
+                                  const BVHNode *node,
+                                  const int mask,
+                                  float r_dist[BVH_RAYCAST_PACKET_SIZE])
+{
+#ifdef BLI_HAVE_SSE2
+  if (packet->rays[0].ray.radius == 0.0f) {
+    /* Same as #fast_ray_nearest_hit, the direction signs and with that `index` are the same for
+     * all rays of the packet. */
+    const float *bv = node->bv;
+    const int *index = packet->rays[0].index;
+    __m128 t1[3], t2[3];
+    for (int i = 0; i < 3; i++) {
+      t1[i] = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bv[index[2 * i]]), packet->origin[i]),
+                         packet->idot_axis[i]);
+      t2[i] = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bv[index[2 * i + 1]]), packet->origin[i]),
+                         packet->idot_axis[i]);
+    }
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 hit_dist = _mm_loadu_ps(packet->hit_dist);
+
+    __m128 miss = _mm_or_ps(_mm_cmpgt_ps(t1[0], t2[1]), _mm_cmplt_ps(t2[0], t1[1]));
+    miss = _mm_or_ps(miss, _mm_or_ps(_mm_cmpgt_ps(t1[0], t2[2]), _mm_cmplt_ps(t2[0], t1[2])));
+    miss = _mm_or_ps(miss, _mm_or_ps(_mm_cmpgt_ps(t1[1], t2[2]), _mm_cmplt_ps(t2[1], t1[2])));
+    miss = _mm_or_ps(miss, _mm_or_ps(_mm_cmplt_ps(t2[0], zero), _mm_cmplt_ps(t2[1], zero)));
+    miss = _mm_or_ps(miss, _mm_or_ps(_mm_cmplt_ps(t2[2], zero), _mm_cmpgt_ps(t1[0], hit_dist)));
+    miss = _mm_or_ps(miss, _mm_cmpgt_ps(t1[1], hit_dist));
+    miss = _mm_or_ps(miss, _mm_cmpgt_ps(t1[2], hit_dist));
+
+    __m128 dist = _mm_max_ps(_mm_max_ps(t1[0], t1[1]), t1[2]);
+    dist = _mm_or_ps(_mm_and_ps(miss, _mm_set1_ps(FLT_MAX)), _mm_andnot_ps(miss, dist));
+    _mm_storeu_ps(r_dist, dist);
+    return _mm_movemask_ps(_mm_cmplt_ps(dist, hit_dist)) & mask;
+  }
+#endif
+
+  int hit_mask = 0;
+  for (int i = 0; i < packet->rays_num; i++) {
+    if (mask & (1 << i)) {
+      const BVHRayCastData *data = &packet->rays[i];
+      r_dist[i] = (data->ray.radius == 0.0f) ? fast_ray_nearest_hit(data, node) :
+                                               ray_nearest_hit(data, node->bv);
+      if (r_dist[i] < data->hit.dist) {
+        hit_mask |= 1 << i;
+      }
+    }
+  }
+  return hit_mask;
+}
+
+static void dfs_raycast_packet(BVHRayCastPacket *packet, const BVHNode *node, int mask)
+{
+  float dist[BVH_RAYCAST_PACKET_SIZE];
+  mask = packet_ray_nearest_hit(packet, node, mask, dist);
+  if (mask == 0) {
+    return;
+  }
+
+  if (node->node_num == 0) {
+    for (int i = 0; i < packet->rays_num; i++) {
+      if (mask & (1 << i)) {
+        BVHRayCastData *data = &packet->rays[i];
+        if (data->callback) {
+          data->callback(data->userdata, node->index, &data->ray, &data->hit);
+        }
+        else {
+          data->hit.index = node->index;
+          data->hit.dist = dist[i];
+          madd_v3_v3v3fl(data->hit.co, data->ray.origin, data->ray.direction, dist[i]);
+        }
+        packet->hit_dist[i] = data->hit.dist;
+      }
+    }
+  }
+  else {
+    /* All rays of the packet have the same direction signs, so they'd all choose this order. */
+    if (packet->rays[0].ray_dot_axis[node->main_axis] > 0.0f) {
+      for (int i = 0; i != node->node_num; i++) {
+        dfs_raycast_packet(packet, node->children[i], mask);
+      }
+    }
+    else {
+      for (int i = node->node_num - 1; i >= 0; i--) {
+        dfs_raycast_packet(packet, node->children[i], mask);
+      }
+    }
+  }
+}
+
+/**
+ * Rays get the same key when #bvhtree_ray_cast_data_precalc gives the same traversal order
+ * and the same `index` for the ray/box test.
+ */
+static uint bvhtree_ray_cast_direction_key(const float dir[3])
+{
+  uint key = 0;
+  for (int i = 0; i < 3; i++) {
+    const float dot = dot_v3v3(dir, bvhtree_kdop_axes[i]);
+    const uint sign = (fabsf(dot) < FLT_EPSILON) ? 0 : ((dot > 0.0f) ? 1 : 2);
+    key = key * 3 + sign;
+  }
+  return key;
+}
+
+/** Spread the lower bits of the value, so that there are two zero bits between them. */
+static uint bvhtree_morton_spread_bits(uint x)
+{
+  x = (x | (x << 16)) & 0x030000FF;
+  x = (x | (x << 8)) & 0x0300F00F;
+  x = (x | (x << 4)) & 0x030C30C3;
+  x = (x | (x << 2)) & 0x09249249;
+  return x;
+}
+
+/**
+ * Sort the rays by their direction key first and by the Morton code of their origin in the
+ * bounds of the tree second, so that packets contain rays that traverse similar nodes.
+ */
+static void bvhtree_ray_cast_batch_sort(const BVHTree *tree,
+                                        const float (*co)[3],
+                                        const float (*dir)[3],
+                                        const int rays_num,
+                                        int *r_sorted_rays)
+{
+  const float *root_bv = tree->nodes[tree->leaf_num]->bv;
+  const uint cells_num = 1u << BVH_RAYCAST_MORTON_BITS;
+  float scale[3];
+  for (int i = 0; i < 3; i++) {
+    const float size = root_bv[2 * i + 1] - root_bv[2 * i];
+    scale[i] = (size > 0.0f) ? (float)cells_num / size : 0.0f;
+  }
+
+  uint *keys = MEM_mallocN(sizeof(uint) * (size_t)rays_num, __func__);
+  uint *keys_tmp = MEM_mallocN(sizeof(uint) * (size_t)rays_num, __func__);
+  int *rays = r_sorted_rays;
+  int *rays_tmp = MEM_mallocN(sizeof(int) * (size_t)rays_num, __func__);
+
+  for (int i = 0; i < rays_num; i++) {
+    uint morton = 0;
+    for (int axis = 0; axis < 3; axis++) {
+      const float cell = (co[i][axis] - root_bv[2 * axis]) * scale[axis];
+      const uint cell_clamped = (cell > 0.0f) ? min_uu((uint)cell, cells_num - 1) : 0;
+      morton |= bvhtree_morton_spread_bits(cell_clamped) << axis;
+    }
+    keys[i] = (bvhtree_ray_cast_direction_key(dir[i]) << (3 * BVH_RAYCAST_MORTON_BITS)) |
+              morton;
+    rays[i] = i;
+  }
+
+  /* Radix sort, one byte of the key at a time. */
+  for (int shift = 0; shift < 32; shift += 8) {
+    int offsets[257] = {0};
+    for (int i = 0; i < rays_num; i++) {
+      offsets[((keys[i] >> shift) & 0xFF) + 1]++;
+    }
+    for (int i = 0; i < 256; i++) {
+      offsets[i + 1] += offsets[i];
+    }
+    for (int i = 0; i < rays_num; i++) {
+      const int dst = offsets[(keys[i] >> shift) & 0xFF]++;
+      keys_tmp[dst] = keys[i];
+      rays_tmp[dst] = rays[i];
+    }
+    SWAP(uint *, keys, keys_tmp);
+    SWAP(int *, rays, rays_tmp);
+  }
+  /* After an even number of passes, the sorted rays are in the given array again. */
+  BLI_assert(rays == r_sorted_rays);
+
+  MEM_freeN(keys);
+  MEM_freeN(keys_tmp);
+  MEM_freeN(rays_tmp);
+}
+
+static void bvhtree_ray_cast_batch_task_cb(void *__restrict userdata,
+                                           const int packet_index,
+                                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const BVHRayCastBatchData *batch = userdata;
+  const int *rays = &batch->sorted_rays[batch->packet_offsets[packet_index]];
+
+  BVHRayCastPacket packet;
+  packet.rays_num = batch->packet_offsets[packet_index + 1] -
+                    batch->packet_offsets[packet_index];
+
+  for (int i = 0; i < packet.rays_num; i++) {
+    BVHRayCastData *data = &packet.rays[i];
+    data->tree = batch->tree;
+    data->callback = batch->callback;
+    data->userdata = batch->userdata;
+    copy_v3_v3(data->ray.origin, batch->co[rays[i]]);
+    copy_v3_v3(data->ray.direction, batch->dir[rays[i]]);
+    data->ray.radius = batch->radius;
+    bvhtree_ray_cast_data_precalc(data, batch->flag);
+    data->hit = batch->hits[rays[i]];
+    packet.hit_dist[i] = data->hit.dist;
+  }
+  /* Unused lanes get copies of the last ray, they are masked out. */
+  for (int i = packet.rays_num; i < BVH_RAYCAST_PACKET_SIZE; i++) {
+    packet.hit_dist[i] = packet.hit_dist[packet.rays_num - 1];
+  }
+
+#ifdef BLI_HAVE_SSE2
+  for (int axis = 0; axis < 3; axis++) {
+    float origin[BVH_RAYCAST_PACKET_SIZE], idot_axis[BVH_RAYCAST_PACKET_SIZE];
+    for (int i = 0; i < BVH_RAYCAST_PACKET_SIZE; i++) {
+      const BVHRayCastData *data = &packet.rays[min_ii(i, packet.rays_num - 1)];
+      origin[i] = data->ray.origin[axis];
+      idot_axis[i] = data->idot_axis[axis];
+    }
+    packet.origin[axis] = _mm_loadu_ps(origin);
+    packet.idot_axis[axis] = _mm_loadu_ps(idot_axis);
+  }
+#endif
+
+  const BVHNode *root = batch->tree->nodes[batch->tree->leaf_num];
+  dfs_raycast_packet(&packet, root, (1 << packet.rays_num) - 1);
+
+  for (int i = 0; i < packet.rays_num; i++) {
+    batch->hits[rays[i]] = packet.rays[i].hit;
+  }
+}
+
+void BLI_bvhtree_ray_cast_batch(BVHTree *tree,
+                                const float (*co)[3],
+                                const float (*dir)[3],
+                                const int rays_num,
+                                const float radius,
+                                BVHTreeRayHit *hits,
+                                BVHTree_RayCastCallback callback,
+                                void *userdata,
+                                const int flag)
+{
+  if (rays_num == 0 || tree->leaf_num == 0) {
+    return;
+  }
+
+  int *sorted_rays = MEM_mallocN(sizeof(int) * (size_t)rays_num, __func__);
+  bvhtree_ray_cast_batch_sort(tree, co, dir, rays_num, sorted_rays);
+
+  /* Split the sorted rays into packets, a packet only contains rays with the same key. */
+  int *packet_offsets = MEM_mallocN(sizeof(int) * (size_t)(rays_num + 1), __func__);
+  int packets_num = 0;
+  uint packet_key = UINT_MAX;
+  int packet_size = 0;
+  for (int i = 0; i < rays_num; i++) {
+    const uint key = bvhtree_ray_cast_direction_key(dir[sorted_rays[i]]);
+    if (key != packet_key || packet_size == BVH_RAYCAST_PACKET_SIZE) {
+      packet_offsets[packets_num++] = i;
+      packet_key = key;
+      packet_size = 0;
+    }
+    packet_size++;
+  }
+  packet_offsets[packets_num] = rays_num;
+
+  BVHRayCastBatchData batch = {
+      .tree = tree,
+      .co = co,
+      .dir = dir,
+      .radius = radius,
+      .hits = hits,
+      .callback = callback,
+      .userdata = userdata,
+      .flag = flag,
+      .sorted_rays = sorted_rays,
+      .packet_offsets = packet_offsets,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 16;
+  BLI_task_parallel_range(0, packets_num, &batch, bvhtree_ray_cast_batch_task_cb, &settings);
+
+  MEM_freeN(sorted_rays);
+  MEM_freeN(packet_offsets);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree_range_query
  *
@@ -8,6 +8,7 @@
 
 #include "BLI_kdtree_impl.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_strict_flags.h"
 #include "BLI_utildefines.h"
 
@@ -42,6 +43,11 @@ struct KDTree {
 #define KD_NEAR_ALLOC_INC 100 /* alloc increment for collecting nearest */
 #define KD_FOUND_ALLOC_INC 50 /* alloc increment for collecting nearest */
 
+/** Sub-trees with fewer nodes are balanced in the task that partitioned their parent. */
+#define KD_BALANCE_TASK_MIN 8192
+/** Number of query points that traverse the tree together in batched queries. */
+#define KD_BATCH_SIZE 8
+
 #define KD_NODE_UNSET ((uint)-1)
 
 /**
@@ -131,7 +137,29 @@ void BLI_kdtree_nd_(insert)(KDTree *tree, int index, const float co[KD_DIMS])
 #endif
 }
 
-static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const uint ofs)
+/**
+ * Index of the root of a sub-tree after balancing, the median is always chosen as root.
+ */
+static uint kdtree_balance_root(const uint nodes_len, const uint ofs)
+{
+  return nodes_len ? (nodes_len / 2) + ofs : KD_NODE_UNSET;
+}
+
+typedef struct KDTreeBalanceTask {
+  KDTreeNode *nodes;
+  uint nodes_len;
+  uint axis;
+  uint ofs;
+} KDTreeBalanceTask;
+
+static void kdtree_balance_task_fn(TaskPool *__restrict pool, void *taskdata);
+
+/**
+ * \param pool: When not null, large sub-trees are balanced in separate tasks.
+ * Sub-trees are stored in separate ranges of \a nodes, so they can be balanced independently.
+ */
+static uint kdtree_balance(
+    TaskPool *pool, KDTreeNode *nodes, uint nodes_len, uint axis, const uint ofs)
 {
   KDTreeNode *node;
   float co;
@@ -180,13 +208,32 @@ static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const u
   node = &nodes[median];
   node->d = axis;
   axis = (axis + 1) % KD_DIMS;
-  node->left = kdtree_balance(nodes, median, axis, ofs);
-  node->right = kdtree_balance(
-      nodes + median + 1, (nodes_len - (median + 1)), axis, (median + 1) + ofs);
 
+  const uint right_len = nodes_len - (median + 1);
+  if (pool != NULL && right_len >= KD_BALANCE_TASK_MIN) {
+    KDTreeBalanceTask *task = MEM_mallocN(sizeof(*task), __func__);
+    task->nodes = nodes + median + 1;
+    task->nodes_len = right_len;
+    task->axis = axis;
+    task->ofs = (median + 1) + ofs;
+    BLI_task_pool_push(pool, kdtree_balance_task_fn, task, true, NULL);
+    node->right = kdtree_balance_root(right_len, (median + 1) + ofs);
+  }
+  else {
+    node->right = kdtree_balance(pool, nodes + median + 1, right_len, axis, (median + 1) + ofs);
+  }
+  node->left = kdtree_balance(pool, nodes, median, axis, ofs);
+
+  BLI_assert(node->left == kdtree_balance_root(median, ofs));
   return median + ofs;
 }
 
+static void kdtree_balance_task_fn(TaskPool *__restrict pool, void *taskdata)
+{
+  const KDTreeBalanceTask *task = taskdata;
+  kdtree_balance(pool, task->nodes, task->nodes_len, task->axis, task->ofs);
+}
+
 void BLI_kdtree_nd_(balance)(KDTree *tree)
 {
   if (tree->root != KD_NODE_ROOT_IS_INIT) {
@@ -196,7 +243,17 @@ void BLI_kdtree_nd_(balance)(KDTree *tree)
     }
   }
 
-  tree->root = kdtree_balance(tree->nodes, tree->nodes_len, 0, 0);
+  if (tree->nodes_len >= KD_BALANCE_TASK_MIN * 2) {
+    /* The nodes are partitioned the same way as in the single threaded case,
+     * so the resulting tree doesn't depend on the number of threads. */
+    TaskPool *pool = BLI_task_pool_create(NULL, TASK_PRIORITY_HIGH);
+    tree->root = kdtree_balance(pool, tree->nodes, tree->nodes_len, 0, 0);
+    BLI_task_pool_work_and_wait(pool);
+    BLI_task_pool_free(pool);
+  }
+  else {
+    tree->root = kdtree_balance(NULL, tree->nodes, tree->nodes_len, 0, 0);
+  }
 
 #ifdef DEBUG
   tree->is_balanced = true;
@@ -318,6 +375,226 @@ int BLI_kdtree_nd_(find_nearest)(const KDTree *tree,
   return min_node->index;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name BLI_kdtree_3d_find_nearest_batch
+ * \{ */
+
+struct NearestBatchParams {
+  const KDTree *tree;
+  const float (*co)[KD_DIMS];
+  uint co_len;
+  /** Query point indices, sorted so that consecutive points are close to each other. */
+  uint *order;
+  /** The leaf node that contains every query point. */
+  uint *leaves;
+  KDTreeNearest *r_nearest;
+};
+
+/**
+ * Find the nearest nodes of up to #KD_BATCH_SIZE query points with a single traversal.
+ * A node is visited when it may be the nearest node of any of the query points.
+ * Distances are computed for all query points at once, in loops that the compiler can vectorize.
+ */
+static void kdtree_find_nearest_batch(const KDTree *tree,
+                                      const float (*co)[KD_DIMS],
+                                      const uint *leaves,
+                                      const uint *indices,
+                                      const uint indices_len,
+                                      KDTreeNearest *r_nearest)
+{
+  const KDTreeNode *nodes = tree->nodes;
+  uint *stack, stack_default[KD_STACK_INIT];
+  uint stack_len_capacity, cur = 0;
+
+  /* Coordinates of the query points per axis. Unused lanes repeat the last query point. */
+  float batch_co[KD_DIMS][KD_BATCH_SIZE];
+  float min_dist[KD_BATCH_SIZE];
+  uint min_node[KD_BATCH_SIZE];
+  for (uint i = 0; i < KD_BATCH_SIZE; i++) {
+    const uint index = indices[MIN2(i, indices_len - 1)];
+    for (uint j = 0; j < KD_DIMS; j++) {
+      batch_co[j][i] = co[index][j];
+    }
+    /* The leaf is usually close to the query point, starting with it allows skipping most of
+     * the tree. */
+    min_node[i] = leaves[index];
+    min_dist[i] = len_squared_vnvn(nodes[min_node[i]].co, co[index]);
+  }
+
+  stack = stack_default;
+  stack_len_capacity = ARRAY_SIZE(stack_default);
+
+  stack[cur++] = tree->root;
+
+  while (cur--) {
+    const uint node_index = stack[cur];
+    const KDTreeNode *node = &nodes[node_index];
+    const uint d = node->d;
+
+    float dist[KD_BATCH_SIZE] = {0.0f};
+    for (uint j = 0; j < KD_DIMS; j++) {
+      for (uint i = 0; i < KD_BATCH_SIZE; i++) {
+        dist[i] += square_f(node->co[j] - batch_co[j][i]);
+      }
+    }
+
+    /* Count query points on each side of the splitting plane,
+     * and check which sides may contain nodes closer than the current nearest nodes. */
+    uint left_len = 0;
+    bool use_left = false, use_right = false;
+    for (uint i = 0; i < KD_BATCH_SIZE; i++) {
+      if (dist[i] < min_dist[i]) {
+        min_dist[i] = dist[i];
+        min_node[i] = node_index;
+      }
+      const float plane_dist = node->co[d] - batch_co[d][i];
+      const bool is_left = plane_dist >= 0.0f;
+      const bool use_far_side = square_f(plane_dist) < min_dist[i];
+      left_len += is_left;
+      use_left |= is_left || use_far_side;
+      use_right |= !is_left || use_far_side;
+    }
+
+    /* Push the side with most query points last, so that it is visited first. */
+    if (left_len * 2 >= KD_BATCH_SIZE) {
+      if (use_right && node->right != KD_NODE_UNSET) {
+        stack[cur++] = node->right;
+      }
+      if (use_left && node->left != KD_NODE_UNSET) {
+        stack[cur++] = node->left;
+      }
+    }
+    else {
+      if (use_left && node->left != KD_NODE_UNSET) {
+        stack[cur++] = node->left;
+      }
+      if (use_right && node->right != KD_NODE_UNSET) {
+        stack[cur++] = node->right;
+      }
+    }
+    if (UNLIKELY(cur + KD_DIMS > stack_len_capacity)) {
+      stack = realloc_nodes(stack, &stack_len_capacity, stack_default != stack);
+    }
+  }
+
+  for (uint i = 0; i < indices_len; i++) {
+    const KDTreeNode *node = &nodes[min_node[i]];
+    KDTreeNearest *nearest = &r_nearest[indices[i]];
+    nearest->index = node->index;
+    nearest->dist = sqrtf(min_dist[i]);
+    copy_vn_vn(nearest->co, node->co);
+  }
+
+  if (stack != stack_default) {
+    MEM_freeN(stack);
+  }
+}
+
+static void kdtree_find_nearest_batch_cb(void *__restrict userdata,
+                                         const int iter,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const struct NearestBatchParams *p = userdata;
+  const uint start = (uint)iter * KD_BATCH_SIZE;
+  kdtree_find_nearest_batch(p->tree,
+                            p->co,
+                            p->leaves,
+                            p->order + start,
+                            MIN2((uint)KD_BATCH_SIZE, p->co_len - start),
+                            p->r_nearest);
+}
+
+/**
+ * Descend to the leaf that contains the query point, like a nearest search would do first.
+ * The leaf index is used to sort query points, because points with the same leaf or with leaves
+ * next to each other in the node array traverse the tree in a very similar way.
+ */
+static void kdtree_find_leaf_cb(void *__restrict userdata,
+                                const int iter,
+                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const struct NearestBatchParams *p = userdata;
+  const KDTreeNode *nodes = p->tree->nodes;
+  const float *co = p->co[iter];
+  uint node_index = p->tree->root;
+  while (true) {
+    const KDTreeNode *node = &nodes[node_index];
+    const uint child = (co[node->d] < node->co[node->d]) ? node->left : node->right;
+    if (child == KD_NODE_UNSET) {
+      break;
+    }
+    node_index = child;
+  }
+  p->leaves[iter] = node_index;
+}
+
+/**
+ * Find the nearest node of many query points, which is faster than calling
+ * #BLI_kdtree_3d_find_nearest for every point. The query points are sorted spatially and
+ * processed in parallel, in groups that traverse the tree together.
+ *
+ * \param r_nearest: An array with \a co_len elements. When the tree is empty,
+ * all indices are set to -1.
+ * \note When multiple nodes are at the same distance to a query point,
+ * a different one than the one from #BLI_kdtree_3d_find_nearest may be returned.
+ */
+void BLI_kdtree_nd_(find_nearest_batch)(const KDTree *tree,
+                                        const float (*co)[KD_DIMS],
+                                        const uint co_len,
+                                        KDTreeNearest *r_nearest)
+{
+#ifdef DEBUG
+  BLI_assert(tree->is_balanced == true);
+#endif
+
+  if (UNLIKELY(tree->root == KD_NODE_UNSET)) {
+    memset(r_nearest, 0, sizeof(*r_nearest) * co_len);
+    for (uint i = 0; i < co_len; i++) {
+      r_nearest[i].index = -1;
+    }
+    return;
+  }
+
+  struct NearestBatchParams p = {
+      .tree = tree,
+      .co = co,
+      .co_len = co_len,
+      .order = MEM_mallocN(sizeof(uint) * co_len, __func__),
+      .leaves = MEM_mallocN(sizeof(uint) * co_len, __func__),
+      .r_nearest = r_nearest,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+  BLI_task_parallel_range(0, (int)co_len, &p, kdtree_find_leaf_cb, &settings);
+
+  /* Counting sort of the query points by leaf. */
+  uint *leaf_offsets = MEM_callocN(sizeof(uint) * (tree->nodes_len + 1), __func__);
+  for (uint i = 0; i < co_len; i++) {
+    leaf_offsets[p.leaves[i] + 1]++;
+  }
+  for (uint i = 0; i < tree->nodes_len; i++) {
+    leaf_offsets[i + 1] += leaf_offsets[i];
+  }
+  for (uint i = 0; i < co_len; i++) {
+    p.order[leaf_offsets[p.leaves[i]]++] = i;
+  }
+  MEM_freeN(leaf_offsets);
+
+  settings.min_iter_per_thread = 64;
+  BLI_task_parallel_range(0,
+                          (int)((co_len + KD_BATCH_SIZE - 1) / KD_BATCH_SIZE),
+                          &p,
+                          kdtree_find_nearest_batch_cb,
+                          &settings);
+
+  MEM_freeN(p.order);
+  MEM_freeN(p.leaves);
+}
+
+/** \} */
+
 /**
  * A version of #BLI_kdtree_3d_find_nearest which runs a callback
  * to filter out values.
@@ -837,8 +1114,9 @@ static void deduplicate_recursive(const struct DeDuplicateParams *p, uint i)
     }
   }
   else {
-    if ((p->search != node->index) && (p->duplicates[node->index] == -1)) {
-      if (len_squared_vnvn(node->co, p->search_co) <= p->range_sq) {
+    /* Test the distance first, the duplicates of points out of range must not be accessed. */
+    if ((p->search != node->index) && (len_squared_vnvn(node->co, p->search_co) <= p->range_sq)) {
+      if (p->duplicates[node->index] == -1) {
         p->duplicates[node->index] = (int)p->search;
         *p->duplicates_found += 1;
       }
@@ -852,6 +1130,25 @@ static void deduplicate_recursive(const struct DeDuplicateParams *p, uint i)
   }
 }
 
+/**
+ * Mark points in range of the point at \a co that are not marked yet as duplicates of \a index.
+ * \a index is marked as its own duplicate when any point was found.
+ */
+static void deduplicate_search(struct DeDuplicateParams *p,
+                               const uint root,
+                               const float co[KD_DIMS],
+                               const int index)
+{
+  p->search = index;
+  copy_vn_vn(p->search_co, co);
+  int found_prev = *p->duplicates_found;
+  deduplicate_recursive(p, root);
+  if (*p->duplicates_found != found_prev) {
+    /* Prevent chains of doubles. */
+    p->duplicates[index] = index;
+  }
+}
+
 /**
  * Find duplicate points in \a range.
  * Favors speed over quality since it doesn't find the best target vertex for merging.
@@ -890,14 +1187,7 @@ int BLI_kdtree_nd_(calc_duplicates_fast)(const KDTree *tree,
       const uint node_index = order[i];
       const int index = (int)i;
       if (ELEM(duplicates[index], -1, index)) {
-        p.search = index;
-        copy_vn_vn(p.search_co, tree->nodes[node_index].co);
-        int found_prev = found;
-        deduplicate_recursive(&p, tree->root);
-        if (found != found_prev) {
-          /* Prevent chains of doubles. */
-          duplicates[index] = index;
-        }
+        deduplicate_search(&p, tree->root, tree->nodes[node_index].co, index);
       }
     }
     MEM_freeN(order);
@@ -907,20 +1197,59 @@ int BLI_kdtree_nd_(calc_duplicates_fast)(const KDTree *tree,
       const uint node_index = i;
       const int index = p.nodes[node_index].index;
       if (ELEM(duplicates[index], -1, index)) {
-        p.search = index;
-        copy_vn_vn(p.search_co, tree->nodes[node_index].co);
-        int found_prev = found;
-        deduplicate_recursive(&p, tree->root);
-        if (found != found_prev) {
-          /* Prevent chains of doubles. */
-          duplicates[index] = index;
-        }
+        deduplicate_search(&p, tree->root, tree->nodes[node_index].co, index);
       }
     }
   }
   return found;
 }
 
+/**
+ * A single step of #BLI_kdtree_nd_calc_duplicates_fast: when \a duplicates[index] is -1 or \a
+ * index, points in \a range of \a co that are not marked yet are marked as duplicates of
+ * \a index. Only the values of points within \a range of \a co are accessed, so steps for points
+ * in separate groups can run in parallel.
+ *
+ * Calling this for all points in the order given by #BLI_kdtree_nd_indices_in_tree_order gives
+ * the same result as #BLI_kdtree_nd_calc_duplicates_fast without index order.
+ *
+ * \returns The number of points that were marked.
+ */
+int BLI_kdtree_nd_(calc_duplicates_fast_step)(const KDTree *tree,
+                                              const float co[KD_DIMS],
+                                              const int index,
+                                              const float range,
+                                              int *duplicates)
+{
+  if (!ELEM(duplicates[index], -1, index)) {
+    return 0;
+  }
+  int found = 0;
+  struct DeDuplicateParams p = {
+      .nodes = tree->nodes,
+      .range = range,
+      .range_sq = square_f(range),
+      .duplicates = duplicates,
+      .duplicates_found = &found,
+  };
+  deduplicate_search(&p, tree->root, co, index);
+  return found;
+}
+
+/**
+ * Fill \a r_indices with the indices of the points in the order in which the nodes are stored,
+ * which depends on the layout of the balanced tree.
+ */
+void BLI_kdtree_nd_(indices_in_tree_order)(const KDTree *tree, int *r_indices)
+{
+#ifdef DEBUG
+  BLI_assert(tree->is_balanced == true);
+#endif
+  for (uint i = 0; i < tree->nodes_len; i++) {
+    r_indices[i] = tree->nodes[i].index;
+  }
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -4,6 +4,9 @@
  * \ingroup bli
  */
 
+#include <cfloat>
+#include <cmath>
+
 #include "BLI_hash.hh"
 #include "BLI_math_boolean.hh"
 #include "BLI_math_mpq.hh"
@@ -2484,6 +2487,31 @@ int orient3d_fast(const double3 &a, const double3 &b, const double3 &c, const do
   return sgn(robust_pred::orient3dfast(a, b, c, d));
 }
 
+int filter_orient3d(const double3 &a, const double3 &b, const double3 &c, const double3 &d)
+{
+  const double3 ad = a - d;
+  const double3 bd = b - d;
+  const double3 cd = c - d;
+  const double det = ad.z * (bd.x * cd.y - cd.x * bd.y) + bd.z * (cd.x * ad.y - ad.x * cd.y) +
+                     cd.z * (ad.x * bd.y - bd.x * ad.y);
+  /* The supremum is the same expression with absolute values of the inputs and only additions.
+   * Every input has index 1, which gives the determinant index 11. See
+   * EXACT GEOMETRIC COMPUTATION USING CASCADING, by Burnikel, Funke, and Seel. */
+  const double3 abs_d(fabs(d.x), fabs(d.y), fabs(d.z));
+  const double3 sup_ad(fabs(a.x) + abs_d.x, fabs(a.y) + abs_d.y, fabs(a.z) + abs_d.z);
+  const double3 sup_bd(fabs(b.x) + abs_d.x, fabs(b.y) + abs_d.y, fabs(b.z) + abs_d.z);
+  const double3 sup_cd(fabs(c.x) + abs_d.x, fabs(c.y) + abs_d.y, fabs(c.z) + abs_d.z);
+  const double supremum = sup_ad.z * (sup_bd.x * sup_cd.y + sup_cd.x * sup_bd.y) +
+                          sup_bd.z * (sup_cd.x * sup_ad.y + sup_ad.x * sup_cd.y) +
+                          sup_cd.z * (sup_ad.x * sup_bd.y + sup_bd.x * sup_ad.y);
+  constexpr double index_orient3d = 11;
+  const double err_bound = supremum * index_orient3d * DBL_EPSILON;
+  if (fabs(det) > err_bound) {
+    return det > 0 ? 1 : -1;
+  }
+  return 0;
+}
+
 int insphere(
     const double3 &a, const double3 &b, const double3 &c, const double3 &d, const double3 &e)
 {
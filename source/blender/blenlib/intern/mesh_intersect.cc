@@ -16,6 +16,7 @@
 #  include "BLI_array.hh"
 #  include "BLI_assert.h"
 #  include "BLI_delaunay_2d.h"
+#  include "BLI_disjoint_set.hh"
 #  include "BLI_hash.hh"
 #  include "BLI_kdopbvh.h"
 #  include "BLI_map.hh"
@@ -1150,38 +1151,66 @@ static int filter_plane_side(const double3 &p,
  * in the caller can avoid many allocs and frees of mpq3 and mpq_class structures.
  */
 static inline mpq3 tti_interp(
-    const mpq3 &a, const mpq3 &b, const mpq3 &c, const mpq3 &n, mpq3 &ab, mpq3 &ac, mpq3 &dotbuf)
+    const Vert *a, const Vert *b, const Vert *c, const mpq3 &n, mpq3 &ab, mpq3 &ac, mpq3 &dotbuf)
 {
-  ab = a;
-  ab -= b;
-  ac = a;
-  ac -= c;
+  if (a == c) {
+    return a->co_exact;
+  }
+  ac = a->co_exact;
+  ac -= c->co_exact;
+  mpq_class num = math::dot_with_buffer(ac, n, dotbuf);
+  if (num == 0) {
+    /* Common when the triangles share vertices, avoid the division. */
+    return a->co_exact;
+  }
+  ab = a->co_exact;
+  ab -= b->co_exact;
   mpq_class den = math::dot_with_buffer(ab, n, dotbuf);
   BLI_assert(den != 0);
-  mpq_class alpha = math::dot_with_buffer(ac, n, dotbuf) / den;
-  return a - alpha * ab;
+  if (num == den) {
+    return b->co_exact;
+  }
+  mpq_class alpha = num / den;
+  return a->co_exact - alpha * ab;
 }
 
 /**
- * Return +1, 0, -1 as a + ad is above, on, or below the oriented plane containing a, b, c in CCW
- * order. This is the same as -oriented(a, b, c, a + ad), but uses fewer arithmetic operations.
- * TODO: change arguments to `const Vert *` and use floating filters.
- * The ba, ca, n, and dotbuf arguments are used as temporaries; declaring them
+ * Return +1, 0, -1 as d is above, on, or below the oriented plane containing a, b, c in CCW
+ * order. This is the same as -orient3d(a, b, c, d). The sign is decided with a floating point
+ * filter when possible, exact arithmetic is only needed when d is on or very near the plane.
+ * The ba, ca, ad, n, and dotbuf arguments are used as temporaries; declaring them
  * in the caller can avoid many allocs and frees of mpq3 and mpq_class structures.
  */
-static inline int tti_above(const mpq3 &a,
-                            const mpq3 &b,
-                            const mpq3 &c,
-                            const mpq3 &ad,
+static inline int tti_above(const Vert *a,
+                            const Vert *b,
+                            const Vert *c,
+                            const Vert *d,
                             mpq3 &ba,
                             mpq3 &ca,
+                            mpq3 &ad,
                             mpq3 &n,
                             mpq3 &dotbuf)
 {
-  ba = b;
-  ba -= a;
-  ca = c;
-  ca -= a;
+  if (ELEM(d, a, b, c) || ELEM(c, a, b)) {
+    /* Triangles sharing vertices give many of these. */
+    return 0;
+  }
+  int orient = filter_orient3d(a->co, b->co, c->co, d->co);
+  if (orient != 0) {
+#  ifdef PERFDEBUG
+    incperfcount(5); /* Triangle-triangle orientation tests decided by filter. */
+#  endif
+    return -orient;
+  }
+#  ifdef PERFDEBUG
+  incperfcount(6); /* Triangle-triangle orientation tests decided exactly. */
+#  endif
+  ba = b->co_exact;
+  ba -= a->co_exact;
+  ca = c->co_exact;
+  ca -= a->co_exact;
+  ad = d->co_exact;
+  ad -= a->co_exact;
 
   n.x = ba.y * ca.z - ba.z * ca.y;
   n.y = ba.z * ca.x - ba.x * ca.z;
@@ -1203,12 +1232,12 @@ static inline int tti_above(const mpq3 &a,
  *   of the plane and at least one of q1 and r1 are off the plane.
  * Similarly for p2, q2, r2 with respect to the first triangle's plane.
  */
-static ITT_value itt_canon2(const mpq3 &p1,
-                            const mpq3 &q1,
-                            const mpq3 &r1,
-                            const mpq3 &p2,
-                            const mpq3 &q2,
-                            const mpq3 &r2,
+static ITT_value itt_canon2(const Vert *p1,
+                            const Vert *q1,
+                            const Vert *r1,
+                            const Vert *p2,
+                            const Vert *q2,
+                            const Vert *r2,
                             const mpq3 &n1,
                             const mpq3 &n2)
 {
@@ -1219,26 +1248,19 @@ static ITT_value itt_canon2(const mpq3 &p1,
     std::cout << "p2=" << p2 << " q2=" << q2 << " r2=" << r2 << "\n";
     std::cout << "n1=" << n1 << " n2=" << n2 << "\n";
     std::cout << "approximate values:\n";
-    std::cout << "p1=(" << p1[0].get_d() << "," << p1[1].get_d() << "," << p1[2].get_d() << ")\n";
-    std::cout << "q1=(" << q1[0].get_d() << "," << q1[1].get_d() << "," << q1[2].get_d() << ")\n";
-    std::cout << "r1=(" << r1[0].get_d() << "," << r1[1].get_d() << "," << r1[2].get_d() << ")\n";
-    std::cout << "p2=(" << p2[0].get_d() << "," << p2[1].get_d() << "," << p2[2].get_d() << ")\n";
-    std::cout << "q2=(" << q2[0].get_d() << "," << q2[1].get_d() << "," << q2[2].get_d() << ")\n";
-    std::cout << "r2=(" << r2[0].get_d() << "," << r2[1].get_d() << "," << r2[2].get_d() << ")\n";
     std::cout << "n1=(" << n1[0].get_d() << "," << n1[1].get_d() << "," << n1[2].get_d() << ")\n";
     std::cout << "n2=(" << n2[0].get_d() << "," << n2[1].get_d() << "," << n2[2].get_d() << ")\n";
   }
-  mpq3 p1p2 = p2 - p1;
   mpq3 intersect_1;
   mpq3 intersect_2;
-  mpq3 buf[4];
+  mpq3 buf[5];
   bool no_overlap = false;
   /* Top test in classification tree. */
-  if (tti_above(p1, q1, r2, p1p2, buf[0], buf[1], buf[2], buf[3]) > 0) {
+  if (tti_above(p1, q1, r2, p2, buf[0], buf[1], buf[2], buf[3], buf[4]) > 0) {
     /* Middle right test in classification tree. */
-    if (tti_above(p1, r1, r2, p1p2, buf[0], buf[1], buf[2], buf[3]) <= 0) {
+    if (tti_above(p1, r1, r2, p2, buf[0], buf[1], buf[2], buf[3], buf[4]) <= 0) {
       /* Bottom right test in classification tree. */
-      if (tti_above(p1, r1, q2, p1p2, buf[0], buf[1], buf[2], buf[3]) > 0) {
+      if (tti_above(p1, r1, q2, p2, buf[0], buf[1], buf[2], buf[3], buf[4]) > 0) {
         /* Overlap is [k [i l] j]. */
         if (dbg_level > 0) {
           std::cout << "overlap [k [i l] j]\n";
@@ -1267,7 +1289,7 @@ static ITT_value itt_canon2(const mpq3 &p1,
   }
   else {
     /* Middle left test in classification tree. */
-    if (tti_above(p1, q1, q2, p1p2, buf[0], buf[1], buf[2], buf[3]) < 0) {
+    if (tti_above(p1, q1, q2, p2, buf[0], buf[1], buf[2], buf[3], buf[4]) < 0) {
       /* No overlap: [i j] [k l]. */
       if (dbg_level > 0) {
         std::cout << "no overlap: [i j] [k l]\n";
@@ -1276,7 +1298,7 @@ static ITT_value itt_canon2(const mpq3 &p1,
     }
     else {
       /* Bottom left test in classification tree. */
-      if (tti_above(p1, r1, q2, p1p2, buf[0], buf[1], buf[2], buf[3]) >= 0) {
+      if (tti_above(p1, r1, q2, p2, buf[0], buf[1], buf[2], buf[3], buf[4]) >= 0) {
         /* Overlap is [k [i j] l]. */
         if (dbg_level > 0) {
           std::cout << "overlap [k [i j] l]\n";
@@ -1313,12 +1335,12 @@ static ITT_value itt_canon2(const mpq3 &p1,
 
 /* Helper function for intersect_tri_tri. Arguments have been canonicalized for triangle 1. */
 
-static ITT_value itt_canon1(const mpq3 &p1,
-                            const mpq3 &q1,
-                            const mpq3 &r1,
-                            const mpq3 &p2,
-                            const mpq3 &q2,
-                            const mpq3 &r2,
+static ITT_value itt_canon1(const Vert *p1,
+                            const Vert *q1,
+                            const Vert *r1,
+                            const Vert *p2,
+                            const Vert *q2,
+                            const Vert *r2,
                             const mpq3 &n1,
                             const mpq3 &n2,
                             int sp2,
@@ -1451,18 +1473,19 @@ static ITT_value intersect_tri_tri(const IMesh &tm, int t1, int t2)
   const mpq3 &q2 = vq2->co_exact;
   const mpq3 &r2 = vr2->co_exact;
 
+  /* Vertices shared by the triangles are on both planes, that doesn't have to be computed. */
   const mpq3 &n2 = tri2.plane->norm_exact;
-  if (sp1 == 0) {
+  if (sp1 == 0 && !ELEM(vp1, vp2, vq2, vr2)) {
     buf[0] = p1;
     buf[0] -= r2;
     sp1 = sgn(math::dot_with_buffer(buf[0], n2, buf[1]));
   }
-  if (sq1 == 0) {
+  if (sq1 == 0 && !ELEM(vq1, vp2, vq2, vr2)) {
     buf[0] = q1;
     buf[0] -= r2;
     sq1 = sgn(math::dot_with_buffer(buf[0], n2, buf[1]));
   }
-  if (sr1 == 0) {
+  if (sr1 == 0 && !ELEM(vr1, vp2, vq2, vr2)) {
     buf[0] = r1;
     buf[0] -= r2;
     sr1 = sgn(math::dot_with_buffer(buf[0], n2, buf[1]));
@@ -1484,17 +1507,17 @@ static ITT_value intersect_tri_tri(const IMesh &tm, int t1, int t2)
 
   /* Repeat for signs of t2's vertices with respect to plane of t1. */
   const mpq3 &n1 = tri1.plane->norm_exact;
-  if (sp2 == 0) {
+  if (sp2 == 0 && !ELEM(vp2, vp1, vq1, vr1)) {
     buf[0] = p2;
     buf[0] -= r1;
     sp2 = sgn(math::dot_with_buffer(buf[0], n1, buf[1]));
   }
-  if (sq2 == 0) {
+  if (sq2 == 0 && !ELEM(vq2, vp1, vq1, vr1)) {
     buf[0] = q2;
     buf[0] -= r1;
     sq2 = sgn(math::dot_with_buffer(buf[0], n1, buf[1]));
   }
-  if (sr2 == 0) {
+  if (sr2 == 0 && !ELEM(vr2, vp1, vq1, vr1)) {
     buf[0] = r2;
     buf[0] -= r1;
     sr2 = sgn(math::dot_with_buffer(buf[0], n1, buf[1]));
@@ -1520,49 +1543,49 @@ static ITT_value intersect_tri_tri(const IMesh &tm, int t1, int t2)
   ITT_value ans;
   if (sp1 > 0) {
     if (sq1 > 0) {
-      ans = itt_canon1(r1, p1, q1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+      ans = itt_canon1(vr1, vp1, vq1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2);
     }
     else if (sr1 > 0) {
-      ans = itt_canon1(q1, r1, p1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+      ans = itt_canon1(vq1, vr1, vp1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2);
     }
     else {
-      ans = itt_canon1(p1, q1, r1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+      ans = itt_canon1(vp1, vq1, vr1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2);
     }
   }
   else if (sp1 < 0) {
     if (sq1 < 0) {
-      ans = itt_canon1(r1, p1, q1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+      ans = itt_canon1(vr1, vp1, vq1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2);
     }
     else if (sr1 < 0) {
-      ans = itt_canon1(q1, r1, p1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+      ans = itt_canon1(vq1, vr1, vp1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2);
     }
     else {
-      ans = itt_canon1(p1, q1, r1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+      ans = itt_canon1(vp1, vq1, vr1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2);
     }
   }
   else {
     if (sq1 < 0) {
       if (sr1 >= 0) {
-        ans = itt_canon1(q1, r1, p1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+        ans = itt_canon1(vq1, vr1, vp1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2);
       }
       else {
-        ans = itt_canon1(p1, q1, r1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+        ans = itt_canon1(vp1, vq1, vr1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2);
       }
     }
     else if (sq1 > 0) {
       if (sr1 > 0) {
-        ans = itt_canon1(p1, q1, r1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+        ans = itt_canon1(vp1, vq1, vr1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2);
       }
       else {
-        ans = itt_canon1(q1, r1, p1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+        ans = itt_canon1(vq1, vr1, vp1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2);
       }
     }
     else {
       if (sr1 > 0) {
-        ans = itt_canon1(r1, p1, q1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+        ans = itt_canon1(vr1, vp1, vq1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2);
       }
       else if (sr1 < 0) {
-        ans = itt_canon1(r1, p1, q1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+        ans = itt_canon1(vr1, vp1, vq1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2);
       }
       else {
         if (dbg_level > 0) {
@@ -2757,11 +2780,15 @@ static CoplanarClusterInfo find_clusters(const IMesh &tm,
   /* Use a VectorSet to get stable order from run to run. */
   VectorSet<int> maybe_coplanar_tris;
   maybe_coplanar_tris.reserve(2 * itt_map.size());
+  /* Triangles with a coplanar intersection are in the same plane, so the canonical plane only
+   * has to be computed (with exact divisions) once for every group of such triangles. */
+  DisjointSet coplanar_groups(tm.face_size());
   for (auto item : itt_map.items()) {
     if (item.value.kind == ICOPLANAR) {
       int t1 = item.key.first;
       int t2 = item.key.second;
       maybe_coplanar_tris.add_multiple({t1, t2});
+      coplanar_groups.join(t1, t2);
     }
   }
   if (dbg_level > 0) {
@@ -2778,19 +2805,23 @@ static CoplanarClusterInfo find_clusters(const IMesh &tm,
    * triangles that form intersection bridges between two or more clusters. */
   Map<Plane, Vector<CoplanarCluster>> plane_cls;
   plane_cls.reserve(maybe_coplanar_tris.size());
+  Map<int64_t, Plane> group_planes;
   for (int t : maybe_coplanar_tris) {
     /* Use a canonical version of the plane for map index.
      * We can't just store the canonical version in the face
      * since canonicalizing loses the orientation of the normal. */
-    Plane tplane = *tm.face(t)->plane;
-    BLI_assert(tplane.exact_populated());
-    tplane.make_canonical();
+    const Plane &tplane = group_planes.lookup_or_add_cb(coplanar_groups.find_root(t), [&]() {
+      Plane plane = *tm.face(t)->plane;
+      BLI_assert(plane.exact_populated());
+      plane.make_canonical();
+      return plane;
+    });
     if (dbg_level > 0) {
       std::cout << "plane for tri " << t << " = " << &tplane << "\n";
     }
     /* Assume all planes are in canonical from (see canon_plane()). */
-    if (plane_cls.contains(tplane)) {
-      Vector<CoplanarCluster> &curcls = plane_cls.lookup(tplane);
+    if (Vector<CoplanarCluster> *curcls_ptr = plane_cls.lookup_ptr(tplane)) {
+      Vector<CoplanarCluster> &curcls = *curcls_ptr;
       if (dbg_level > 0) {
         std::cout << "already has " << curcls.size() << " clusters\n";
       }
@@ -3181,6 +3212,14 @@ static void perfdata_init()
   perfdata->count.append(0);
   perfdata->count_name.append("final non-NONE intersects");
 
+  /* count 5. */
+  perfdata->count.append(0);
+  perfdata->count_name.append("tri tri orientation tests decided by filter");
+
+  /* count 6. */
+  perfdata->count.append(0);
+  perfdata->count_name.append("tri tri orientation tests decided exactly");
+
   /* max 0. */
   perfdata->max.append(0);
   perfdata->max_name.append("total faces");
@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: Apache-2.0 */
 
+#include "BLI_atomic_disjoint_set.hh"
 #include "BLI_disjoint_set.hh"
 #include "BLI_strict_flags.h"
 
@@ -33,4 +34,43 @@ TEST(disjoint_set, Test)
   EXPECT_FALSE(disjoint_set.in_same_set(0, 4));
 }
 
+TEST(atomic_disjoint_set, Test)
+{
+  AtomicDisjointSet disjoint_set(6);
+  EXPECT_FALSE(disjoint_set.in_same_set(1, 2));
+  EXPECT_FALSE(disjoint_set.in_same_set(5, 3));
+  EXPECT_TRUE(disjoint_set.in_same_set(2, 2));
+  EXPECT_EQ(disjoint_set.find_root(3), 3);
+
+  disjoint_set.join(4, 3);
+
+  EXPECT_TRUE(disjoint_set.in_same_set(3, 4));
+  EXPECT_FALSE(disjoint_set.in_same_set(2, 3));
+  EXPECT_EQ(disjoint_set.find_root(4), 3);
+
+  disjoint_set.join(1, 4);
+  disjoint_set.join(5, 2);
+
+  EXPECT_TRUE(disjoint_set.in_same_set(1, 3));
+  EXPECT_FALSE(disjoint_set.in_same_set(0, 4));
+  EXPECT_EQ(disjoint_set.find_root(4), 1);
+  EXPECT_EQ(disjoint_set.find_root(5), 2);
+}
+
+TEST(atomic_disjoint_set, Parallel)
+{
+  /* Join every element with the element at half its index. All elements are in one set then,
+   * and the smallest element is the root. */
+  const int size = 100000;
+  AtomicDisjointSet disjoint_set(size);
+  threading::parallel_for(IndexRange(1, size - 1), 128, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      disjoint_set.join(int(i), int(i / 2));
+    }
+  });
+  for (const int64_t i : IndexRange(size)) {
+    EXPECT_EQ(disjoint_set.find_root(int(i)), 0);
+  }
+}
+
 }  // namespace blender::tests
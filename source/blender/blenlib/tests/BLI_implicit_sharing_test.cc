@@ -0,0 +1,57 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_implicit_sharing.hh"
+
+namespace blender::tests {
+
+class SharedIntArray : public ImplicitSharingInfo {
+ public:
+  int *data;
+  bool *freed;
+
+  SharedIntArray(int *data, bool *freed) : data(data), freed(freed)
+  {
+  }
+
+ private:
+  void delete_self_with_data() override
+  {
+    MEM_freeN(data);
+    *freed = true;
+    MEM_delete(this);
+  }
+};
+
+TEST(implicit_sharing, UserCount)
+{
+  bool freed = false;
+  int *data = static_cast<int *>(MEM_calloc_arrayN(4, sizeof(int), __func__));
+  const SharedIntArray *sharing_info = MEM_new<SharedIntArray>(__func__, data, &freed);
+  EXPECT_TRUE(sharing_info->is_mutable());
+
+  sharing_info->user_add();
+  EXPECT_FALSE(sharing_info->is_mutable());
+  sharing_info->user_remove();
+  EXPECT_TRUE(sharing_info->is_mutable());
+  EXPECT_FALSE(freed);
+
+  sharing_info->user_remove();
+  EXPECT_TRUE(freed);
+}
+
+TEST(implicit_sharing, Handle)
+{
+  bool freed = false;
+  int *data = static_cast<int *>(MEM_calloc_arrayN(4, sizeof(int), __func__));
+  const ImplicitSharingInfo *sharing_info = MEM_new<SharedIntArray>(__func__, data, &freed);
+  const ImplicitSharingInfoHandle *handle = sharing_info;
+  EXPECT_EQ(static_cast<const ImplicitSharingInfo *>(handle), sharing_info);
+  static_cast<const ImplicitSharingInfo *>(handle)->user_remove();
+  EXPECT_TRUE(freed);
+}
+
+}  // namespace blender::tests
@@ -66,11 +66,16 @@ static void optimal_check_callback(void *userdata,
  * Note that a small epsilon is added to the BVH nodes bounds, even if we pass in zero.
  * Use rounding to ensure very close nodes don't cause the wrong node to be found as nearest.
  */
-static void find_nearest_points_test(
-    int points_len, float scale, int round, int random_seed, bool optimal = false)
+static void find_nearest_points_test(int points_len,
+                                     float scale,
+                                     int round,
+                                     int random_seed,
+                                     bool optimal = false,
+                                     int tree_type = 8,
+                                     int balance_flag = 0)
 {
   struct RNG *rng = BLI_rng_new(random_seed);
-  BVHTree *tree = BLI_bvhtree_new(points_len, 0.0, 8, 8);
+  BVHTree *tree = BLI_bvhtree_new(points_len, 0.0, tree_type, 8);
 
   void *mem = MEM_mallocN(sizeof(float[3]) * points_len, __func__);
   float(*points)[3] = (float(*)[3])mem;
@@ -79,7 +84,7 @@ static void find_nearest_points_test(
     rng_v3_round(points[i], 3, rng, round, scale);
     BLI_bvhtree_insert(tree, i, points[i], 1);
   }
-  BLI_bvhtree_balance(tree);
+  BLI_bvhtree_balance_ex(tree, balance_flag);
 
   /* first find each point */
   BVHTree_NearestPointCallback callback = optimal ? optimal_check_callback : nullptr;
@@ -132,3 +137,155 @@ TEST(kdopbvh, OptimalFindNearest_500)
 {
   find_nearest_points_test(500, 1.0, 1000, 12, true);
 }
+
+TEST(kdopbvh, SAHFindNearest_2)
+{
+  find_nearest_points_test(2, 1.0, 1000, 123, false, 2, BVH_BALANCE_SAH);
+}
+TEST(kdopbvh, SAHFindNearest_500)
+{
+  find_nearest_points_test(500, 1.0, 1000, 12, false, 2, BVH_BALANCE_SAH);
+}
+TEST(kdopbvh, SAHFindNearest_TreeType4_5000)
+{
+  find_nearest_points_test(5000, 1.0, 1000, 12, false, 4, BVH_BALANCE_SAH);
+}
+TEST(kdopbvh, SAHFindNearest_TreeType8_5000)
+{
+  find_nearest_points_test(5000, 1.0, 1000, 12, false, 8, BVH_BALANCE_SAH);
+}
+TEST(kdopbvh, SAHOptimalFindNearest_500)
+{
+  find_nearest_points_test(500, 1.0, 1000, 12, true, 2, BVH_BALANCE_SAH);
+}
+/* Many leafs at the same position can't be split by the SAH. */
+TEST(kdopbvh, SAHFindNearest_Duplicates_5000)
+{
+  find_nearest_points_test(5000, 1.0, 4, 12, false, 4, BVH_BALANCE_SAH);
+}
+
+/**
+ * Without a callback, ray-casts hit the bounding boxes of the points. Check that casting rays in
+ * a batch finds the same boxes as casting every ray on its own.
+ */
+static void raycast_batch_test(int points_len, int tree_type, float radius, int random_seed)
+{
+  struct RNG *rng = BLI_rng_new(random_seed);
+  BVHTree *tree = BLI_bvhtree_new(points_len, 0.01f, tree_type, 6);
+  for (int i = 0; i < points_len; i++) {
+    float co[3];
+    BLI_rng_get_float_unit_v3(rng, co);
+    BLI_bvhtree_insert(tree, i, co, 1);
+  }
+  BLI_bvhtree_balance(tree);
+
+  const int rays_len = 1000;
+  float(*co)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * rays_len, __func__);
+  float(*dir)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * rays_len, __func__);
+  BVHTreeRayHit *hits = (BVHTreeRayHit *)MEM_mallocN(sizeof(BVHTreeRayHit) * rays_len, __func__);
+  for (int i = 0; i < rays_len; i++) {
+    rng_v3_round(co[i], 3, rng, 1000, 2.0f);
+    /* Include some axis aligned rays. */
+    if (i % 10 == 0) {
+      zero_v3(dir[i]);
+      dir[i][i % 3] = (i % 20 == 0) ? 1.0f : -1.0f;
+    }
+    else {
+      BLI_rng_get_float_unit_v3(rng, dir[i]);
+    }
+    hits[i].index = -1;
+    hits[i].dist = (i % 2) ? BVH_RAYCAST_DIST_MAX : 1.0f;
+  }
+
+  BLI_bvhtree_ray_cast_batch(
+      tree, co, dir, rays_len, radius, hits, nullptr, nullptr, BVH_RAYCAST_DEFAULT);
+
+  for (int i = 0; i < rays_len; i++) {
+    BVHTreeRayHit hit;
+    hit.index = -1;
+    hit.dist = (i % 2) ? BVH_RAYCAST_DIST_MAX : 1.0f;
+    BLI_bvhtree_ray_cast(tree, co[i], dir[i], radius, &hit, nullptr, nullptr);
+    EXPECT_EQ(hit.index, hits[i].index);
+    EXPECT_EQ(hit.dist, hits[i].dist);
+  }
+
+  BLI_bvhtree_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(co);
+  MEM_freeN(dir);
+  MEM_freeN(hits);
+}
+
+TEST(kdopbvh, RaycastBatch_Binary)
+{
+  raycast_batch_test(1000, 2, 0.0f, 1234);
+}
+TEST(kdopbvh, RaycastBatch_TreeType4)
+{
+  raycast_batch_test(1000, 4, 0.0f, 123);
+}
+TEST(kdopbvh, RaycastBatch_Radius)
+{
+  raycast_batch_test(1000, 4, 0.05f, 12);
+}
+
+static int refit_points_callback(void *userdata, int index, float r_co[BVH_LEAF_POINTS_MAX][3])
+{
+  const float(*points)[3] = (const float(*)[3])userdata;
+  copy_v3_v3(r_co[0], points[index]);
+  return 1;
+}
+
+/**
+ * Move all points of a balanced tree and refit it. Every point must be found again, no matter
+ * how far the points moved. A translation doesn't change the cost of the tree.
+ */
+static void refit_test(int points_len, int tree_type, int balance_flag, int random_seed)
+{
+  struct RNG *rng = BLI_rng_new(random_seed);
+  BVHTree *tree = BLI_bvhtree_new(points_len, 0.0, tree_type, 6);
+
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+  for (int i = 0; i < points_len; i++) {
+    rng_v3_round(points[i], 3, rng, 1000, 1.0f);
+    BLI_bvhtree_insert(tree, i, points[i], 1);
+  }
+  BLI_bvhtree_balance_ex(tree, balance_flag);
+  const float cost = BLI_bvhtree_surface_area_cost(tree);
+
+  const float offset[3] = {10.0f, -5.0f, 2.0f};
+  for (int i = 0; i < points_len; i++) {
+    add_v3_v3(points[i], offset);
+  }
+  BLI_bvhtree_refit(tree, refit_points_callback, points);
+  EXPECT_NEAR(cost, BLI_bvhtree_surface_area_cost(tree), cost * 1e-3f);
+
+  for (int i = 0; i < points_len; i++) {
+    rng_v3_round(points[i], 3, rng, 1000, 1.0f);
+  }
+  BLI_bvhtree_refit(tree, refit_points_callback, points);
+
+  for (int i = 0; i < points_len; i++) {
+    const int j = BLI_bvhtree_find_nearest(tree, points[i], nullptr, nullptr, nullptr);
+    EXPECT_GE(j, 0);
+    EXPECT_LT(j, points_len);
+    EXPECT_EQ_ARRAY(points[i], points[j], 3);
+  }
+
+  BLI_bvhtree_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(points);
+}
+
+TEST(kdopbvh, Refit_1)
+{
+  refit_test(1, 4, 0, 1234);
+}
+TEST(kdopbvh, Refit_5000)
+{
+  refit_test(5000, 4, 0, 123);
+}
+TEST(kdopbvh, RefitSAH_5000)
+{
+  refit_test(5000, 2, BVH_BALANCE_SAH, 12);
+}
@@ -0,0 +1,128 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+#include "BLI_kdtree.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.hh"
+#include "BLI_vector.hh"
+
+namespace blender::tests {
+
+static float3 random_float3(RandomNumberGenerator &rng)
+{
+  const float x = rng.get_float();
+  const float y = rng.get_float();
+  const float z = rng.get_float();
+  return {x, y, z};
+}
+
+static KDTree_3d *build_random_tree(const int points_num, const uint32_t seed)
+{
+  RandomNumberGenerator rng(seed);
+  KDTree_3d *tree = BLI_kdtree_3d_new(points_num);
+  for (const int i : IndexRange(points_num)) {
+    const float3 co = random_float3(rng);
+    BLI_kdtree_3d_insert(tree, i, co);
+  }
+  BLI_kdtree_3d_balance(tree);
+  return tree;
+}
+
+static void test_find_nearest_batch(const int points_num, const int queries_num)
+{
+  KDTree_3d *tree = build_random_tree(points_num, 0);
+
+  RandomNumberGenerator rng(1);
+  Vector<float3> queries(queries_num);
+  for (float3 &co : queries) {
+    co = rng.get_unit_float3() * 2.0f;
+  }
+
+  Vector<KDTreeNearest_3d> nearest(queries_num);
+  BLI_kdtree_3d_find_nearest_batch(
+      tree, reinterpret_cast<const float(*)[3]>(queries.data()), queries_num, nearest.data());
+
+  for (const int i : IndexRange(queries_num)) {
+    KDTreeNearest_3d expected;
+    BLI_kdtree_3d_find_nearest(tree, queries[i], &expected);
+    /* Different points at the same distance may be found. */
+    EXPECT_EQ(nearest[i].dist, expected.dist);
+    EXPECT_EQ(len_v3v3(queries[i], nearest[i].co), nearest[i].dist);
+  }
+
+  BLI_kdtree_3d_free(tree);
+}
+
+TEST(kdtree, FindNearestBatch)
+{
+  test_find_nearest_batch(1, 5);
+  test_find_nearest_batch(10, 100);
+  test_find_nearest_batch(10000, 1003);
+}
+
+TEST(kdtree, FindNearestBatchEmpty)
+{
+  KDTree_3d *tree = BLI_kdtree_3d_new(0);
+  BLI_kdtree_3d_balance(tree);
+  const float co[2][3] = {{0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}};
+  KDTreeNearest_3d nearest[2];
+  BLI_kdtree_3d_find_nearest_batch(tree, co, 2, nearest);
+  EXPECT_EQ(nearest[0].index, -1);
+  EXPECT_EQ(nearest[1].index, -1);
+  BLI_kdtree_3d_free(tree);
+}
+
+TEST(kdtree, BalanceLarge)
+{
+  /* Large enough to balance sub-trees in separate tasks. */
+  const int points_num = 100000;
+  KDTree_3d *tree = build_random_tree(points_num, 2);
+
+  RandomNumberGenerator rng(2);
+  for (const int i : IndexRange(points_num)) {
+    const float3 co = random_float3(rng);
+    KDTreeNearest_3d nearest;
+    EXPECT_EQ(BLI_kdtree_3d_find_nearest(tree, co, &nearest), i);
+    EXPECT_EQ(nearest.dist, 0.0f);
+  }
+
+  BLI_kdtree_3d_free(tree);
+}
+
+TEST(kdtree, CalcDuplicatesFastStep)
+{
+  /* Searching from every point in the order of the nodes gives the same duplicates. */
+  const int points_num = 5000;
+  KDTree_3d *tree = build_random_tree(points_num, 3);
+  const float range = 0.03f;
+
+  Array<int> expected(points_num, -1);
+  const int expected_found = BLI_kdtree_3d_calc_duplicates_fast(
+      tree, range, false, expected.data());
+  EXPECT_GT(expected_found, 0);
+
+  Array<int> tree_order(points_num);
+  BLI_kdtree_3d_indices_in_tree_order(tree, tree_order.data());
+  RandomNumberGenerator rng(3);
+  Array<float3> positions(points_num);
+  for (float3 &co : positions) {
+    co = random_float3(rng);
+  }
+  Array<int> duplicates(points_num, -1);
+  int found = 0;
+  for (const int i : tree_order) {
+    found += BLI_kdtree_3d_calc_duplicates_fast_step(
+        tree, positions[i], i, range, duplicates.data());
+  }
+
+  EXPECT_EQ(found, expected_found);
+  for (const int i : IndexRange(points_num)) {
+    EXPECT_EQ(duplicates[i], expected[i]);
+  }
+
+  BLI_kdtree_3d_free(tree);
+}
+
+}  // namespace blender::tests
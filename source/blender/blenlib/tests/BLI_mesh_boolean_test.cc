@@ -8,13 +8,18 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "PIL_time.h"
+
 #include "BLI_array.hh"
 #include "BLI_map.hh"
 #include "BLI_math_mpq.hh"
 #include "BLI_math_vec_mpq_types.hh"
 #include "BLI_mesh_boolean.hh"
+#include "BLI_task.h"
 #include "BLI_vector.hh"
 
+#define DO_PERF_TESTS 0
+
 #ifdef WITH_GMP
 namespace blender::meshintersect::tests {
 
@@ -955,5 +960,181 @@ TEST(boolean_polymesh, CubePlane)
   }
 }
 
+#  if DO_PERF_TESTS
+
+/**
+ * Add a UV-sphere with `nrings` rings and `2 * nrings` segments to the arena, made of quads
+ * except for the triangle fans at the poles.
+ */
+static void add_sphere(IMeshArena &arena,
+                       int nrings,
+                       const double3 &center,
+                       double radius,
+                       Vector<Face *> &r_faces)
+{
+  const int nsegs = 2 * nrings;
+  Array<const Vert *> vert(nsegs * (nrings - 1));
+  auto vert_index_fn = [nrings](int seg, int ring) { return seg * (nrings - 1) + ring - 1; };
+  for (int s = 0; s < nsegs; ++s) {
+    const double phi = s * 2.0 * M_PI / nsegs;
+    for (int r = 1; r < nrings; ++r) {
+      const double theta = r * M_PI / nrings;
+      const double3 co(center[0] + radius * sin(theta) * cos(phi),
+                       center[1] + radius * sin(theta) * sin(phi),
+                       center[2] + radius * cos(theta));
+      vert[vert_index_fn(s, r)] = arena.add_or_find_vert(co, arena.tot_allocated_verts());
+    }
+  }
+  const Vert *vtop = arena.add_or_find_vert(center + double3(0, 0, radius),
+                                            arena.tot_allocated_verts());
+  const Vert *vbot = arena.add_or_find_vert(center - double3(0, 0, radius),
+                                            arena.tot_allocated_verts());
+  for (int s = 0; s < nsegs; ++s) {
+    const int snext = (s + 1) % nsegs;
+    const int fid = arena.tot_allocated_faces();
+    r_faces.append(arena.add_face(
+        {vtop, vert[vert_index_fn(s, 1)], vert[vert_index_fn(snext, 1)]}, fid));
+    for (int r = 1; r < nrings - 1; ++r) {
+      r_faces.append(arena.add_face({vert[vert_index_fn(s, r)],
+                                     vert[vert_index_fn(s, r + 1)],
+                                     vert[vert_index_fn(snext, r + 1)],
+                                     vert[vert_index_fn(snext, r)]},
+                                    fid + r));
+    }
+    r_faces.append(arena.add_face({vert[vert_index_fn(s, nrings - 1)],
+                                   vbot,
+                                   vert[vert_index_fn(snext, nrings - 1)]},
+                                  fid + nrings - 1));
+  }
+}
+
+/**
+ * Add an axis aligned box from `min` to `max` to the arena, with every side subdivided into
+ * `subdiv` by `subdiv` quads. Coordinates are computed exactly, so that coplanar sides of
+ * different boxes really are coplanar.
+ */
+static void add_box(
+    IMeshArena &arena, int subdiv, const mpq3 &min, const mpq3 &max, Vector<Face *> &r_faces)
+{
+  const int grid_len = subdiv + 1;
+  /* Each side is a grid in the two axes other than `axis`, at `axis` coordinate min or max. */
+  for (int axis = 0; axis < 3; ++axis) {
+    const int axis_u = (axis + 1) % 3;
+    const int axis_v = (axis + 2) % 3;
+    for (const bool is_max : {false, true}) {
+      Array<const Vert *> vert(grid_len * grid_len);
+      for (int iv = 0; iv < grid_len; ++iv) {
+        for (int iu = 0; iu < grid_len; ++iu) {
+          mpq3 co;
+          co[axis] = is_max ? max[axis] : min[axis];
+          co[axis_u] = min[axis_u] + (max[axis_u] - min[axis_u]) * iu / subdiv;
+          co[axis_v] = min[axis_v] + (max[axis_v] - min[axis_v]) * iv / subdiv;
+          vert[iv * grid_len + iu] = arena.add_or_find_vert(co, arena.tot_allocated_verts());
+        }
+      }
+      for (int iv = 0; iv < subdiv; ++iv) {
+        for (int iu = 0; iu < subdiv; ++iu) {
+          const Vert *v0 = vert[iv * grid_len + iu];
+          const Vert *v1 = vert[iv * grid_len + iu + 1];
+          const Vert *v2 = vert[(iv + 1) * grid_len + iu + 1];
+          const Vert *v3 = vert[(iv + 1) * grid_len + iu];
+          /* Keep the normals pointing outwards. */
+          const int fid = arena.tot_allocated_faces();
+          if (is_max) {
+            r_faces.append(arena.add_face({v0, v1, v2, v3}, fid));
+          }
+          else {
+            r_faces.append(arena.add_face({v3, v2, v1, v0}, fid));
+          }
+        }
+      }
+    }
+  }
+}
+
+static void boolean_perf_test(const char *name,
+                              IMeshArena &arena,
+                              Span<Face *> faces,
+                              int shape_0_len,
+                              BoolOpType op,
+                              bool use_self)
+{
+  BLI_task_scheduler_init(); /* Without this, no parallelism. */
+  IMesh mesh(faces);
+  const double time_start = PIL_check_seconds_timer();
+  IMesh out = boolean_mesh(
+      mesh,
+      op,
+      use_self ? 1 : 2,
+      [shape_0_len](int f) { return f < shape_0_len ? 0 : 1; },
+      use_self,
+      false,
+      nullptr,
+      &arena);
+  const double time_end = PIL_check_seconds_timer();
+  out.populate_vert();
+  std::cout << name << ": " << faces.size() << " faces in, " << out.face_size()
+            << " faces out, boolean time: " << time_end - time_start << "\n";
+  EXPECT_GT(out.face_size(), 0);
+  if (DO_OBJ) {
+    write_obj_mesh(out, name);
+  }
+  BLI_task_scheduler_exit();
+}
+
+static void spheresphere_perf_test(int nrings, double offset, BoolOpType op, bool use_self)
+{
+  IMeshArena arena;
+  Vector<Face *> faces;
+  add_sphere(arena, nrings, double3(0.0), 1.0, faces);
+  const int shape_0_len = faces.size();
+  add_sphere(arena, nrings, double3(offset, offset / 2, offset / 3), 1.0, faces);
+  boolean_perf_test("spheresphere", arena, faces, shape_0_len, op, use_self);
+}
+
+static void boxbox_coplanar_perf_test(int subdiv, BoolOpType op)
+{
+  /* The second box shares the bottom plane of the first one and is shifted along x and y,
+   * so the exact solver has to build large coplanar clusters. */
+  IMeshArena arena;
+  Vector<Face *> faces;
+  add_box(arena, subdiv, mpq3(0, 0, 0), mpq3(2, 2, 2), faces);
+  const int shape_0_len = faces.size();
+  add_box(arena, subdiv, mpq3(mpq_class(1, 3), mpq_class(1, 5), 0), mpq3(3, 3, 1), faces);
+  boolean_perf_test("boxbox_coplanar", arena, faces, shape_0_len, op, false);
+}
+
+static void spherebox_perf_test(int nrings, int subdiv, BoolOpType op)
+{
+  IMeshArena arena;
+  Vector<Face *> faces;
+  add_box(arena, subdiv, mpq3(-1, -1, -1), mpq3(1, 1, 1), faces);
+  const int shape_0_len = faces.size();
+  add_sphere(arena, nrings, double3(0.75, 0.5, 0.25), 1.0, faces);
+  boolean_perf_test("spherebox", arena, faces, shape_0_len, op, false);
+}
+
+TEST(boolean_perf, SphereSphereUnion)
+{
+  spheresphere_perf_test(128, 0.5, BoolOpType::Union, false);
+}
+
+TEST(boolean_perf, SphereSphereSelfUnion)
+{
+  spheresphere_perf_test(64, 0.5, BoolOpType::Union, true);
+}
+
+TEST(boolean_perf, BoxBoxCoplanarDifference)
+{
+  boxbox_coplanar_perf_test(64, BoolOpType::Difference);
+}
+
+TEST(boolean_perf, SphereBoxIntersect)
+{
+  spherebox_perf_test(128, 32, BoolOpType::Intersect);
+}
+
+#  endif
+
 }  // namespace blender::meshintersect::tests
 #endif
@@ -0,0 +1,260 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+#include "BLI_kdopbvh.h"
+#include "BLI_math_geom.h"
+#include "BLI_math_vec_types.hh"
+#include "BLI_math_vector.hh"
+#include "BLI_rand.hh"
+
+#include "PIL_time.h"
+
+namespace blender::tests {
+
+/**
+ * Triangles of a height-field with the given number of quads per side, in the unit square.
+ */
+static Array<float3> terrain_triangles(const int resolution)
+{
+  RandomNumberGenerator rng(0);
+  Array<float> heights((resolution + 1) * (resolution + 1));
+  for (float &height : heights) {
+    height = rng.get_float() * 0.1f;
+  }
+  auto vert = [&](const int x, const int y) {
+    return float3(float(x) / resolution,
+                  float(y) / resolution,
+                  heights[y * (resolution + 1) + x]);
+  };
+
+  Array<float3> triangles(resolution * resolution * 6);
+  int i = 0;
+  for (const int y : IndexRange(resolution)) {
+    for (const int x : IndexRange(resolution)) {
+      triangles[i++] = vert(x, y);
+      triangles[i++] = vert(x + 1, y);
+      triangles[i++] = vert(x + 1, y + 1);
+      triangles[i++] = vert(x, y);
+      triangles[i++] = vert(x + 1, y + 1);
+      triangles[i++] = vert(x, y + 1);
+    }
+  }
+  return triangles;
+}
+
+static void raycast_triangle_callback(void *userdata,
+                                      int index,
+                                      const BVHTreeRay *ray,
+                                      BVHTreeRayHit *hit)
+{
+  const float3 *tri = static_cast<const float3 *>(userdata) + index * 3;
+  float dist;
+  if (isect_ray_tri_watertight_v3(
+          ray->origin, ray->isect_precalc, tri[0], tri[1], tri[2], &dist, nullptr) &&
+      dist < hit->dist) {
+    hit->index = index;
+    hit->dist = dist;
+  }
+}
+
+static void bvhtree_raycast_test(const char *id,
+                                 const int resolution,
+                                 const Span<float3> origins,
+                                 const Span<float3> directions)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  Array<float3> triangles = terrain_triangles(resolution);
+  const int tris_num = triangles.size() / 3;
+
+  double time = PIL_check_seconds_timer();
+  BVHTree *tree = BLI_bvhtree_new(tris_num, 0.0f, 4, 6);
+  for (const int i : IndexRange(tris_num)) {
+    BLI_bvhtree_insert(tree, i, triangles[i * 3], 3);
+  }
+  BLI_bvhtree_balance_ex(tree, BVH_BALANCE_SAH);
+  printf("\tBuild tree with %d triangles: %fs\n", tris_num, PIL_check_seconds_timer() - time);
+
+  Array<BVHTreeRayHit> hits(origins.size());
+  time = PIL_check_seconds_timer();
+  for (const int i : origins.index_range()) {
+    hits[i].index = -1;
+    hits[i].dist = BVH_RAYCAST_DIST_MAX;
+    BLI_bvhtree_ray_cast(tree,
+                         origins[i],
+                         directions[i],
+                         0.0f,
+                         &hits[i],
+                         raycast_triangle_callback,
+                         triangles.data());
+  }
+  printf("\tCast %d rays: %fs\n", int(origins.size()), PIL_check_seconds_timer() - time);
+
+  Array<BVHTreeRayHit> hits_batch(origins.size());
+  time = PIL_check_seconds_timer();
+  for (BVHTreeRayHit &hit : hits_batch) {
+    hit.index = -1;
+    hit.dist = BVH_RAYCAST_DIST_MAX;
+  }
+  BLI_bvhtree_ray_cast_batch(tree,
+                             reinterpret_cast<const float(*)[3]>(origins.data()),
+                             reinterpret_cast<const float(*)[3]>(directions.data()),
+                             origins.size(),
+                             0.0f,
+                             hits_batch.data(),
+                             raycast_triangle_callback,
+                             triangles.data(),
+                             BVH_RAYCAST_DEFAULT);
+  printf("\tCast %d rays batched: %fs\n", int(origins.size()), PIL_check_seconds_timer() - time);
+
+  for (const int i : origins.index_range()) {
+    EXPECT_EQ(hits[i].index, hits_batch[i].index);
+    EXPECT_EQ(hits[i].dist, hits_batch[i].dist);
+  }
+
+  BLI_bvhtree_free(tree);
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+/**
+ * Rays pointing down from a jittered grid above the terrain, like rays cast from the points of
+ * a grid mesh.
+ */
+static void bvhtree_raycast_grid_test(const char *id, const bool shuffle)
+{
+  const int resolution = 512;
+  RandomNumberGenerator rng(1);
+  Array<float3> origins(resolution * resolution);
+  Array<float3> directions(resolution * resolution);
+  for (const int y : IndexRange(resolution)) {
+    for (const int x : IndexRange(resolution)) {
+      const float2 jitter(rng.get_float(), rng.get_float());
+      const int i = y * resolution + x;
+      origins[i] = float3((float2(x, y) + jitter) / float(resolution), 1.0f);
+      const float3 direction(rng.get_float() - 0.5f, rng.get_float() - 0.5f, -4.0f);
+      directions[i] = math::normalize(direction);
+    }
+  }
+  if (shuffle) {
+    for (const int i : origins.index_range()) {
+      const int j = rng.get_int32(origins.size());
+      std::swap(origins[i], origins[j]);
+      std::swap(directions[i], directions[j]);
+    }
+  }
+  bvhtree_raycast_test(id, 512, origins, directions);
+}
+
+TEST(kdopbvh, RaycastGrid)
+{
+  bvhtree_raycast_grid_test("BVHTree ray-cast - grid order", false);
+}
+
+TEST(kdopbvh, RaycastShuffled)
+{
+  bvhtree_raycast_grid_test("BVHTree ray-cast - random order", true);
+}
+
+TEST(kdopbvh, RaycastRandomDirections)
+{
+  const int rays_num = 262144;
+  RandomNumberGenerator rng(2);
+  Array<float3> origins(rays_num);
+  Array<float3> directions(rays_num);
+  for (const int i : IndexRange(rays_num)) {
+    origins[i] = float3(rng.get_float(), rng.get_float(), rng.get_float() * 0.5f + 0.1f);
+    directions[i] = rng.get_unit_float3();
+  }
+  bvhtree_raycast_test("BVHTree ray-cast - random directions", 512, origins, directions);
+}
+
+static int refit_triangle_callback(void *userdata, int index, float r_co[BVH_LEAF_POINTS_MAX][3])
+{
+  const float3 *tri = static_cast<const float3 *>(userdata) + index * 3;
+  for (const int i : IndexRange(3)) {
+    copy_v3_v3(r_co[i], tri[i]);
+  }
+  return 3;
+}
+
+static BVHTree *terrain_tree_build(const Span<float3> triangles)
+{
+  const int tris_num = triangles.size() / 3;
+  BVHTree *tree = BLI_bvhtree_new(tris_num, 0.0f, 4, 6);
+  for (const int i : IndexRange(tris_num)) {
+    BLI_bvhtree_insert(tree, i, triangles[i * 3], 3);
+  }
+  BLI_bvhtree_balance_ex(tree, BVH_BALANCE_SAH);
+  return tree;
+}
+
+/**
+ * Deform the terrain with growing waves, like an animated mesh, and compare refitting the tree
+ * with building it again.
+ */
+TEST(kdopbvh, RefitDeform)
+{
+  printf("\n========== STARTING BVHTree refit ==========\n");
+
+  const Array<float3> rest_triangles = terrain_triangles(512);
+  Array<float3> triangles = rest_triangles;
+  BVHTree *tree = terrain_tree_build(triangles);
+  const float build_cost = BLI_bvhtree_surface_area_cost(tree);
+
+  RandomNumberGenerator rng(3);
+  Array<float3> origins(65536);
+  for (float3 &origin : origins) {
+    origin = float3(rng.get_float(), rng.get_float(), 2.0f);
+  }
+  const float3 direction(0.0f, 0.0f, -1.0f);
+
+  for (const int frame : IndexRange(1, 4)) {
+    const float amplitude = 0.1f * frame;
+    for (const int i : triangles.index_range()) {
+      const float3 &co = rest_triangles[i];
+      triangles[i] = co + float3(0.0f, 0.0f, amplitude * std::sin(co.x * 20.0f));
+    }
+
+    double time = PIL_check_seconds_timer();
+    BLI_bvhtree_refit(tree, refit_triangle_callback, triangles.data());
+    const double refit_time = PIL_check_seconds_timer() - time;
+
+    time = PIL_check_seconds_timer();
+    BVHTree *new_tree = terrain_tree_build(triangles);
+    const double build_time = PIL_check_seconds_timer() - time;
+
+    printf("\tWave amplitude %.1f: refit %fs, build %fs, cost refit %.1f, build %.1f (%.1f)\n",
+           amplitude,
+           refit_time,
+           build_time,
+           BLI_bvhtree_surface_area_cost(tree),
+           BLI_bvhtree_surface_area_cost(new_tree),
+           build_cost);
+
+    for (const float3 &origin : origins) {
+      BVHTreeRayHit hit, new_hit;
+      hit.index = new_hit.index = -1;
+      hit.dist = new_hit.dist = BVH_RAYCAST_DIST_MAX;
+      BLI_bvhtree_ray_cast(
+          tree, origin, direction, 0.0f, &hit, raycast_triangle_callback, triangles.data());
+      BLI_bvhtree_ray_cast(new_tree,
+                           origin,
+                           direction,
+                           0.0f,
+                           &new_hit,
+                           raycast_triangle_callback,
+                           triangles.data());
+      EXPECT_EQ(hit.dist, new_hit.dist);
+    }
+    BLI_bvhtree_free(new_tree);
+  }
+
+  BLI_bvhtree_free(tree);
+
+  printf("========== ENDED BVHTree refit ==========\n\n");
+}
+
+}  // namespace blender::tests
@@ -0,0 +1,91 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "BLI_kdtree.h"
+#include "BLI_math_vec_types.hh"
+#include "BLI_rand.hh"
+#include "BLI_vector.hh"
+
+#include "PIL_time.h"
+
+namespace blender::tests {
+
+/**
+ * Points on a jittered grid, in grid order like the vertices of many meshes.
+ */
+static Vector<float3> grid_points(const int resolution, const uint32_t seed)
+{
+  RandomNumberGenerator rng(seed);
+  Vector<float3> points;
+  for (const int x : IndexRange(resolution)) {
+    for (const int y : IndexRange(resolution)) {
+      for (const int z : IndexRange(resolution)) {
+        const float3 jitter(rng.get_float(), rng.get_float(), rng.get_float());
+        points.append((float3(x, y, z) + jitter * 0.5f) / float(resolution));
+      }
+    }
+  }
+  return points;
+}
+
+static void kdtree_find_nearest_test(const char *id, const int resolution, const bool shuffle)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  const Vector<float3> points = grid_points(resolution, 0);
+  Vector<float3> queries = grid_points(resolution, 1);
+  if (shuffle) {
+    RandomNumberGenerator rng(2);
+    rng.shuffle(queries.as_mutable_span());
+  }
+
+  double time = PIL_check_seconds_timer();
+  KDTree_3d *tree = BLI_kdtree_3d_new(points.size());
+  for (const int i : points.index_range()) {
+    BLI_kdtree_3d_insert(tree, i, points[i]);
+  }
+  BLI_kdtree_3d_balance(tree);
+  printf("\tBuild tree with %d points: %fs\n",
+         int(points.size()),
+         PIL_check_seconds_timer() - time);
+
+  Vector<KDTreeNearest_3d> nearest(queries.size());
+  time = PIL_check_seconds_timer();
+  for (const int i : queries.index_range()) {
+    BLI_kdtree_3d_find_nearest(tree, queries[i], &nearest[i]);
+  }
+  printf("\tFind nearest for %d points: %fs\n",
+         int(queries.size()),
+         PIL_check_seconds_timer() - time);
+
+  Vector<KDTreeNearest_3d> nearest_batch(queries.size());
+  time = PIL_check_seconds_timer();
+  BLI_kdtree_3d_find_nearest_batch(tree,
+                                   reinterpret_cast<const float(*)[3]>(queries.data()),
+                                   queries.size(),
+                                   nearest_batch.data());
+  printf("\tFind nearest batch for %d points: %fs\n",
+         int(queries.size()),
+         PIL_check_seconds_timer() - time);
+
+  for (const int i : queries.index_range()) {
+    EXPECT_EQ(nearest[i].dist, nearest_batch[i].dist);
+  }
+
+  BLI_kdtree_3d_free(tree);
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(kdtree, FindNearestGrid)
+{
+  kdtree_find_nearest_test("KDTree find nearest - grid order", 64, false);
+}
+
+TEST(kdtree, FindNearestShuffled)
+{
+  kdtree_find_nearest_test("KDTree find nearest - random order", 64, true);
+}
+
+}  // namespace blender::tests
@@ -10,15 +10,24 @@
 
 #include "BLI_filereader.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 struct GHash;
+struct MemFileSharedBuffer;
 struct Scene;
 
 typedef struct {
   void *next, *prev;
-  const char *buf;
+  /**
+   * Content of the chunk, shared by all chunks with the same content in all undo steps,
+   * see #BLO_memfile_chunk_add.
+   */
+  struct MemFileSharedBuffer *buffer;
   /** Size in bytes. */
   size_t size;
-  /** When true, this chunk doesn't own the memory, it's shared with a previous #MemFileChunk */
+  /** When true, this chunk is identical to the one at the same place in the previous step. */
   bool is_identical;
   /** When true, this chunk is also identical to the one in the next step (used by undo code to
    * detect unchanged IDs).
@@ -31,7 +40,6 @@ typedef struct {
 
 typedef struct MemFile {
   ListBase chunks;
-  size_t size;
 } MemFile;
 
 typedef struct MemFileWriteData {
@@ -48,6 +56,7 @@ typedef struct MemFileWriteData {
 typedef struct MemFileUndoData {
   char filename[1024]; /* FILE_MAX */
   MemFile memfile;
+  /** See #BLO_memfile_size_get. */
   size_t undo_size;
 } MemFileUndoData;
 
@@ -68,6 +77,11 @@ void BLO_memfile_write_init(MemFileWriteData *mem_data,
                             MemFile *reference_memfile);
 void BLO_memfile_write_finalize(MemFileWriteData *mem_data);
 
+/**
+ * Add a chunk to the written memfile. Its buffer is shared with the chunk at the same place in
+ * the reference memfile when they are identical, otherwise with any chunk of any undo step that
+ * has the same content, which is found by its hash.
+ */
 void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t size);
 
 /* exports */
@@ -87,6 +101,24 @@ extern void BLO_memfile_merge(MemFile *first, MemFile *second);
  * Clear is_identical_future before adding next memfile.
  */
 extern void BLO_memfile_clear_future(MemFile *memfile);
+/**
+ * Compress the buffers that aren't used by any of the \a hot_steps_num last written memfiles.
+ * They are decompressed again when a memfile using them is read or written as reference.
+ */
+extern void BLO_memfile_compress_cold(int hot_steps_num);
+/**
+ * Memory used by the buffers of all memfiles.
+ *
+ * \param r_memory: Total size of the buffers, when uncompressed.
+ * \param r_memory_used: Memory actually used, taking compression into account.
+ */
+extern void BLO_memfile_memory_stats(int *r_buffers_num, size_t *r_memory, size_t *r_memory_used);
+/**
+ * Memory charged to the memfile. The size of every buffer is divided between the chunks that use
+ * it, so the sizes of all memfiles add up to the size of all buffers. The size changes when other
+ * memfiles that share buffers with this one are written or freed.
+ */
+extern size_t BLO_memfile_size_get(const MemFile *memfile);
 
 /* Utilities. */
 
@@ -101,3 +133,7 @@ extern struct Main *BLO_memfile_main_get(struct MemFile *memfile,
 extern bool BLO_memfile_write_file(struct MemFile *memfile, const char *filename);
 
 FileReader *BLO_memfile_new_filereader(MemFile *memfile, int undo_direction);
+
+#ifdef __cplusplus
+}
+#endif
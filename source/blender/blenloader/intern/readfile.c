@@ -165,6 +165,20 @@
  */
 #define USE_BHEAD_READ_ON_DEMAND
 
+/**
+ * Map large data blocks of uncompressed files into memory copy-on-write instead of reading them,
+ * so pages that are never accessed are never read (e.g. mesh layers that are replaced on load).
+ *
+ * \note This is opt-in (see #UserDef_Experimental.use_mmap_file_read) since pages that weren't
+ * accessed yet would see modifications made to the file in-place by other applications.
+ * Blender itself always writes to a temporary file which is then renamed, that is safe.
+ */
+#ifdef USE_BHEAD_READ_ON_DEMAND
+#  define USE_BHEAD_READ_MMAP
+/** Smaller blocks are read, mapping them isn't worth the system calls and the page tables. */
+#  define BHEAD_READ_MMAP_MIN_SIZE (1 << 20)
+#endif
+
 /** Use #GHash for #BHead name-based lookups (speeds up linking). */
 #define USE_GHASH_BHEAD
 
@@ -1037,6 +1051,127 @@ static void decode_blender_header(FileData *fd)
   }
 }
 
+#ifdef USE_BHEAD_READ_ON_DEMAND
+/**
+ * Create the list of all blocks from the index at the end of the file (see
+ * #G_FILE_BLOCK_INDEX), instead of reading the header of every block in the file. The data of
+ * #DATA blocks is still only read when needed, so opening a library to link a few data-blocks
+ * from it only reads these data-blocks.
+ *
+ * \return False when there is no usable index, the blocks are then read from the file as usual.
+ */
+static bool read_file_block_index(FileData *fd)
+{
+  if (fd->file->seek == NULL ||
+      (fd->flags & (FD_FLAGS_IS_MEMFILE | FD_FLAGS_SWITCH_ENDIAN | FD_FLAGS_POINTSIZE_DIFFERS))) {
+    return false;
+  }
+
+  const off64_t blocks_offset = fd->file->offset;
+  BLI_assert(blocks_offset == SIZEOFBLENDERHEADER);
+
+  /* The offset of the index is stored in the #ENDB block at the end of the file. */
+  BHead endb;
+  const off64_t endb_offset = fd->file->seek(fd->file, -(off64_t)sizeof(BHead), SEEK_END);
+  if (endb_offset <= blocks_offset || fd->file->read(fd->file, &endb, sizeof(BHead)) !=
+                                          sizeof(BHead)) {
+    fd->file->seek(fd->file, blocks_offset, SEEK_SET);
+    return false;
+  }
+  const off64_t index_offset = (off64_t)(((uint64_t)(uint32_t)endb.nr << 32) |
+                                         (uint64_t)(uint32_t)endb.SDNAnr);
+
+  BHead index_bhead;
+  uchar *index = NULL;
+  bool ok = endb.code == ENDB && endb.len == 0 && index_offset >= blocks_offset &&
+            index_offset + (off64_t)sizeof(BHead) <= endb_offset &&
+            fd->file->seek(fd->file, index_offset, SEEK_SET) == index_offset &&
+            fd->file->read(fd->file, &index_bhead, sizeof(BHead)) == sizeof(BHead) &&
+            index_bhead.code == DATA &&
+            index_offset + (off64_t)sizeof(BHead) + index_bhead.len == endb_offset;
+  if (ok) {
+    index = MEM_mallocN((size_t)index_bhead.len, __func__);
+    ok = fd->file->read(fd->file, index, (size_t)index_bhead.len) == index_bhead.len;
+  }
+
+  ListBase bhead_list = {NULL, NULL};
+  off64_t offset = blocks_offset;
+  const uchar *index_iter = index;
+  const uchar *index_end = index + (ok ? index_bhead.len : 0);
+  while (ok && index_iter < index_end) {
+    BHead bhead;
+    if ((size_t)(index_end - index_iter) < sizeof(BHead)) {
+      ok = false;
+      break;
+    }
+    memcpy(&bhead, index_iter, sizeof(BHead));
+    index_iter += sizeof(BHead);
+    offset += sizeof(BHead);
+    if (bhead.len < 0 || offset + bhead.len > index_offset) {
+      ok = false;
+      break;
+    }
+
+    BHeadN *new_bhead;
+    if (BHEAD_USE_READ_ON_DEMAND(&bhead)) {
+      new_bhead = MEM_mallocN(sizeof(BHeadN), "new_bhead");
+      new_bhead->file_offset = offset;
+      new_bhead->has_data = false;
+    }
+    else {
+      new_bhead = MEM_mallocN(sizeof(BHeadN) + (size_t)bhead.len, "new_bhead");
+      new_bhead->file_offset = 0;
+      new_bhead->has_data = true;
+      if (blo_bhead_is_id(&bhead)) {
+        /* The index contains the data of ID blocks. */
+        if (index_end - index_iter < bhead.len) {
+          ok = false;
+        }
+        else {
+          memcpy(new_bhead + 1, index_iter, (size_t)bhead.len);
+          index_iter += bhead.len;
+        }
+      }
+      else {
+        /* Other blocks (global data, DNA, thumbnail...) are few, read them from the file. */
+        ok = fd->file->seek(fd->file, offset, SEEK_SET) == offset &&
+             fd->file->read(fd->file, new_bhead + 1, (size_t)bhead.len) == bhead.len;
+      }
+    }
+    new_bhead->next = new_bhead->prev = NULL;
+    new_bhead->is_memchunk_identical = false;
+    new_bhead->bhead = bhead;
+    BLI_addtail(&bhead_list, new_bhead);
+
+    offset += bhead.len;
+  }
+  /* The index must describe all blocks before it. */
+  ok = ok && offset == index_offset;
+
+  MEM_SAFE_FREE(index);
+
+  if (!ok) {
+    BLI_freelistN(&bhead_list);
+    fd->file->seek(fd->file, blocks_offset, SEEK_SET);
+    return false;
+  }
+
+  /* The index itself isn't needed in the list, only the #ENDB block remains. */
+  BHeadN *endb_bhead = MEM_mallocN(sizeof(BHeadN), "new_bhead");
+  endb_bhead->next = endb_bhead->prev = NULL;
+  endb_bhead->file_offset = 0;
+  endb_bhead->has_data = true;
+  endb_bhead->is_memchunk_identical = false;
+  endb_bhead->bhead = endb;
+  BLI_addtail(&bhead_list, endb_bhead);
+
+  BLI_assert(BLI_listbase_is_empty(&fd->bhead_list));
+  fd->bhead_list = bhead_list;
+  fd->is_eof = true;
+  return true;
+}
+#endif /* USE_BHEAD_READ_ON_DEMAND */
+
 /**
  * \return Success if the file is read correctly, else set \a r_error_message.
  */
@@ -1150,6 +1285,7 @@ static FileData *filedata_new(BlendFileReadReport *reports)
   fd->libmap = oldnewmap_new();
 
   fd->reports = reports;
+  fd->mmap_filedes = -1;
 
   return fd;
 }
@@ -1159,6 +1295,9 @@ static FileData *blo_decode_and_check(FileData *fd, ReportList *reports)
   decode_blender_header(fd);
 
   if (fd->flags & FD_FLAGS_FILE_OK) {
+#ifdef USE_BHEAD_READ_ON_DEMAND
+    read_file_block_index(fd);
+#endif
     const char *error_message = NULL;
     if (read_file_dna(fd, &error_message) == false) {
       BKE_reportf(
@@ -1240,6 +1379,14 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
   FileData *fd = filedata_new(reports);
   fd->file = file;
 
+#if defined(USE_BHEAD_READ_MMAP) && !defined(WIN32)
+  /* The readers above may close `filedes` at any time, keep a descriptor of our own. */
+  if (memcmp(header, "BLENDER", sizeof(header)) == 0 &&
+      USER_EXPERIMENTAL_TEST(&U, use_mmap_file_read)) {
+    fd->mmap_filedes = dup(filedes);
+  }
+#endif
+
   return fd;
 }
 
@@ -1351,6 +1498,9 @@ void blo_filedata_free(FileData *fd)
     }
 #endif
     fd->file->close(fd->file);
+    if (fd->mmap_filedes != -1) {
+      close(fd->mmap_filedes);
+    }
 
     if (fd->filesdna) {
       DNA_sdna_free(fd->filesdna);
@@ -1884,23 +2034,35 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
       }
       else {
         /* SDNA_CMP_EQUAL */
-        temp = MEM_mallocN(bh->len, blockname);
-#ifdef USE_BHEAD_READ_ON_DEMAND
-        if (BHEADN_FROM_BHEAD(bh)->has_data) {
-          memcpy(temp, (bh + 1), bh->len);
+#ifdef USE_BHEAD_READ_MMAP
+        if (fd->mmap_filedes != -1 && bh->len >= BHEAD_READ_MMAP_MIN_SIZE &&
+            BHEADN_FROM_BHEAD(bh)->has_data == false) {
+          /* May fail, e.g. for unaligned blocks, then read the block as usual below. */
+          temp = MEM_mmap_file_privateN(fd->mmap_filedes,
+                                        (size_t)BHEADN_FROM_BHEAD(bh)->file_offset,
+                                        (size_t)bh->len,
+                                        blockname);
         }
-        else {
-          /* Instead of allocating the bhead, then copying it,
-           * read the data from the file directly into the memory. */
-          if (UNLIKELY(!blo_bhead_read_data(fd, bh, temp))) {
-            fd->flags &= ~FD_FLAGS_FILE_OK;
-            MEM_freeN(temp);
-            temp = NULL;
+#endif
+        if (temp == NULL) {
+          temp = MEM_mallocN(bh->len, blockname);
+#ifdef USE_BHEAD_READ_ON_DEMAND
+          if (BHEADN_FROM_BHEAD(bh)->has_data) {
+            memcpy(temp, (bh + 1), bh->len);
+          }
+          else {
+            /* Instead of allocating the bhead, then copying it,
+             * read the data from the file directly into the memory. */
+            if (UNLIKELY(!blo_bhead_read_data(fd, bh, temp))) {
+              fd->flags &= ~FD_FLAGS_FILE_OK;
+              MEM_freeN(temp);
+              temp = NULL;
+            }
           }
-        }
 #else
-        memcpy(temp, (bh + 1), bh->len);
+          memcpy(temp, (bh + 1), bh->len);
 #endif
+        }
       }
     }
 
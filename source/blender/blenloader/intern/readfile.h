@@ -51,6 +51,11 @@ typedef struct FileData {
   bool is_eof;
 
   FileReader *file;
+  /**
+   * Own descriptor of an uncompressed file, to map large data blocks instead of reading them,
+   * see #USE_BHEAD_READ_MMAP. -1 when unused.
+   */
+  int mmap_filedes;
 
   /** Whether we are undoing (< 0) or redoing (> 0), used to choose which 'unchanged' flag to use
    * to detect unchanged data from memfile. */
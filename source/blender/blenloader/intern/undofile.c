@@ -19,12 +19,17 @@
 #  include <io.h>
 #endif
 
+#include <zstd.h>
+
 #include "MEM_guardedalloc.h"
 
 #include "DNA_listBase.h"
 
 #include "BLI_blenlib.h"
 #include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BLO_readfile.h"
 #include "BLO_undofile.h"
@@ -36,53 +41,259 @@
 /* keep last */
 #include "BLI_strict_flags.h"
 
-/* **************** support for memory-write, for undo buffers *************** */
+/* -------------------------------------------------------------------- */
+/** \name Shared Chunk Buffers
+ *
+ * The content of every chunk is stored once in a reference counted buffer, no matter how many
+ * chunks of how many undo steps have that content. Buffers are found by a hash of their content.
+ *
+ * The storage is global, it's shared by the memfiles of all undo stacks. All access to it, and to
+ * the buffers in it, is done with #memfile_buffers_mutex locked. The static functions below
+ * expect the caller to hold the lock.
+ * \{ */
+
+/** Buffers smaller than this aren't compressed, the gain wouldn't be worth it. */
+#define MEMFILE_COMPRESS_MIN_SIZE 4096
+#define MEMFILE_COMPRESSION_LEVEL 1
+
+typedef struct MemFileSharedBuffer {
+  /** Next buffer with the same hash. */
+  struct MemFileSharedBuffer *next;
+  uint hash;
+  int users;
+  /** Value of #MemFileBufferStorage.generation when the buffer was last written. */
+  uint generation;
+  size_t size;
+  /** Uncompressed content, NULL while the buffer is compressed. */
+  char *data;
+  /** Compressed content, NULL when the buffer isn't compressed. */
+  void *data_compressed;
+  size_t size_compressed;
+} MemFileSharedBuffer;
+
+static struct MemFileBufferStorage {
+  /** Map a content hash to the first #MemFileSharedBuffer with that hash. */
+  GHash *buffers_by_hash;
+  /** Incremented for every written memfile. */
+  uint generation;
+  int buffers_num;
+  size_t memory;
+  size_t memory_used;
+} memfile_buffers = {NULL};
+
+static ThreadMutex memfile_buffers_mutex = BLI_MUTEX_INITIALIZER;
+
+static uint memfile_buffer_hash(const char *buf, size_t size)
+{
+  return BLI_hash_mm2((const unsigned char *)buf, size, 0);
+}
 
-void BLO_memfile_free(MemFile *memfile)
+static const char *memfile_buffer_data_ensure(MemFileSharedBuffer *buffer)
 {
-  MemFileChunk *chunk;
+  if (buffer->data == NULL) {
+    buffer->data = MEM_mallocN(buffer->size, "Chunk buffer");
+    const size_t size = ZSTD_decompress(
+        buffer->data, buffer->size, buffer->data_compressed, buffer->size_compressed);
+    BLI_assert(size == buffer->size);
+    UNUSED_VARS_NDEBUG(size);
+    memfile_buffers.memory_used += buffer->size;
+    memfile_buffers.memory_used -= buffer->size_compressed;
+    MEM_freeN(buffer->data_compressed);
+    buffer->data_compressed = NULL;
+    buffer->size_compressed = 0;
+  }
+  return buffer->data;
+}
 
-  while ((chunk = BLI_pophead(&memfile->chunks))) {
-    if (chunk->is_identical == false) {
-      MEM_freeN((void *)chunk->buf);
+/**
+ * Get a buffer with the given content, adding a new one when there is none yet.
+ */
+static MemFileSharedBuffer *memfile_buffer_ensure(const char *buf, size_t size)
+{
+  if (memfile_buffers.buffers_by_hash == NULL) {
+    memfile_buffers.buffers_by_hash = BLI_ghash_new(
+        BLI_ghashutil_inthash_p_simple, BLI_ghashutil_intcmp, __func__);
+  }
+
+  const uint hash = memfile_buffer_hash(buf, size);
+  void **first_p;
+  if (BLI_ghash_ensure_p(memfile_buffers.buffers_by_hash, POINTER_FROM_UINT(hash), &first_p)) {
+    for (MemFileSharedBuffer *buffer = *first_p; buffer != NULL; buffer = buffer->next) {
+      if (buffer->size == size && memcmp(memfile_buffer_data_ensure(buffer), buf, size) == 0) {
+        buffer->users++;
+        return buffer;
+      }
     }
-    MEM_freeN(chunk);
   }
-  memfile->size = 0;
+  else {
+    *first_p = NULL;
+  }
+
+  MemFileSharedBuffer *buffer = MEM_callocN(sizeof(MemFileSharedBuffer), __func__);
+  buffer->next = *first_p;
+  buffer->hash = hash;
+  buffer->users = 1;
+  buffer->size = size;
+  buffer->data = MEM_mallocN(size, "Chunk buffer");
+  memcpy(buffer->data, buf, size);
+  *first_p = buffer;
+
+  memfile_buffers.buffers_num++;
+  memfile_buffers.memory += size;
+  memfile_buffers.memory_used += size;
+  return buffer;
 }
 
-void BLO_memfile_merge(MemFile *first, MemFile *second)
+static void memfile_buffer_release(MemFileSharedBuffer *buffer)
 {
-  /* We use this mapping to store the memory buffers from second memfile chunks which are not owned
-   * by it (i.e. shared with some previous memory steps). */
-  GHash *buffer_to_second_memchunk = BLI_ghash_new(
-      BLI_ghashutil_ptrhash, BLI_ghashutil_ptrcmp, __func__);
-
-  /* First, detect all memchunks in second memfile that are not owned by it. */
-  for (MemFileChunk *sc = second->chunks.first; sc != NULL; sc = sc->next) {
-    if (sc->is_identical) {
-      BLI_ghash_insert(buffer_to_second_memchunk, (void *)sc->buf, sc);
-    }
+  BLI_assert(buffer->users > 0);
+  if (--buffer->users > 0) {
+    return;
+  }
+
+  void **first_p = BLI_ghash_lookup_p(memfile_buffers.buffers_by_hash,
+                                      POINTER_FROM_UINT(buffer->hash));
+  MemFileSharedBuffer **buffer_p = (MemFileSharedBuffer **)first_p;
+  while (*buffer_p != buffer) {
+    buffer_p = &(*buffer_p)->next;
+  }
+  *buffer_p = buffer->next;
+  if (*first_p == NULL) {
+    BLI_ghash_remove(memfile_buffers.buffers_by_hash, POINTER_FROM_UINT(buffer->hash), NULL, NULL);
+  }
+
+  memfile_buffers.buffers_num--;
+  memfile_buffers.memory -= buffer->size;
+  if (buffer->data != NULL) {
+    memfile_buffers.memory_used -= buffer->size;
+    MEM_freeN(buffer->data);
   }
+  else {
+    memfile_buffers.memory_used -= buffer->size_compressed;
+    MEM_freeN(buffer->data_compressed);
+  }
+  MEM_freeN(buffer);
+
+  /* Don't keep the map around once all undo steps are freed. */
+  if (memfile_buffers.buffers_num == 0) {
+    BLI_ghash_free(memfile_buffers.buffers_by_hash, NULL, NULL);
+    memfile_buffers.buffers_by_hash = NULL;
+  }
+}
+
+static void memfile_buffer_compress_fn(void *__restrict userdata,
+                                       const int index,
+                                       const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MemFileSharedBuffer *buffer = ((MemFileSharedBuffer **)userdata)[index];
+  const size_t bound = ZSTD_compressBound(buffer->size);
+  void *data_compressed = MEM_mallocN(bound, "Chunk buffer compressed");
+  const size_t size_compressed = ZSTD_compress(
+      data_compressed, bound, buffer->data, buffer->size, MEMFILE_COMPRESSION_LEVEL);
+  if (ZSTD_isError(size_compressed) || size_compressed >= buffer->size) {
+    /* Keep incompressible buffers as they are. */
+    MEM_freeN(data_compressed);
+    return;
+  }
+  buffer->data_compressed = MEM_reallocN(data_compressed, size_compressed);
+  buffer->size_compressed = size_compressed;
+  MEM_freeN(buffer->data);
+  buffer->data = NULL;
+}
 
-  /* Now, check all chunks from first memfile (the one we are removing), and if a memchunk owned by
-   * it is also used by the second memfile, transfer the ownership. */
-  for (MemFileChunk *fc = first->chunks.first; fc != NULL; fc = fc->next) {
-    if (!fc->is_identical) {
-      MemFileChunk *sc = BLI_ghash_lookup(buffer_to_second_memchunk, fc->buf);
-      if (sc != NULL) {
-        BLI_assert(sc->is_identical);
-        sc->is_identical = false;
-        fc->is_identical = true;
+typedef struct MemFileCompressData {
+  MemFileSharedBuffer **buffers;
+  int buffers_num;
+} MemFileCompressData;
+
+static void memfile_buffers_compress_isolated(void *userdata)
+{
+  MemFileCompressData *data = userdata;
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 4;
+  BLI_task_parallel_range(
+      0, data->buffers_num, data->buffers, memfile_buffer_compress_fn, &settings);
+}
+
+void BLO_memfile_compress_cold(int hot_steps_num)
+{
+  BLI_mutex_lock(&memfile_buffers_mutex);
+  if (memfile_buffers.buffers_by_hash == NULL ||
+      memfile_buffers.generation < (uint)hot_steps_num) {
+    BLI_mutex_unlock(&memfile_buffers_mutex);
+    return;
+  }
+  const uint cold_generation = memfile_buffers.generation - (uint)hot_steps_num;
+
+  MemFileSharedBuffer **buffers = MEM_malloc_arrayN(
+      (size_t)memfile_buffers.buffers_num, sizeof(*buffers), __func__);
+  int buffers_num = 0;
+  GHASH_FOREACH_BEGIN (MemFileSharedBuffer *, first, memfile_buffers.buffers_by_hash) {
+    for (MemFileSharedBuffer *buffer = first; buffer != NULL; buffer = buffer->next) {
+      if (buffer->data != NULL && buffer->generation <= cold_generation &&
+          buffer->size >= MEMFILE_COMPRESS_MIN_SIZE) {
+        buffers[buffers_num++] = buffer;
       }
-      /* Note that if the second memfile does not use that chunk, we assume that the first one
-       * fully owns it without sharing it with any other memfile, and hence it should be freed with
-       * it. */
     }
   }
+  GHASH_FOREACH_END();
+
+  /* Compress in isolation, so that this thread doesn't run other tasks that may need the lock
+   * while waiting. */
+  MemFileCompressData data = {buffers, buffers_num};
+  BLI_task_isolate(memfile_buffers_compress_isolated, &data);
 
-  BLI_ghash_free(buffer_to_second_memchunk, NULL, NULL);
+  for (int i = 0; i < buffers_num; i++) {
+    if (buffers[i]->data == NULL) {
+      memfile_buffers.memory_used -= buffers[i]->size;
+      memfile_buffers.memory_used += buffers[i]->size_compressed;
+    }
+  }
+  MEM_freeN(buffers);
+  BLI_mutex_unlock(&memfile_buffers_mutex);
+}
+
+void BLO_memfile_memory_stats(int *r_buffers_num, size_t *r_memory, size_t *r_memory_used)
+{
+  BLI_mutex_lock(&memfile_buffers_mutex);
+  *r_buffers_num = memfile_buffers.buffers_num;
+  *r_memory = memfile_buffers.memory;
+  *r_memory_used = memfile_buffers.memory_used;
+  BLI_mutex_unlock(&memfile_buffers_mutex);
+}
+
+size_t BLO_memfile_size_get(const MemFile *memfile)
+{
+  size_t size = 0;
+  BLI_mutex_lock(&memfile_buffers_mutex);
+  LISTBASE_FOREACH (const MemFileChunk *, chunk, &memfile->chunks) {
+    size += chunk->size / (size_t)chunk->buffer->users;
+  }
+  BLI_mutex_unlock(&memfile_buffers_mutex);
+  return size;
+}
 
+/** \} */
+
+/* **************** support for memory-write, for undo buffers *************** */
+
+void BLO_memfile_free(MemFile *memfile)
+{
+  MemFileChunk *chunk;
+
+  BLI_mutex_lock(&memfile_buffers_mutex);
+  while ((chunk = BLI_pophead(&memfile->chunks))) {
+    memfile_buffer_release(chunk->buffer);
+    MEM_freeN(chunk);
+  }
+  BLI_mutex_unlock(&memfile_buffers_mutex);
+}
+
+void BLO_memfile_merge(MemFile *first, MemFile *second)
+{
+  /* Buffers are reference counted, the ones shared with the second memfile are kept. */
+  UNUSED_VARS(second);
   BLO_memfile_free(first);
 }
 
@@ -99,6 +310,9 @@ void BLO_memfile_write_init(MemFileWriteData *mem_data,
 {
   mem_data->written_memfile = written_memfile;
   mem_data->reference_memfile = reference_memfile;
+  BLI_mutex_lock(&memfile_buffers_mutex);
+  memfile_buffers.generation++;
+  BLI_mutex_unlock(&memfile_buffers_mutex);
   mem_data->reference_current_chunk = reference_memfile ? reference_memfile->chunks.first : NULL;
 
   /* If we have a reference memfile, we generate a mapping between the session_uuid's of the
@@ -141,7 +355,7 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
 
   MemFileChunk *curchunk = MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk");
   curchunk->size = size;
-  curchunk->buf = NULL;
+  curchunk->buffer = NULL;
   curchunk->is_identical = false;
   /* This is unsafe in the sense that an app handler or other code that does not
    * perform an undo push may make changes after the last undo push that
@@ -150,12 +364,15 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
   curchunk->id_session_uuid = mem_data->current_id_session_uuid;
   BLI_addtail(&memfile->chunks, curchunk);
 
+  BLI_mutex_lock(&memfile_buffers_mutex);
+
   /* we compare compchunk with buf */
   if (*compchunk_step != NULL) {
     MemFileChunk *compchunk = *compchunk_step;
     if (compchunk->size == curchunk->size) {
-      if (memcmp(compchunk->buf, buf, size) == 0) {
-        curchunk->buf = compchunk->buf;
+      if (memcmp(memfile_buffer_data_ensure(compchunk->buffer), buf, size) == 0) {
+        curchunk->buffer = compchunk->buffer;
+        curchunk->buffer->users++;
         curchunk->is_identical = true;
         compchunk->is_identical_future = true;
       }
@@ -163,13 +380,13 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
     *compchunk_step = compchunk->next;
   }
 
-  /* not equal... */
-  if (curchunk->buf == NULL) {
-    char *buf_new = MEM_mallocN(size, "Chunk buffer");
-    memcpy(buf_new, buf, size);
-    curchunk->buf = buf_new;
-    memfile->size += size;
+  /* Not equal to the reference, but may still be equal to a chunk elsewhere in the history. */
+  if (curchunk->buffer == NULL) {
+    curchunk->buffer = memfile_buffer_ensure(buf, size);
   }
+  curchunk->buffer->generation = memfile_buffers.generation;
+
+  BLI_mutex_unlock(&memfile_buffers_mutex);
 }
 
 struct Main *BLO_memfile_main_get(struct MemFile *memfile,
@@ -226,16 +443,20 @@ bool BLO_memfile_write_file(struct MemFile *memfile, const char *filename)
     return false;
   }
 
+  BLI_mutex_lock(&memfile_buffers_mutex);
   for (chunk = memfile->chunks.first; chunk; chunk = chunk->next) {
 #ifdef _WIN32
-    if ((size_t)write(file, chunk->buf, (uint)chunk->size) != chunk->size)
+    if ((size_t)write(file, memfile_buffer_data_ensure(chunk->buffer), (uint)chunk->size) !=
+        chunk->size)
 #else
-    if ((size_t)write(file, chunk->buf, chunk->size) != chunk->size)
+    if ((size_t)write(file, memfile_buffer_data_ensure(chunk->buffer), chunk->size) !=
+        chunk->size)
 #endif
     {
       break;
     }
   }
+  BLI_mutex_unlock(&memfile_buffers_mutex);
 
   close(file);
 
@@ -305,7 +526,11 @@ static ssize_t undo_read(FileReader *reader, void *buffer, size_t size)
         readsize = chunk->size - chunkoffset;
       }
 
-      memcpy(POINTER_OFFSET(buffer, totread), chunk->buf + chunkoffset, readsize);
+      BLI_mutex_lock(&memfile_buffers_mutex);
+      memcpy(POINTER_OFFSET(buffer, totread),
+             memfile_buffer_data_ensure(chunk->buffer) + chunkoffset,
+             readsize);
+      BLI_mutex_unlock(&memfile_buffers_mutex);
       totread += readsize;
       undo->reader.offset += (off64_t)readsize;
       seek += readsize;
@@ -54,6 +54,8 @@
  * - write #GLOB (#FileGlobal struct) (some global vars).
  * - write #DNA1 (#SDNA struct)
  * - write #USER (#UserDef struct) if filename is `~/.config/blender/X.XX/config/startup.blend`.
+ * - write the index of all blocks above as a #DATA block, with #G_FILE_BLOCK_INDEX.
+ * - write #ENDB (with the offset of the block index, if any).
  */
 
 #include <fcntl.h>
@@ -89,6 +91,7 @@
 #include "BLI_linklist.h"
 #include "BLI_math_base.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "MEM_guardedalloc.h" /* MEM_freeN */
 
@@ -136,6 +139,9 @@
 /** Use if we want to store how many bytes have been written to the file. */
 // #define USE_WRITE_DATA_LEN
 
+/** Maximum number of data-blocks serialized in parallel before their output is written. */
+#define WRITE_ID_BATCH_SIZE 64
+
 /* -------------------------------------------------------------------- */
 /** \name Internal Write Wrapper's (Abstracts Compression)
  * \{ */
@@ -390,6 +396,30 @@ static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
 /** \name Write Data Type & Functions
  * \{ */
 
+/** Growable memory buffer. */
+typedef struct WriteMemBuffer {
+  uchar *data;
+  size_t used_len;
+  size_t max_len;
+} WriteMemBuffer;
+
+/**
+ * In-memory output of a single data-block, when it is serialized on a worker thread.
+ *
+ * The length of every #mywrite call is recorded, so that replaying them into the actual
+ * #WriteData produces exactly the same chunks (and compressed frames) as a serial write would.
+ */
+typedef struct WriteIDBuffer {
+  WriteMemBuffer mem;
+
+  size_t *segments;
+  size_t segments_num;
+  size_t segments_max;
+
+  /** Entries of the data-block for #WriteData.block_index. */
+  WriteMemBuffer block_index;
+} WriteIDBuffer;
+
 typedef struct {
   const struct SDNA *sdna;
 
@@ -424,6 +454,15 @@ typedef struct {
    * Will be NULL for UNDO.
    */
   WriteWrap *ww;
+
+  /** When set, everything is appended to this buffer instead (see #write_ids_parallel). */
+  WriteIDBuffer *id_buffer;
+
+  /**
+   * When set, the header of every block is added to this buffer, followed by its data for ID
+   * blocks. It is written at the end of the file, see #G_FILE_BLOCK_INDEX.
+   */
+  WriteMemBuffer *block_index;
 } WriteData;
 
 typedef struct BlendWriter {
@@ -489,6 +528,47 @@ static void writedata_free(WriteData *wd)
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Deferred Data-Block Output
+ * \{ */
+
+static void write_mem_buffer_append(WriteMemBuffer *mbuf, const void *adr, size_t len)
+{
+  if (mbuf->used_len + len > mbuf->max_len) {
+    mbuf->max_len = MAX2(mbuf->max_len * 2, mbuf->used_len + len);
+    mbuf->data = MEM_reallocN(mbuf->data, mbuf->max_len);
+  }
+  memcpy(&mbuf->data[mbuf->used_len], adr, len);
+  mbuf->used_len += len;
+}
+
+static void write_mem_buffer_free(WriteMemBuffer *mbuf)
+{
+  MEM_SAFE_FREE(mbuf->data);
+  mbuf->used_len = mbuf->max_len = 0;
+}
+
+static void write_id_buffer_append(WriteIDBuffer *idbuf, const void *adr, size_t len)
+{
+  write_mem_buffer_append(&idbuf->mem, adr, len);
+
+  if (idbuf->segments_num == idbuf->segments_max) {
+    idbuf->segments_max = MAX2(idbuf->segments_max * 2, 64);
+    idbuf->segments = MEM_reallocN(idbuf->segments, sizeof(size_t) * idbuf->segments_max);
+  }
+  idbuf->segments[idbuf->segments_num++] = len;
+}
+
+static void write_id_buffer_free(WriteIDBuffer *idbuf)
+{
+  write_mem_buffer_free(&idbuf->mem);
+  write_mem_buffer_free(&idbuf->block_index);
+  MEM_SAFE_FREE(idbuf->segments);
+  idbuf->segments_num = idbuf->segments_max = 0;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Local Writing API 'mywrite'
  * \{ */
@@ -521,6 +601,11 @@ static void mywrite(WriteData *wd, const void *adr, size_t len)
     return;
   }
 
+  if (wd->id_buffer != NULL) {
+    write_id_buffer_append(wd->id_buffer, adr, len);
+    return;
+  }
+
 #ifdef USE_WRITE_DATA_LEN
   wd->write_len += len;
 #endif
@@ -649,6 +734,23 @@ static void mywrite_id_end(WriteData *wd, ID *UNUSED(id))
 /** \name Generic DNA File Writing
  * \{ */
 
+/**
+ * Write a block header followed by #BHead.len bytes of data.
+ */
+static void mywrite_block(WriteData *wd, const BHead *bh, const void *data)
+{
+  if (wd->block_index != NULL) {
+    write_mem_buffer_append(wd->block_index, bh, sizeof(BHead));
+    /* ID names are needed to look data-blocks up, so the index stores the whole ID struct. */
+    if (bh->code <= 0xFFFF) {
+      write_mem_buffer_append(wd->block_index, data, (size_t)bh->len);
+    }
+  }
+
+  mywrite(wd, bh, sizeof(BHead));
+  mywrite(wd, data, (size_t)bh->len);
+}
+
 static void writestruct_at_address_nr(
     WriteData *wd, int filecode, const int struct_nr, int nr, const void *adr, const void *data)
 {
@@ -674,8 +776,7 @@ static void writestruct_at_address_nr(
     return;
   }
 
-  mywrite(wd, &bh, sizeof(BHead));
-  mywrite(wd, data, (size_t)bh.len);
+  mywrite_block(wd, &bh, data);
 }
 
 static void writestruct_nr(
@@ -708,8 +809,7 @@ static void writedata(WriteData *wd, int filecode, size_t len, const void *adr)
   bh.SDNAnr = 0;
   bh.len = (int)len;
 
-  mywrite(wd, &bh, sizeof(BHead));
-  mywrite(wd, adr, len);
+  mywrite_block(wd, &bh, adr);
 }
 
 /* use this to force writing of lists in same order as reading (using link_list) */
@@ -1025,6 +1125,9 @@ static void write_global(WriteData *wd, int fileflags, Main *mainvar)
 
   /* prevent to save this, is not good convention, and feature with concerns... */
   fg.fileflags = (fileflags & ~G_FILE_FLAG_ALL_RUNTIME);
+  /* The block index is found through the #ENDB block, the flag is only a write option. Not
+   * storing it keeps all blocks before the index identical to a file without index. */
+  fg.fileflags &= ~G_FILE_BLOCK_INDEX;
 
   fg.globalf = G.f;
   /* Write information needed for recovery. */
@@ -1070,6 +1173,155 @@ static void write_thumb(WriteData *wd, const BlendThumbnail *thumb)
 /** \name File Writing (Private)
  * \{ */
 
+/**
+ * Write a data-block, through a copy of its struct in which runtime data is cleared.
+ *
+ * \param id_buffer: Memory for the copy, at least as large as the struct of the ID type.
+ */
+static void write_id(WriteData *wd, ID *id, void *id_buffer)
+{
+  const IDTypeInfo *id_type = BKE_idtype_get_info_from_id(id);
+  BlendWriter writer = {wd};
+
+  memcpy(id_buffer, id, id_type->struct_size);
+
+  /* Clear runtime data to reduce false detection of changed data in undo/redo context. */
+  ((ID *)id_buffer)->tag = 0;
+  ((ID *)id_buffer)->us = 0;
+  ((ID *)id_buffer)->icon_id = 0;
+  /* Those listbase data change every time we add/remove an ID, and also often when
+   * renaming one (due to re-sorting). This avoids generating a lot of false 'is changed'
+   * detections between undo steps. */
+  ((ID *)id_buffer)->prev = NULL;
+  ((ID *)id_buffer)->next = NULL;
+  /* Those runtime pointers should never be set during writing stage, but just in case clear
+   * them too. */
+  ((ID *)id_buffer)->orig_id = NULL;
+  ((ID *)id_buffer)->newid = NULL;
+  /* Even though in theory we could be able to preserve this python instance across undo even
+   * when we need to re-read the ID into its original address, this is currently cleared in
+   * #direct_link_id_common in `readfile.c` anyway, */
+  ((ID *)id_buffer)->py_instance = NULL;
+
+  if (id_type->blend_write != NULL) {
+    id_type->blend_write(&writer, (ID *)id_buffer, id);
+  }
+}
+
+/**
+ * ID types whose `blend_write` callback only reads the original data-block and its own
+ * temporary copy, so that several data-blocks of that type can be written at the same time.
+ * These are the types that usually hold most of the data of large files.
+ */
+static bool write_id_type_supports_threading(const short id_code)
+{
+  return ELEM(id_code, ID_ME, ID_CV, ID_PT, ID_VO, ID_KE, ID_AC, ID_GD, ID_IM, ID_SO, ID_VF);
+}
+
+typedef struct WriteIDsParallelData {
+  const struct SDNA *sdna;
+  bool use_block_index;
+  ID **ids;
+  WriteIDBuffer *buffers;
+} WriteIDsParallelData;
+
+static void write_ids_parallel_fn(void *__restrict userdata,
+                                  const int index,
+                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  WriteIDsParallelData *data = userdata;
+  ID *id = data->ids[index];
+
+  WriteData id_wd = {
+      .sdna = data->sdna,
+      .id_buffer = &data->buffers[index],
+      .block_index = data->use_block_index ? &data->buffers[index].block_index : NULL,
+  };
+  void *id_buffer = MEM_mallocN(BKE_idtype_get_info_from_id(id)->struct_size, __func__);
+  write_id(&id_wd, id, id_buffer);
+  MEM_freeN(id_buffer);
+}
+
+/**
+ * Serialize data-blocks into separate buffers in parallel, then write these buffers in order.
+ * The resulting file is exactly the same as when writing the data-blocks one after the other.
+ *
+ * \note Library override operations must already be stored for the data-blocks that need them,
+ * they are restored here once the data-blocks are written.
+ */
+static void write_ids_parallel(WriteData *wd,
+                               OverrideLibraryStorage *override_storage,
+                               ID **ids,
+                               const bool *ids_do_override,
+                               const int ids_num)
+{
+  WriteIDBuffer *buffers = MEM_calloc_arrayN(ids_num, sizeof(*buffers), __func__);
+  WriteIDsParallelData data = {wd->sdna, wd->block_index != NULL, ids, buffers};
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, ids_num, &data, write_ids_parallel_fn, &settings);
+
+  for (int i = 0; i < ids_num; i++) {
+    WriteIDBuffer *idbuf = &buffers[i];
+
+    mywrite_id_begin(wd, ids[i]);
+    const uchar *adr = idbuf->mem.data;
+    for (size_t segment = 0; segment < idbuf->segments_num; segment++) {
+      mywrite(wd, adr, idbuf->segments[segment]);
+      adr += idbuf->segments[segment];
+    }
+    if (wd->block_index != NULL) {
+      write_mem_buffer_append(
+          wd->block_index, idbuf->block_index.data, idbuf->block_index.used_len);
+    }
+    write_id_buffer_free(idbuf);
+
+    if (ids_do_override[i]) {
+      BKE_lib_override_library_operations_store_end(override_storage, ids[i]);
+    }
+
+    mywrite_id_end(wd, ids[i]);
+  }
+
+  MEM_freeN(buffers);
+}
+
+/**
+ * Write the index of all blocks written so far (see #G_FILE_BLOCK_INDEX), so that readers can
+ * get the layout of the file without scanning it.
+ *
+ * The index is a #DATA block that isn't referenced by anything, so readers that don't use it
+ * skip it without loading it. Its offset is stored in the otherwise unused #BHead.SDNAnr (low
+ * bits) and #BHead.nr (high bits) of the #ENDB block, which is always at the end of the file.
+ */
+static void write_block_index(WriteData *wd, BHead *endb)
+{
+  WriteMemBuffer *block_index = wd->block_index;
+  /* Don't add the index to itself. */
+  wd->block_index = NULL;
+
+  if (block_index->used_len > INT_MAX) {
+    return;
+  }
+
+  uint64_t index_offset = SIZEOFBLENDERHEADER;
+  for (size_t pos = 0; pos < block_index->used_len;) {
+    BHead bh;
+    memcpy(&bh, &block_index->data[pos], sizeof(BHead));
+    pos += sizeof(BHead) + ((bh.code <= 0xFFFF) ? (size_t)bh.len : 0);
+    index_offset += sizeof(BHead) + (size_t)bh.len;
+  }
+
+  /* All block sizes are multiples of 4, so #writedata doesn't add padding. */
+  BLI_assert((block_index->used_len & 3) == 0);
+  writedata(wd, DATA, block_index->used_len, block_index->data);
+
+  endb->SDNAnr = (int)(uint32_t)index_offset;
+  endb->nr = (int)(uint32_t)(index_offset >> 32);
+}
+
 /* if MemFile * there's filesave to memory */
 static bool write_file_handle(Main *mainvar,
                               WriteWrap *ww,
@@ -1095,7 +1347,13 @@ static bool write_file_handle(Main *mainvar,
           (ENDIAN_ORDER == B_ENDIAN) ? 'V' : 'v',
           BLENDER_FILE_VERSION);
 
-  mywrite(wd, buf, 12);
+  mywrite(wd, buf, SIZEOFBLENDERHEADER);
+
+  /* Undo steps are always read entirely, an index wouldn't help them. */
+  WriteMemBuffer block_index = {NULL};
+  if ((write_flags & G_FILE_BLOCK_INDEX) && current == NULL) {
+    wd->block_index = &block_index;
+  }
 
   write_renderinfo(wd, mainvar);
   write_thumb(wd, thumb);
@@ -1132,6 +1390,14 @@ static bool write_file_handle(Main *mainvar,
         id_buffer = MEM_mallocN(idtype_struct_size, __func__);
       }
 
+      /* Undo steps are always written serially, the memfile chunks are compared in order. */
+      const bool use_threading = !wd->use_memfile &&
+                                 write_id_type_supports_threading(GS(id->name)) &&
+                                 BLI_system_thread_count() > 1;
+      ID *batch_ids[WRITE_ID_BATCH_SIZE];
+      bool batch_do_override[WRITE_ID_BATCH_SIZE];
+      int batch_num = 0;
+
       for (; id; id = id->next) {
         /* We should never attempt to write non-regular IDs
          * (i.e. all kind of temp/runtime ones). */
@@ -1153,6 +1419,16 @@ static bool write_file_handle(Main *mainvar,
           BKE_lib_override_library_operations_store_start(bmain, override_storage, id);
         }
 
+        if (use_threading) {
+          batch_ids[batch_num] = id;
+          batch_do_override[batch_num] = do_override;
+          if (++batch_num == WRITE_ID_BATCH_SIZE) {
+            write_ids_parallel(wd, override_storage, batch_ids, batch_do_override, batch_num);
+            batch_num = 0;
+          }
+          continue;
+        }
+
         if (wd->use_memfile) {
           /* Record the changes that happened up to this undo push in
            * recalc_up_to_undo_push, and clear recalc_after_undo_push again
@@ -1177,30 +1453,7 @@ static bool write_file_handle(Main *mainvar,
 
         mywrite_id_begin(wd, id);
 
-        memcpy(id_buffer, id, idtype_struct_size);
-
-        /* Clear runtime data to reduce false detection of changed data in undo/redo context. */
-        ((ID *)id_buffer)->tag = 0;
-        ((ID *)id_buffer)->us = 0;
-        ((ID *)id_buffer)->icon_id = 0;
-        /* Those listbase data change every time we add/remove an ID, and also often when
-         * renaming one (due to re-sorting). This avoids generating a lot of false 'is changed'
-         * detections between undo steps. */
-        ((ID *)id_buffer)->prev = NULL;
-        ((ID *)id_buffer)->next = NULL;
-        /* Those runtime pointers should never be set during writing stage, but just in case clear
-         * them too. */
-        ((ID *)id_buffer)->orig_id = NULL;
-        ((ID *)id_buffer)->newid = NULL;
-        /* Even though in theory we could be able to preserve this python instance across undo even
-         * when we need to re-read the ID into its original address, this is currently cleared in
-         * #direct_link_id_common in `readfile.c` anyway, */
-        ((ID *)id_buffer)->py_instance = NULL;
-
-        const IDTypeInfo *id_type = BKE_idtype_get_info_from_id(id);
-        if (id_type->blend_write != NULL) {
-          id_type->blend_write(&writer, (ID *)id_buffer, id);
-        }
+        write_id(wd, id, id_buffer);
 
         if (do_override) {
           BKE_lib_override_library_operations_store_end(override_storage, id);
@@ -1209,6 +1462,10 @@ static bool write_file_handle(Main *mainvar,
         mywrite_id_end(wd, id);
       }
 
+      if (batch_num != 0) {
+        write_ids_parallel(wd, override_storage, batch_ids, batch_do_override, batch_num);
+      }
+
       if (id_buffer != id_buffer_static) {
         MEM_SAFE_FREE(id_buffer);
       }
@@ -1241,6 +1498,10 @@ static bool write_file_handle(Main *mainvar,
   /* end of file */
   memset(&bhead, 0, sizeof(BHead));
   bhead.code = ENDB;
+  if (wd->block_index != NULL) {
+    write_block_index(wd, &bhead);
+    write_mem_buffer_free(&block_index);
+  }
   mywrite(wd, &bhead, sizeof(BHead));
 
   blo_join_main(&mainlist);
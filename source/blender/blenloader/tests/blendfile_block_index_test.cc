@@ -0,0 +1,172 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#include "blendfile_loading_base_test.h"
+
+#include <algorithm>
+#include <string>
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_appdir.h"
+#include "BKE_global.h"
+#include "BKE_lib_id.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+
+#include "BLI_fileops.h"
+#include "BLI_linklist.h"
+#include "BLI_path_util.h"
+
+#include "BLO_blend_defs.h"
+#include "BLO_readfile.h"
+#include "BLO_writefile.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_sdna_types.h"
+
+class BlendfileBlockIndexTest : public BlendfileLoadingBaseTest {
+ protected:
+  Main *bmain = nullptr;
+
+  void SetUp() override
+  {
+    BKE_tempdir_init(nullptr);
+    bmain = BKE_main_new();
+    for (int i = 0; i < 100; i++) {
+      const std::string name = "Mesh" + std::to_string(i);
+      Mesh *mesh = BKE_mesh_add(bmain, name.c_str());
+      id_fake_user_set(&mesh->id);
+    }
+  }
+
+  void TearDown() override
+  {
+    BKE_main_free(bmain);
+    BlendfileLoadingBaseTest::TearDown();
+  }
+
+  std::string write(const char *filename, const int write_flags)
+  {
+    char filepath[FILE_MAX];
+    BLI_join_dirfile(filepath, sizeof(filepath), BKE_tempdir_base(), filename);
+    BlendFileWriteParams params{};
+    EXPECT_TRUE(BLO_write_file(bmain, filepath, write_flags, &params, nullptr));
+    return filepath;
+  }
+
+  /** Names of the meshes in the file, as seen when linking from it. */
+  static std::string read_mesh_names(const std::string &filepath)
+  {
+    BlendFileReadReport bf_reports{};
+    BlendHandle *bh = BLO_blendhandle_from_file(filepath.c_str(), &bf_reports);
+    EXPECT_NE(bh, nullptr);
+    if (bh == nullptr) {
+      return "";
+    }
+    int names_num = 0;
+    LinkNode *names = BLO_blendhandle_get_datablock_names(bh, ID_ME, false, &names_num);
+    std::string result;
+    for (LinkNode *link = names; link; link = link->next) {
+      result += static_cast<const char *>(link->link);
+      result += ";";
+    }
+    BLI_linklist_freeN(names);
+    BLO_blendhandle_close(bh);
+    return result;
+  }
+};
+
+TEST_F(BlendfileBlockIndexTest, ReadWithIndex)
+{
+  const std::string filepath_plain = write("block_index_plain.blend", 0);
+  const std::string filepath_index = write("block_index.blend", G_FILE_BLOCK_INDEX);
+  const std::string filepath_compressed = write("block_index_zstd.blend",
+                                                G_FILE_BLOCK_INDEX | G_FILE_COMPRESS);
+
+  const std::string names = read_mesh_names(filepath_plain);
+  EXPECT_NE(names.find("Mesh0;"), std::string::npos);
+  EXPECT_NE(names.find("Mesh99;"), std::string::npos);
+  EXPECT_EQ(read_mesh_names(filepath_index), names);
+  EXPECT_EQ(read_mesh_names(filepath_compressed), names);
+
+  BLI_delete(filepath_plain.c_str(), false, false);
+  BLI_delete(filepath_index.c_str(), false, false);
+  BLI_delete(filepath_compressed.c_str(), false, false);
+}
+
+TEST_F(BlendfileBlockIndexTest, FileLayoutUnchanged)
+{
+  const std::string filepath_plain = write("block_index_plain.blend", 0);
+  const std::string filepath_index = write("block_index.blend", G_FILE_BLOCK_INDEX);
+
+  size_t plain_size = 0, index_size = 0;
+  char *plain = static_cast<char *>(
+      BLI_file_read_binary_as_mem(filepath_plain.c_str(), 0, &plain_size));
+  char *index = static_cast<char *>(
+      BLI_file_read_binary_as_mem(filepath_index.c_str(), 0, &index_size));
+  ASSERT_NE(plain, nullptr);
+  ASSERT_NE(index, nullptr);
+
+  /* The index is only inserted before the final #ENDB block, all other blocks are unchanged. */
+  const size_t blocks_size = plain_size - sizeof(BHead);
+  ASSERT_GT(index_size, plain_size);
+  EXPECT_EQ(memcmp(plain, index, blocks_size), 0);
+
+  BHead index_bhead, endb;
+  memcpy(&index_bhead, index + blocks_size, sizeof(BHead));
+  memcpy(&endb, index + index_size - sizeof(BHead), sizeof(BHead));
+  EXPECT_EQ(index_bhead.code, DATA);
+  EXPECT_EQ(endb.code, ENDB);
+  EXPECT_EQ(uint32_t(endb.SDNAnr), blocks_size);
+  EXPECT_EQ(endb.nr, 0);
+
+  MEM_freeN(plain);
+  MEM_freeN(index);
+  BLI_delete(filepath_plain.c_str(), false, false);
+  BLI_delete(filepath_index.c_str(), false, false);
+}
+
+TEST_F(BlendfileBlockIndexTest, LinkUsesIndex)
+{
+  const std::string filepath = write("block_index_link.blend", G_FILE_BLOCK_INDEX);
+
+  size_t size = 0;
+  char *data = static_cast<char *>(BLI_file_read_binary_as_mem(filepath.c_str(), 0, &size));
+  ASSERT_NE(data, nullptr);
+  BHead endb;
+  memcpy(&endb, data + size - sizeof(BHead), sizeof(BHead));
+  const size_t index_offset = uint32_t(endb.SDNAnr);
+  ASSERT_LT(index_offset, size);
+
+  /* Rename a mesh only in the copy of its ID struct in the index. Readers that use the index
+   * see the new name, a sequential scan of the blocks would still find the old one. */
+  const char old_name[] = "MEMesh5";
+  const char new_name[] = "MEMesx5";
+  char *name = std::search(data + index_offset,
+                           data + size,
+                           old_name,
+                           old_name + sizeof(old_name));
+  ASSERT_NE(name, data + size);
+  memcpy(name, new_name, sizeof(new_name));
+  FILE *file = BLI_fopen(filepath.c_str(), "wb");
+  ASSERT_NE(file, nullptr);
+  EXPECT_EQ(fwrite(data, 1, size, file), size);
+  fclose(file);
+  MEM_freeN(data);
+
+  const std::string names = read_mesh_names(filepath);
+  EXPECT_NE(names.find("Mesx5;"), std::string::npos);
+  EXPECT_EQ(names.find("Mesh5;"), std::string::npos);
+
+  /* Linking looks the data-block up by the name in the index. */
+  TempLibraryContext *temp_lib_ctx = BLO_library_temp_load_id(
+      bmain, filepath.c_str(), ID_ME, "Mesx5", nullptr);
+  ASSERT_NE(temp_lib_ctx->temp_id, nullptr);
+  EXPECT_STREQ(temp_lib_ctx->temp_id->name, "MEMesx5");
+  BLO_library_temp_free(temp_lib_ctx);
+
+  temp_lib_ctx = BLO_library_temp_load_id(bmain, filepath.c_str(), ID_ME, "Mesh5", nullptr);
+  EXPECT_EQ(temp_lib_ctx->temp_id, nullptr);
+  BLO_library_temp_free(temp_lib_ctx);
+
+  BLI_delete(filepath.c_str(), false, false);
+}
@@ -0,0 +1,166 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#include "blendfile_loading_base_test.h"
+
+#include <string>
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_appdir.h"
+#include "BKE_lib_id.h"
+
+#include "BLI_fileops.h"
+#include "BLI_path_util.h"
+#include "BLI_task.hh"
+
+#include "BLO_undofile.h"
+
+class UndofileTest : public BlendfileLoadingBaseTest {
+ protected:
+  /* Compressible content that differs per seed. */
+  static std::vector<char> make_buffer(const int seed, const size_t size = 8192)
+  {
+    std::vector<char> buffer(size);
+    for (size_t i = 0; i < size; i++) {
+      buffer[i] = char((i / 64) * 3 + seed);
+    }
+    return buffer;
+  }
+
+  static void write_memfile(MemFile *memfile,
+                            MemFile *reference,
+                            const std::vector<std::vector<char>> &chunks)
+  {
+    MemFileWriteData mem_data = {nullptr};
+    BLO_memfile_write_init(&mem_data, memfile, reference);
+    mem_data.current_id_session_uuid = MAIN_ID_SESSION_UUID_UNSET;
+    for (const std::vector<char> &chunk : chunks) {
+      BLO_memfile_chunk_add(&mem_data, chunk.data(), chunk.size());
+    }
+    BLO_memfile_write_finalize(&mem_data);
+  }
+};
+
+TEST_F(UndofileTest, ShareIdenticalChunks)
+{
+  const std::vector<char> a = make_buffer(1);
+  const std::vector<char> b = make_buffer(2);
+  const std::vector<char> c = make_buffer(3);
+
+  MemFile memfile1 = {{nullptr}};
+  write_memfile(&memfile1, nullptr, {a, b});
+  EXPECT_EQ(BLO_memfile_size_get(&memfile1), a.size() + b.size());
+
+  /* Reordered chunks don't match the reference at the same place, but are still shared. */
+  MemFile memfile2 = {{nullptr}};
+  write_memfile(&memfile2, &memfile1, {b, a, a});
+  const MemFileChunk *chunk2 = static_cast<const MemFileChunk *>(memfile2.chunks.first);
+  EXPECT_FALSE(chunk2->is_identical);
+
+  MemFile memfile3 = {{nullptr}};
+  write_memfile(&memfile3, &memfile2, {b, c});
+  const MemFileChunk *chunk3 = static_cast<const MemFileChunk *>(memfile3.chunks.first);
+  EXPECT_TRUE(chunk3->is_identical);
+
+  int buffers_num;
+  size_t memory, memory_used;
+  BLO_memfile_memory_stats(&buffers_num, &memory, &memory_used);
+  EXPECT_EQ(buffers_num, 3);
+  EXPECT_EQ(memory, a.size() + b.size() + c.size());
+  EXPECT_EQ(memory_used, memory);
+
+  /* Shared buffers are divided between the memfiles using them. The sizes add up to the memory
+   * of all buffers, up to rounding of every chunk. */
+  const size_t size1 = BLO_memfile_size_get(&memfile1);
+  const size_t size2 = BLO_memfile_size_get(&memfile2);
+  const size_t size3 = BLO_memfile_size_get(&memfile3);
+  EXPECT_LT(size1, a.size() + b.size());
+  EXPECT_GT(size2, 0);
+  EXPECT_LE(size1 + size2 + size3, memory);
+  EXPECT_GE(size1 + size2 + size3, memory - 7);
+
+  /* Freeing the first step keeps the buffers used by later ones. */
+  BLO_memfile_merge(&memfile1, &memfile2);
+  BLO_memfile_memory_stats(&buffers_num, &memory, &memory_used);
+  EXPECT_EQ(buffers_num, 3);
+
+  BLO_memfile_free(&memfile2);
+  BLO_memfile_memory_stats(&buffers_num, &memory, &memory_used);
+  EXPECT_EQ(buffers_num, 2);
+
+  /* The last memfile is now charged for all buffers it uses, also for those that were added by
+   * the freed memfiles. */
+  EXPECT_EQ(BLO_memfile_size_get(&memfile3), b.size() + c.size());
+
+  BLO_memfile_free(&memfile3);
+  BLO_memfile_memory_stats(&buffers_num, &memory, &memory_used);
+  EXPECT_EQ(buffers_num, 0);
+  EXPECT_EQ(memory, 0);
+  EXPECT_EQ(memory_used, 0);
+}
+
+TEST_F(UndofileTest, CompressColdChunks)
+{
+  BKE_tempdir_init(nullptr);
+  const std::vector<char> a = make_buffer(1);
+  const std::vector<char> b = make_buffer(2);
+  const std::vector<char> c = make_buffer(3);
+
+  MemFile memfile1 = {{nullptr}};
+  write_memfile(&memfile1, nullptr, {a, b});
+  MemFile memfile2 = {{nullptr}};
+  write_memfile(&memfile2, &memfile1, {a, c});
+
+  /* Only `b` isn't used by the last step. */
+  BLO_memfile_compress_cold(1);
+  int buffers_num;
+  size_t memory, memory_used;
+  BLO_memfile_memory_stats(&buffers_num, &memory, &memory_used);
+  EXPECT_EQ(memory, a.size() + b.size() + c.size());
+  EXPECT_LT(memory_used, a.size() + b.size() + c.size());
+  EXPECT_GT(memory_used, a.size() + c.size());
+
+  /* Writing the memfile decompresses its buffers. */
+  char filepath[FILE_MAX];
+  BLI_join_dirfile(filepath, sizeof(filepath), BKE_tempdir_base(), "undofile_test.blend");
+  ASSERT_TRUE(BLO_memfile_write_file(&memfile1, filepath));
+  size_t file_size;
+  char *file_data = static_cast<char *>(BLI_file_read_binary_as_mem(filepath, 0, &file_size));
+  BLI_delete(filepath, false, false);
+  ASSERT_NE(file_data, nullptr);
+  ASSERT_EQ(file_size, a.size() + b.size());
+  EXPECT_EQ(memcmp(file_data, a.data(), a.size()), 0);
+  EXPECT_EQ(memcmp(file_data + a.size(), b.data(), b.size()), 0);
+  MEM_freeN(file_data);
+
+  BLO_memfile_memory_stats(&buffers_num, &memory, &memory_used);
+  EXPECT_EQ(memory_used, memory);
+
+  BLO_memfile_free(&memfile1);
+  BLO_memfile_free(&memfile2);
+}
+
+TEST_F(UndofileTest, WriteFromThreads)
+{
+  const std::vector<char> a = make_buffer(1);
+  const int memfiles_num = 16;
+  std::vector<MemFile> memfiles(memfiles_num, MemFile{{nullptr}});
+
+  /* The buffer storage is shared by all memfiles, which may be written from different threads. */
+  blender::threading::parallel_for(blender::IndexRange(memfiles_num), 1, [&](const auto range) {
+    for (const int i : range) {
+      write_memfile(&memfiles[i], nullptr, {a, make_buffer(i + 2)});
+    }
+  });
+
+  int buffers_num;
+  size_t memory, memory_used;
+  BLO_memfile_memory_stats(&buffers_num, &memory, &memory_used);
+  EXPECT_EQ(buffers_num, memfiles_num + 1);
+
+  for (MemFile &memfile : memfiles) {
+    BLO_memfile_free(&memfile);
+  }
+  BLO_memfile_memory_stats(&buffers_num, &memory, &memory_used);
+  EXPECT_EQ(buffers_num, 0);
+}
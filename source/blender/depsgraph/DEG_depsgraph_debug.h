@@ -52,6 +52,29 @@ void DEG_debug_stats_gnuplot(const struct Depsgraph *graph,
                              const char *label,
                              const char *output_filename);
 
+/**
+ * Evaluate all operations of the dependency graph the given number of times and print how well
+ * the evaluation is parallelized: the total time spent in operations, the time of the critical
+ * path, and the efficiency of the measured evaluation and of the same evaluation replayed with
+ * different scheduling orders.
+ */
+void DEG_debug_eval_benchmark(struct Depsgraph *graph, int num_iterations, FILE *stream);
+
+/**
+ * Start recording the start and end time of every operation evaluated by any dependency graph,
+ * together with the worker thread which evaluated it. When already recording, only the file path
+ * is changed.
+ */
+void DEG_debug_profile_begin(const char *filepath);
+/**
+ * Stop recording and write the recorded evaluations to the file passed to
+ * #DEG_debug_profile_begin, in the Chrome trace event JSON format. It can be inspected with
+ * `chrome://tracing` or Perfetto. Does nothing when the profile was not started.
+ *
+ * \return true if the profile was written.
+ */
+bool DEG_debug_profile_end(void);
+
 /* ************************************************ */
 
 /** Compare two dependency graphs. */
@@ -11,9 +11,20 @@
 
 #include "DNA_anim_types.h"
 
+#include "BLI_hash.hh"
+#include "BLI_listbase.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_animsys.h"
+#include "BKE_lib_id.h"
+
+#include "DNA_action_types.h"
+#include "DNA_constraint_types.h"
+#include "DNA_gpencil_modifier_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_node_types.h"
+#include "DNA_object_types.h"
+#include "DNA_shader_fx_types.h"
 
 namespace blender::deg {
 
@@ -81,27 +92,92 @@ void animated_property_cb(ID * /*id*/, FCurve *fcurve, void *data_v)
   PropertyRNA *property_rna = nullptr;
   if (!RNA_path_resolve_property(
           &data->pointer_rna, fcurve->rna_path, &pointer_rna, &property_rna)) {
+    /* The path might resolve after changes in other IDs. */
+    data->animated_property_storage->is_self_contained = false;
     return;
   }
   /* Get storage for the ID.
    * This is needed to deal with cases when nested datablock is animated by its parent. */
   AnimatedPropertyStorage *animated_property_storage = data->animated_property_storage;
   if (pointer_rna.owner_id != data->pointer_rna.owner_id) {
+    data->animated_property_storage->is_self_contained = false;
     animated_property_storage = data->builder_cache->ensureAnimatedPropertyStorage(
         pointer_rna.owner_id);
+    animated_property_storage->is_self_contained = false;
   }
   /* Set the property as animated. */
   animated_property_storage->tagPropertyAsAnimated(&pointer_rna, property_rna);
 }
 
+/* Add a value to a hash of a sequence. Unlike #get_default_hash_2 it mixes the bits of the
+ * existing hash, so that the hash depends on the order of the values. */
+uint64_t hash_combine(const uint64_t hash, const uint64_t value)
+{
+  return hash ^ (value + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2));
+}
+
+void fcurve_hash_cb(ID * /*id*/, FCurve *fcurve, void *data_v)
+{
+  uint64_t *hash = static_cast<uint64_t *>(data_v);
+  *hash = hash_combine(
+      *hash, get_default_hash_2(fcurve, StringRef(fcurve->rna_path ? fcurve->rna_path : "")));
+}
+
+/* Hash of named elements of a list, in order. Paths into collections are resolved by the name or
+ * index of the element. */
+template<typename T> uint64_t listbase_names_hash(uint64_t hash, const ListBase &listbase)
+{
+  LISTBASE_FOREACH (const T *, element, &listbase) {
+    hash = hash_combine(hash, get_default_hash_2(element, StringRef(element->name)));
+  }
+  return hash;
+}
+
+/* Hash of everything the animated properties of the ID are found from which can change without
+ * tagging the ID for update: F-Curves are re-allocated on undo, pose channels when the pose is
+ * rebuilt, and elements which are addressed by name can be renamed or reordered. */
+uint64_t animated_properties_hash(ID *id)
+{
+  uint64_t hash = 0;
+  BKE_fcurves_id_cb(id, fcurve_hash_cb, &hash);
+  switch (GS(id->name)) {
+    case ID_OB: {
+      const Object *object = reinterpret_cast<const Object *>(id);
+      hash = listbase_names_hash<ModifierData>(hash, object->modifiers);
+      hash = listbase_names_hash<GpencilModifierData>(hash, object->greasepencil_modifiers);
+      hash = listbase_names_hash<ShaderFxData>(hash, object->shader_fx);
+      hash = listbase_names_hash<bConstraint>(hash, object->constraints);
+      if (object->pose != nullptr) {
+        LISTBASE_FOREACH (const bPoseChannel *, pchan, &object->pose->chanbase) {
+          hash = hash_combine(hash, get_default_hash_2(pchan, StringRef(pchan->name)));
+          hash = listbase_names_hash<bConstraint>(hash, pchan->constraints);
+        }
+      }
+      break;
+    }
+    case ID_NT: {
+      const bNodeTree *ntree = reinterpret_cast<const bNodeTree *>(id);
+      hash = listbase_names_hash<bNode>(hash, ntree->nodes);
+      break;
+    }
+    default:
+      break;
+  }
+  return hash;
+}
+
 }  // namespace
 
-AnimatedPropertyStorage::AnimatedPropertyStorage() : is_fully_initialized(false)
+AnimatedPropertyStorage::AnimatedPropertyStorage()
 {
+  reset();
 }
 
 void AnimatedPropertyStorage::initializeFromID(DepsgraphBuilderCache *builder_cache, ID *id)
 {
+  id_session_uuid = id->session_uuid;
+  fcurves_hash = animated_properties_hash(id);
+
   AnimatedPropertyCallbackData data;
   RNA_id_pointer_create(id, &data.pointer_rna);
   data.animated_property_storage = this;
@@ -109,6 +185,26 @@ void AnimatedPropertyStorage::initializeFromID(DepsgraphBuilderCache *builder_ca
   BKE_fcurves_id_cb(id, animated_property_cb, &data);
 }
 
+bool AnimatedPropertyStorage::canBeReusedForID(ID *id) const
+{
+  /* The session UUID catches IDs which were freed and re-allocated at the same address. */
+  return is_fully_initialized && is_self_contained && !is_id_tagged &&
+         id_session_uuid != MAIN_ID_SESSION_UUID_UNSET && id_session_uuid == id->session_uuid &&
+         fcurves_hash == animated_properties_hash(id);
+}
+
+void AnimatedPropertyStorage::reset()
+{
+  is_fully_initialized = false;
+  is_self_contained = true;
+  is_id_tagged = false;
+  is_used = false;
+  id_session_uuid = MAIN_ID_SESSION_UUID_UNSET;
+  fcurves_hash = 0;
+  animated_objects_set.clear();
+  animated_properties_set.clear();
+}
+
 void AnimatedPropertyStorage::tagPropertyAsAnimated(const AnimatedPropertyID &property_id)
 {
   animated_objects_set.add(property_id.data);
@@ -139,6 +235,11 @@ bool AnimatedPropertyStorage::isAnyPropertyAnimated(const PointerRNA *pointer_rn
 
 /* Builder cache itself. */
 
+DepsgraphBuilderCache::DepsgraphBuilderCache()
+    : num_reused_storages(0), num_initialized_storages(0)
+{
+}
+
 DepsgraphBuilderCache::~DepsgraphBuilderCache()
 {
   for (AnimatedPropertyStorage *animated_property_storage :
@@ -147,10 +248,56 @@ DepsgraphBuilderCache::~DepsgraphBuilderCache()
   }
 }
 
+void DepsgraphBuilderCache::begin_build()
+{
+  for (AnimatedPropertyStorage *animated_property_storage :
+       animated_property_storage_map_.values()) {
+    animated_property_storage->is_used = false;
+  }
+  num_reused_storages = 0;
+  num_initialized_storages = 0;
+}
+
+void DepsgraphBuilderCache::end_build()
+{
+  /* The IDs of unused storages might have been freed already, so only the pointer is used. */
+  Vector<ID *> unused_ids;
+  for (const auto item : animated_property_storage_map_.items()) {
+    if (!item.value->is_used) {
+      unused_ids.append(item.key);
+    }
+  }
+  for (ID *id : unused_ids) {
+    delete animated_property_storage_map_.pop(id);
+  }
+}
+
+void DepsgraphBuilderCache::tag_id_update(const ID *id)
+{
+  AnimatedPropertyStorage *animated_property_storage =
+      animated_property_storage_map_.lookup_default(const_cast<ID *>(id), nullptr);
+  if (animated_property_storage != nullptr) {
+    animated_property_storage->is_id_tagged = true;
+  }
+}
+
 AnimatedPropertyStorage *DepsgraphBuilderCache::ensureAnimatedPropertyStorage(ID *id)
 {
-  return animated_property_storage_map_.lookup_or_add_cb(
-      id, []() { return new AnimatedPropertyStorage(); });
+  AnimatedPropertyStorage *animated_property_storage =
+      animated_property_storage_map_.lookup_or_add_cb(
+          id, []() { return new AnimatedPropertyStorage(); });
+  if (!animated_property_storage->is_used) {
+    /* First use of the storage by this build, check whether the data from the previous build is
+     * still valid. */
+    if (animated_property_storage->canBeReusedForID(id)) {
+      num_reused_storages++;
+    }
+    else {
+      animated_property_storage->reset();
+    }
+    animated_property_storage->is_used = true;
+  }
+  return animated_property_storage;
 }
 
 AnimatedPropertyStorage *DepsgraphBuilderCache::ensureInitializedAnimatedPropertyStorage(ID *id)
@@ -159,6 +306,7 @@ AnimatedPropertyStorage *DepsgraphBuilderCache::ensureInitializedAnimatedPropert
   if (!animated_property_storage->is_fully_initialized) {
     animated_property_storage->initializeFromID(this, id);
     animated_property_storage->is_fully_initialized = true;
+    num_initialized_storages++;
   }
   return animated_property_storage;
 }
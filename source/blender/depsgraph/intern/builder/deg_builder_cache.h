@@ -47,6 +47,10 @@ class AnimatedPropertyStorage {
 
   void initializeFromID(DepsgraphBuilderCache *builder_cache, ID *id);
 
+  /* Check whether the storage initialized by a previous build is still valid for the given ID. */
+  bool canBeReusedForID(ID *id) const;
+  void reset();
+
   void tagPropertyAsAnimated(const AnimatedPropertyID &property_id);
   void tagPropertyAsAnimated(const PointerRNA *pointer_rna, const PropertyRNA *property_rna);
 
@@ -58,6 +62,22 @@ class AnimatedPropertyStorage {
   /* The storage is fully initialized from all F-Curves from corresponding ID. */
   bool is_fully_initialized;
 
+  /* All F-Curves of the ID resolved to properties of the ID itself, and no other ID animates
+   * properties of this one. Only such storages can be reused by the following builds, since
+   * changes in other IDs can not invalidate them. */
+  bool is_self_contained;
+
+  /* The ID was tagged for update since the storage has been initialized. */
+  bool is_id_tagged;
+
+  /* The storage was used by the current build. */
+  bool is_used;
+
+  /* Session UUID of the ID and hash of its F-Curves and of the elements their paths refer to by
+   * name, at the time the storage was initialized. */
+  uint id_session_uuid;
+  uint64_t fcurves_hash;
+
   /* indexed by PointerRNA.data. */
   Set<void *> animated_objects_set;
   Set<AnimatedPropertyID> animated_properties_set;
@@ -65,11 +85,25 @@ class AnimatedPropertyStorage {
   MEM_CXX_CLASS_ALLOC_FUNCS("AnimatedPropertyStorage");
 };
 
-/* Cached data which can be re-used by multiple builders. */
+/* Cached data which can be re-used by multiple builders.
+ *
+ * The cache is owned by the dependency graph and is kept between relations updates. The animated
+ * property storages of IDs which did not change since the previous build are reused, which avoids
+ * resolving RNA paths of all F-Curves and drivers of the scene on every relations update. Nodes
+ * and relations are not cached, they are built for the whole graph every time. */
 class DepsgraphBuilderCache {
  public:
+  DepsgraphBuilderCache();
   ~DepsgraphBuilderCache();
 
+  void begin_build();
+  /* Frees cached data which was not used by the build, it belongs to IDs which are not in the
+   * dependency graph anymore. */
+  void end_build();
+
+  /* Invalidate data cached for the ID, called when the ID is tagged for update. */
+  void tag_id_update(const ID *id);
+
   /* Makes sure storage for animated properties exists and initialized for the given ID. */
   AnimatedPropertyStorage *ensureAnimatedPropertyStorage(ID *id);
   AnimatedPropertyStorage *ensureInitializedAnimatedPropertyStorage(ID *id);
@@ -98,6 +132,10 @@ class DepsgraphBuilderCache {
 
   Map<ID *, AnimatedPropertyStorage *> animated_property_storage_map_;
 
+  /* Statistics of the current build, for the timing report. */
+  int num_reused_storages;
+  int num_initialized_storages;
+
   MEM_CXX_CLASS_ALLOC_FUNCS("DepsgraphBuilderCache");
 };
 
@@ -0,0 +1,188 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#include "intern/builder/deg_builder_cache.h"
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_listbase.h"
+#include "BLI_string.h"
+
+#include "BKE_action.h"
+#include "BKE_anim_data.h"
+#include "BKE_fcurve.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_main.h"
+#include "BKE_modifier.h"
+#include "BKE_object.h"
+
+#include "DNA_action_types.h"
+#include "DNA_anim_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+
+#include "RNA_access.h"
+#include "RNA_define.h"
+#include "RNA_prototypes.h"
+
+namespace blender::deg::tests {
+
+class deg_builder_cache : public testing::Test {
+ protected:
+  Main *bmain = nullptr;
+  Object *object = nullptr;
+  ModifierData *modifier_a = nullptr;
+  ModifierData *modifier_b = nullptr;
+  bAction *action = nullptr;
+
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+    BKE_modifier_init();
+    RNA_init();
+  }
+
+  static void TearDownTestSuite()
+  {
+    RNA_exit();
+  }
+
+  /* An object with the modifiers "A" and "B", the visibility of "A" is animated. */
+  void SetUp() override
+  {
+    bmain = BKE_main_new();
+    object = BKE_object_add_only_object(bmain, OB_EMPTY, "Object");
+    modifier_a = add_modifier("A");
+    modifier_b = add_modifier("B");
+    action = BKE_action_add(bmain, "Action");
+    BKE_animdata_ensure_id(&object->id)->action = action;
+    add_fcurve("modifiers[\"A\"].show_viewport");
+  }
+
+  void TearDown() override
+  {
+    BKE_main_free(bmain);
+  }
+
+  ModifierData *add_modifier(const char *name)
+  {
+    ModifierData *md = BKE_modifier_new(eModifierType_Subsurf);
+    STRNCPY(md->name, name);
+    BLI_addtail(&object->modifiers, md);
+    return md;
+  }
+
+  void add_fcurve(const char *rna_path)
+  {
+    FCurve *fcu = BKE_fcurve_create();
+    fcu->rna_path = BLI_strdup(rna_path);
+    BLI_addtail(&action->curves, fcu);
+  }
+
+  /* Simulate a build of the relations, which checks the visibility of both modifiers. */
+  void build(DepsgraphBuilderCache &cache, bool *r_a_is_animated, bool *r_b_is_animated)
+  {
+    cache.begin_build();
+    *r_a_is_animated = cache.isPropertyAnimated(
+        &object->id, AnimatedPropertyID(&object->id, &RNA_Modifier, modifier_a, "show_viewport"));
+    *r_b_is_animated = cache.isPropertyAnimated(
+        &object->id, AnimatedPropertyID(&object->id, &RNA_Modifier, modifier_b, "show_viewport"));
+    cache.end_build();
+  }
+};
+
+TEST_F(deg_builder_cache, ReuseUnchanged)
+{
+  DepsgraphBuilderCache cache;
+  bool a_is_animated, b_is_animated;
+  build(cache, &a_is_animated, &b_is_animated);
+  EXPECT_TRUE(a_is_animated);
+  EXPECT_FALSE(b_is_animated);
+  EXPECT_EQ(cache.num_initialized_storages, 1);
+
+  build(cache, &a_is_animated, &b_is_animated);
+  EXPECT_TRUE(a_is_animated);
+  EXPECT_FALSE(b_is_animated);
+  EXPECT_EQ(cache.num_reused_storages, 1);
+  EXPECT_EQ(cache.num_initialized_storages, 0);
+}
+
+TEST_F(deg_builder_cache, TaggedIDIsNotReused)
+{
+  DepsgraphBuilderCache cache;
+  bool a_is_animated, b_is_animated;
+  build(cache, &a_is_animated, &b_is_animated);
+  cache.tag_id_update(&object->id);
+  build(cache, &a_is_animated, &b_is_animated);
+  EXPECT_EQ(cache.num_reused_storages, 0);
+  EXPECT_EQ(cache.num_initialized_storages, 1);
+}
+
+TEST_F(deg_builder_cache, ModifierRename)
+{
+  DepsgraphBuilderCache cache;
+  bool a_is_animated, b_is_animated;
+  build(cache, &a_is_animated, &b_is_animated);
+
+  /* Swap the names without tagging the object, the F-Curve now animates the other modifier. */
+  STRNCPY(modifier_a->name, "B");
+  STRNCPY(modifier_b->name, "A");
+  build(cache, &a_is_animated, &b_is_animated);
+  EXPECT_FALSE(a_is_animated);
+  EXPECT_TRUE(b_is_animated);
+  EXPECT_EQ(cache.num_reused_storages, 0);
+}
+
+TEST_F(deg_builder_cache, ModifierReorder)
+{
+  DepsgraphBuilderCache cache;
+  FCurve *fcu = static_cast<FCurve *>(action->curves.first);
+  MEM_freeN(fcu->rna_path);
+  fcu->rna_path = BLI_strdup("modifiers[0].show_viewport");
+  bool a_is_animated, b_is_animated;
+  build(cache, &a_is_animated, &b_is_animated);
+  EXPECT_TRUE(a_is_animated);
+
+  BLI_listbase_swaplinks(&object->modifiers, modifier_a, modifier_b);
+  build(cache, &a_is_animated, &b_is_animated);
+  EXPECT_FALSE(a_is_animated);
+  EXPECT_TRUE(b_is_animated);
+}
+
+TEST_F(deg_builder_cache, UndoChangesFCurves)
+{
+  DepsgraphBuilderCache cache;
+  bool a_is_animated, b_is_animated;
+  build(cache, &a_is_animated, &b_is_animated);
+
+  /* Undo re-allocates the F-Curves of changed IDs, without tagging them for update. The new
+   * F-Curve can even be allocated at the same address. */
+  BKE_fcurves_free(&action->curves);
+  add_fcurve("modifiers[\"B\"].show_viewport");
+  build(cache, &a_is_animated, &b_is_animated);
+  EXPECT_FALSE(a_is_animated);
+  EXPECT_TRUE(b_is_animated);
+  EXPECT_EQ(cache.num_reused_storages, 0);
+}
+
+TEST_F(deg_builder_cache, UndoReplacesID)
+{
+  DepsgraphBuilderCache cache;
+  bool a_is_animated, b_is_animated;
+  build(cache, &a_is_animated, &b_is_animated);
+
+  /* An ID which is read by undo at the address of the previous one gets a new session UUID. */
+  BKE_lib_libblock_session_uuid_renew(&object->id);
+  build(cache, &a_is_animated, &b_is_animated);
+  EXPECT_TRUE(a_is_animated);
+  EXPECT_EQ(cache.num_reused_storages, 0);
+  EXPECT_EQ(cache.num_initialized_storages, 1);
+}
+
+}  // namespace blender::deg::tests
@@ -20,24 +20,42 @@ AbstractBuilderPipeline::AbstractBuilderPipeline(::Depsgraph *graph)
     : deg_graph_(reinterpret_cast<Depsgraph *>(graph)),
       bmain_(deg_graph_->bmain),
       scene_(deg_graph_->scene),
-      view_layer_(deg_graph_->view_layer)
+      view_layer_(deg_graph_->view_layer),
+      builder_cache_(deg_graph_->builder_cache)
 {
 }
 
 void AbstractBuilderPipeline::build()
 {
+  const bool do_time = (G.debug & (G_DEBUG_DEPSGRAPH_BUILD | G_DEBUG_DEPSGRAPH_TIME)) != 0;
   double start_time = 0.0;
-  if (G.debug & (G_DEBUG_DEPSGRAPH_BUILD | G_DEBUG_DEPSGRAPH_TIME)) {
+  if (do_time) {
     start_time = PIL_check_seconds_timer();
   }
 
   build_step_sanity_check();
+  /* Nodes and relations are always built from scratch for the whole graph. Only the animated
+   * property lookups of unchanged IDs are reused from the previous build, see
+   * #DepsgraphBuilderCache. Relations of an ID point to nodes of other IDs, so reusing parts of
+   * the graph would need a way to find the relations that became invalid. */
+  builder_cache_.begin_build();
   build_step_nodes();
+  const double nodes_time = do_time ? PIL_check_seconds_timer() : 0.0;
   build_step_relations();
+  const double relations_time = do_time ? PIL_check_seconds_timer() : 0.0;
   build_step_finalize();
-
-  if (G.debug & (G_DEBUG_DEPSGRAPH_BUILD | G_DEBUG_DEPSGRAPH_TIME)) {
-    printf("Depsgraph built in %f seconds.\n", PIL_check_seconds_timer() - start_time);
+  builder_cache_.end_build();
+
+  if (do_time) {
+    const double end_time = PIL_check_seconds_timer();
+    printf("Depsgraph built in %f seconds.\n", end_time - start_time);
+    printf("  Nodes: %f seconds, relations: %f seconds, finalize: %f seconds.\n",
+           nodes_time - start_time,
+           relations_time - nodes_time,
+           end_time - relations_time);
+    printf("  Animated properties: reused for %d IDs, initialized for %d IDs.\n",
+           builder_cache_.num_reused_storages,
+           builder_cache_.num_initialized_storages);
   }
 }
 
@@ -0,0 +1,210 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#include "intern/debug/deg_debug_profile.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+
+#include "MEM_guardedalloc.h"
+
+#include "PIL_time.h"
+
+#include "BLI_fileops.h"
+#include "BLI_string.h"
+#include "BLI_vector.hh"
+
+#include "DEG_depsgraph_debug.h"
+
+#include "intern/debug/deg_debug.h"
+#include "intern/depsgraph.h"
+#include "intern/node/deg_node_component.h"
+#include "intern/node/deg_node_operation.h"
+
+namespace blender::deg {
+
+namespace {
+
+struct ProfileEvent {
+  string name;
+  string category;
+  /* Arguments of the event as JSON object members, can be empty. */
+  string args;
+  double start_time;
+  double end_time;
+  int thread_id;
+};
+
+struct Profile {
+  string filepath;
+  /* Time stamps in the file are relative to this time. */
+  double start_time;
+  Vector<ProfileEvent> events;
+  int num_threads = 0;
+  std::mutex mutex;
+};
+
+/* Only exists while profiling, it is not changed while dependency graphs are evaluated. */
+Profile *profile = nullptr;
+
+std::atomic<int> next_thread_id = 0;
+
+string json_escape(const string &str)
+{
+  string result;
+  result.reserve(str.size());
+  for (const char c : str) {
+    switch (c) {
+      case '"':
+        result += "\\\"";
+        break;
+      case '\\':
+        result += "\\\\";
+        break;
+      case '\n':
+        result += "\\n";
+        break;
+      case '\t':
+        result += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char buffer[8];
+          BLI_snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+          result += buffer;
+        }
+        else {
+          result += c;
+        }
+        break;
+    }
+  }
+  return result;
+}
+
+void write_profile(const Profile &profile, FILE *file)
+{
+  /* Time stamps and durations of the trace event format are in microseconds. */
+  auto microseconds = [&](const double time) { return (time - profile.start_time) * 1e6; };
+
+  fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+  fprintf(file,
+          "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, "
+          "\"args\": {\"name\": \"Depsgraph\"}}");
+  for (const int thread_id : IndexRange(profile.num_threads)) {
+    fprintf(file,
+            ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+            "\"args\": {\"name\": \"Thread %d\"}}",
+            thread_id,
+            thread_id);
+  }
+  for (const ProfileEvent &event : profile.events) {
+    fprintf(file,
+            ",\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, "
+            "\"pid\": 1, \"tid\": %d",
+            json_escape(event.name).c_str(),
+            json_escape(event.category).c_str(),
+            microseconds(event.start_time),
+            (event.end_time - event.start_time) * 1e6,
+            event.thread_id);
+    if (!event.args.empty()) {
+      fprintf(file, ", \"args\": {%s}", event.args.c_str());
+    }
+    fprintf(file, "}");
+  }
+  fprintf(file, "\n]}\n");
+}
+
+}  // namespace
+
+bool deg_debug_profile_is_enabled()
+{
+  return profile != nullptr;
+}
+
+int deg_debug_profile_thread_id()
+{
+  static thread_local int thread_id = next_thread_id.fetch_add(1, std::memory_order_relaxed);
+  return thread_id;
+}
+
+void deg_debug_profile_add_evaluation(const Depsgraph *graph,
+                                      const double start_time,
+                                      const double end_time,
+                                      const Span<ProfileOperationEvent> operation_events)
+{
+  /* Convert the events to strings outside of the lock, the nodes are only valid now. */
+  Vector<ProfileEvent> events;
+  events.reserve(operation_events.size() + 1);
+
+  char args[256];
+  BLI_snprintf(args,
+               sizeof(args),
+               "\"depsgraph\": \"%s\", \"frame\": %.3f, \"operations\": %d",
+               json_escape(graph->debug.name).c_str(),
+               graph->ctime,
+               int(operation_events.size()));
+  events.append(
+      {"Evaluation", "evaluation", args, start_time, end_time, deg_debug_profile_thread_id()});
+
+  for (const ProfileOperationEvent &operation_event : operation_events) {
+    const OperationNode *operation_node = operation_event.operation_node;
+    events.append({operation_node->full_identifier(),
+                   nodeTypeAsString(operation_node->owner->type),
+                   "",
+                   operation_event.start_time,
+                   operation_event.end_time,
+                   operation_event.thread_id});
+  }
+
+  std::lock_guard lock{profile->mutex};
+  for (ProfileEvent &event : events) {
+    profile->events.append(std::move(event));
+  }
+}
+
+}  // namespace blender::deg
+
+namespace deg = blender::deg;
+
+void DEG_debug_profile_begin(const char *filepath)
+{
+  if (deg::profile == nullptr) {
+    deg::profile = MEM_new<deg::Profile>(__func__);
+    deg::profile->start_time = PIL_check_seconds_timer();
+  }
+  deg::profile->filepath = filepath;
+}
+
+bool DEG_debug_profile_end(void)
+{
+  if (deg::profile == nullptr) {
+    return false;
+  }
+  deg::Profile *profile = deg::profile;
+  deg::profile = nullptr;
+
+  profile->num_threads = deg::next_thread_id.load(std::memory_order_relaxed);
+
+  errno = 0;
+  FILE *file = BLI_fopen(profile->filepath.c_str(), "w");
+  bool success = false;
+  if (file == nullptr) {
+    const char *err_msg = errno ? strerror(errno) : "unknown";
+    DEG_ERROR_PRINTF(
+        "Error writing depsgraph profile '%s': %s\n", profile->filepath.c_str(), err_msg);
+  }
+  else {
+    deg::write_profile(*profile, file);
+    success = (ferror(file) == 0);
+    fclose(file);
+  }
+
+  MEM_delete(profile);
+  return success;
+}
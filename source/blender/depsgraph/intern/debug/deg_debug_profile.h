@@ -0,0 +1,40 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup depsgraph
+ *
+ * Recording of operation timings of all dependency graph evaluations, which is written to a file
+ * in the Chrome trace event format.
+ */
+
+#pragma once
+
+#include "BLI_span.hh"
+
+namespace blender::deg {
+
+struct Depsgraph;
+struct OperationNode;
+
+/* Evaluation of a single operation, as recorded by a worker thread. */
+struct ProfileOperationEvent {
+  const OperationNode *operation_node;
+  double start_time;
+  double end_time;
+  int thread_id;
+};
+
+/* Is true between #DEG_debug_profile_begin and #DEG_debug_profile_end. */
+bool deg_debug_profile_is_enabled();
+
+/* Small number identifying the calling thread in the profile. */
+int deg_debug_profile_thread_id();
+
+/* Add evaluation of the graph and the operations evaluated by it to the profile. Is to be called
+ * while the operation nodes are still valid. */
+void deg_debug_profile_add_evaluation(const Depsgraph *graph,
+                                      double start_time,
+                                      double end_time,
+                                      Span<ProfileOperationEvent> operation_events);
+
+}  // namespace blender::deg
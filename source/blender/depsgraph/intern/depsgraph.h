@@ -24,6 +24,7 @@
 #include "DEG_depsgraph.h"
 #include "DEG_depsgraph_physics.h"
 
+#include "intern/builder/deg_builder_cache.h"
 #include "intern/debug/deg_debug.h"
 #include "intern/depsgraph_type.h"
 
@@ -159,6 +160,10 @@ struct Depsgraph {
    * created along with relations, for fast lookup during evaluation. */
   Map<const ID *, ListBase *> *physics_relations[DEG_PHYSICS_RELATIONS_NUM];
 
+  /* Data gathered while building relations, which is kept for the following relations updates.
+   * Is invalidated per ID when the ID is tagged for update. */
+  DepsgraphBuilderCache builder_cache;
+
   MEM_CXX_CLASS_ALLOC_FUNCS("Depsgraph");
 };
 
@@ -7,6 +7,9 @@
  * Implementation of tools for debugging the depsgraph
  */
 
+#include "PIL_time.h"
+
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "DNA_scene_types.h"
@@ -22,8 +25,11 @@
 #include "intern/depsgraph.h"
 #include "intern/depsgraph_relation.h"
 #include "intern/depsgraph_type.h"
+#include "intern/eval/deg_eval.h"
+#include "intern/eval/deg_eval_stats.h"
 #include "intern/node/deg_node_component.h"
 #include "intern/node/deg_node_id.h"
+#include "intern/node/deg_node_operation.h"
 #include "intern/node/deg_node_time.h"
 
 namespace deg = blender::deg;
@@ -232,6 +238,60 @@ static deg::string depsgraph_name_for_logging(struct Depsgraph *depsgraph)
   return "[" + deg::string(name) + "]: ";
 }
 
+void DEG_debug_eval_benchmark(Depsgraph *graph, const int num_iterations, FILE *stream)
+{
+  deg::Depsgraph *deg_graph = reinterpret_cast<deg::Depsgraph *>(graph);
+  const int num_threads = BLI_system_thread_count();
+
+  double wall_time = 0.0;
+  deg::EvalScheduleStats total_stats;
+  for (int iteration = 0; iteration < num_iterations; iteration++) {
+    /* Tag everything but copy-on-write operations, which matches a frame change where all of the
+     * scene is animated. */
+    for (deg::OperationNode *op_node : deg_graph->operations) {
+      if (op_node->owner->type != deg::NodeType::COPY_ON_WRITE) {
+        op_node->tag_update(deg_graph, deg::DEG_UPDATE_SOURCE_TIME);
+      }
+    }
+    const double start_time = PIL_check_seconds_timer();
+    deg::deg_evaluate_on_refresh(deg_graph);
+    wall_time += PIL_check_seconds_timer() - start_time;
+
+    const deg::EvalScheduleStats stats = deg::deg_eval_stats_schedule(deg_graph, num_threads);
+    total_stats.num_operations = stats.num_operations;
+    total_stats.work_time += stats.work_time;
+    total_stats.critical_path_time += stats.critical_path_time;
+    total_stats.fifo_replay_time += stats.fifo_replay_time;
+    total_stats.critical_path_replay_time += stats.critical_path_replay_time;
+  }
+  if (num_iterations <= 0 || total_stats.work_time <= 0.0) {
+    return;
+  }
+
+  /* Parallel efficiency is the fraction of the time of all threads which is spent evaluating
+   * operations. */
+  auto print_time = [&](const char *label, const double time) {
+    fprintf(stream,
+            "  %s: %f seconds, %.1f%% efficiency\n",
+            label,
+            time / num_iterations,
+            100.0 * total_stats.work_time / (time * num_threads));
+  };
+  fprintf(stream,
+          "%sEvaluation of %d operations on %d threads, average of %d iterations:\n",
+          depsgraph_name_for_logging(graph).c_str(),
+          total_stats.num_operations,
+          num_threads,
+          num_iterations);
+  fprintf(stream, "  Operations: %f seconds\n", total_stats.work_time / num_iterations);
+  fprintf(stream,
+          "  Critical path: %f seconds\n",
+          total_stats.critical_path_time / num_iterations);
+  print_time("Evaluation", wall_time);
+  print_time("Replay, first ready first", total_stats.fifo_replay_time);
+  print_time("Replay, critical path first", total_stats.critical_path_replay_time);
+}
+
 void DEG_debug_print_begin(struct Depsgraph *depsgraph)
 {
   fprintf(stdout, "%s", depsgraph_name_for_logging(depsgraph).c_str());
@@ -646,6 +646,10 @@ void graph_id_tag_update(
   IDNode *id_node = (graph != nullptr) ? graph->find_id_node(id) : nullptr;
   if (graph != nullptr) {
     DEG_graph_id_type_tag(reinterpret_cast<::Depsgraph *>(graph), GS(id->name));
+    if (update_source == DEG_UPDATE_SOURCE_USER_EDIT) {
+      /* Edits might change what relations of the ID are built from. */
+      graph->builder_cache.tag_id_update(id);
+    }
   }
   if (flag == 0) {
     deg_graph_node_tag_zero(bmain, graph, id_node, update_source);
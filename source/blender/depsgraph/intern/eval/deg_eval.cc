@@ -12,8 +12,10 @@
 #include "PIL_time.h"
 
 #include "BLI_compiler_attrs.h"
+#include "BLI_enumerable_thread_specific.hh"
 #include "BLI_gsqueue.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_global.h"
@@ -31,6 +33,7 @@
 
 #include "atomic_ops.h"
 
+#include "intern/debug/deg_debug_profile.h"
 #include "intern/depsgraph.h"
 #include "intern/depsgraph_relation.h"
 #include "intern/depsgraph_tag.h"
@@ -57,10 +60,7 @@ void schedule_children(DepsgraphEvalState *state,
                        ScheduleFunction *schedule_function,
                        ScheduleFunctionArgs... schedule_function_args);
 
-void schedule_node_to_pool(OperationNode *node, const int UNUSED(thread_id), TaskPool *pool)
-{
-  BLI_task_pool_push(pool, deg_task_run_func, node, false, nullptr);
-}
+void schedule_node_to_pool(OperationNode *node, const int thread_id, TaskPool *pool);
 
 /* Denotes which part of dependency graph is being evaluated. */
 enum class EvaluationStage {
@@ -84,39 +84,83 @@ struct DepsgraphEvalState {
   bool do_stats;
   EvaluationStage stage;
   bool need_single_thread_pass;
+
+  /* Operations which are ready to be evaluated by the task pool, kept as a heap ordered by their
+   * critical path cost. Tasks of the pool do not own an operation, each of them evaluates the
+   * most expensive ready operation instead, so that the longest chains of dependent operations
+   * are started as early as possible. */
+  Vector<OperationNode *> ready_operations;
+  SpinLock ready_operations_lock;
+
+  /* Operations evaluated by every thread, only recorded when profiling. */
+  bool do_profile;
+  threading::EnumerableThreadSpecific<Vector<ProfileOperationEvent>> profile_events;
 };
 
-void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_node)
+bool operation_critical_path_cost_less(const OperationNode *a, const OperationNode *b)
+{
+  return a->critical_path_cost < b->critical_path_cost;
+}
+
+void schedule_node_to_pool(OperationNode *node, const int UNUSED(thread_id), TaskPool *pool)
+{
+  DepsgraphEvalState *state = (DepsgraphEvalState *)BLI_task_pool_user_data(pool);
+  BLI_spin_lock(&state->ready_operations_lock);
+  state->ready_operations.append(node);
+  std::push_heap(state->ready_operations.begin(),
+                 state->ready_operations.end(),
+                 operation_critical_path_cost_less);
+  BLI_spin_unlock(&state->ready_operations_lock);
+  /* Every ready operation is matched by exactly one task, so the heap is never empty when a task
+   * starts. */
+  BLI_task_pool_push(pool, deg_task_run_func, nullptr, false, nullptr);
+}
+
+OperationNode *pop_ready_operation(DepsgraphEvalState *state)
+{
+  BLI_spin_lock(&state->ready_operations_lock);
+  BLI_assert(!state->ready_operations.is_empty());
+  std::pop_heap(state->ready_operations.begin(),
+                state->ready_operations.end(),
+                operation_critical_path_cost_less);
+  OperationNode *operation_node = state->ready_operations.pop_last();
+  BLI_spin_unlock(&state->ready_operations_lock);
+  return operation_node;
+}
+
+void evaluate_node(DepsgraphEvalState *state, OperationNode *operation_node)
 {
   ::Depsgraph *depsgraph = reinterpret_cast<::Depsgraph *>(state->graph);
 
   /* Sanity checks. */
   BLI_assert_msg(!operation_node->is_noop(), "NOOP nodes should not actually be scheduled");
-  /* Perform operation. */
-  if (state->do_stats) {
-    const double start_time = PIL_check_seconds_timer();
-    operation_node->evaluate(depsgraph);
-    operation_node->stats.current_time += PIL_check_seconds_timer() - start_time;
-  }
-  else {
-    operation_node->evaluate(depsgraph);
+  /* Perform operation. It is always timed, the timing is used to estimate the cost of the
+   * operation when scheduling the next evaluations. */
+  const double start_time = PIL_check_seconds_timer();
+  operation_node->evaluate(depsgraph);
+  const double end_time = PIL_check_seconds_timer();
+  operation_node->stats.current_time += end_time - start_time;
+
+  if (state->do_profile) {
+    state->profile_events.local().append(
+        {operation_node, start_time, end_time, deg_debug_profile_thread_id()});
   }
 }
 
-void deg_task_run_func(TaskPool *pool, void *taskdata)
+void deg_task_run_func(TaskPool *pool, void *UNUSED(taskdata))
 {
   void *userdata_v = BLI_task_pool_user_data(pool);
   DepsgraphEvalState *state = (DepsgraphEvalState *)userdata_v;
 
   /* Evaluate node. */
-  OperationNode *operation_node = reinterpret_cast<OperationNode *>(taskdata);
+  OperationNode *operation_node = pop_ready_operation(state);
   evaluate_node(state, operation_node);
 
   /* Schedule children. */
   schedule_children(state, operation_node, schedule_node_to_pool, pool);
 }
 
-bool check_operation_node_visible(OperationNode *op_node)
+bool check_operation_node_visible(const OperationNode *op_node)
 {
   const ComponentNode *comp_node = op_node->owner;
   /* Special exception, copy on write component is to be always evaluated,
@@ -166,16 +210,62 @@ void calculate_pending_parents(Depsgraph *graph)
   }
 }
 
+bool operation_needs_evaluation(const OperationNode *node)
+{
+  return (node->flag & DEPSOP_FLAG_NEEDS_UPDATE) && check_operation_node_visible(node);
+}
+
+/* Calculate critical path cost of all operations which are to be evaluated: the estimated time
+ * of the operation itself plus the highest cost of the operations which depend on it.
+ *
+ * The costs are calculated in reverse topological order, which is found by counting down the
+ * pending parents the same way the evaluation does it, using custom_flags as the counter. */
+void calculate_critical_path_costs(Depsgraph *graph)
+{
+  Vector<OperationNode *> sorted_operations;
+  for (OperationNode *node : graph->operations) {
+    node->critical_path_cost = 0.0;
+    if (!operation_needs_evaluation(node)) {
+      continue;
+    }
+    node->custom_flags = node->num_links_pending;
+    if (node->num_links_pending == 0) {
+      sorted_operations.append(node);
+    }
+  }
+  for (int64_t i = 0; i < sorted_operations.size(); i++) {
+    for (Relation *rel : sorted_operations[i]->outlinks) {
+      OperationNode *child = (OperationNode *)rel->to;
+      if ((rel->flag & RELATION_FLAG_CYCLIC) || !operation_needs_evaluation(child)) {
+        continue;
+      }
+      if (--child->custom_flags == 0) {
+        sorted_operations.append(child);
+      }
+    }
+  }
+  for (int64_t i = sorted_operations.size() - 1; i >= 0; i--) {
+    OperationNode *node = sorted_operations[i];
+    double children_cost = 0.0;
+    for (Relation *rel : node->outlinks) {
+      const OperationNode *child = (const OperationNode *)rel->to;
+      if ((rel->flag & RELATION_FLAG_CYCLIC) == 0) {
+        children_cost = max(children_cost, child->critical_path_cost);
+      }
+    }
+    node->critical_path_cost = deg_eval_stats_operation_cost(node) + children_cost;
+  }
+}
+
 void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
 {
-  const bool do_stats = state->do_stats;
   calculate_pending_parents(graph);
+  calculate_critical_path_costs(graph);
   /* Clear tags and other things which needs to be clear. */
   for (OperationNode *node : graph->operations) {
-    if (do_stats) {
-      node->stats.reset_current();
-    }
+    node->stats.reset_current();
   }
+  state->ready_operations.reserve(graph->operations.size());
 }
 
 bool is_metaball_object_operation(const OperationNode *operation_node)
@@ -359,6 +449,7 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   BPy_BEGIN_ALLOW_THREADS;
 #endif
 
+  const double start_time = PIL_check_seconds_timer();
   graph->is_evaluating = true;
   depsgraph_ensure_view_layer(graph);
   /* Set up evaluation state. */
@@ -366,6 +457,8 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   state.graph = graph;
   state.do_stats = graph->debug.do_time_debug();
   state.need_single_thread_pass = false;
+  state.do_profile = deg_debug_profile_is_enabled();
+  BLI_spin_init(&state.ready_operations_lock);
   /* Prepare all nodes for evaluation. */
   initialize_execution(&state, graph);
 
@@ -389,6 +482,19 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
     evaluate_graph_single_threaded(&state);
   }
 
+  BLI_spin_end(&state.ready_operations_lock);
+
+  if (state.do_profile) {
+    Vector<ProfileOperationEvent> profile_events;
+    for (const Vector<ProfileOperationEvent> &thread_events : state.profile_events) {
+      profile_events.extend(thread_events);
+    }
+    deg_debug_profile_add_evaluation(
+        graph, start_time, PIL_check_seconds_timer(), profile_events);
+  }
+
+  /* Remember operation timings, they are used to prioritize the next evaluations. */
+  deg_eval_stats_update_average(graph);
   /* Finalize statistics gathering. This is because we only gather single
    * operation timing here, without aggregating anything to avoid any extra
    * synchronization. */
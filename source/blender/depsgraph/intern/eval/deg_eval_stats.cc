@@ -7,9 +7,13 @@
 
 #include "intern/eval/deg_eval_stats.h"
 
+#include <algorithm>
+
+#include "BLI_array.hh"
 #include "BLI_utildefines.h"
 
 #include "intern/depsgraph.h"
+#include "intern/depsgraph_relation.h"
 
 #include "intern/node/deg_node.h"
 #include "intern/node/deg_node_component.h"
@@ -18,6 +22,82 @@
 
 namespace blender::deg {
 
+namespace {
+
+/* Number of evaluations over which operation timings are averaged. Older timings fade out, so the
+ * estimated costs follow changes in the scene. */
+const int MAX_AVERAGE_SAMPLES = 8;
+
+/* Cost of operations which were never timed. Not zero, so that before any timings are available
+ * the critical path is the longest chain of operations. */
+const double UNTIMED_OPERATION_COST = 1e-5;
+
+/* Simulate evaluation of operations with the given durations and dependencies on the given number
+ * of threads, returns the time at which the last operation is finished.
+ *
+ * When priorities are given, the ready operation with the highest priority is started first.
+ * Otherwise ready operations are started in the order in which they became ready. */
+double simulate_schedule(const Span<double> durations,
+                         const Span<Vector<int>> children,
+                         const Span<int> num_parents,
+                         const Span<double> priorities,
+                         const int num_threads)
+{
+  auto priority_less = [&](const int a, const int b) { return priorities[a] < priorities[b]; };
+  /* Pairs of finish time and operation index, as a heap with the earliest finish time on top. */
+  using RunningOperation = std::pair<double, int>;
+  auto finish_greater = [](const RunningOperation &a, const RunningOperation &b) {
+    return a.first > b.first;
+  };
+
+  Array<int> num_pending(num_parents);
+  Vector<int> ready;
+  int64_t ready_begin = 0;
+  Vector<RunningOperation> running;
+
+  auto push_ready = [&](const int index) {
+    ready.append(index);
+    if (!priorities.is_empty()) {
+      std::push_heap(ready.begin(), ready.end(), priority_less);
+    }
+  };
+  auto pop_ready = [&]() {
+    if (priorities.is_empty()) {
+      return ready[ready_begin++];
+    }
+    std::pop_heap(ready.begin(), ready.end(), priority_less);
+    return ready.pop_last();
+  };
+
+  for (const int i : num_pending.index_range()) {
+    if (num_pending[i] == 0) {
+      push_ready(i);
+    }
+  }
+  double time = 0.0;
+  while (true) {
+    while (running.size() < num_threads && ready_begin < ready.size()) {
+      const int index = pop_ready();
+      running.append({time + durations[index], index});
+      std::push_heap(running.begin(), running.end(), finish_greater);
+    }
+    if (running.is_empty()) {
+      break;
+    }
+    std::pop_heap(running.begin(), running.end(), finish_greater);
+    const RunningOperation finished = running.pop_last();
+    time = finished.first;
+    for (const int child : children[finished.second]) {
+      if (--num_pending[child] == 0) {
+        push_ready(child);
+      }
+    }
+  }
+  return time;
+}
+
+}  // namespace
+
 void deg_eval_stats_aggregate(Depsgraph *graph)
 {
   /* Reset current evaluation stats for ID and component nodes.
@@ -38,4 +118,76 @@ void deg_eval_stats_aggregate(Depsgraph *graph)
   }
 }
 
+void deg_eval_stats_update_average(Depsgraph *graph)
+{
+  for (OperationNode *op_node : graph->operations) {
+    if (!op_node->scheduled || op_node->is_noop()) {
+      continue;
+    }
+    Node::Stats &stats = op_node->stats;
+    if (stats.num_samples < MAX_AVERAGE_SAMPLES) {
+      stats.num_samples++;
+    }
+    stats.average_time += (stats.current_time - stats.average_time) / stats.num_samples;
+  }
+}
+
+double deg_eval_stats_operation_cost(const OperationNode *node)
+{
+  if (node->is_noop()) {
+    return 0.0;
+  }
+  if (node->stats.num_samples == 0) {
+    return UNTIMED_OPERATION_COST;
+  }
+  return node->stats.average_time;
+}
+
+EvalScheduleStats deg_eval_stats_schedule(const Depsgraph *graph, const int num_threads)
+{
+  EvalScheduleStats stats;
+
+  /* Gather operations which were evaluated, and the dependencies between them. */
+  Vector<const OperationNode *> operations;
+  Map<const OperationNode *, int> operation_indices;
+  for (const OperationNode *op_node : graph->operations) {
+    if (op_node->scheduled) {
+      operation_indices.add_new(op_node, operations.size());
+      operations.append(op_node);
+    }
+  }
+  Array<double> durations(operations.size());
+  Array<double> priorities(operations.size());
+  Array<Vector<int>> children(operations.size());
+  Array<int> num_parents(operations.size(), 0);
+  for (const int i : operations.index_range()) {
+    const OperationNode *op_node = operations[i];
+    if (!op_node->is_noop()) {
+      stats.num_operations++;
+    }
+    durations[i] = op_node->is_noop() ? 0.0 : op_node->stats.current_time;
+    priorities[i] = op_node->critical_path_cost;
+    stats.work_time += durations[i];
+    for (const Relation *rel : op_node->outlinks) {
+      if (rel->flag & RELATION_FLAG_CYCLIC) {
+        continue;
+      }
+      const int child = operation_indices.lookup_default((const OperationNode *)rel->to, -1);
+      if (child != -1) {
+        children[i].append(child);
+        num_parents[child]++;
+      }
+    }
+  }
+
+  /* With as many threads as operations, every operation starts as soon as its dependencies are
+   * finished, so the total time is the time of the critical path. */
+  stats.critical_path_time = simulate_schedule(
+      durations, children, num_parents, {}, max(int(operations.size()), 1));
+  stats.fifo_replay_time = simulate_schedule(durations, children, num_parents, {}, num_threads);
+  stats.critical_path_replay_time = simulate_schedule(
+      durations, children, num_parents, priorities, num_threads);
+  return stats;
+}
+
 }  // namespace blender::deg
@@ -11,9 +11,38 @@ namespace blender {
 namespace deg {
 
 struct Depsgraph;
+struct OperationNode;
 
 /* Aggregate operation timings to overall component and ID nodes timing. */
 void deg_eval_stats_aggregate(Depsgraph *graph);
 
+/* Accumulate timings of the operations evaluated by the last graph evaluation into their
+ * averaged timing. */
+void deg_eval_stats_update_average(Depsgraph *graph);
+
+/* Estimated time needed to evaluate the operation, based on the previous evaluations. */
+double deg_eval_stats_operation_cost(const OperationNode *node);
+
+/* Statistics about how well the last graph evaluation could be parallelized. */
+struct EvalScheduleStats {
+  /* Number of operations which were evaluated. */
+  int num_operations = 0;
+  /* Sum of the evaluation time of all operations. */
+  double work_time = 0.0;
+  /* Evaluation time of the longest chain of dependent operations. This is the lowest possible
+   * evaluation time, no matter how many threads are used. */
+  double critical_path_time = 0.0;
+  /* Evaluation time of the operations replayed on the given number of threads, when ready
+   * operations are evaluated in the order they became ready. */
+  double fifo_replay_time = 0.0;
+  /* Same as above, when ready operations with the highest critical path cost are evaluated
+   * first, as done by the evaluation engine. */
+  double critical_path_replay_time = 0.0;
+};
+
+/* Replay the last graph evaluation using the measured operation timings, simulating the
+ * scheduling of the operations on the given number of threads. */
+EvalScheduleStats deg_eval_stats_schedule(const Depsgraph *graph, int num_threads);
+
 }  // namespace deg
 }  // namespace blender
@@ -265,6 +265,8 @@ Node::Stats::Stats()
 void Node::Stats::reset()
 {
   current_time = 0.0;
+  average_time = 0.0;
+  num_samples = 0;
 }
 
 void Node::Stats::reset_current()
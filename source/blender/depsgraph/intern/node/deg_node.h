@@ -162,6 +162,12 @@ struct Node {
     void reset_current();
     /* Time spend on this node during current graph evaluation. */
     double current_time;
+    /* Moving average of the time spent on this node, over the graph evaluations which
+     * evaluated it. Used to estimate the cost of the node when scheduling evaluation. */
+    double average_time;
+    /* Number of evaluations accumulated into average_time, saturates at a small number so
+     * the average keeps following changes in the scene. */
+    int num_samples;
   };
   /* Relationships between nodes
    * The reason why all depsgraph nodes are descended from this type (apart
@@ -255,6 +255,9 @@ struct OperationNode : public Node {
   /* How many inlinks are we still waiting on before we can be evaluated. */
   uint32_t num_links_pending;
   bool scheduled;
+  /* Estimated time needed to evaluate this operation and the longest chain of operations which
+   * depend on it. Ready operations with the highest cost are evaluated first. */
+  double critical_path_cost;
 
   /* Identifier for the operation being performed. */
   OperationCode opcode;
@@ -991,6 +991,7 @@ void EDBM_verts_mirror_cache_begin_ex(BMEditMesh *em,
 
   /* one or the other is used depending if topo is enabled */
   KDTree_3d *tree = NULL;
+  KDTreeNearest_3d *tree_nearest = NULL;
   MirrTopoStore_t mesh_topo_store = {NULL, -1, -1, -1};
 
   BM_mesh_elem_table_ensure(bm, BM_VERT);
@@ -1026,10 +1027,32 @@ void EDBM_verts_mirror_cache_begin_ex(BMEditMesh *em,
       BLI_kdtree_3d_insert(tree, i, v->co);
     }
     BLI_kdtree_3d_balance(tree);
+
+    /* Find the vertices at the mirrored positions of all vertices at once,
+     * this is much faster than one search per vertex for large meshes.
+     * The queries are in the same order as the vertices in the loop below. */
+    float(*mirr_cos)[3] = MEM_mallocN(sizeof(*mirr_cos) * bm->totvert, __func__);
+    uint mirr_cos_len = 0;
+    BM_ITER_MESH (v, &iter, bm, BM_VERTS_OF_MESH) {
+      if (respecthide && BM_elem_flag_test(v, BM_ELEM_HIDDEN)) {
+        continue;
+      }
+      if (use_select && !BM_elem_flag_test(v, BM_ELEM_SELECT)) {
+        continue;
+      }
+      copy_v3_v3(mirr_cos[mirr_cos_len], v->co);
+      mirr_cos[mirr_cos_len][axis] *= -1.0f;
+      mirr_cos_len++;
+    }
+    tree_nearest = MEM_mallocN(sizeof(*tree_nearest) * max_ii(mirr_cos_len, 1), __func__);
+    BLI_kdtree_3d_find_nearest_batch(
+        tree, (const float(*)[3])mirr_cos, mirr_cos_len, tree_nearest);
+    MEM_freeN(mirr_cos);
   }
 
 #define VERT_INTPTR(_v, _i) (r_index ? &r_index[_i] : BM_ELEM_CD_GET_VOID_P(_v, cd_vmirr_offset))
 
+  uint nearest_index = 0;
   BM_ITER_MESH_INDEX (v, &iter, bm, BM_VERTS_OF_MESH, i) {
     if (respecthide && BM_elem_flag_test(v, BM_ELEM_HIDDEN)) {
       continue;
@@ -1058,7 +1081,7 @@ void EDBM_verts_mirror_cache_begin_ex(BMEditMesh *em,
       co[axis] *= -1.0f;
 
       v_mirr = NULL;
-      i_mirr = BLI_kdtree_3d_find_nearest(tree, co, NULL);
+      i_mirr = tree_nearest[nearest_index++].index;
       if (i_mirr != -1) {
         BMVert *v_test = BM_vert_at_index(bm, i_mirr);
         if (len_squared_v3v3(co, v_test->co) < maxdist_sq) {
@@ -1085,6 +1108,7 @@ void EDBM_verts_mirror_cache_begin_ex(BMEditMesh *em,
   }
   else {
     BLI_kdtree_3d_free(tree);
+    MEM_freeN(tree_nearest);
   }
 }
 
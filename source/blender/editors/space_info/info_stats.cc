@@ -47,6 +47,8 @@
 #include "BKE_scene.h"
 #include "BKE_subdiv_ccg.h"
 
+#include "BLO_undofile.h"
+
 #include "DEG_depsgraph_query.h"
 
 #include "ED_info.h"
@@ -644,6 +646,15 @@ static const char *info_statusbar_string(Main *bmain,
     uintptr_t mem_in_use = MEM_get_memory_in_use();
     BLI_str_format_byte_unit(formatted_mem, mem_in_use, false);
     ofs += BLI_snprintf_rlen(info + ofs, len, TIP_("Memory: %s"), formatted_mem);
+
+    /* Memory of global undo steps, which is included in the memory above. */
+    int undo_buffers_num;
+    size_t undo_memory, undo_memory_used;
+    BLO_memfile_memory_stats(&undo_buffers_num, &undo_memory, &undo_memory_used);
+    if (undo_memory_used != 0) {
+      BLI_str_format_byte_unit(formatted_mem, undo_memory_used, false);
+      ofs += BLI_snprintf_rlen(info + ofs, len - ofs, TIP_(" (Undo: %s)"), formatted_mem);
+    }
   }
 
   /* GPU VRAM status. */
@@ -1589,16 +1589,8 @@ static std::chrono::microseconds node_get_execution_time(const bNodeTree &ntree,
   return exec_time;
 }
 
-static std::string node_get_execution_time_label(const SpaceNode &snode, const bNode &node)
+static std::string node_execution_time_to_string(const std::chrono::microseconds exec_time)
 {
-  int node_count = 0;
-  std::chrono::microseconds exec_time = node_get_execution_time(
-      *snode.nodetree, node, snode, node_count);
-
-  if (node_count == 0) {
-    return std::string("");
-  }
-
   uint64_t exec_time_us = exec_time.count();
 
   /* Don't show time if execution time is 0 microseconds. */
@@ -1623,6 +1615,19 @@ static std::string node_get_execution_time_label(const SpaceNode &snode, const b
   return stream.str() + " ms";
 }
 
+static std::string node_get_execution_time_label(const SpaceNode &snode, const bNode &node)
+{
+  int node_count = 0;
+  std::chrono::microseconds exec_time = node_get_execution_time(
+      *snode.nodetree, node, snode, node_count);
+
+  if (node_count == 0) {
+    return std::string("");
+  }
+
+  return node_execution_time_to_string(exec_time);
+}
+
 struct NodeExtraInfoRow {
   std::string text;
   const char *tooltip;
@@ -1651,6 +1656,16 @@ static Vector<NodeExtraInfoRow> node_get_extra_info(const SpaceNode &snode, cons
   }
   const geo_log::NodeLog *node_log = geo_log::ModifierLog::find_node_by_node_editor_context(snode,
                                                                                             node);
+  if (node_log != nullptr && snode.overlay.flag & SN_OVERLAY_SHOW_TIMINGS) {
+    for (const geo_log::FieldInputTime &field_input_time : node_log->field_input_times()) {
+      NodeExtraInfoRow row;
+      row.text = field_input_time.name + ": " +
+                 node_execution_time_to_string(field_input_time.exec_time);
+      row.tooltip = TIP_("The time it took to retrieve this field input during the execution");
+      row.icon = ICON_NONE;
+      rows.append(std::move(row));
+    }
+  }
   if (node_log != nullptr) {
     for (const std::string &message : node_log->debug_messages()) {
       NodeExtraInfoRow row;
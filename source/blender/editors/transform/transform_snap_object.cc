@@ -903,6 +903,7 @@ static bool raycastEditMesh(SnapObjectContext *sctx,
                                        0.0f,
                                        4,
                                        6,
+                                       0,
                                        BVHTREE_FROM_EM_LOOPTRI,
                                        nullptr,
                                        nullptr);
@@ -89,6 +89,22 @@ static bool memfile_undosys_step_encode(struct bContext *UNUSED(C),
   us->data = BKE_memfile_undo_encode(bmain, us_prev ? us_prev->data : NULL);
   us->step.data_size = us->data->undo_size;
 
+  /* Steps share buffers, each step is charged its share of the buffers it uses. The share changes
+   * when steps are added or freed, update it before the undo memory limit is applied. */
+  LISTBASE_FOREACH (UndoStep *, us_iter, &ustack->steps) {
+    if (us_iter->type == BKE_UNDOSYS_TYPE_MEMFILE) {
+      MemFileUndoData *data = ((MemFileUndoStep *)us_iter)->data;
+      data->undo_size = BLO_memfile_size_get(&data->memfile);
+      us_iter->data_size = data->undo_size;
+    }
+  }
+
+  if (USER_EXPERIMENTAL_TEST(&U, use_undo_compression)) {
+    /* Keep the data of the new step and the previous one, which is most likely to be restored,
+     * uncompressed. */
+    BLO_memfile_compress_cold(2);
+  }
+
   /* Store the fact that we should not re-use old data with that undo step, and reset the Main
    * flag. */
   us->step.use_old_bmain_data = !bmain->use_memfile_full_barrier;
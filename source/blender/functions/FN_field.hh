@@ -32,6 +32,9 @@
  * they share common sub-fields and a common context.
  */
 
+#include <chrono>
+#include <mutex>
+
 #include "BLI_function_ref.hh"
 #include "BLI_generic_virtual_array.hh"
 #include "BLI_string_ref.hh"
@@ -302,6 +305,40 @@ class FieldContext {
                                        ResourceScope &scope) const;
 };
 
+/**
+ * Records how long it took to retrieve every field input from its #FieldContext. Timings are
+ * only recorded while an instance exists on the thread that evaluates the fields, so that callers
+ * like the geometry nodes evaluator can report them for the node that is being executed.
+ * Instances can be nested, only the innermost one records timings.
+ */
+class FieldInputTimings : NonMovable, NonCopyable {
+ public:
+  struct Item {
+    std::string name;
+    std::chrono::nanoseconds duration;
+  };
+
+ private:
+  FieldInputTimings *previous_;
+  /* Inputs can be retrieved from multiple threads at the same time. */
+  std::mutex mutex_;
+  Vector<Item> items_;
+
+ public:
+  FieldInputTimings();
+  ~FieldInputTimings();
+
+  /** The innermost instance on the current thread, or null when timings are not recorded. */
+  static FieldInputTimings *get_active();
+
+  void add(std::string name, std::chrono::nanoseconds duration);
+
+  Span<Item> items() const
+  {
+    return items_;
+  }
+};
+
 /**
  * Utility class that makes it easier to evaluate fields.
  */
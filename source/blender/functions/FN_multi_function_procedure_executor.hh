@@ -10,13 +10,24 @@
 
 namespace blender::fn {
 
-/** A multi-function that executes a procedure internally. */
+/**
+ * A multi-function that executes a procedure internally.
+ *
+ * Large masks are split into blocks of indices, for which the whole procedure is executed before
+ * going to the next block. This keeps intermediate values in the CPU caches and allows executing
+ * blocks on multiple threads.
+ */
 class MFProcedureExecutor : public MultiFunction {
  private:
   MFSignature signature_;
   const MFProcedure &procedure_;
+  /** False when the procedure has parameters that can't be split into blocks. */
+  bool supports_blocks_;
 
  public:
+  /** Number of consecutive indices that are processed together. */
+  static constexpr int64_t block_size = 4096;
+
   MFProcedureExecutor(const MFProcedure &procedure);
 
   void call(IndexMask mask, MFParams params, MFContext context) const override;
@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup fn
+ */
+
+#include "BLI_array.hh"
+
+#include "FN_multi_function_procedure.hh"
+
+namespace blender::fn {
+
+/**
+ * A multi-function that executes a procedure which is a straight sequence of calls to functions
+ * with single values, like the procedures built for field evaluation.
+ *
+ * Unlike #MFProcedureExecutor, which calls every function for all indices before going to the
+ * next one, this executor calls all functions on a small chunk of indices before going to the
+ * next chunk. The intermediate values of a chunk stay in the CPU cache, so long chains of cheap
+ * functions are not limited by memory bandwidth.
+ *
+ * Use #can_execute to check whether a procedure is supported.
+ */
+class MFFusedProcedureExecutor : public MultiFunction {
+ private:
+  MFSignature signature_;
+  const MFProcedure &procedure_;
+  /** Call instructions in the order in which they are executed. */
+  Vector<const MFCallInstruction *> calls_;
+  /** Index of the procedure parameter of every variable, or -1 for intermediate variables. */
+  Array<int> param_index_by_variable_;
+  /** Maximum number of consecutive indices that are processed at once. */
+  int64_t chunk_size_;
+
+ public:
+  MFFusedProcedureExecutor(const MFProcedure &procedure);
+
+  /**
+   * Whether the procedure has no branches, only uses single values and doesn't have mutable
+   * parameters.
+   */
+  static bool can_execute(const MFProcedure &procedure);
+
+  void call(IndexMask mask, MFParams params, MFContext context) const override;
+
+ private:
+  ExecutionHints get_execution_hints() const override;
+};
+
+}  // namespace blender::fn
@@ -5,12 +5,14 @@
 #include "BLI_multi_value_map.hh"
 #include "BLI_set.hh"
 #include "BLI_stack.hh"
+#include "BLI_task.hh"
 #include "BLI_vector_set.hh"
 
 #include "FN_field.hh"
 #include "FN_multi_function_procedure.hh"
 #include "FN_multi_function_procedure_builder.hh"
 #include "FN_multi_function_procedure_executor.hh"
+#include "FN_multi_function_procedure_fused_executor.hh"
 #include "FN_multi_function_procedure_optimization.hh"
 
 namespace blender::fn {
@@ -86,15 +88,47 @@ static Vector<GVArray> get_field_context_inputs(
     const FieldContext &context,
     const Span<std::reference_wrapper<const FieldInput>> field_inputs)
 {
-  Vector<GVArray> field_context_inputs;
-  for (const FieldInput &field_input : field_inputs) {
-    GVArray varray = context.get_varray_for_input(field_input, mask, scope);
+  using Clock = std::chrono::steady_clock;
+  /* Worker threads don't see the timings of the calling thread, so pass them on explicitly. */
+  FieldInputTimings *timings = FieldInputTimings::get_active();
+
+  Vector<GVArray> field_context_inputs(field_inputs.size());
+  auto get_input = [&](const int i, ResourceScope &input_scope) {
+    const Clock::time_point begin = timings ? Clock::now() : Clock::time_point();
+    const FieldInput &field_input = field_inputs[i];
+    GVArray varray = context.get_varray_for_input(field_input, mask, input_scope);
     if (!varray) {
       const CPPType &type = field_input.cpp_type();
       varray = GVArray::ForSingleDefault(type, mask.min_array_size());
     }
-    field_context_inputs.append(varray);
+    field_context_inputs[i] = std::move(varray);
+    if (timings) {
+      timings->add(field_input.socket_inspection_name(), Clock::now() - begin);
+    }
+  };
+
+  if (field_inputs.size() > 1 && mask.size() >= 4096) {
+    /* Inputs are independent of each other and some of them can be expensive (e.g. normals or
+     * attributes that have to be interpolated to another domain), so retrieve them in parallel
+     * when there are enough elements to be worth the overhead of the tasks. A resource scope
+     * can't be used from multiple threads, so every input gets its own. */
+    Array<std::unique_ptr<ResourceScope>> input_scopes(field_inputs.size());
+    threading::parallel_for(field_inputs.index_range(), 1, [&](const IndexRange range) {
+      for (const int i : range) {
+        input_scopes[i] = std::make_unique<ResourceScope>();
+        get_input(i, *input_scopes[i]);
+      }
+    });
+    for (std::unique_ptr<ResourceScope> &input_scope : input_scopes) {
+      scope.add(std::move(input_scope));
+    }
+  }
+  else {
+    for (const int i : field_inputs.index_range()) {
+      get_input(i, scope);
+    }
   }
+
   return field_context_inputs;
 }
 
@@ -367,9 +401,17 @@ Vector<GVArray> evaluate_fields(ResourceScope &scope,
     MFProcedure procedure;
     build_multi_function_procedure_for_fields(
         procedure, scope, field_tree_info, varying_fields_to_evaluate);
-    MFProcedureExecutor procedure_executor{procedure};
+    /* Evaluate chains of functions on small chunks of indices at a time when possible, so that
+     * intermediate values don't have to be written to and read back from main memory. */
+    std::unique_ptr<MultiFunction> procedure_executor;
+    if (MFFusedProcedureExecutor::can_execute(procedure)) {
+      procedure_executor = std::make_unique<MFFusedProcedureExecutor>(procedure);
+    }
+    else {
+      procedure_executor = std::make_unique<MFProcedureExecutor>(procedure);
+    }
 
-    MFParamsBuilder mf_params{procedure_executor, &mask};
+    MFParamsBuilder mf_params{*procedure_executor, &mask};
     MFContextBuilder mf_context;
 
     /* Provide inputs to the procedure executor. */
@@ -410,7 +452,7 @@ Vector<GVArray> evaluate_fields(ResourceScope &scope,
       mf_params.add_uninitialized_single_output(span);
     }
 
-    procedure_executor.call_auto(mask, mf_params, mf_context);
+    procedure_executor->call_auto(mask, mf_params, mf_context);
   }
 
   /* Evaluate constant fields if necessary. */
@@ -557,6 +599,34 @@ bool IndexFieldInput::is_equal_to(const fn::FieldNode &other) const
   return dynamic_cast<const IndexFieldInput *>(&other) != nullptr;
 }
 
+/* --------------------------------------------------------------------
+ * FieldInputTimings.
+ */
+
+static thread_local FieldInputTimings *active_field_input_timings = nullptr;
+
+FieldInputTimings::FieldInputTimings() : previous_(active_field_input_timings)
+{
+  active_field_input_timings = this;
+}
+
+FieldInputTimings::~FieldInputTimings()
+{
+  BLI_assert(active_field_input_timings == this);
+  active_field_input_timings = previous_;
+}
+
+FieldInputTimings *FieldInputTimings::get_active()
+{
+  return active_field_input_timings;
+}
+
+void FieldInputTimings::add(std::string name, const std::chrono::nanoseconds duration)
+{
+  std::lock_guard lock{mutex_};
+  items_.append({std::move(name), duration});
+}
+
 /* --------------------------------------------------------------------
  * FieldNode.
  */
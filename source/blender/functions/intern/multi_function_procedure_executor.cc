@@ -1,8 +1,12 @@
 /* SPDX-License-Identifier: GPL-2.0-or-later */
 
+#include <limits>
+
 #include "FN_multi_function_procedure_executor.hh"
 
+#include "BLI_enumerable_thread_specific.hh"
 #include "BLI_stack.hh"
+#include "BLI_task.hh"
 
 namespace blender::fn {
 
@@ -16,6 +20,12 @@ MFProcedureExecutor::MFProcedureExecutor(const MFProcedure &procedure) : procedu
 
   signature_ = signature.build();
   this->set_signature(&signature_);
+
+  /* Blocks of a vector parameter can't be passed to the procedure without copying them. */
+  supports_blocks_ = std::all_of(
+      procedure.params().begin(), procedure.params().end(), [](const ConstMFParameter &param) {
+        return param.variable->data_type().is_single();
+      });
 }
 
 using IndicesSplitVectors = std::array<Vector<int64_t>, 2>;
@@ -134,6 +144,12 @@ class ValueAllocator : NonCopyable, NonMovable {
   /** All buffers in the free-lists below have been allocated with this allocator. */
   LinearAllocator<> &linear_allocator_;
 
+  /**
+   * Span buffers are allocated for at least this many elements. This allows reusing them when
+   * the procedure is executed multiple times with differently sized masks.
+   */
+  int64_t min_span_buffer_size_;
+
   /**
    * Use stacks so that the most recently used buffers are reused first. This improves cache
    * efficiency.
@@ -153,7 +169,8 @@ class ValueAllocator : NonCopyable, NonMovable {
   Stack<void *> variable_state_free_list_;
 
  public:
-  ValueAllocator(LinearAllocator<> &linear_allocator) : linear_allocator_(linear_allocator)
+  ValueAllocator(LinearAllocator<> &linear_allocator, const int64_t min_span_buffer_size = 0)
+      : linear_allocator_(linear_allocator), min_span_buffer_size_(min_span_buffer_size)
   {
   }
 
@@ -182,15 +199,16 @@ class ValueAllocator : NonCopyable, NonMovable {
 
     const int64_t element_size = type.size();
     const int64_t alignment = type.alignment();
+    const int64_t buffer_size = element_size * std::max<int64_t>(size, min_span_buffer_size_);
 
     if (alignment > min_alignment) {
       /* In this rare case we fallback to not reusing existing buffers. */
-      buffer = linear_allocator_.allocate(element_size * size, alignment);
+      buffer = linear_allocator_.allocate(buffer_size, alignment);
     }
     else {
       Stack<void *> *stack = span_buffers_free_list_.lookup_ptr(element_size);
       if (stack == nullptr || stack->is_empty()) {
-        buffer = linear_allocator_.allocate(element_size * size, min_alignment);
+        buffer = linear_allocator_.allocate(buffer_size, min_alignment);
       }
       else {
         /* Reuse existing buffer. */
@@ -814,13 +832,13 @@ void ValueAllocator::release_variable_state(VariableState *state)
 /** Keeps track of the states of all variables during evaluation. */
 class VariableStates {
  private:
-  ValueAllocator value_allocator_;
+  ValueAllocator &value_allocator_;
   Map<const MFVariable *, VariableState *> variable_states_;
   IndexMask full_mask_;
 
  public:
-  VariableStates(LinearAllocator<> &linear_allocator, IndexMask full_mask)
-      : value_allocator_(linear_allocator), full_mask_(full_mask)
+  VariableStates(ValueAllocator &value_allocator, IndexMask full_mask)
+      : value_allocator_(value_allocator), full_mask_(full_mask)
   {
   }
 
@@ -1163,17 +1181,22 @@ class InstructionScheduler {
   }
 };
 
-void MFProcedureExecutor::call(IndexMask full_mask, MFParams params, MFContext context) const
+/**
+ * Execute the procedure for all indices in the mask. The value allocator may be reused for
+ * multiple executions.
+ */
+static void execute_procedure(const MFProcedureExecutor &executor,
+                              const MFProcedure &procedure,
+                              const IndexMask full_mask,
+                              MFParams params,
+                              const MFContext context,
+                              ValueAllocator &value_allocator)
 {
-  BLI_assert(procedure_.validate());
-
-  LinearAllocator<> linear_allocator;
-
-  VariableStates variable_states{linear_allocator, full_mask};
-  variable_states.add_initial_variable_states(*this, procedure_, params);
+  VariableStates variable_states{value_allocator, full_mask};
+  variable_states.add_initial_variable_states(executor, procedure, params);
 
   InstructionScheduler scheduler;
-  scheduler.add_referenced_indices(*procedure_.entry(), full_mask);
+  scheduler.add_referenced_indices(*procedure.entry(), full_mask);
 
   /* Loop until all indices got to a return instruction. */
   while (NextInstructionInfo instr_info = scheduler.pop_next()) {
@@ -1219,9 +1242,9 @@ void MFProcedureExecutor::call(IndexMask full_mask, MFParams params, MFContext c
     }
   }
 
-  for (const int param_index : this->param_indices()) {
-    const MFParamType param_type = this->param_type(param_index);
-    const MFVariable *variable = procedure_.params()[param_index].variable;
+  for (const int param_index : executor.param_indices()) {
+    const MFParamType param_type = executor.param_type(param_index);
+    const MFVariable *variable = procedure.params()[param_index].variable;
     VariableState &variable_state = variable_states.get_variable_state(*variable);
     switch (param_type.interface_type()) {
       case MFParamType::Input: {
@@ -1242,11 +1265,115 @@ void MFProcedureExecutor::call(IndexMask full_mask, MFParams params, MFContext c
   }
 }
 
+/** Memory that is reused for all blocks that are executed on the same thread. */
+struct BlockAllocators {
+  LinearAllocator<> linear_allocator;
+  ValueAllocator value_allocator{linear_allocator, MFProcedureExecutor::block_size};
+};
+
+/**
+ * Find the positions in the mask of the indices that are in the given range.
+ */
+static IndexRange mask_positions_in_range(const IndexMask mask, const IndexRange range)
+{
+  if (mask.is_range()) {
+    const IndexRange mask_range = mask.as_range();
+    const int64_t start = std::clamp(
+        range.start(), mask_range.start(), mask_range.one_after_last());
+    const int64_t end = std::clamp(
+        range.one_after_last(), mask_range.start(), mask_range.one_after_last());
+    return IndexRange(start - mask_range.start(), end - start);
+  }
+  const Span<int64_t> indices = mask.indices();
+  const int64_t start = std::lower_bound(indices.begin(), indices.end(), range.start()) -
+                        indices.begin();
+  const int64_t end = std::lower_bound(
+                          indices.begin() + start, indices.end(), range.one_after_last()) -
+                      indices.begin();
+  return IndexRange(start, end - start);
+}
+
+void MFProcedureExecutor::call(IndexMask full_mask, MFParams params, MFContext context) const
+{
+  BLI_assert(procedure_.validate());
+
+  if (!supports_blocks_ || full_mask.is_empty() ||
+      full_mask.last() - full_mask[0] < block_size) {
+    LinearAllocator<> linear_allocator;
+    ValueAllocator value_allocator{linear_allocator};
+    execute_procedure(*this, procedure_, full_mask, params, context, value_allocator);
+    return;
+  }
+
+  /* Split the index space into blocks, so that intermediate values of a block stay in the
+   * caches. Their buffers are reused for the next block that is executed on the same thread. */
+  threading::EnumerableThreadSpecific<BlockAllocators> allocators_by_thread;
+  const int64_t mask_start = full_mask[0];
+  const int64_t blocks_num = (full_mask.last() - mask_start) / block_size + 1;
+
+  threading::parallel_for(IndexRange(blocks_num), 1, [&](const IndexRange blocks) {
+    ValueAllocator &value_allocator = allocators_by_thread.local().value_allocator;
+    Vector<int64_t> offset_mask_indices;
+    for (const int64_t block : blocks) {
+      const IndexRange positions = mask_positions_in_range(
+          full_mask, IndexRange(mask_start + block * block_size, block_size));
+      if (positions.is_empty()) {
+        continue;
+      }
+      const int64_t slice_start = full_mask[positions.first()];
+      const IndexRange slice_range{slice_start, full_mask[positions.last()] - slice_start + 1};
+      const IndexMask offset_mask = full_mask.slice_and_offset(positions, offset_mask_indices);
+
+      MFParamsBuilder offset_params{*this, offset_mask.min_array_size()};
+      for (const int param_index : this->param_indices()) {
+        const MFParamType param_type = this->param_type(param_index);
+        switch (param_type.category()) {
+          case MFParamType::SingleInput: {
+            const GVArray &varray = params.readonly_single_input(param_index);
+            offset_params.add_readonly_single_input(varray.slice(slice_range));
+            break;
+          }
+          case MFParamType::SingleMutable: {
+            const GMutableSpan span = params.single_mutable(param_index);
+            offset_params.add_single_mutable(span.slice(slice_range));
+            break;
+          }
+          case MFParamType::SingleOutput: {
+            const GMutableSpan span = params.uninitialized_single_output_if_required(
+                param_index);
+            if (span.is_empty()) {
+              offset_params.add_ignored_single_output();
+            }
+            else {
+              offset_params.add_uninitialized_single_output(span.slice(slice_range));
+            }
+            break;
+          }
+          case MFParamType::VectorInput:
+          case MFParamType::VectorMutable:
+          case MFParamType::VectorOutput: {
+            BLI_assert_unreachable();
+            break;
+          }
+        }
+      }
+      execute_procedure(*this, procedure_, offset_mask, offset_params, context, value_allocator);
+    }
+  });
+}
+
 MultiFunction::ExecutionHints MFProcedureExecutor::get_execution_hints() const
 {
   ExecutionHints hints;
-  hints.allocates_array = true;
-  hints.min_grain_size = 10000;
+  if (supports_blocks_) {
+    /* The mask is split into blocks and multi-threaded in #call already. */
+    hints.allocates_array = false;
+    hints.min_grain_size = std::numeric_limits<int64_t>::max();
+  }
+  else {
+    hints.allocates_array = true;
+    hints.min_grain_size = 10000;
+  }
   return hints;
 }
 
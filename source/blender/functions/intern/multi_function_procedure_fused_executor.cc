@@ -0,0 +1,251 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "FN_multi_function_procedure_fused_executor.hh"
+
+#include "BLI_linear_allocator.hh"
+
+namespace blender::fn {
+
+/**
+ * The values of all variables for a chunk of indices should roughly fit into this many bytes, to
+ * stay in the L1 cache of most CPUs.
+ */
+static constexpr int64_t chunk_bytes = 32 * 1024;
+static constexpr int64_t min_chunk_size = 64;
+static constexpr int64_t max_chunk_size = 4096;
+
+/**
+ * Call the callback for every instruction that is executed, in order. Returns false when an
+ * instruction isn't supported by #MFFusedProcedureExecutor.
+ */
+template<typename Fn> static bool foreach_instruction_in_order(const MFProcedure &procedure, Fn fn)
+{
+  const MFInstruction *instruction = procedure.entry();
+  while (instruction != nullptr) {
+    switch (instruction->type()) {
+      case MFInstructionType::Call: {
+        const MFCallInstruction &call = *static_cast<const MFCallInstruction *>(instruction);
+        fn(call);
+        instruction = call.next();
+        break;
+      }
+      case MFInstructionType::Destruct: {
+        /* All intermediate values are destructed after every chunk. */
+        instruction = static_cast<const MFDestructInstruction *>(instruction)->next();
+        break;
+      }
+      case MFInstructionType::Dummy: {
+        instruction = static_cast<const MFDummyInstruction *>(instruction)->next();
+        break;
+      }
+      case MFInstructionType::Return: {
+        return true;
+      }
+      case MFInstructionType::Branch: {
+        return false;
+      }
+    }
+  }
+  /* Procedures have to end with a return instruction. */
+  return false;
+}
+
+bool MFFusedProcedureExecutor::can_execute(const MFProcedure &procedure)
+{
+  for (const MFVariable *variable : procedure.variables()) {
+    if (!variable->data_type().is_single()) {
+      return false;
+    }
+  }
+
+  /* Every variable must be computed before it is used and can only be computed once, since its
+   * value isn't kept between chunks. */
+  Array<bool> is_initialized(procedure.variables().size(), false);
+  for (const ConstMFParameter &param : procedure.params()) {
+    if (param.type == MFParamType::Mutable) {
+      return false;
+    }
+    if (param.type == MFParamType::Input) {
+      is_initialized[param.variable->id()] = true;
+    }
+  }
+
+  bool is_supported = true;
+  const bool is_straight = foreach_instruction_in_order(
+      procedure, [&](const MFCallInstruction &call) {
+        const MultiFunction &fn = call.fn();
+        for (const int param_index : fn.param_indices()) {
+          const MFParamType param_type = fn.param_type(param_index);
+          const MFVariable *variable = call.params()[param_index];
+          switch (param_type.category()) {
+            case MFParamType::SingleInput: {
+              is_supported &= variable != nullptr && is_initialized[variable->id()];
+              break;
+            }
+            case MFParamType::SingleOutput: {
+              if (variable != nullptr) {
+                is_supported &= !is_initialized[variable->id()];
+                is_initialized[variable->id()] = true;
+              }
+              break;
+            }
+            default: {
+              is_supported = false;
+              break;
+            }
+          }
+        }
+      });
+  if (!is_straight || !is_supported) {
+    return false;
+  }
+
+  /* Unused variables would be destructed without being initialized. */
+  return !is_initialized.as_span().contains(false);
+}
+
+MFFusedProcedureExecutor::MFFusedProcedureExecutor(const MFProcedure &procedure)
+    : procedure_(procedure)
+{
+  BLI_assert(can_execute(procedure));
+
+  MFSignatureBuilder signature("Fused Procedure Executor");
+  for (const ConstMFParameter &param : procedure.params()) {
+    signature.add("Parameter", MFParamType(param.type, param.variable->data_type()));
+  }
+  signature_ = signature.build();
+  this->set_signature(&signature_);
+
+  foreach_instruction_in_order(procedure,
+                               [&](const MFCallInstruction &call) { calls_.append(&call); });
+
+  param_index_by_variable_.reinitialize(procedure.variables().size());
+  param_index_by_variable_.fill(-1);
+  for (const int param_index : procedure.params().index_range()) {
+    param_index_by_variable_[procedure.params()[param_index].variable->id()] = param_index;
+  }
+
+  int64_t bytes_per_index = 0;
+  for (const MFVariable *variable : procedure.variables()) {
+    bytes_per_index += variable->data_type().single_type().size();
+  }
+  chunk_size_ = std::clamp(
+      chunk_bytes / std::max<int64_t>(bytes_per_index, 1), min_chunk_size, max_chunk_size);
+}
+
+void MFFusedProcedureExecutor::call(IndexMask mask, MFParams params, MFContext context) const
+{
+  if (mask.is_empty()) {
+    return;
+  }
+  const Span<const MFVariable *> variables = procedure_.variables();
+
+  /* Buffers for the values of the intermediate variables and for the outputs that the caller
+   * ignores. They are reused for every chunk, indices in them are relative to the chunk. */
+  LinearAllocator<> allocator;
+  Array<void *> chunk_buffers(variables.size(), nullptr);
+  for (const int variable_index : variables.index_range()) {
+    const CPPType &type = variables[variable_index]->data_type().single_type();
+    const int param_index = param_index_by_variable_[variable_index];
+    if (param_index != -1) {
+      if (procedure_.params()[param_index].type == MFParamType::Input) {
+        continue;
+      }
+      if (!params.uninitialized_single_output_if_required(param_index).is_empty()) {
+        continue;
+      }
+    }
+    chunk_buffers[variable_index] = allocator.allocate(type.size() * chunk_size_,
+                                                       type.alignment());
+  }
+
+  Array<GVArray> chunk_varrays(variables.size());
+  /* Start of the values of the variables that are not inputs, for the current chunk. */
+  Array<void *> chunk_data(variables.size());
+  Vector<int64_t> offset_indices;
+  const int64_t mask_end = mask.last() + 1;
+  int64_t chunk_start_position = 0;
+  while (chunk_start_position < mask.size()) {
+    /* Find the indices in the next chunk. */
+    const int64_t chunk_start = mask[chunk_start_position];
+    const int64_t chunk_end = std::min(chunk_start + chunk_size_, mask_end);
+    int64_t chunk_end_position;
+    if (mask.is_range()) {
+      chunk_end_position = chunk_start_position + chunk_end - chunk_start;
+    }
+    else {
+      const Span<int64_t> indices = mask.indices();
+      chunk_end_position = std::lower_bound(
+                               indices.begin() + chunk_start_position, indices.end(), chunk_end) -
+                           indices.begin();
+    }
+    const IndexRange chunk_positions{chunk_start_position,
+                                     chunk_end_position - chunk_start_position};
+    const IndexRange chunk_range{chunk_start, mask[chunk_positions.last()] - chunk_start + 1};
+    const IndexMask chunk_mask = mask.slice_and_offset(chunk_positions, offset_indices);
+    chunk_start_position = chunk_end_position;
+
+    /* Get the values of all variables for the chunk. */
+    for (const int variable_index : variables.index_range()) {
+      if (chunk_buffers[variable_index] != nullptr) {
+        chunk_data[variable_index] = chunk_buffers[variable_index];
+        continue;
+      }
+      const int param_index = param_index_by_variable_[variable_index];
+      if (procedure_.params()[param_index].type == MFParamType::Input) {
+        chunk_varrays[variable_index] = params.readonly_single_input(param_index).slice(
+            chunk_range);
+      }
+      else {
+        chunk_data[variable_index] =
+            params.uninitialized_single_output(param_index).slice(chunk_range).data();
+      }
+    }
+    auto chunk_span = [&](const MFVariable &variable) {
+      return GMutableSpan(
+          variable.data_type().single_type(), chunk_data[variable.id()], chunk_range.size());
+    };
+
+    for (const MFCallInstruction *call : calls_) {
+      const MultiFunction &fn = call->fn();
+      MFParamsBuilder call_params{fn, &chunk_mask};
+      for (const int param_index : fn.param_indices()) {
+        const MFVariable *variable = call->params()[param_index];
+        if (fn.param_type(param_index).category() == MFParamType::SingleInput) {
+          if (chunk_varrays[variable->id()]) {
+            call_params.add_readonly_single_input(chunk_varrays[variable->id()]);
+          }
+          else {
+            call_params.add_readonly_single_input(GSpan(chunk_span(*variable)));
+          }
+        }
+        else if (variable == nullptr) {
+          call_params.add_ignored_single_output();
+        }
+        else {
+          call_params.add_uninitialized_single_output(chunk_span(*variable));
+        }
+      }
+      fn.call(chunk_mask, call_params, context);
+    }
+
+    /* The buffers are reused for the next chunk. */
+    for (const int variable_index : variables.index_range()) {
+      const CPPType &type = variables[variable_index]->data_type().single_type();
+      if (chunk_buffers[variable_index] != nullptr && !type.is_trivially_destructible()) {
+        type.destruct_indices(chunk_buffers[variable_index], chunk_mask);
+      }
+    }
+  }
+}
+
+MultiFunction::ExecutionHints MFFusedProcedureExecutor::get_execution_hints() const
+{
+  ExecutionHints hints;
+  /* Intermediate values only need memory for one chunk, so the mask doesn't have to be split up
+   * to keep peak memory usage low. */
+  hints.allocates_array = false;
+  return hints;
+}
+
+}  // namespace blender::fn
@@ -125,6 +125,87 @@ TEST(field, InputAndFunction)
   EXPECT_EQ(result[8], 16);
 }
 
+/** An input that computes its values eagerly, into memory owned by the resource scope. */
+class ScaledIndexFieldInput final : public FieldInput {
+ private:
+  int factor_;
+
+ public:
+  ScaledIndexFieldInput(const int factor)
+      : FieldInput(CPPType::get<int>(), "Scaled Index"), factor_(factor)
+  {
+  }
+
+  GVArray get_varray_for_context(const FieldContext &UNUSED(context),
+                                 IndexMask mask,
+                                 ResourceScope &scope) const final
+  {
+    Array<int> &values = scope.construct<Array<int>>(mask.min_array_size());
+    mask.foreach_index([&](const int64_t i) { values[i] = int(i) * factor_; });
+    return VArray<int>::ForSpan(values);
+  }
+};
+
+TEST(field, MultipleInputs)
+{
+  /* The mask is small, so the inputs are retrieved one after another. */
+  GField input_1{std::make_shared<ScaledIndexFieldInput>(1)};
+  GField input_10{std::make_shared<ScaledIndexFieldInput>(10)};
+  Field<int> input_100{std::make_shared<ScaledIndexFieldInput>(100)};
+
+  std::unique_ptr<MultiFunction> add_fn = std::make_unique<CustomMF_SI_SI_SO<int, int, int>>(
+      "add", [](int a, int b) { return a + b; });
+  GField add_field{std::make_shared<FieldOperation>(
+                       FieldOperation(std::move(add_fn), {input_1, input_10})),
+                   0};
+
+  Array<int> result(10);
+  VArray<int> result_100;
+
+  const Array<int64_t> indices = {2, 4, 6, 8};
+  const IndexMask mask{indices};
+
+  FieldContext context;
+  FieldEvaluator evaluator{context, &mask};
+  evaluator.add_with_destination(add_field, result.as_mutable_span());
+  evaluator.add(input_100, &result_100);
+  evaluator.evaluate();
+  EXPECT_EQ(result[2], 22);
+  EXPECT_EQ(result[4], 44);
+  EXPECT_EQ(result[8], 88);
+  EXPECT_EQ(result_100[6], 600);
+  EXPECT_EQ(result_100[8], 800);
+}
+
+TEST(field, MultipleInputsParallelWithTimings)
+{
+  /* Inputs are retrieved in parallel, with separate resource scopes. */
+  GField input_1{std::make_shared<ScaledIndexFieldInput>(1)};
+  GField input_10{std::make_shared<ScaledIndexFieldInput>(10)};
+
+  std::unique_ptr<MultiFunction> add_fn = std::make_unique<CustomMF_SI_SI_SO<int, int, int>>(
+      "add", [](int a, int b) { return a + b; });
+  GField add_field{std::make_shared<FieldOperation>(
+                       FieldOperation(std::move(add_fn), {input_1, input_10})),
+                   0};
+
+  Array<int> result(10000);
+
+  FieldInputTimings timings;
+  FieldContext context;
+  FieldEvaluator evaluator{context, result.size()};
+  evaluator.add_with_destination(add_field, result.as_mutable_span());
+  evaluator.evaluate();
+  EXPECT_EQ(result[0], 0);
+  EXPECT_EQ(result[5000], 55000);
+  EXPECT_EQ(result[9999], 109989);
+
+  ASSERT_EQ(timings.items().size(), 2);
+  EXPECT_EQ(timings.items()[0].name, "Scaled Index");
+  EXPECT_EQ(timings.items()[1].name, "Scaled Index");
+  EXPECT_EQ(FieldInputTimings::get_active(), &timings);
+}
+
 TEST(field, TwoFunctions)
 {
   GField index_field{std::make_shared<IndexFieldInput>()};
@@ -2,9 +2,12 @@
 
 #include "testing/testing.h"
 
+#include "BLI_timeit.hh"
+
 #include "FN_multi_function_builder.hh"
 #include "FN_multi_function_procedure_builder.hh"
 #include "FN_multi_function_procedure_executor.hh"
+#include "FN_multi_function_procedure_fused_executor.hh"
 #include "FN_multi_function_test_common.hh"
 
 namespace blender::fn::tests {
@@ -378,4 +381,228 @@ TEST(multi_function_procedure, BufferReuse)
   EXPECT_EQ(results[4], 53);
 }
 
+TEST(multi_function_procedure, ExecuteInBlocks)
+{
+  /**
+   * procedure(int a, bool cond, std::string *out) {
+   *   int b = a + 10;
+   *   if (cond) {
+   *     b += 100;
+   *   }
+   *   out = to_string(b);
+   * }
+   */
+
+  CustomMF_SI_SO<int, int> add_10_fn{"add 10", [](int a) { return a + 10; }};
+  CustomMF_SM<int> add_100_fn{"add 100", [](int &a) { a += 100; }};
+  CustomMF_SI_SO<int, std::string> to_string_fn{"to string",
+                                                [](int a) { return std::to_string(a); }};
+
+  MFProcedure procedure;
+  MFProcedureBuilder builder{procedure};
+
+  MFVariable *var_a = &builder.add_single_input_parameter<int>();
+  MFVariable *var_cond = &builder.add_single_input_parameter<bool>();
+  auto [var_b] = builder.add_call<1>(add_10_fn, {var_a});
+  builder.add_destruct(*var_a);
+  MFProcedureBuilder::Branch branch = builder.add_branch(*var_cond);
+  branch.branch_true.add_call(add_100_fn, {var_b});
+  builder.set_cursor_after_branch(branch);
+  builder.add_destruct(*var_cond);
+  auto [var_out] = builder.add_call<1>(to_string_fn, {var_b});
+  builder.add_destruct(*var_b);
+  builder.add_return();
+  builder.add_output_parameter(*var_out);
+
+  EXPECT_TRUE(procedure.validate());
+
+  MFProcedureExecutor procedure_fn{procedure};
+
+  /* Span multiple blocks, with some blocks that don't contain any index. */
+  const int64_t size = MFProcedureExecutor::block_size * 5 + 7;
+  Vector<int64_t> indices;
+  Array<bool> is_selected(size, false);
+  for (const int64_t i : IndexRange(size)) {
+    if (i % 3 != 0 && (i < MFProcedureExecutor::block_size * 2 ||
+                       i >= MFProcedureExecutor::block_size * 3)) {
+      indices.append(i);
+      is_selected[i] = true;
+    }
+  }
+
+  Array<int> inputs(size);
+  Array<bool> conditions(size);
+  for (const int64_t i : IndexRange(size)) {
+    inputs[i] = int(i);
+    conditions[i] = i % 2 == 0;
+  }
+  Array<std::string> results(size);
+
+  MFParamsBuilder params{procedure_fn, size};
+  params.add_readonly_single_input(inputs.as_span());
+  params.add_readonly_single_input(conditions.as_span());
+  params.add_uninitialized_single_output(results.as_mutable_span());
+
+  MFContextBuilder context;
+  procedure_fn.call(indices.as_span(), params, context);
+
+  for (const int64_t i : IndexRange(size)) {
+    if (is_selected[i]) {
+      EXPECT_EQ(results[i], std::to_string(i + (i % 2 == 0 ? 110 : 10)));
+    }
+    else {
+      EXPECT_TRUE(results[i].empty());
+    }
+  }
+}
+
+TEST(multi_function_procedure, FusedExecutor)
+{
+  /**
+   * procedure(int a, int *out1, std::string *out2) {
+   *   int b = a + 10;
+   *   std::string c = to_string(b);
+   *   out1 = b * 2;
+   *   out2 = c + c;
+   * }
+   */
+
+  CustomMF_SI_SO<int, int> add_10_fn{"add 10", [](int a) { return a + 10; }};
+  CustomMF_SI_SO<int, int> mul_2_fn{"mul 2", [](int a) { return a * 2; }};
+  CustomMF_SI_SO<int, std::string> to_string_fn{"to string",
+                                                [](int a) { return std::to_string(a); }};
+  CustomMF_SI_SI_SO<std::string, std::string, std::string> concat_fn{
+      "concat", [](const std::string &a, const std::string &b) { return a + b; }};
+
+  MFProcedure procedure;
+  MFProcedureBuilder builder{procedure};
+
+  MFVariable *var_a = &builder.add_single_input_parameter<int>();
+  auto [var_b] = builder.add_call<1>(add_10_fn, {var_a});
+  builder.add_destruct(*var_a);
+  auto [var_c] = builder.add_call<1>(to_string_fn, {var_b});
+  auto [var_out1] = builder.add_call<1>(mul_2_fn, {var_b});
+  builder.add_destruct(*var_b);
+  auto [var_out2] = builder.add_call<1>(concat_fn, {var_c, var_c});
+  builder.add_destruct(*var_c);
+  builder.add_return();
+  builder.add_output_parameter(*var_out1);
+  builder.add_output_parameter(*var_out2);
+
+  EXPECT_TRUE(procedure.validate());
+  EXPECT_TRUE(MFFusedProcedureExecutor::can_execute(procedure));
+
+  MFFusedProcedureExecutor procedure_fn{procedure};
+
+  /* Use more indices than fit into one chunk, with gaps. */
+  const int size = 20000;
+  Vector<int64_t> indices;
+  for (int i = 0; i < size; i += 3) {
+    indices.append(i);
+  }
+  const IndexMask mask{indices};
+
+  Array<int> inputs(size);
+  for (const int i : inputs.index_range()) {
+    inputs[i] = i;
+  }
+  Array<int> results1(size, -1);
+  Array<std::string> results2(size);
+
+  {
+    MFParamsBuilder params{procedure_fn, &mask};
+    params.add_readonly_single_input(inputs.as_span());
+    params.add_uninitialized_single_output(results1.as_mutable_span());
+    params.add_uninitialized_single_output(
+        GMutableSpan(CPPType::get<std::string>(), results2.data(), size));
+
+    MFContextBuilder context;
+    procedure_fn.call(mask, params, context);
+  }
+
+  for (const int i : IndexRange(size)) {
+    if (i % 3 == 0) {
+      EXPECT_EQ(results1[i], (i + 10) * 2);
+      EXPECT_EQ(results2[i], std::to_string(i + 10) + std::to_string(i + 10));
+    }
+    else {
+      EXPECT_EQ(results1[i], -1);
+    }
+  }
+
+  /* Ignore the second output. */
+  results1.fill(-1);
+  {
+    MFParamsBuilder params{procedure_fn, size};
+    params.add_readonly_single_input(inputs.as_span());
+    params.add_uninitialized_single_output(results1.as_mutable_span());
+    params.add_ignored_single_output();
+
+    MFContextBuilder context;
+    procedure_fn.call(IndexRange(5, size - 10), params, context);
+  }
+  EXPECT_EQ(results1[4], -1);
+  EXPECT_EQ(results1[5], 30);
+  EXPECT_EQ(results1[size - 6], (size - 6 + 10) * 2);
+  EXPECT_EQ(results1[size - 5], -1);
+}
+
+TEST(multi_function_procedure, FusedExecutorUnsupported)
+{
+  /* Mutable parameters and branches are not supported. */
+  CustomMF_SM<int> add_10_fn{"add_10", [](int &a) { a += 10; }};
+
+  MFProcedure procedure;
+  MFProcedureBuilder builder{procedure};
+  MFVariable *var_a = &builder.add_single_mutable_parameter<int>();
+  builder.add_call(add_10_fn, {var_a});
+  builder.add_return();
+
+  EXPECT_TRUE(procedure.validate());
+  EXPECT_FALSE(MFFusedProcedureExecutor::can_execute(procedure));
+}
+
+/**
+ * Set this to 1 to activate the benchmark. It is disabled by default, because it takes a while.
+ */
+#if 0
+TEST(multi_function_procedure, FusedExecutorBenchmark)
+{
+  /* A long chain of cheap functions, like many math nodes. */
+  CustomMF_SI_SO<float, float> mul_add_fn{"mul add", [](float a) { return a * 0.5f + 1.0f; }};
+
+  MFProcedure procedure;
+  MFProcedureBuilder builder{procedure};
+  MFVariable *var = &builder.add_single_input_parameter<float>();
+  for ([[maybe_unused]] const int i : IndexRange(20)) {
+    MFVariable *var_prev = var;
+    var = builder.add_call<1>(mul_add_fn, {var_prev})[0];
+    if (var_prev->id() != 0) {
+      builder.add_destruct(*var_prev);
+    }
+  }
+  builder.add_return();
+  builder.add_output_parameter(*var);
+  EXPECT_TRUE(procedure.validate());
+
+  const int64_t size = 10'000'000;
+  Array<float> inputs(size, 1.0f);
+  Array<float> results(size);
+
+  auto run = [&](const MultiFunction &procedure_fn, const StringRef name) {
+    MFParamsBuilder params{procedure_fn, size};
+    params.add_readonly_single_input(inputs.as_span());
+    params.add_uninitialized_single_output(results.as_mutable_span());
+    MFContextBuilder context;
+    SCOPED_TIMER(name);
+    procedure_fn.call_auto(IndexRange(size), params, context);
+  };
+
+  for ([[maybe_unused]] const int i : IndexRange(3)) {
+    run(MFProcedureExecutor(procedure), "Procedure executor      ");
+    run(MFFusedProcedureExecutor(procedure), "Fused procedure executor");
+  }
+}
+#endif /* Benchmark */
+
 }  // namespace blender::fn::tests
@@ -0,0 +1,28 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "BLI_math_vec_types.hh"
+#include "BLI_span.hh"
+
+#pragma once
+
+/** \file
+ * \ingroup geo
+ */
+
+namespace blender::geometry {
+
+/**
+ * Eliminate points that are closer than \a minimum_distance to a point that is kept. Points are
+ * processed in index order, a point that is not eliminated by \a elimination_mask yet is kept
+ * when no point with a lower index was kept within the distance. This gives the same result as a
+ * greedy pass over the points, independent of the number of threads.
+ *
+ * Only building the spatial grid is multi-threaded, the elimination is a single serial pass.
+ * Eliminating in parallel, e.g. in passes over grid cells that are not neighbors, would keep a
+ * different set of points and change the result of existing files.
+ */
+void eliminate_close_points(Span<float3> positions,
+                            float minimum_distance,
+                            MutableSpan<bool> elimination_mask);
+
+}  // namespace blender::geometry
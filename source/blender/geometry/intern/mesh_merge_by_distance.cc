@@ -1,10 +1,16 @@
 /* SPDX-License-Identifier: GPL-2.0-or-later */
 
+#include <algorithm>
+
+#include "atomic_ops.h"
+
 #include "BLI_array.hh"
+#include "BLI_atomic_disjoint_set.hh"
 #include "BLI_index_mask.hh"
 #include "BLI_kdtree.h"
 #include "BLI_math_vector.h"
 #include "BLI_math_vector.hh"
+#include "BLI_task.hh"
 #include "BLI_vector.hh"
 
 #include "DNA_mesh_types.h"
@@ -27,6 +33,9 @@ namespace blender::geometry {
 /* indicates whether an edge or vertex in groups_map will be merged. */
 #define ELEM_MERGED (int)(-2)
 
+/* Number of elements that are copied to the result mesh by a single task. */
+#define WELD_BLOCK_SIZE 4096
+
 /* Used to indicate a range in an array specifying a group. */
 struct WeldGroup {
   int len;
@@ -1388,6 +1397,41 @@ static void customdata_weld(
 /** \name Mesh Vertex Merging
  * \{ */
 
+static IndexRange weld_block_range(const int block, const int size)
+{
+  const int start = block * WELD_BLOCK_SIZE;
+  return IndexRange(start, std::min(WELD_BLOCK_SIZE, size - start));
+}
+
+/**
+ * Find the index in the result mesh of the first element of every block of #WELD_BLOCK_SIZE
+ * source elements, so that the blocks can be copied in parallel. The last value is the number of
+ * elements in the result.
+ */
+template<typename IsKeptFn>
+static Array<int> weld_block_dest_offsets(const int size, const IsKeptFn &is_kept)
+{
+  const int blocks_num = divide_ceil_u(size, WELD_BLOCK_SIZE);
+  Array<int> offsets(blocks_num + 1);
+  threading::parallel_for(IndexRange(blocks_num), 1, [&](IndexRange blocks) {
+    for (const int block : blocks) {
+      int count = 0;
+      for (const int i : weld_block_range(block, size)) {
+        count += is_kept(i);
+      }
+      offsets[block] = count;
+    }
+  });
+  int offset = 0;
+  for (const int block : IndexRange(blocks_num)) {
+    const int count = offsets[block];
+    offsets[block] = offset;
+    offset += count;
+  }
+  offsets.last() = offset;
+  return offsets;
+}
+
 static Mesh *create_merged_mesh(const Mesh &mesh,
                                 MutableSpan<int> vert_dest_map,
                                 const int removed_vertex_count)
@@ -1416,35 +1460,44 @@ static Mesh *create_merged_mesh(const Mesh &mesh,
    * #vert_dest_map. This map will be used to adjust the edges, polys and loops. */
   MutableSpan<int> vert_final = vert_dest_map;
 
-  int dest_index = 0;
-  for (int i = 0; i < totvert; i++) {
-    int source_index = i;
-    int count = 0;
-    while (i < totvert && vert_dest_map[i] == OUT_OF_CONTEXT) {
-      vert_final[i] = dest_index + count;
-      count++;
-      i++;
-    }
-    if (count) {
-      CustomData_copy_data(&mesh.vdata, &result->vdata, source_index, dest_index, count);
-      dest_index += count;
-    }
-    if (i == totvert) {
-      break;
-    }
-    if (vert_dest_map[i] != ELEM_MERGED) {
-      struct WeldGroup *wgroup = &weld_mesh.vert_groups[vert_dest_map[i]];
-      customdata_weld(&mesh.vdata,
-                      &result->vdata,
-                      &weld_mesh.vert_groups_buffer[wgroup->ofs],
-                      wgroup->len,
-                      dest_index);
-      vert_final[i] = dest_index;
-      dest_index++;
+  const Array<int> vert_block_offsets = weld_block_dest_offsets(
+      totvert, [&](const int i) { return vert_dest_map[i] != ELEM_MERGED; });
+  const IndexRange vert_blocks = vert_block_offsets.index_range().drop_back(1);
+  threading::parallel_for(vert_blocks, 1, [&](IndexRange blocks) {
+    for (const int block : blocks) {
+      const int end = weld_block_range(block, totvert).one_after_last();
+      int dest_index = vert_block_offsets[block];
+      for (int i = block * WELD_BLOCK_SIZE; i < end; i++) {
+        int source_index = i;
+        int count = 0;
+        while (i < end && vert_dest_map[i] == OUT_OF_CONTEXT) {
+          vert_final[i] = dest_index + count;
+          count++;
+          i++;
+        }
+        if (count) {
+          CustomData_copy_data(&mesh.vdata, &result->vdata, source_index, dest_index, count);
+          dest_index += count;
+        }
+        if (i == end) {
+          break;
+        }
+        if (vert_dest_map[i] != ELEM_MERGED) {
+          struct WeldGroup *wgroup = &weld_mesh.vert_groups[vert_dest_map[i]];
+          customdata_weld(&mesh.vdata,
+                          &result->vdata,
+                          &weld_mesh.vert_groups_buffer[wgroup->ofs],
+                          wgroup->len,
+                          dest_index);
+          vert_final[i] = dest_index;
+          dest_index++;
+        }
+      }
+      BLI_assert(dest_index == vert_block_offsets[block + 1]);
     }
-  }
+  });
 
-  BLI_assert(dest_index == result_nverts);
+  BLI_assert(vert_block_offsets.last() == result_nverts);
 
   /* Edges. */
 
@@ -1452,102 +1505,149 @@ static Mesh *create_merged_mesh(const Mesh &mesh,
    * #edge_groups_map. This map will be used to adjust the polys and loops. */
   MutableSpan<int> edge_final = weld_mesh.edge_groups_map;
 
-  dest_index = 0;
-  for (int i = 0; i < totedge; i++) {
-    const int source_index = i;
-    int count = 0;
-    while (i < totedge && weld_mesh.edge_groups_map[i] == OUT_OF_CONTEXT) {
-      edge_final[i] = dest_index + count;
-      count++;
-      i++;
-    }
-    if (count) {
-      CustomData_copy_data(&mesh.edata, &result->edata, source_index, dest_index, count);
-      MEdge *me = &result->medge[dest_index];
-      dest_index += count;
-      for (; count--; me++) {
-        me->v1 = vert_final[me->v1];
-        me->v2 = vert_final[me->v2];
+  const Array<int> edge_block_offsets = weld_block_dest_offsets(
+      totedge, [&](const int i) { return weld_mesh.edge_groups_map[i] != ELEM_MERGED; });
+  const IndexRange edge_blocks = edge_block_offsets.index_range().drop_back(1);
+  threading::parallel_for(edge_blocks, 1, [&](IndexRange blocks) {
+    for (const int block : blocks) {
+      const int end = weld_block_range(block, totedge).one_after_last();
+      int dest_index = edge_block_offsets[block];
+      for (int i = block * WELD_BLOCK_SIZE; i < end; i++) {
+        const int source_index = i;
+        int count = 0;
+        while (i < end && weld_mesh.edge_groups_map[i] == OUT_OF_CONTEXT) {
+          edge_final[i] = dest_index + count;
+          count++;
+          i++;
+        }
+        if (count) {
+          CustomData_copy_data(&mesh.edata, &result->edata, source_index, dest_index, count);
+          MEdge *me = &result->medge[dest_index];
+          dest_index += count;
+          for (; count--; me++) {
+            me->v1 = vert_final[me->v1];
+            me->v2 = vert_final[me->v2];
+          }
+        }
+        if (i == end) {
+          break;
+        }
+        if (weld_mesh.edge_groups_map[i] != ELEM_MERGED) {
+          struct WeldGroupEdge *wegrp = &weld_mesh.edge_groups[weld_mesh.edge_groups_map[i]];
+          customdata_weld(&mesh.edata,
+                          &result->edata,
+                          &weld_mesh.edge_groups_buffer[wegrp->group.ofs],
+                          wegrp->group.len,
+                          dest_index);
+          MEdge *me = &result->medge[dest_index];
+          me->v1 = vert_final[wegrp->v1];
+          me->v2 = vert_final[wegrp->v2];
+          /* "For now, assume that all merged edges are loose. This flag will be cleared in the
+           * Polys/Loops step". */
+          me->flag |= ME_LOOSEEDGE;
+
+          edge_final[i] = dest_index;
+          dest_index++;
+        }
       }
+      BLI_assert(dest_index == edge_block_offsets[block + 1]);
     }
-    if (i == totedge) {
-      break;
-    }
-    if (weld_mesh.edge_groups_map[i] != ELEM_MERGED) {
-      struct WeldGroupEdge *wegrp = &weld_mesh.edge_groups[weld_mesh.edge_groups_map[i]];
-      customdata_weld(&mesh.edata,
-                      &result->edata,
-                      &weld_mesh.edge_groups_buffer[wegrp->group.ofs],
-                      wegrp->group.len,
-                      dest_index);
-      MEdge *me = &result->medge[dest_index];
-      me->v1 = vert_final[wegrp->v1];
-      me->v2 = vert_final[wegrp->v2];
-      /* "For now, assume that all merged edges are loose. This flag will be cleared in the
-       * Polys/Loops step". */
-      me->flag |= ME_LOOSEEDGE;
-
-      edge_final[i] = dest_index;
-      dest_index++;
-    }
-  }
+  });
 
-  BLI_assert(dest_index == result_nedges);
+  BLI_assert(edge_block_offsets.last() == result_nedges);
 
   /* Polys/Loops. */
 
-  MPoly *r_mp = &result->mpoly[0];
-  MLoop *r_ml = &result->mloop[0];
-  int r_i = 0;
-  int loop_cur = 0;
-  Array<int, 64> group_buffer(weld_mesh.max_poly_len);
-  for (const int i : mpoly.index_range()) {
-    const MPoly &mp = mpoly[i];
-    const int loop_start = loop_cur;
-    const int poly_ctx = weld_mesh.poly_map[i];
-    if (poly_ctx == OUT_OF_CONTEXT) {
-      int mp_loop_len = mp.totloop;
-      CustomData_copy_data(&mesh.ldata, &result->ldata, mp.loopstart, loop_cur, mp_loop_len);
-      loop_cur += mp_loop_len;
-      for (; mp_loop_len--; r_ml++) {
-        r_ml->v = vert_final[r_ml->v];
-        r_ml->e = edge_final[r_ml->e];
+  /* Find the number of loops of every poly in the result first, so that polys can be copied in
+   * parallel. Polys that are removed get the size -1. */
+  Array<int> poly_dest_loop_len(totpoly);
+  threading::parallel_for(mpoly.index_range(), 1024, [&](IndexRange range) {
+    for (const int i : range) {
+      const int poly_ctx = weld_mesh.poly_map[i];
+      if (poly_ctx == OUT_OF_CONTEXT) {
+        poly_dest_loop_len[i] = mpoly[i].totloop;
+        continue;
       }
-    }
-    else {
       const WeldPoly &wp = weld_mesh.wpoly[poly_ctx];
       WeldLoopOfPolyIter iter;
       if (!weld_iter_loop_of_poly_begin(
-              iter, wp, weld_mesh.wloop, mloop, weld_mesh.loop_map, group_buffer.data())) {
+              iter, wp, weld_mesh.wloop, mloop, weld_mesh.loop_map, nullptr) ||
+          wp.poly_dst != OUT_OF_CONTEXT) {
+        poly_dest_loop_len[i] = -1;
         continue;
       }
+      int loop_len = 0;
+      while (weld_iter_loop_of_poly_next(iter)) {
+        loop_len++;
+      }
+      poly_dest_loop_len[i] = loop_len;
+    }
+  });
+
+  /* The first poly and loop in the result of every source poly. */
+  Array<int> poly_dest_offsets(totpoly);
+  Array<int> poly_dest_loop_offsets(totpoly);
+  int r_i = 0;
+  int loop_cur = 0;
+  for (const int i : mpoly.index_range()) {
+    poly_dest_offsets[i] = r_i;
+    poly_dest_loop_offsets[i] = loop_cur;
+    if (poly_dest_loop_len[i] != -1) {
+      r_i++;
+      loop_cur += poly_dest_loop_len[i];
+    }
+  }
 
-      if (wp.poly_dst != OUT_OF_CONTEXT) {
+  threading::parallel_for(mpoly.index_range(), 1024, [&](IndexRange range) {
+    Array<int, 64> group_buffer(weld_mesh.max_poly_len);
+    for (const int i : range) {
+      if (poly_dest_loop_len[i] == -1) {
         continue;
       }
-      while (weld_iter_loop_of_poly_next(iter)) {
-        customdata_weld(
-            &mesh.ldata, &result->ldata, group_buffer.data(), iter.group_len, loop_cur);
-        int v = vert_final[iter.v];
-        int e = edge_final[iter.e];
-        r_ml->v = v;
-        r_ml->e = e;
-        r_ml++;
-        loop_cur++;
-        if (iter.type) {
-          result->medge[e].flag &= ~ME_LOOSEEDGE;
+      const MPoly &mp = mpoly[i];
+      const int loop_start = poly_dest_loop_offsets[i];
+      const int poly_ctx = weld_mesh.poly_map[i];
+      MLoop *r_ml = &result->mloop[loop_start];
+      if (poly_ctx == OUT_OF_CONTEXT) {
+        int mp_loop_len = mp.totloop;
+        CustomData_copy_data(&mesh.ldata, &result->ldata, mp.loopstart, loop_start, mp_loop_len);
+        for (; mp_loop_len--; r_ml++) {
+          r_ml->v = vert_final[r_ml->v];
+          r_ml->e = edge_final[r_ml->e];
+        }
+      }
+      else {
+        const WeldPoly &wp = weld_mesh.wpoly[poly_ctx];
+        WeldLoopOfPolyIter iter;
+        weld_iter_loop_of_poly_begin(
+            iter, wp, weld_mesh.wloop, mloop, weld_mesh.loop_map, group_buffer.data());
+        int loop_dst = loop_start;
+        while (weld_iter_loop_of_poly_next(iter)) {
+          customdata_weld(
+              &mesh.ldata, &result->ldata, group_buffer.data(), iter.group_len, loop_dst);
+          int v = vert_final[iter.v];
+          int e = edge_final[iter.e];
+          r_ml->v = v;
+          r_ml->e = e;
+          r_ml++;
+          loop_dst++;
+          if (iter.type) {
+            /* Other polys using the same edge may be copied at the same time. */
+            atomic_fetch_and_and_int16(&result->medge[e].flag, ~int16_t(ME_LOOSEEDGE));
+          }
         }
-        BLI_assert((result->medge[e].flag & ME_LOOSEEDGE) == 0);
       }
-    }
 
-    CustomData_copy_data(&mesh.pdata, &result->pdata, i, r_i, 1);
-    r_mp->loopstart = loop_start;
-    r_mp->totloop = loop_cur - loop_start;
-    r_mp++;
-    r_i++;
-  }
+      MPoly &r_mp = result->mpoly[poly_dest_offsets[i]];
+      CustomData_copy_data(&mesh.pdata, &result->pdata, i, poly_dest_offsets[i], 1);
+      r_mp.loopstart = loop_start;
+      r_mp.totloop = poly_dest_loop_len[i];
+    }
+  });
 
+  MPoly *r_mp = &result->mpoly[r_i];
+  MLoop *r_ml = &result->mloop[loop_cur];
+  Array<int, 64> group_buffer(weld_mesh.max_poly_len);
   for (const int i : IndexRange(weld_mesh.wpoly_new_len)) {
     const WeldPoly &wp = weld_mesh.wpoly_new[i];
     const int loop_start = loop_cur;
@@ -1600,18 +1700,103 @@ std::optional<Mesh *> mesh_merge_by_distance_all(const Mesh &mesh,
                                                  const IndexMask selection,
                                                  const float merge_distance)
 {
-  Array<int> vert_dest_map(mesh.totvert, OUT_OF_CONTEXT);
+  Span<MVert> verts{mesh.mvert, mesh.totvert};
 
   KDTree_3d *tree = BLI_kdtree_3d_new(selection.size());
-
   for (const int i : selection) {
-    BLI_kdtree_3d_insert(tree, i, mesh.mvert[i].co);
+    BLI_kdtree_3d_insert(tree, i, verts[i].co);
   }
-
   BLI_kdtree_3d_balance(tree);
-  const int vert_kill_len = BLI_kdtree_3d_calc_duplicates_fast(
-      tree, merge_distance, false, vert_dest_map.data());
-  BLI_kdtree_3d_free(tree);
+  BLI_SCOPED_DEFER([&]() { BLI_kdtree_3d_free(tree); });
+
+  /* Join vertices that are within the merge distance into clusters. Vertices are only merged
+   * into vertices of the same cluster, so clusters can be processed independently. The range
+   * search finds all vertices that the search for duplicates can find. */
+  AtomicDisjointSet clusters(mesh.totvert);
+  Array<bool> has_neighbor(mesh.totvert, false);
+  threading::parallel_for(selection.index_range(), 1024, [&](const IndexRange range) {
+    for (const int vert : selection.slice(range)) {
+      struct CallbackData {
+        int vert;
+        AtomicDisjointSet &clusters;
+        bool has_neighbor;
+      } callback_data = {vert, clusters, false};
+      BLI_kdtree_3d_range_search_cb(
+          tree,
+          verts[vert].co,
+          merge_distance,
+          [](void *user_data, int index, const float *UNUSED(co), float UNUSED(dist_sq)) {
+            CallbackData &callback_data = *static_cast<CallbackData *>(user_data);
+            if (index != callback_data.vert) {
+              callback_data.clusters.join(callback_data.vert, index);
+              callback_data.has_neighbor = true;
+            }
+            return true;
+          },
+          &callback_data);
+      has_neighbor[vert] = callback_data.has_neighbor;
+    }
+  });
+
+  /* Find the vertices of every cluster, in the order of the nodes of the tree. That is the order
+   * in which #BLI_kdtree_3d_calc_duplicates_fast processes them, which decides which vertices
+   * become merge targets. */
+  Vector<int> cluster_offsets;
+  Array<int> cluster_verts;
+  {
+    Array<int> tree_order(selection.size());
+    BLI_kdtree_3d_indices_in_tree_order(tree, tree_order.data());
+
+    Array<int> cluster_sizes(mesh.totvert, 0);
+    int cluster_verts_num = 0;
+    for (const int vert : selection) {
+      if (has_neighbor[vert]) {
+        cluster_sizes[clusters.find_root(vert)]++;
+        cluster_verts_num++;
+      }
+    }
+    if (cluster_verts_num == 0) {
+      return std::nullopt;
+    }
+    /* Reuse the sizes array for the position of the next vertex of every cluster. */
+    MutableSpan<int> cluster_fill = cluster_sizes;
+    int offset = 0;
+    for (const int vert : selection) {
+      if (cluster_sizes[vert] > 0) {
+        const int size = cluster_sizes[vert];
+        cluster_offsets.append(offset);
+        cluster_fill[vert] = offset;
+        offset += size;
+      }
+    }
+    cluster_offsets.append(offset);
+    cluster_verts.reinitialize(offset);
+    for (const int vert : tree_order) {
+      if (has_neighbor[vert]) {
+        cluster_verts[cluster_fill[clusters.find_root(vert)]++] = vert;
+      }
+    }
+  }
+
+  /* The same search as #BLI_kdtree_3d_calc_duplicates_fast, which only finds vertices in the
+   * same cluster. The result is independent of the number of threads. */
+  Array<int> vert_dest_map(mesh.totvert, OUT_OF_CONTEXT);
+  const int vert_kill_len = threading::parallel_reduce(
+      IndexRange(cluster_offsets.size() - 1),
+      16,
+      0,
+      [&](const IndexRange range, int kill_len) {
+        for (const int cluster : range) {
+          const Span<int> verts_in_cluster = cluster_verts.as_span().slice(
+              cluster_offsets[cluster], cluster_offsets[cluster + 1] - cluster_offsets[cluster]);
+          for (const int vert : verts_in_cluster) {
+            kill_len += BLI_kdtree_3d_calc_duplicates_fast_step(
+                tree, verts[vert].co, vert, merge_distance, vert_dest_map.data());
+          }
+        }
+        return kill_len;
+      },
+      std::plus<int>());
 
   if (vert_kill_len == 0) {
     return std::nullopt;
@@ -0,0 +1,158 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include <algorithm>
+
+#include "BLI_array.hh"
+#include "BLI_math_vector.h"
+#include "BLI_task.hh"
+
+#include "GEO_point_elimination.hh"
+
+namespace blender::geometry {
+
+/**
+ * A uniform grid with cells at least as large as the minimum distance, stored as a spatial hash:
+ * the points are sorted into buckets by a hash of their cell. Points closer than the minimum
+ * distance to a point are in the buckets of the 27 cells around it. Points of other cells can
+ * share these buckets, they are skipped by the distance test.
+ */
+class PointGrid {
+ private:
+  Span<float3> positions_;
+  float cell_size_inv_;
+  int bucket_bits_;
+  Array<int> bucket_offsets_;
+  Array<int> bucket_points_;
+
+ public:
+  PointGrid(const Span<float3> positions, const float minimum_distance) : positions_(positions)
+  {
+    /* Larger cells are fine for correctness. They are slightly larger than the minimum distance,
+     * so that rounding errors can't put points in range more than one cell apart. Also limit the
+     * number of cells, so that cell coordinates fit into an integer. */
+    const float max_abs_co = threading::parallel_reduce(
+        positions.index_range(),
+        4096,
+        0.0f,
+        [&](const IndexRange range, float max_co) {
+          for (const float3 &co : positions.slice(range)) {
+            max_co = std::max({max_co, std::abs(co.x), std::abs(co.y), std::abs(co.z)});
+          }
+          return max_co;
+        },
+        [](const float a, const float b) { return std::max(a, b); });
+    const float cell_size = std::max(minimum_distance * 1.001f, max_abs_co * FLT_EPSILON * 16.0f);
+    cell_size_inv_ = 1.0f / cell_size;
+
+    bucket_bits_ = 1;
+    while ((int64_t(1) << bucket_bits_) < positions.size()) {
+      bucket_bits_++;
+    }
+    const int buckets_num = 1 << bucket_bits_;
+
+    Array<int> point_buckets(positions.size());
+    threading::parallel_for(positions.index_range(), 4096, [&](const IndexRange range) {
+      for (const int i : range) {
+        point_buckets[i] = this->bucket_of_cell(this->cell_of_position(positions[i]));
+      }
+    });
+
+    /* Counting sort by bucket, points in a bucket are sorted by index. */
+    bucket_offsets_.reinitialize(buckets_num + 1);
+    bucket_offsets_.fill(0);
+    for (const int bucket : point_buckets) {
+      bucket_offsets_[bucket + 1]++;
+    }
+    for (const int bucket : IndexRange(buckets_num)) {
+      bucket_offsets_[bucket + 1] += bucket_offsets_[bucket];
+    }
+    bucket_points_.reinitialize(positions.size());
+    Array<int> bucket_fill(bucket_offsets_.as_span().drop_back(1));
+    for (const int i : positions.index_range()) {
+      bucket_points_[bucket_fill[point_buckets[i]]++] = i;
+    }
+  }
+
+  /**
+   * Return true if \a fn returns true for any point other than \a point with a squared distance
+   * to it that is not larger than \a dist_sq.
+   */
+  template<typename Fn>
+  bool any_point_in_range(const int point, const float dist_sq, const Fn &fn) const
+  {
+    const float3 &co = positions_[point];
+    const int3 cell = this->cell_of_position(co);
+    /* Different cells can have the same bucket, but every bucket must only be visited once. */
+    int buckets[27];
+    int buckets_num = 0;
+    for (int x = -1; x <= 1; x++) {
+      for (int y = -1; y <= 1; y++) {
+        for (int z = -1; z <= 1; z++) {
+          const int bucket = this->bucket_of_cell(cell + int3(x, y, z));
+          if (std::find(buckets, buckets + buckets_num, bucket) == buckets + buckets_num) {
+            buckets[buckets_num++] = bucket;
+          }
+        }
+      }
+    }
+    for (const int bucket : Span(buckets, buckets_num)) {
+      for (const int other_point : bucket_points_.as_span().slice(
+               bucket_offsets_[bucket], bucket_offsets_[bucket + 1] - bucket_offsets_[bucket])) {
+        if (other_point != point && len_squared_v3v3(co, positions_[other_point]) <= dist_sq &&
+            fn(other_point)) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+ private:
+  int3 cell_of_position(const float3 &co) const
+  {
+    return int3(int(floorf(co.x * cell_size_inv_)),
+                int(floorf(co.y * cell_size_inv_)),
+                int(floorf(co.z * cell_size_inv_)));
+  }
+
+  int bucket_of_cell(const int3 &cell) const
+  {
+    const uint64_t hash = (uint64_t(uint32_t(cell.x)) * 73856093) ^
+                          (uint64_t(uint32_t(cell.y)) * 19349663) ^
+                          (uint64_t(uint32_t(cell.z)) * 83492791);
+    return int((hash * 0x9E3779B97F4A7C15) >> (64 - bucket_bits_));
+  }
+};
+
+void eliminate_close_points(const Span<float3> positions,
+                            const float minimum_distance,
+                            MutableSpan<bool> elimination_mask)
+{
+  BLI_assert(positions.size() == elimination_mask.size());
+  if (minimum_distance <= 0.0f || positions.is_empty()) {
+    return;
+  }
+
+  /* Building the grid is done in parallel. The elimination itself depends on the result for all
+   * points with a lower index, so it is done in a single pass. */
+  const PointGrid grid(positions, minimum_distance);
+  const float minimum_distance_sq = minimum_distance * minimum_distance;
+
+  /* Points that are not processed yet are not kept. */
+  Array<bool> is_kept(positions.size(), false);
+  for (const int i : positions.index_range()) {
+    if (elimination_mask[i]) {
+      continue;
+    }
+    if (grid.any_point_in_range(i, minimum_distance_sq, [&](const int other_point) {
+          return is_kept[other_point];
+        })) {
+      elimination_mask[i] = true;
+    }
+    else {
+      is_kept[i] = true;
+    }
+  }
+}
+
+}  // namespace blender::geometry
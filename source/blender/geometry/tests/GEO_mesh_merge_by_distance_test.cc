@@ -0,0 +1,134 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+#include "BLI_kdtree.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.hh"
+#include "BLI_vector.hh"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+
+#include "GEO_mesh_merge_by_distance.hh"
+
+namespace blender::geometry::tests {
+
+class mesh_merge_by_distance : public testing::Test {
+ public:
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+};
+
+static Mesh *create_point_mesh(const Span<float3> positions)
+{
+  Mesh *mesh = BKE_mesh_new_nomain(positions.size(), 0, 0, 0, 0);
+  for (const int i : positions.index_range()) {
+    copy_v3_v3(mesh->mvert[i].co, positions[i]);
+  }
+  return mesh;
+}
+
+/**
+ * Find the positions of the vertices after merging them into the targets that are chosen by
+ * #BLI_kdtree_3d_calc_duplicates_fast, the way merging was done before it was multi-threaded.
+ * Merged vertices are placed at the average position of their group.
+ */
+static Vector<float3> merged_positions_kdtree(const Span<float3> positions,
+                                              const float merge_distance)
+{
+  KDTree_3d *tree = BLI_kdtree_3d_new(positions.size());
+  for (const int i : positions.index_range()) {
+    BLI_kdtree_3d_insert(tree, i, positions[i]);
+  }
+  BLI_kdtree_3d_balance(tree);
+  Array<int> dest_map(positions.size(), -1);
+  BLI_kdtree_3d_calc_duplicates_fast(tree, merge_distance, false, dest_map.data());
+  BLI_kdtree_3d_free(tree);
+
+  Array<float3> sums(positions.size(), float3(0.0f));
+  Array<int> counts(positions.size(), 0);
+  for (const int i : positions.index_range()) {
+    const int target = dest_map[i] == -1 ? i : dest_map[i];
+    sums[target] += positions[i];
+    counts[target]++;
+  }
+  Vector<float3> result;
+  for (const int i : positions.index_range()) {
+    if (ELEM(dest_map[i], -1, i)) {
+      result.append(sums[i] / float(counts[i]));
+    }
+  }
+  return result;
+}
+
+static void expect_same_as_kdtree(const Span<float3> positions, const float merge_distance)
+{
+  const Vector<float3> expected = merged_positions_kdtree(positions, merge_distance);
+
+  Mesh *mesh = create_point_mesh(positions);
+  const std::optional<Mesh *> result = mesh_merge_by_distance_all(
+      *mesh, IndexMask(mesh->totvert), merge_distance);
+  const Mesh &result_mesh = result ? **result : *mesh;
+
+  ASSERT_EQ(result_mesh.totvert, expected.size());
+  for (const int i : expected.index_range()) {
+    EXPECT_V3_NEAR(result_mesh.mvert[i].co, expected[i], 1e-5f);
+  }
+
+  if (result) {
+    BKE_id_free(nullptr, *result);
+  }
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(mesh_merge_by_distance, Nothing)
+{
+  const Array<float3> positions = {float3(0.0f), float3(1.0f, 0.0f, 0.0f)};
+  Mesh *mesh = create_point_mesh(positions);
+  EXPECT_FALSE(mesh_merge_by_distance_all(*mesh, IndexMask(mesh->totvert), 0.5f).has_value());
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(mesh_merge_by_distance, Chain)
+{
+  /* Vertices are never merged transitively along the chain. */
+  Array<float3> positions(9);
+  for (const int i : positions.index_range()) {
+    positions[i] = float3(float(i) * 0.75f, 0.0f, 0.0f);
+  }
+  expect_same_as_kdtree(positions, 1.0f);
+}
+
+TEST_F(mesh_merge_by_distance, RandomSameAsKDTree)
+{
+  RandomNumberGenerator rng(3);
+  Array<float3> positions(20000);
+  for (float3 &position : positions) {
+    position = float3(rng.get_float(), rng.get_float(), rng.get_float()) * 10.0f;
+  }
+  expect_same_as_kdtree(positions, 0.1f);
+  expect_same_as_kdtree(positions, 0.4f);
+}
+
+TEST_F(mesh_merge_by_distance, DuplicatesSameAsKDTree)
+{
+  /* Exact duplicates with a merge distance of zero, which depends on the layout of the tree. */
+  RandomNumberGenerator rng(5);
+  Array<float3> positions(3000);
+  for (const int i : positions.index_range()) {
+    const int cell = rng.get_int32(500);
+    positions[i] = float3(float(cell % 10), float(cell / 10 % 10), float(cell / 100));
+  }
+  expect_same_as_kdtree(positions, 0.0f);
+  expect_same_as_kdtree(positions, 1.0f);
+}
+
+}  // namespace blender::geometry::tests
@@ -0,0 +1,121 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+#include "BLI_kdtree.h"
+#include "BLI_rand.hh"
+#include "BLI_utildefines.h"
+
+#include "GEO_point_elimination.hh"
+
+namespace blender::geometry::tests {
+
+/** Greedy elimination in index order with a KD-tree, as done by Poisson disk distribution. */
+static void eliminate_close_points_kdtree(const Span<float3> positions,
+                                          const float minimum_distance,
+                                          MutableSpan<bool> elimination_mask)
+{
+  KDTree_3d *kdtree = BLI_kdtree_3d_new(positions.size());
+  for (const int i : positions.index_range()) {
+    BLI_kdtree_3d_insert(kdtree, i, positions[i]);
+  }
+  BLI_kdtree_3d_balance(kdtree);
+  for (const int i : positions.index_range()) {
+    if (elimination_mask[i]) {
+      continue;
+    }
+    struct CallbackData {
+      int index;
+      MutableSpan<bool> elimination_mask;
+    } callback_data = {i, elimination_mask};
+    BLI_kdtree_3d_range_search_cb(
+        kdtree,
+        positions[i],
+        minimum_distance,
+        [](void *user_data, int index, const float *UNUSED(co), float UNUSED(dist_sq)) {
+          CallbackData &callback_data = *static_cast<CallbackData *>(user_data);
+          if (index != callback_data.index) {
+            callback_data.elimination_mask[index] = true;
+          }
+          return true;
+        },
+        &callback_data);
+  }
+  BLI_kdtree_3d_free(kdtree);
+}
+
+static void expect_same_as_kdtree(const Span<float3> positions,
+                                  const float minimum_distance,
+                                  const Span<bool> initial_mask)
+{
+  Array<bool> expected(initial_mask);
+  eliminate_close_points_kdtree(positions, minimum_distance, expected);
+  Array<bool> result(initial_mask);
+  eliminate_close_points(positions, minimum_distance, result);
+  for (const int i : positions.index_range()) {
+    EXPECT_EQ(result[i], expected[i]) << "point " << i;
+  }
+}
+
+TEST(point_elimination, Empty)
+{
+  Array<bool> mask;
+  eliminate_close_points({}, 1.0f, mask);
+}
+
+TEST(point_elimination, Line)
+{
+  /* Every second point is kept, the others are within the distance of the previous point. */
+  Array<float3> positions(10);
+  for (const int i : positions.index_range()) {
+    positions[i] = float3(float(i) * 0.6f, 0.0f, 0.0f);
+  }
+  Array<bool> mask(positions.size(), false);
+  eliminate_close_points(positions, 1.0f, mask);
+  for (const int i : positions.index_range()) {
+    EXPECT_EQ(mask[i], i % 2 == 1);
+  }
+}
+
+TEST(point_elimination, ZeroDistance)
+{
+  Array<float3> positions(3, float3(1.0f));
+  Array<bool> mask(positions.size(), false);
+  eliminate_close_points(positions, 0.0f, mask);
+  EXPECT_FALSE(mask[0]);
+  EXPECT_FALSE(mask[1]);
+  EXPECT_FALSE(mask[2]);
+}
+
+TEST(point_elimination, RandomSameAsKDTree)
+{
+  RandomNumberGenerator rng(42);
+  Array<float3> positions(20000);
+  for (float3 &position : positions) {
+    position = float3(rng.get_float(), rng.get_float(), rng.get_float() * 0.1f) * 10.0f;
+  }
+  expect_same_as_kdtree(positions, 0.2f, Array<bool>(positions.size(), false));
+  expect_same_as_kdtree(positions, 1.5f, Array<bool>(positions.size(), false));
+
+  /* Points that are eliminated already don't eliminate other points. */
+  Array<bool> initial_mask(positions.size());
+  for (bool &value : initial_mask) {
+    value = rng.get_float() < 0.3f;
+  }
+  expect_same_as_kdtree(positions, 0.2f, initial_mask);
+}
+
+TEST(point_elimination, FarAwaySameAsKDTree)
+{
+  /* Clusters of points far from the origin, with a small distance compared to the coordinates. */
+  RandomNumberGenerator rng(7);
+  Array<float3> positions(5000);
+  for (const int i : positions.index_range()) {
+    const float3 center = float3(float(i % 5) * 1000.0f, -20000.0f, 3000.0f);
+    positions[i] = center + float3(rng.get_float(), rng.get_float(), rng.get_float());
+  }
+  expect_same_as_kdtree(positions, 0.05f, Array<bool>(positions.size(), false));
+}
+
+}  // namespace blender::geometry::tests
@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup stl
+ */
+
+#pragma once
+
+#include "BKE_context.h"
+#include "BLI_path_util.h"
+
+/* The axis enums are shared with the OBJ IO module. */
+#include "IO_wavefront_obj.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct STLImportParams {
+  /** Full path to the source STL file to import. */
+  char filepath[FILE_MAX];
+  eTransformAxisForward forward_axis;
+  eTransformAxisUp up_axis;
+  float global_scale;
+  /** Use the facet normals of the file as custom normals, instead of computing them. */
+  bool use_facet_normal;
+  /** Run mesh validation on the imported mesh; slow, but catches broken files. */
+  bool validate_mesh;
+};
+
+struct STLExportParams {
+  /** Full path to the destination STL file. */
+  char filepath[FILE_MAX];
+  eTransformAxisForward forward_axis;
+  eTransformAxisUp up_axis;
+  float global_scale;
+  bool export_selected_objects;
+  bool apply_modifiers;
+  /** Write the text format instead of the (much smaller and faster) binary one. */
+  bool ascii_format;
+};
+
+/**
+ * Perform the full import process.
+ * Import also changes the selection & the active object; callers
+ * need to update the UI bits if needed.
+ */
+void STL_import(bContext *C, const struct STLImportParams *import_params);
+
+void STL_export(bContext *C, const struct STLExportParams *export_params);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,140 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup stl
+ */
+
+#include <iostream>
+#include <system_error>
+
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
+#include "BKE_object.h"
+
+#include "BLI_array.hh"
+#include "BLI_math_matrix.h"
+#include "BLI_math_rotation.h"
+#include "BLI_math_vector.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_task.hh"
+
+#include "DEG_depsgraph_query.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "stl_export.hh"
+#include "stl_export_writer.hh"
+
+namespace blender::io::stl {
+
+/** Number of triangles passed to the writer at once, to limit memory usage. */
+static constexpr int64_t batch_size = 1 << 20;
+
+/**
+ * Object to world transform, with the axis conversion and scale of the export parameters.
+ */
+static void world_and_axes_transform(const Object &object,
+                                     const STLExportParams &export_params,
+                                     float r_transform[4][4])
+{
+  float axes_transform[3][3];
+  unit_m3(axes_transform);
+  /* +Y-forward and +Z-up are the default Blender axis settings. */
+  mat3_from_axis_conversion(OBJ_AXIS_Y_FORWARD,
+                            OBJ_AXIS_Z_UP,
+                            export_params.forward_axis,
+                            export_params.up_axis,
+                            axes_transform);
+  mul_m3_fl(axes_transform, export_params.global_scale);
+  mul_m4_m3m4(r_transform, axes_transform, object.obmat);
+  /* mul_m4_m3m4 does not transform last row of obmat, i.e. location data. */
+  mul_v3_m3v3(r_transform[3], axes_transform, object.obmat[3]);
+  r_transform[3][3] = object.obmat[3][3];
+}
+
+static void write_mesh_triangles(STLWriter &writer, const Mesh &mesh, const float transform[4][4])
+{
+  const MLoopTri *looptris = BKE_mesh_runtime_looptri_ensure(&mesh);
+  const int64_t tris_num = BKE_mesh_runtime_looptri_len(&mesh);
+  /* Negative scaling flips the winding order of the transformed triangles. */
+  const bool flip = is_negative_m4(transform);
+
+  Array<float3> corner_positions(std::min(tris_num, batch_size) * 3);
+  for (int64_t batch_start = 0; batch_start < tris_num; batch_start += batch_size) {
+    const IndexRange batch(batch_start, std::min(batch_size, tris_num - batch_start));
+    threading::parallel_for(IndexRange(batch.size()), 8192, [&](const IndexRange range) {
+      for (const int64_t i : range) {
+        const MLoopTri &looptri = looptris[batch[i]];
+        for (const int corner : IndexRange(3)) {
+          const int dst_corner = flip && corner > 0 ? 3 - corner : corner;
+          const MVert &vert = mesh.mvert[mesh.mloop[looptri.tri[corner]].v];
+          mul_v3_m4v3(corner_positions[i * 3 + dst_corner], transform, vert.co);
+        }
+      }
+    });
+    writer.write_triangles(corner_positions.as_span().take_front(batch.size() * 3));
+  }
+}
+
+static void write_objects(Depsgraph *depsgraph,
+                          const STLExportParams &export_params,
+                          STLWriter &writer)
+{
+  const int deg_objects_visibility_flags = DEG_ITER_OBJECT_FLAG_LINKED_DIRECTLY |
+                                           DEG_ITER_OBJECT_FLAG_LINKED_VIA_SET |
+                                           DEG_ITER_OBJECT_FLAG_VISIBLE |
+                                           DEG_ITER_OBJECT_FLAG_DUPLI;
+  DEG_OBJECT_ITER_BEGIN (depsgraph, object, deg_objects_visibility_flags) {
+    if (export_params.export_selected_objects && !(object->base_flag & BASE_SELECTED)) {
+      continue;
+    }
+    if (!ELEM(object->type, OB_MESH, OB_SURF, OB_CURVES_LEGACY, OB_FONT, OB_MBALL)) {
+      continue;
+    }
+    Mesh *mesh = export_params.apply_modifiers ? BKE_object_get_evaluated_mesh(object) :
+                                                 BKE_object_get_pre_modified_mesh(object);
+    bool mesh_needs_free = false;
+    if (mesh == nullptr) {
+      /* Curves, text and meta-balls need a new mesh. */
+      mesh = BKE_mesh_new_from_object(depsgraph, object, true, true);
+      mesh_needs_free = true;
+    }
+    if (mesh == nullptr) {
+      continue;
+    }
+
+    float transform[4][4];
+    world_and_axes_transform(*object, export_params, transform);
+    write_mesh_triangles(writer, *mesh, transform);
+
+    if (mesh_needs_free) {
+      BKE_id_free(nullptr, mesh);
+    }
+  }
+  DEG_OBJECT_ITER_END;
+}
+
+void exporter_main(bContext *C, const STLExportParams &export_params)
+{
+  Depsgraph *depsgraph = CTX_data_ensure_evaluated_depsgraph(C);
+
+  char solid_name[FILE_MAX];
+  BLI_strncpy(solid_name, BLI_path_basename(export_params.filepath), FILE_MAX);
+  BLI_path_extension_replace(solid_name, FILE_MAX, "");
+
+  try {
+    STLWriter writer{export_params.filepath, export_params.ascii_format, solid_name};
+    write_objects(depsgraph, export_params, writer);
+  }
+  catch (const std::system_error &ex) {
+    std::cerr << ex.code().category().name() << ": " << ex.what() << ": "
+              << ex.code().message() << std::endl;
+  }
+}
+
+}  // namespace blender::io::stl
@@ -0,0 +1,18 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup stl
+ */
+
+#pragma once
+
+#include "IO_stl.h"
+
+namespace blender::io::stl {
+
+/**
+ * Export the evaluated meshes of all (or only the selected) objects into one STL file.
+ */
+void exporter_main(bContext *C, const STLExportParams &export_params);
+
+}  // namespace blender::io::stl
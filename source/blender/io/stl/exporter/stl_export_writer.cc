@@ -0,0 +1,146 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup stl
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <system_error>
+
+#include "BKE_blender_version.h"
+
+#include "BLI_array.hh"
+#include "BLI_fileops.h"
+#include "BLI_math_geom.h"
+#include "BLI_task.hh"
+
+/* SEP macro from BLI path utils clashes with SEP symbol in fmt headers. */
+#undef SEP
+#define FMT_HEADER_ONLY
+#include <fmt/format.h>
+
+#include "stl_export_writer.hh"
+
+namespace blender::io::stl {
+
+/** Number of triangles formatted serially by one task. */
+static constexpr int64_t chunk_size = 8192;
+
+static constexpr size_t BINARY_HEADER_SIZE = 80;
+static constexpr size_t BINARY_STRIDE = 12 * 4 + 2;
+
+STLWriter::STLWriter(const char *filepath, const bool ascii, const char *solid_name)
+    : filepath_(filepath), ascii_(ascii), solid_name_(solid_name)
+{
+  file_ = BLI_fopen(filepath, "wb");
+  if (file_ == nullptr) {
+    throw std::system_error(errno, std::system_category(), "Cannot open file " + filepath_);
+  }
+  if (ascii_) {
+    const std::string header = fmt::format("solid {}\n", solid_name_);
+    write_bytes(header.data(), header.size());
+  }
+  else {
+    /* The header must not start with "solid", which would make it look like an ASCII file.
+     * The triangle count is written when closing the file. */
+    char header[BINARY_HEADER_SIZE + sizeof(uint32_t)] = {0};
+    fmt::format_to_n(header,
+                     BINARY_HEADER_SIZE,
+                     "Binary STL written by Blender {}",
+                     BKE_blender_version_string());
+    write_bytes(header, sizeof(header));
+  }
+}
+
+STLWriter::~STLWriter()
+{
+  if (file_ == nullptr) {
+    return;
+  }
+  if (ascii_) {
+    const std::string footer = fmt::format("endsolid {}\n", solid_name_);
+    write_bytes(footer.data(), footer.size());
+  }
+  else {
+    if (tris_num_ > UINT32_MAX) {
+      std::cerr << "Error: too many triangles for binary STL file '" << filepath_ << "'"
+                << std::endl;
+    }
+    const uint32_t tris_num = uint32_t(tris_num_);
+    fseek(file_, BINARY_HEADER_SIZE, SEEK_SET);
+    write_bytes(&tris_num, sizeof(tris_num));
+  }
+  if (std::fclose(file_)) {
+    std::cerr << "Error: could not close the file '" << filepath_
+              << "' properly, it may be corrupted." << std::endl;
+  }
+}
+
+void STLWriter::write_bytes(const void *data, const size_t size)
+{
+  if (fwrite(data, 1, size, file_) != size) {
+    std::cerr << "Error: could not write to the file '" << filepath_ << "'" << std::endl;
+  }
+}
+
+static float3 triangle_normal(const float3 *corners)
+{
+  float3 normal;
+  normal_tri_v3(normal, corners[0], corners[1], corners[2]);
+  return normal;
+}
+
+void STLWriter::write_triangles(const Span<float3> corner_positions)
+{
+  const int64_t tris_num = corner_positions.size() / 3;
+  const int64_t chunks_num = (tris_num + chunk_size - 1) / chunk_size;
+  auto chunk_range = [&](const int64_t chunk) {
+    return IndexRange(chunk * chunk_size, std::min(chunk_size, tris_num - chunk * chunk_size));
+  };
+
+  if (ascii_) {
+    Array<fmt::memory_buffer> buffers(chunks_num);
+    threading::parallel_for(IndexRange(chunks_num), 1, [&](const IndexRange range) {
+      for (const int64_t chunk : range) {
+        auto out = fmt::appender(buffers[chunk]);
+        for (const int64_t tri : chunk_range(chunk)) {
+          const float3 *corners = &corner_positions[tri * 3];
+          const float3 normal = triangle_normal(corners);
+          fmt::format_to(out, "facet normal {:e} {:e} {:e}\n", normal.x, normal.y, normal.z);
+          fmt::format_to(out, " outer loop\n");
+          for (const int i : IndexRange(3)) {
+            fmt::format_to(
+                out, "  vertex {:e} {:e} {:e}\n", corners[i].x, corners[i].y, corners[i].z);
+          }
+          fmt::format_to(out, " endloop\nendfacet\n");
+        }
+      }
+    });
+    for (const fmt::memory_buffer &buffer : buffers) {
+      write_bytes(buffer.data(), buffer.size());
+    }
+  }
+  else {
+    /* The size of binary triangles is fixed, so all chunks are written into one buffer. */
+    Array<char> buffer(tris_num * BINARY_STRIDE);
+    threading::parallel_for(IndexRange(chunks_num), 1, [&](const IndexRange range) {
+      for (const int64_t chunk : range) {
+        for (const int64_t tri : chunk_range(chunk)) {
+          const float3 *corners = &corner_positions[tri * 3];
+          const float3 normal = triangle_normal(corners);
+          char *dst = &buffer[tri * BINARY_STRIDE];
+          memcpy(dst, &normal, sizeof(float3));
+          memcpy(dst + sizeof(float3), corners, sizeof(float3[3]));
+          /* Attribute byte count. */
+          memset(dst + sizeof(float3[4]), 0, sizeof(uint16_t));
+        }
+      }
+    });
+    write_bytes(buffer.data(), buffer.size());
+  }
+  tris_num_ += tris_num;
+}
+
+}  // namespace blender::io::stl
@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup stl
+ */
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+
+#include "BLI_math_vec_types.hh"
+#include "BLI_span.hh"
+#include "BLI_utility_mixins.hh"
+
+namespace blender::io::stl {
+
+/**
+ * Writes triangles to a binary or ASCII STL file.
+ *
+ * Triangles are passed in batches; every batch is split into chunks that are formatted into
+ * separate buffers in parallel, which are then written to the file in order.
+ */
+class STLWriter : NonCopyable, NonMovable {
+ private:
+  std::string filepath_;
+  FILE *file_ = nullptr;
+  bool ascii_;
+  std::string solid_name_;
+  /** Number of triangles written so far, stored in the header of binary files. */
+  int64_t tris_num_ = 0;
+
+ public:
+  /**
+   * Open the file and write the header.
+   * \throw std::system_error when the file cannot be opened.
+   */
+  STLWriter(const char *filepath, bool ascii, const char *solid_name) noexcept(false);
+  /**
+   * Write the footer (ASCII) or the triangle count (binary) and close the file.
+   */
+  ~STLWriter();
+
+  /**
+   * Write a batch of triangles, given as three positions each. The facet normals are computed
+   * from the positions.
+   */
+  void write_triangles(Span<float3> corner_positions);
+
+ private:
+  void write_bytes(const void *data, size_t size);
+};
+
+}  // namespace blender::io::stl
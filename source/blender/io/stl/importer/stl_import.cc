@@ -0,0 +1,184 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup stl
+ */
+
+#include <cstdio>
+#include <fcntl.h>
+#ifndef WIN32
+#  include <unistd.h>
+#else
+#  include <io.h>
+#endif
+
+#include "BKE_collection.h"
+#include "BKE_context.h"
+#include "BKE_customdata.h"
+#include "BKE_layer.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_object.h"
+
+#include "BLI_fileops.h"
+#include "BLI_math_matrix.h"
+#include "BLI_math_rotation.h"
+#include "BLI_mmap.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+
+#include "DNA_collection_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "stl_import.hh"
+#include "stl_import_ascii_reader.hh"
+#include "stl_import_binary_reader.hh"
+#include "stl_import_mesh.hh"
+
+namespace blender::io::stl {
+
+/**
+ * Whether the buffer holds a binary STL file. ASCII files start with "solid", but so do the
+ * headers of some binary files; the triangle count must match the size of binary files though.
+ */
+static bool is_binary_stl(const Span<char> buffer)
+{
+  const int64_t tris_num = binary_stl_tris_num(buffer);
+  if (tris_num < 0) {
+    return false;
+  }
+  const int64_t binary_size = BINARY_HEADER_SIZE + BINARY_TRIS_NUM_SIZE + tris_num * BINARY_STRIDE;
+  const bool starts_with_solid = StringRef(buffer.data(), std::min<int64_t>(buffer.size(), 5)) ==
+                                 "solid";
+  return !starts_with_solid || buffer.size() == binary_size;
+}
+
+static Mesh *read_stl_mesh(const Span<char> buffer, const STLImportParams &import_params)
+{
+  if (is_binary_stl(buffer)) {
+    const TriangleCorners corners = binary_stl_triangle_corners(buffer);
+    if (corners.tris_num > INT32_MAX / 3) {
+      fprintf(stderr, "STL file '%s' has too many triangles.\n", import_params.filepath);
+      return nullptr;
+    }
+    const WeldedTriangles triangles = weld_triangle_corners(corners);
+    Array<float3> facet_normals;
+    if (import_params.use_facet_normal) {
+      facet_normals = read_binary_stl_facet_normals(buffer);
+    }
+    return create_mesh_from_triangles(triangles, facet_normals, import_params.validate_mesh);
+  }
+
+  const ASCIITriangles ascii_triangles = read_ascii_stl(StringRef(buffer.data(), buffer.size()),
+                                                        import_params.use_facet_normal);
+  if (ascii_triangles.corner_positions.size() > INT32_MAX) {
+    fprintf(stderr, "STL file '%s' has too many triangles.\n", import_params.filepath);
+    return nullptr;
+  }
+  const WeldedTriangles triangles = weld_triangle_corners(ascii_triangles.corners());
+  return create_mesh_from_triangles(
+      triangles, ascii_triangles.facet_normals, import_params.validate_mesh);
+}
+
+/**
+ * Read the file and create its mesh, or return null on failure, which is reported on the
+ * console.
+ */
+static Mesh *read_stl_file(const STLImportParams &import_params)
+{
+  const int file = BLI_open(import_params.filepath, O_BINARY | O_RDONLY, 0);
+  if (file == -1) {
+    fprintf(stderr, "Cannot read from STL file:'%s'.\n", import_params.filepath);
+    return nullptr;
+  }
+  if (BLI_file_descriptor_size(file) == 0) {
+    close(file);
+    fprintf(stderr, "STL file '%s' is empty.\n", import_params.filepath);
+    return nullptr;
+  }
+  BLI_mmap_file *mmap_file = BLI_mmap_open(file);
+  /* The mapping stays valid after the file is closed. */
+  close(file);
+  if (mmap_file == nullptr) {
+    fprintf(stderr, "Cannot map STL file:'%s'.\n", import_params.filepath);
+    return nullptr;
+  }
+  const Span<char> buffer(static_cast<const char *>(BLI_mmap_get_pointer(mmap_file)),
+                          int64_t(BLI_mmap_get_length(mmap_file)));
+  Mesh *mesh = read_stl_mesh(buffer, import_params);
+  if (BLI_mmap_any_io_error(mmap_file)) {
+    fprintf(stderr, "Error reading STL file:'%s'.\n", import_params.filepath);
+    if (mesh) {
+      BKE_id_free(nullptr, mesh);
+      mesh = nullptr;
+    }
+  }
+  BLI_mmap_free(mmap_file);
+  return mesh;
+}
+
+void importer_main(bContext *C, const STLImportParams &import_params)
+{
+  Main *bmain = CTX_data_main(C);
+  Scene *scene = CTX_data_scene(C);
+  ViewLayer *view_layer = CTX_data_view_layer(C);
+  importer_main(bmain, scene, view_layer, import_params);
+}
+
+void importer_main(Main *bmain,
+                   Scene *scene,
+                   ViewLayer *view_layer,
+                   const STLImportParams &import_params)
+{
+  Mesh *mesh = read_stl_file(import_params);
+  if (mesh == nullptr) {
+    return;
+  }
+
+  /* The object is named after the file, like in the legacy Python importer. */
+  char ob_name[FILE_MAX];
+  BLI_strncpy(ob_name, BLI_path_basename(import_params.filepath), FILE_MAX);
+  BLI_path_extension_replace(ob_name, FILE_MAX, "");
+
+  Object *obj = BKE_object_add_only_object(bmain, OB_MESH, ob_name);
+  Mesh *mesh_in_bmain = static_cast<Mesh *>(
+      BKE_object_obdata_add_from_type(bmain, OB_MESH, ob_name));
+  /* `mesh->flag` is not copied by #BKE_mesh_nomain_to_mesh. */
+  const short autosmooth = (mesh->flag & ME_AUTOSMOOTH);
+  BKE_mesh_nomain_to_mesh(mesh, mesh_in_bmain, obj, &CD_MASK_EVERYTHING, true);
+  mesh_in_bmain->flag |= autosmooth;
+  obj->data = mesh_in_bmain;
+
+  float axes_transform[3][3];
+  float obmat[4][4];
+  /* +Y-forward and +Z-up are the default Blender axis settings. */
+  mat3_from_axis_conversion(import_params.forward_axis,
+                            import_params.up_axis,
+                            OBJ_AXIS_Y_FORWARD,
+                            OBJ_AXIS_Z_UP,
+                            axes_transform);
+  mul_m3_fl(axes_transform, import_params.global_scale);
+  copy_m4_m3(obmat, axes_transform);
+  BKE_object_apply_mat4(obj, obmat, true, false);
+
+  BKE_view_layer_base_deselect_all(view_layer);
+  LayerCollection *lc = BKE_layer_collection_get_active(view_layer);
+  BKE_collection_object_add(bmain, lc->collection, obj);
+  Base *base = BKE_view_layer_base_find(view_layer, obj);
+  BKE_view_layer_base_select_and_set_active(view_layer, base);
+
+  DEG_id_tag_update(&lc->collection->id, ID_RECALC_COPY_ON_WRITE);
+  DEG_id_tag_update_ex(bmain,
+                       &obj->id,
+                       ID_RECALC_TRANSFORM | ID_RECALC_GEOMETRY | ID_RECALC_ANIMATION |
+                           ID_RECALC_BASE_FLAGS);
+  DEG_id_tag_update(&scene->id, ID_RECALC_BASE_FLAGS);
+  DEG_relations_tag_update(bmain);
+}
+
+}  // namespace blender::io::stl
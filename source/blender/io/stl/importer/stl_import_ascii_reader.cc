@@ -0,0 +1,172 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup stl
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "BLI_task.hh"
+#include "BLI_vector.hh"
+
+#include "stl_import_ascii_reader.hh"
+
+namespace blender::io::stl {
+
+/** Target size of the chunks that are parsed in parallel. */
+static constexpr int64_t chunk_size = 256 * 1024;
+
+struct ASCIIChunk {
+  StringRef text;
+  Vector<float3> positions;
+  Vector<float3> normals;
+};
+
+static bool is_whitespace(const char c)
+{
+  return c > 0 && c <= ' ';
+}
+
+static StringRef drop_whitespace(StringRef str)
+{
+  const char *p = str.begin();
+  while (p < str.end() && is_whitespace(*p)) {
+    p++;
+  }
+  return StringRef(p, str.end());
+}
+
+/**
+ * Parse a float from the start of `str` and return the rest.
+ * The mapped file is not null-terminated, so the number is copied before using `strtof`.
+ */
+static StringRef parse_float(StringRef str, float &r_value)
+{
+  str = drop_whitespace(str);
+  const char *end = str.begin();
+  while (end < str.end() && !is_whitespace(*end)) {
+    end++;
+  }
+  char number[64];
+  const int64_t len = std::min<int64_t>(end - str.begin(), sizeof(number) - 1);
+  memcpy(number, str.data(), len);
+  number[len] = '\0';
+  r_value = strtof(number, nullptr);
+  return StringRef(end, str.end());
+}
+
+static StringRef parse_float3(StringRef str, float3 &r_value)
+{
+  str = parse_float(str, r_value.x);
+  str = parse_float(str, r_value.y);
+  return parse_float(str, r_value.z);
+}
+
+static void parse_chunk(ASCIIChunk &chunk, const bool read_facet_normals)
+{
+  StringRef text = chunk.text;
+  while (!text.is_empty()) {
+    const int64_t newline = text.find_first_of('\n');
+    const int64_t line_end = newline == StringRef::not_found ? text.size() : newline;
+    StringRef line = drop_whitespace(text.substr(0, line_end));
+    text = text.drop_prefix(std::min(line_end + 1, text.size()));
+
+    if (line.startswith("vertex")) {
+      float3 co;
+      parse_float3(line.drop_prefix(6), co);
+      chunk.positions.append(co);
+    }
+    else if (read_facet_normals && line.startswith("facet")) {
+      line = drop_whitespace(line.drop_prefix(5));
+      float3 normal(0.0f);
+      if (line.startswith("normal")) {
+        parse_float3(line.drop_prefix(6), normal);
+      }
+      chunk.normals.append(normal);
+    }
+    /* Other keywords (`solid`, `outer loop`, `endloop`, ...) carry no data. */
+  }
+}
+
+/**
+ * Split the buffer into chunks of about #chunk_size bytes that end at line boundaries.
+ */
+static Vector<ASCIIChunk> split_into_chunks(StringRef buffer)
+{
+  Vector<ASCIIChunk> chunks;
+  while (!buffer.is_empty()) {
+    int64_t end = buffer.size();
+    if (buffer.size() > chunk_size) {
+      const int64_t newline = buffer.find_first_of('\n', chunk_size);
+      end = newline == StringRef::not_found ? buffer.size() : newline + 1;
+    }
+    chunks.append_as();
+    chunks.last().text = buffer.substr(0, end);
+    buffer = buffer.drop_prefix(end);
+  }
+  return chunks;
+}
+
+template<typename GetFn>
+static Array<float3> concatenate_chunks(MutableSpan<ASCIIChunk> chunks,
+                                        const int64_t size,
+                                        const GetFn &get_values)
+{
+  Array<int64_t> offsets(chunks.size());
+  int64_t offset = 0;
+  for (const int64_t i : chunks.index_range()) {
+    offsets[i] = offset;
+    offset += get_values(chunks[i]).size();
+  }
+  Array<float3> result(size);
+  threading::parallel_for(chunks.index_range(), 1, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      Vector<float3> &values = get_values(chunks[i]);
+      const int64_t copy_size = std::min<int64_t>(values.size(), size - offsets[i]);
+      if (copy_size > 0) {
+        result.as_mutable_span()
+            .slice(offsets[i], copy_size)
+            .copy_from(values.as_span().take_front(copy_size));
+      }
+      values.clear_and_make_inline();
+    }
+  });
+  return result;
+}
+
+ASCIITriangles read_ascii_stl(StringRef buffer, const bool read_facet_normals)
+{
+  Vector<ASCIIChunk> chunks = split_into_chunks(buffer);
+  threading::parallel_for(chunks.index_range(), 1, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      parse_chunk(chunks[i], read_facet_normals);
+    }
+  });
+
+  int64_t positions_num = 0;
+  int64_t normals_num = 0;
+  for (const ASCIIChunk &chunk : chunks) {
+    positions_num += chunk.positions.size();
+    normals_num += chunk.normals.size();
+  }
+  const int64_t tris_num = positions_num / 3;
+
+  ASCIITriangles result;
+  if (read_facet_normals) {
+    if (normals_num == tris_num) {
+      result.facet_normals = concatenate_chunks(
+          chunks, tris_num, [](ASCIIChunk &chunk) -> Vector<float3> & { return chunk.normals; });
+    }
+    else {
+      fprintf(stderr, "STL import: number of facet normals doesn't match, they are ignored\n");
+    }
+  }
+  result.corner_positions = concatenate_chunks(
+      chunks, tris_num * 3, [](ASCIIChunk &chunk) -> Vector<float3> & { return chunk.positions; });
+  return result;
+}
+
+}  // namespace blender::io::stl
@@ -0,0 +1,42 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup stl
+ */
+
+#pragma once
+
+#include "BLI_array.hh"
+#include "BLI_math_vec_types.hh"
+#include "BLI_string_ref.hh"
+
+#include "stl_import_mesh.hh"
+
+namespace blender::io::stl {
+
+/**
+ * Triangles of an ASCII STL file.
+ */
+struct ASCIITriangles {
+  /** Three positions per triangle. */
+  Array<float3> corner_positions;
+  /** One normal per triangle; empty when not requested or when the file is inconsistent. */
+  Array<float3> facet_normals;
+
+  TriangleCorners corners() const
+  {
+    TriangleCorners corners;
+    corners.data = reinterpret_cast<const char *>(corner_positions.data());
+    corners.tris_num = corner_positions.size() / 3;
+    return corners;
+  }
+};
+
+/**
+ * Parse an ASCII STL file. The buffer is split into line-aligned chunks that are parsed in
+ * parallel. All `solid` blocks of the file are read, and vertices that don't make up a complete
+ * triangle at the end of the file are ignored.
+ */
+ASCIITriangles read_ascii_stl(StringRef buffer, bool read_facet_normals);
+
+}  // namespace blender::io::stl
@@ -0,0 +1,51 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup stl
+ */
+
+#include <cstring>
+
+#include "BLI_task.hh"
+
+#include "stl_import_binary_reader.hh"
+
+namespace blender::io::stl {
+
+int64_t binary_stl_tris_num(const Span<char> buffer)
+{
+  if (buffer.size() < BINARY_HEADER_SIZE + BINARY_TRIS_NUM_SIZE) {
+    return -1;
+  }
+  uint32_t tris_num;
+  memcpy(&tris_num, buffer.data() + BINARY_HEADER_SIZE, sizeof(tris_num));
+  if (buffer.size() < BINARY_HEADER_SIZE + BINARY_TRIS_NUM_SIZE + tris_num * BINARY_STRIDE) {
+    return -1;
+  }
+  return tris_num;
+}
+
+TriangleCorners binary_stl_triangle_corners(const Span<char> buffer)
+{
+  TriangleCorners corners;
+  corners.tris_num = std::max<int64_t>(binary_stl_tris_num(buffer), 0);
+  /* The vertex positions follow the facet normal. */
+  corners.data = buffer.data() + BINARY_HEADER_SIZE + BINARY_TRIS_NUM_SIZE + sizeof(float[3]);
+  corners.tri_stride = BINARY_STRIDE;
+  return corners;
+}
+
+Array<float3> read_binary_stl_facet_normals(const Span<char> buffer)
+{
+  const int64_t tris_num = std::max<int64_t>(binary_stl_tris_num(buffer), 0);
+  const char *data = buffer.data() + BINARY_HEADER_SIZE + BINARY_TRIS_NUM_SIZE;
+  Array<float3> normals(tris_num);
+  threading::parallel_for(normals.index_range(), 8192, [&](const IndexRange range) {
+    for (const int64_t tri : range) {
+      memcpy(&normals[tri], data + tri * BINARY_STRIDE, sizeof(float3));
+    }
+  });
+  return normals;
+}
+
+}  // namespace blender::io::stl
@@ -0,0 +1,42 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup stl
+ */
+
+#pragma once
+
+#include "BLI_array.hh"
+#include "BLI_span.hh"
+
+#include "stl_import_mesh.hh"
+
+namespace blender::io::stl {
+
+/*
+ * Binary STL files have an 80 byte header and a 4 byte triangle count, followed by 50 bytes for
+ * every triangle: a facet normal and three vertex positions (all 3 floats), and 2 bytes of
+ * "attribute byte count" that are unused in practice. All values are little-endian.
+ */
+constexpr int64_t BINARY_HEADER_SIZE = 80;
+constexpr int64_t BINARY_TRIS_NUM_SIZE = 4;
+constexpr int64_t BINARY_STRIDE = 12 * 4 + 2;
+
+/**
+ * Number of triangles given in the header of a binary STL file,
+ * or -1 when the buffer is too small to contain them.
+ */
+int64_t binary_stl_tris_num(Span<char> buffer);
+
+/**
+ * The corner positions of the triangles of a binary STL file,
+ * read directly from the (memory-mapped) file buffer.
+ */
+TriangleCorners binary_stl_triangle_corners(Span<char> buffer);
+
+/**
+ * Read the facet normals of all triangles of a binary STL file.
+ */
+Array<float3> read_binary_stl_facet_normals(Span<char> buffer);
+
+}  // namespace blender::io::stl
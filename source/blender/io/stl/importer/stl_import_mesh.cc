@@ -0,0 +1,263 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup stl
+ */
+
+#include "BKE_mesh.h"
+
+#include "BLI_math_vector.h"
+#include "BLI_task.hh"
+#include "BLI_vector_set.hh"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "stl_import_mesh.hh"
+
+namespace blender::io::stl {
+
+/** Number of corners or triangles processed serially by one task. */
+static constexpr int64_t block_size = 1 << 16;
+static constexpr int shard_bits = 6;
+static constexpr int shards_num = 1 << shard_bits;
+
+static int shard_of_position(const float3 &co)
+{
+  /* The vector hash doesn't mix its bits well, so use the high bits of a multiplicative hash.
+   * The hash sets of the shards use the low bits, which keeps them independent. */
+  return int((co.hash() * uint64_t(0x9E3779B97F4A7C15)) >> (64 - shard_bits));
+}
+
+WeldedTriangles weld_triangle_corners(const TriangleCorners &corners)
+{
+  const int64_t corners_num = corners.size();
+  const int64_t blocks_num = (corners_num + block_size - 1) / block_size;
+  const IndexRange blocks(blocks_num);
+  auto block_range = [&](const int64_t block) {
+    return IndexRange(block * block_size, std::min(block_size, corners_num - block * block_size));
+  };
+
+  /* Find the shard of every corner, and count the corners of every shard in every block. */
+  Array<uint8_t> corner_shards(corners_num);
+  Array<int> block_shard_counts(blocks_num * shards_num, 0);
+  threading::parallel_for(blocks, 1, [&](const IndexRange range) {
+    for (const int64_t block : range) {
+      MutableSpan<int> counts = block_shard_counts.as_mutable_span().slice(block * shards_num,
+                                                                          shards_num);
+      for (const int64_t corner : block_range(block)) {
+        const int shard = shard_of_position(corners[corner]);
+        corner_shards[corner] = uint8_t(shard);
+        counts[shard]++;
+      }
+    }
+  });
+
+  /* Sort the corners by shard, keeping them in file order within every shard. */
+  Array<int64_t> shard_offsets(shards_num + 1);
+  Array<int64_t> block_shard_offsets(blocks_num * shards_num);
+  int64_t offset = 0;
+  for (const int shard : IndexRange(shards_num)) {
+    shard_offsets[shard] = offset;
+    for (const int64_t block : blocks) {
+      block_shard_offsets[block * shards_num + shard] = offset;
+      offset += block_shard_counts[block * shards_num + shard];
+    }
+  }
+  shard_offsets[shards_num] = offset;
+  block_shard_counts.reinitialize(0);
+
+  Array<int> sorted_corners(corners_num);
+  threading::parallel_for(blocks, 1, [&](const IndexRange range) {
+    for (const int64_t block : range) {
+      MutableSpan<int64_t> offsets = block_shard_offsets.as_mutable_span().slice(
+          block * shards_num, shards_num);
+      for (const int64_t corner : block_range(block)) {
+        sorted_corners[offsets[corner_shards[corner]]++] = int(corner);
+      }
+    }
+  });
+  block_shard_offsets.reinitialize(0);
+
+  /* Deduplicate the positions of every shard. Since the corners of a shard are in file order,
+   * the corner that adds a position to the set is its first use in the whole file. */
+  Array<int> corner_verts(corners_num);
+  Array<bool> is_first_use(corners_num);
+  Array<VectorSet<float3>> shard_positions(shards_num);
+  threading::parallel_for(IndexRange(shards_num), 1, [&](const IndexRange range) {
+    for (const int shard : range) {
+      const Span<int> shard_corners = sorted_corners.as_span().slice(
+          shard_offsets[shard], shard_offsets[shard + 1] - shard_offsets[shard]);
+      VectorSet<float3> &positions = shard_positions[shard];
+      for (const int corner : shard_corners) {
+        const int64_t old_size = positions.size();
+        corner_verts[corner] = int(positions.index_of_or_add(corners[corner]));
+        is_first_use[corner] = positions.size() > old_size;
+      }
+    }
+  });
+  sorted_corners.reinitialize(0);
+
+  /* Number the vertices in order of first use. */
+  Array<int> block_vert_offsets(blocks_num + 1);
+  threading::parallel_for(blocks, 1, [&](const IndexRange range) {
+    for (const int64_t block : range) {
+      int count = 0;
+      for (const int64_t corner : block_range(block)) {
+        count += is_first_use[corner];
+      }
+      block_vert_offsets[block] = count;
+    }
+  });
+  int verts_num = 0;
+  for (const int64_t block : blocks) {
+    const int count = block_vert_offsets[block];
+    block_vert_offsets[block] = verts_num;
+    verts_num += count;
+  }
+  block_vert_offsets[blocks_num] = verts_num;
+
+  WeldedTriangles result;
+  result.positions.reinitialize(verts_num);
+  Array<Array<int>> shard_vert_indices(shards_num);
+  for (const int shard : IndexRange(shards_num)) {
+    shard_vert_indices[shard].reinitialize(shard_positions[shard].size());
+  }
+  threading::parallel_for(blocks, 1, [&](const IndexRange range) {
+    for (const int64_t block : range) {
+      int vert = block_vert_offsets[block];
+      for (const int64_t corner : block_range(block)) {
+        if (is_first_use[corner]) {
+          const int shard = corner_shards[corner];
+          shard_vert_indices[shard][corner_verts[corner]] = vert;
+          result.positions[vert] = shard_positions[shard][corner_verts[corner]];
+          vert++;
+        }
+      }
+    }
+  });
+
+  threading::parallel_for(corner_verts.index_range(), block_size, [&](const IndexRange range) {
+    for (const int64_t corner : range) {
+      corner_verts[corner] = shard_vert_indices[corner_shards[corner]][corner_verts[corner]];
+    }
+  });
+  result.corner_verts = std::move(corner_verts);
+  return result;
+}
+
+/**
+ * Indices of the triangles that have three distinct vertices.
+ */
+static Array<int> find_valid_triangles(const Span<int> corner_verts)
+{
+  const int64_t tris_num = corner_verts.size() / 3;
+  const int64_t blocks_num = (tris_num + block_size - 1) / block_size;
+  const IndexRange blocks(blocks_num);
+  auto block_range = [&](const int64_t block) {
+    return IndexRange(block * block_size, std::min(block_size, tris_num - block * block_size));
+  };
+  auto is_valid = [&](const int64_t tri) {
+    const int v0 = corner_verts[tri * 3];
+    const int v1 = corner_verts[tri * 3 + 1];
+    const int v2 = corner_verts[tri * 3 + 2];
+    return v0 != v1 && v1 != v2 && v2 != v0;
+  };
+
+  Array<int> block_offsets(blocks_num + 1);
+  threading::parallel_for(blocks, 1, [&](const IndexRange range) {
+    for (const int64_t block : range) {
+      int count = 0;
+      for (const int64_t tri : block_range(block)) {
+        count += is_valid(tri);
+      }
+      block_offsets[block] = count;
+    }
+  });
+  int valid_num = 0;
+  for (const int64_t block : blocks) {
+    const int count = block_offsets[block];
+    block_offsets[block] = valid_num;
+    valid_num += count;
+  }
+
+  Array<int> valid_tris(valid_num);
+  threading::parallel_for(blocks, 1, [&](const IndexRange range) {
+    for (const int64_t block : range) {
+      int index = block_offsets[block];
+      for (const int64_t tri : block_range(block)) {
+        if (is_valid(tri)) {
+          valid_tris[index++] = int(tri);
+        }
+      }
+    }
+  });
+  return valid_tris;
+}
+
+Mesh *create_mesh_from_triangles(const WeldedTriangles &triangles,
+                                 const Span<float3> facet_normals,
+                                 const bool validate_mesh)
+{
+  const Span<int> corner_verts = triangles.corner_verts;
+  const Array<int> valid_tris = find_valid_triangles(corner_verts);
+  if (valid_tris.size() < corner_verts.size() / 3) {
+    fprintf(stderr,
+            "STL import: skipped %d degenerate triangles\n",
+            int(corner_verts.size() / 3 - valid_tris.size()));
+  }
+
+  const int verts_num = int(triangles.positions.size());
+  const int tris_num = int(valid_tris.size());
+  Mesh *mesh = BKE_mesh_new_nomain(verts_num, 0, 0, tris_num * 3, tris_num);
+
+  const Span<float3> positions = triangles.positions;
+  threading::parallel_for(positions.index_range(), 8192, [&](const IndexRange range) {
+    for (const int i : range) {
+      copy_v3_v3(mesh->mvert[i].co, positions[i]);
+    }
+  });
+
+  const bool use_custom_normals = !facet_normals.is_empty();
+  threading::parallel_for(valid_tris.index_range(), 8192, [&](const IndexRange range) {
+    for (const int i : range) {
+      MPoly &mpoly = mesh->mpoly[i];
+      mpoly.loopstart = i * 3;
+      mpoly.totloop = 3;
+      /* Custom normals are only used for smooth faces. */
+      mpoly.flag = use_custom_normals ? ME_SMOOTH : 0;
+      const int tri = valid_tris[i];
+      for (const int corner : IndexRange(3)) {
+        mesh->mloop[i * 3 + corner].v = corner_verts[tri * 3 + corner];
+      }
+    }
+  });
+
+  BKE_mesh_calc_edges(mesh, false, false);
+
+  if (use_custom_normals) {
+    float(*loop_normals)[3] = static_cast<float(*)[3]>(
+        MEM_malloc_arrayN(mesh->totloop, sizeof(float[3]), __func__));
+    threading::parallel_for(valid_tris.index_range(), 8192, [&](const IndexRange range) {
+      for (const int i : range) {
+        float normal[3];
+        normalize_v3_v3(normal, facet_normals[valid_tris[i]]);
+        for (const int corner : IndexRange(3)) {
+          copy_v3_v3(loop_normals[i * 3 + corner], normal);
+        }
+      }
+    });
+    mesh->flag |= ME_AUTOSMOOTH;
+    BKE_mesh_set_custom_normals(mesh, loop_normals);
+    MEM_freeN(loop_normals);
+  }
+
+  if (validate_mesh) {
+    BKE_mesh_validate(mesh, false, true);
+  }
+  return mesh;
+}
+
+}  // namespace blender::io::stl
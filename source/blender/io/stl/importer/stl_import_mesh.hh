@@ -0,0 +1,74 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup stl
+ */
+
+#pragma once
+
+#include <cstring>
+
+#include "BLI_array.hh"
+#include "BLI_math_vec_types.hh"
+#include "BLI_span.hh"
+
+struct Mesh;
+
+namespace blender::io::stl {
+
+/**
+ * The corner positions of the triangles of an STL file, read from a buffer in which triangles
+ * are stored with a fixed stride: the memory-mapped file itself for the binary format, or an
+ * array of positions for the ASCII format.
+ */
+struct TriangleCorners {
+  /** Position of the first corner of the first triangle. */
+  const char *data = nullptr;
+  int64_t tris_num = 0;
+  /** Number of bytes between two triangles; the three corners of a triangle are contiguous. */
+  int64_t tri_stride = sizeof(float[3][3]);
+
+  int64_t size() const
+  {
+    return tris_num * 3;
+  }
+
+  float3 operator[](const int64_t corner) const
+  {
+    float3 co;
+    memcpy(&co, data + (corner / 3) * tri_stride + (corner % 3) * sizeof(float[3]), sizeof(co));
+    /* Adding zero turns -0.0 into 0.0, so that both get the same hash. */
+    return co + float3(0.0f);
+  }
+};
+
+/**
+ * Result of welding the corners of a triangle soup into shared vertices.
+ */
+struct WeldedTriangles {
+  /** Unique positions, in the order in which they are first used. */
+  Array<float3> positions;
+  /** Vertex index of every triangle corner. */
+  Array<int> corner_verts;
+};
+
+/**
+ * Merge triangle corners with exactly the same position into one vertex.
+ *
+ * Corners are distributed over shards by their hash and every shard is deduplicated in parallel
+ * with its own hash set. Vertex indices are then assigned in order of first use, so the result
+ * is the same as a serial #VectorSet based deduplication would give.
+ */
+WeldedTriangles weld_triangle_corners(const TriangleCorners &corners);
+
+/**
+ * Create a mesh from the welded triangles. Triangles that became degenerate because of the
+ * welding are skipped.
+ *
+ * \param facet_normals: When not empty, the normal of every triangle, used as custom normals.
+ */
+Mesh *create_mesh_from_triangles(const WeldedTriangles &triangles,
+                                 Span<float3> facet_normals,
+                                 bool validate_mesh);
+
+}  // namespace blender::io::stl
@@ -0,0 +1,83 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include <gtest/gtest.h>
+#include <string>
+
+#include "testing/testing.h"
+
+#include "BKE_appdir.h"
+
+#include "BLI_fileops.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "stl_export_writer.hh"
+#include "stl_import_ascii_reader.hh"
+#include "stl_import_binary_reader.hh"
+
+namespace blender::io::stl {
+
+static std::string read_file(const std::string &filepath)
+{
+  size_t size;
+  void *data = BLI_file_read_binary_as_mem(filepath.c_str(), 0, &size);
+  if (data == nullptr) {
+    return "";
+  }
+  std::string result(static_cast<const char *>(data), size);
+  MEM_freeN(data);
+  return result;
+}
+
+static const float3 test_triangles_data[] = {
+    {0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, 2}, {0, 3, 2}, {0, 0, 5}};
+static const Span<float3> test_triangles(test_triangles_data, ARRAY_SIZE(test_triangles_data));
+
+static std::string write_test_file(const bool ascii)
+{
+  BKE_tempdir_init(nullptr);
+  const std::string filepath = std::string(BKE_tempdir_base()) + "stl_exporter_test.stl";
+  {
+    STLWriter writer{filepath.c_str(), ascii, "test"};
+    writer.write_triangles(test_triangles.take_front(3));
+    writer.write_triangles(test_triangles.drop_front(3));
+  }
+  const std::string result = read_file(filepath);
+  BLI_delete(filepath.c_str(), false, false);
+  return result;
+}
+
+TEST(stl_exporter, binary_round_trip)
+{
+  const std::string buffer = write_test_file(false);
+  const Span<char> span(buffer.data(), buffer.size());
+  EXPECT_EQ(span.size(), BINARY_HEADER_SIZE + BINARY_TRIS_NUM_SIZE + 2 * BINARY_STRIDE);
+  EXPECT_NE(buffer.substr(0, 5), "solid");
+  ASSERT_EQ(binary_stl_tris_num(span), 2);
+
+  const TriangleCorners corners = binary_stl_triangle_corners(span);
+  for (const int64_t corner : test_triangles.index_range()) {
+    EXPECT_EQ(corners[corner], test_triangles[corner]);
+  }
+  const Array<float3> normals = read_binary_stl_facet_normals(span);
+  EXPECT_EQ(normals[0], float3(0, 0, 1));
+  EXPECT_EQ(normals[1], float3(1, 0, 0));
+}
+
+TEST(stl_exporter, ascii_round_trip)
+{
+  const std::string buffer = write_test_file(true);
+  EXPECT_EQ(buffer.substr(0, 11), "solid test\n");
+  EXPECT_EQ(buffer.substr(buffer.size() - 14), "endsolid test\n");
+
+  const ASCIITriangles triangles = read_ascii_stl(buffer, true);
+  ASSERT_EQ(triangles.corner_positions.size(), test_triangles.size());
+  for (const int64_t corner : test_triangles.index_range()) {
+    EXPECT_EQ(triangles.corner_positions[corner], test_triangles[corner]);
+  }
+  ASSERT_EQ(triangles.facet_normals.size(), 2);
+  EXPECT_EQ(triangles.facet_normals[0], float3(0, 0, 1));
+  EXPECT_EQ(triangles.facet_normals[1], float3(1, 0, 0));
+}
+
+}  // namespace blender::io::stl
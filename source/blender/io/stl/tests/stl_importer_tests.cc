@@ -0,0 +1,165 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+
+#include "testing/testing.h"
+
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+
+#include "BLI_vector.hh"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "stl_import_ascii_reader.hh"
+#include "stl_import_binary_reader.hh"
+#include "stl_import_mesh.hh"
+
+namespace blender::io::stl {
+
+static TriangleCorners corners_of(const Span<float3> positions)
+{
+  TriangleCorners corners;
+  corners.data = reinterpret_cast<const char *>(positions.data());
+  corners.tris_num = positions.size() / 3;
+  return corners;
+}
+
+TEST(stl_importer, weld_triangle_corners)
+{
+  const Array<float3> positions = {
+      {0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}, {-0.0f, 0, 0}, {2, 2, 2}};
+  const TriangleCorners corners = corners_of(positions);
+  /* The last two positions don't make up a triangle. */
+  EXPECT_EQ(corners.tris_num, 2);
+
+  const WeldedTriangles welded = weld_triangle_corners(corners);
+  /* Vertices are numbered in order of first use. */
+  ASSERT_EQ(welded.positions.size(), 4);
+  EXPECT_EQ(welded.positions[0], float3(0, 0, 0));
+  EXPECT_EQ(welded.positions[1], float3(1, 0, 0));
+  EXPECT_EQ(welded.positions[2], float3(0, 1, 0));
+  EXPECT_EQ(welded.positions[3], float3(1, 1, 0));
+  const Array<int> expected_corner_verts = {0, 1, 2, 1, 3, 2};
+  EXPECT_EQ_ARRAY(welded.corner_verts.data(), expected_corner_verts.data(), 6);
+}
+
+TEST(stl_importer, weld_negative_zero)
+{
+  const Array<float3> positions = {
+      {0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {-0.0f, -0.0f, -0.0f}, {1, -0.0f, 0}, {0, 0, 1}};
+  const WeldedTriangles welded = weld_triangle_corners(corners_of(positions));
+  EXPECT_EQ(welded.positions.size(), 4);
+  EXPECT_EQ(welded.corner_verts[3], 0);
+  EXPECT_EQ(welded.corner_verts[4], 1);
+}
+
+TEST(stl_importer, weld_many_corners)
+{
+  /* A grid of quads, large enough to be split into several blocks and shards. */
+  const int size = 300;
+  Vector<float3> positions;
+  for (const int y : IndexRange(size)) {
+    for (const int x : IndexRange(size)) {
+      const float3 p0(x, y, 0), p1(x + 1, y, 0), p2(x + 1, y + 1, 0), p3(x, y + 1, 0);
+      positions.extend({p0, p1, p2, p0, p2, p3});
+    }
+  }
+  const WeldedTriangles welded = weld_triangle_corners(corners_of(positions));
+  EXPECT_EQ(welded.positions.size(), (size + 1) * (size + 1));
+  for (const int64_t corner : positions.index_range()) {
+    EXPECT_EQ(welded.positions[welded.corner_verts[corner]], positions[corner]);
+  }
+  /* The first triangle uses the first vertices. */
+  EXPECT_EQ(welded.corner_verts[0], 0);
+  EXPECT_EQ(welded.corner_verts[1], 1);
+  EXPECT_EQ(welded.corner_verts[2], 2);
+}
+
+TEST(stl_importer, binary_reader)
+{
+  const float tris[2][4][3] = {{{0, 0, 1}, {0, 0, 0}, {1, 0, 0}, {0, 1, 0}},
+                               {{0, 0, 1}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}}};
+  std::string buffer(BINARY_HEADER_SIZE, 'x');
+  const uint32_t tris_num = 2;
+  buffer.append(reinterpret_cast<const char *>(&tris_num), sizeof(tris_num));
+  for (const int tri : IndexRange(2)) {
+    buffer.append(reinterpret_cast<const char *>(tris[tri]), sizeof(tris[tri]));
+    buffer.append(2, '\0');
+  }
+  const Span<char> span(buffer.data(), buffer.size());
+
+  EXPECT_EQ(binary_stl_tris_num(span), 2);
+  EXPECT_EQ(binary_stl_tris_num(span.drop_back(1)), -1);
+
+  const TriangleCorners corners = binary_stl_triangle_corners(span);
+  EXPECT_EQ(corners.size(), 6);
+  EXPECT_EQ(corners[0], float3(0, 0, 0));
+  EXPECT_EQ(corners[4], float3(1, 1, 0));
+  EXPECT_EQ(corners[5], float3(0, 1, 0));
+
+  const Array<float3> normals = read_binary_stl_facet_normals(span);
+  ASSERT_EQ(normals.size(), 2);
+  EXPECT_EQ(normals[1], float3(0, 0, 1));
+}
+
+TEST(stl_importer, ascii_reader)
+{
+  const std::string text =
+      "solid cube\n"
+      "  facet normal 0 0 -1\n"
+      "    outer loop\n"
+      "      vertex 0 0 0\n"
+      "      vertex 1.5e0 0 0\n"
+      "      vertex 0 1 0\n"
+      "    endloop\n"
+      "  endfacet\n"
+      "  facet normal 0.0 0.0 1.0\r\n"
+      "    outer loop\r\n"
+      "      vertex 0 0 1\r\n"
+      "      vertex -1 2.25 1\r\n"
+      "      vertex 0 1 1\r\n"
+      "    endloop\r\n"
+      "  endfacet\r\n"
+      "endsolid cube\n"
+      "solid other\n"
+      "  facet normal 1 0 0\n"
+      "    outer loop\n"
+      "      vertex 5 5 5\n"
+      "      vertex 6 5 5\n"
+      "      vertex 6 6 5";
+  const ASCIITriangles triangles = read_ascii_stl(text, true);
+  ASSERT_EQ(triangles.corner_positions.size(), 9);
+  EXPECT_EQ(triangles.corner_positions[1], float3(1.5f, 0, 0));
+  EXPECT_EQ(triangles.corner_positions[4], float3(-1, 2.25f, 1));
+  EXPECT_EQ(triangles.corner_positions[8], float3(6, 6, 5));
+  ASSERT_EQ(triangles.facet_normals.size(), 3);
+  EXPECT_EQ(triangles.facet_normals[0], float3(0, 0, -1));
+  EXPECT_EQ(triangles.facet_normals[2], float3(1, 0, 0));
+  EXPECT_EQ(triangles.corners().tris_num, 3);
+
+  const ASCIITriangles without_normals = read_ascii_stl(text, false);
+  EXPECT_EQ(without_normals.corner_positions.size(), 9);
+  EXPECT_TRUE(without_normals.facet_normals.is_empty());
+}
+
+TEST(stl_importer, create_mesh_skips_degenerate_triangles)
+{
+  BKE_idtype_init();
+  WeldedTriangles triangles;
+  triangles.positions = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {1, 1, 0}};
+  triangles.corner_verts = {0, 1, 2, 1, 1, 2, 1, 3, 2};
+  Mesh *mesh = create_mesh_from_triangles(triangles, {}, false);
+  EXPECT_EQ(mesh->totvert, 4);
+  EXPECT_EQ(mesh->totpoly, 2);
+  EXPECT_EQ(mesh->totloop, 6);
+  EXPECT_EQ(mesh->totedge, 5);
+  EXPECT_EQ(mesh->mloop[3].v, 1);
+  EXPECT_EQ(mesh->mloop[4].v, 3);
+  BKE_id_free(nullptr, mesh);
+}
+
+}  // namespace blender::io::stl
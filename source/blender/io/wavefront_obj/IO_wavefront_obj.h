@@ -77,6 +77,26 @@ struct OBJExportParams {
   bool smooth_groups_bitflags;
 };
 
+struct OBJImportParams {
+  /** Full path to the source OBJ file to import. */
+  char filepath[FILE_MAX];
+  /** Value 0 disables clamping. */
+  float clamp_size;
+  eTransformAxisForward forward_axis;
+  eTransformAxisUp up_axis;
+  /** Create a vertex group for each `g` group name used by the faces of an object. */
+  bool import_vertex_groups;
+  /** Run mesh validation on the imported meshes; slow, but catches broken files. */
+  bool validate_meshes;
+};
+
+/**
+ * Perform the full import process.
+ * Import also changes the selection & the active object; callers
+ * need to update the UI bits if needed.
+ */
+void OBJ_import(bContext *C, const struct OBJImportParams *import_params);
+
 void OBJ_export(bContext *C, const struct OBJExportParams *export_params);
 
 #ifdef __cplusplus
@@ -0,0 +1,823 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup obj
+ */
+
+#include <algorithm>
+#include <climits>
+#include <fcntl.h>
+#include <iostream>
+#include <optional>
+#ifndef WIN32
+#  include <unistd.h>
+#else
+#  include <io.h>
+#endif
+
+#include "BLI_array.hh"
+#include "BLI_fileops.h"
+#include "BLI_mmap.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_task.hh"
+
+#include "MEM_guardedalloc.h"
+
+#include "obj_import_file_reader.hh"
+#include "obj_import_string_utils.hh"
+
+namespace blender::io::obj {
+
+/* -------------------------------------------------------------------- */
+/** \name Geometry
+ * \{ */
+
+void Geometry::finalize()
+{
+  const bool has_topology = std::any_of(parts_.begin(), parts_.end(), [](const GeometryPart &p) {
+    return !p.face_elements_.is_empty() || !p.edges_.is_empty();
+  });
+
+  part_material_maps_.clear();
+  part_group_maps_.clear();
+  part_face_offsets_.clear();
+  part_corner_offsets_.clear();
+  total_faces_ = 0;
+  total_corners_ = 0;
+  total_edges_ = 0;
+  for (const GeometryPart &part : parts_) {
+    part_material_maps_.append_as();
+    Vector<int> &material_map = part_material_maps_.last();
+    for (const std::string &name : part.material_names_) {
+      material_map.append(material_names_.index_of_or_add(name));
+    }
+    part_group_maps_.append_as();
+    Vector<int> &group_map = part_group_maps_.last();
+    for (const std::string &name : part.group_names_) {
+      group_map.append(group_names_.index_of_or_add(name));
+    }
+    part_face_offsets_.append(total_faces_);
+    part_corner_offsets_.append(total_corners_);
+    total_faces_ += int(part.face_elements_.size());
+    total_corners_ += int(part.face_corners_.size());
+    total_edges_ += int(part.edges_.size());
+
+    /* Objects with faces or edges only need the vertices they use. Loose vertices are only
+     * kept for point-cloud-like objects, which use all vertices declared in them. */
+    const int min = has_topology ? part.vertex_index_min_ : part.declared_vertex_min_;
+    const int max = has_topology ? part.vertex_index_max_ : part.declared_vertex_max_;
+    vertex_index_min_ = std::min(vertex_index_min_, min);
+    vertex_index_max_ = std::max(vertex_index_max_, max);
+    has_uv_ |= part.has_uv_;
+    has_vertex_normals_ |= part.has_vertex_normals_;
+    has_invalid_polys_ |= part.has_invalid_polys_;
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name OBJ Parsing
+ * \{ */
+
+/** Grouping state that carries over from one line of the file to the next. */
+struct ParserState {
+  /** Number of vertex elements before the current line. */
+  int vertex_offset = 0;
+  int uv_offset = 0;
+  int normal_offset = 0;
+  std::string material_name;
+  std::string group_name;
+  bool shaded_smooth = false;
+};
+
+/** Result of the counting pass over one chunk. */
+struct ChunkSummary {
+  int64_t vertex_count = 0;
+  int64_t uv_count = 0;
+  int64_t normal_count = 0;
+  /** The state changes that are still in effect at the end of the chunk. */
+  std::optional<std::string> material_name;
+  std::optional<std::string> group_name;
+  std::optional<bool> shaded_smooth;
+};
+
+struct ChunkPart {
+  /** The part begins with an `o` line, otherwise it continues the object of the previous one. */
+  bool starts_object = false;
+  std::string object_name;
+  GeometryPart part;
+};
+
+struct ChunkResult {
+  Vector<ChunkPart> parts;
+  Vector<std::string> mtl_libraries;
+};
+
+/** Total number of vertex elements in the file, for index validation. */
+struct VertexTotals {
+  int vertices = 0;
+  int uv_vertices = 0;
+  int normals = 0;
+};
+
+static bool is_whitespace(const char c)
+{
+  return c > 0 && c <= ' ';
+}
+
+/**
+ * If `line` starts with `keyword` followed by white-space (or nothing), drop the keyword from
+ * the line and return true.
+ */
+static bool parse_keyword(StringRef &line, StringRef keyword)
+{
+  const int64_t keyword_len = keyword.size();
+  if (line.size() < keyword_len || !line.startswith(keyword)) {
+    return false;
+  }
+  if (line.size() > keyword_len && !is_whitespace(line[keyword_len])) {
+    return false;
+  }
+  line = line.drop_prefix(keyword_len);
+  return true;
+}
+
+/** Rest of the line with surrounding white-space removed. */
+static StringRef parse_name(StringRef line)
+{
+  line = drop_whitespace(line);
+  const char *end = line.end();
+  while (end > line.begin() && is_whitespace(end[-1])) {
+    --end;
+  }
+  return StringRef(line.begin(), end);
+}
+
+static bool parse_smooth_shading(StringRef line)
+{
+  const StringRef value = parse_name(line);
+  /* Some files use "s 0" instead of "s off"; any other value is a smoothing group. */
+  return !(value.is_empty() || value == "off" || value == "0");
+}
+
+/**
+ * Byte offset just past the end of the line that contains `pos`, skipping over
+ * backslash-newline line continuations.
+ */
+static int64_t find_line_end(StringRef buffer, int64_t pos)
+{
+  const char *begin = buffer.begin();
+  const char *end = buffer.end();
+  const char *ptr = begin + pos;
+  while (ptr < end) {
+    const char *newline = static_cast<const char *>(memchr(ptr, '\n', end - ptr));
+    if (newline == nullptr) {
+      return buffer.size();
+    }
+    const bool is_continuation = (newline > begin && newline[-1] == '\\') ||
+                                 (newline - 1 > begin && newline[-1] == '\r' &&
+                                  newline[-2] == '\\');
+    if (!is_continuation) {
+      return newline + 1 - begin;
+    }
+    ptr = newline + 1;
+  }
+  return buffer.size();
+}
+
+/**
+ * Split the file into chunks of roughly `chunk_size` bytes that start and end at line
+ * boundaries.
+ */
+static Vector<StringRef> split_into_chunks(StringRef buffer, const int64_t chunk_size)
+{
+  Vector<StringRef> chunks;
+  int64_t start = 0;
+  while (start < buffer.size()) {
+    int64_t end = buffer.size();
+    if (buffer.size() - start > chunk_size) {
+      end = find_line_end(buffer, start + chunk_size - 1);
+    }
+    chunks.append(buffer.substr(start, end - start));
+    start = end;
+  }
+  return chunks;
+}
+
+/**
+ * Get the next line of the chunk with leading white-space removed. Line continuations are
+ * resolved into `r_storage` when needed.
+ */
+static StringRef next_line(StringRef &chunk, std::string &r_storage)
+{
+  StringRef line = read_next_line(chunk);
+  if (line_has_continuation(line)) {
+    line = fixup_line_continuations(line, r_storage);
+  }
+  return drop_whitespace(line);
+}
+
+/**
+ * First pass: count the vertex elements of the chunk and find the grouping state at its end.
+ */
+static ChunkSummary summarize_chunk(StringRef chunk)
+{
+  ChunkSummary summary;
+  std::string line_storage;
+  while (!chunk.is_empty()) {
+    StringRef line = next_line(chunk, line_storage);
+    if (line.is_empty()) {
+      continue;
+    }
+    switch (line[0]) {
+      case 'v':
+        if (line.size() == 1 || is_whitespace(line[1])) {
+          summary.vertex_count++;
+        }
+        else if (parse_keyword(line, "vt")) {
+          summary.uv_count++;
+        }
+        else if (parse_keyword(line, "vn")) {
+          summary.normal_count++;
+        }
+        break;
+      case 'u':
+        if (parse_keyword(line, "usemtl")) {
+          summary.material_name = parse_name(line);
+        }
+        break;
+      case 's':
+        if (parse_keyword(line, "s")) {
+          summary.shaded_smooth = parse_smooth_shading(line);
+        }
+        break;
+      case 'g':
+        if (parse_keyword(line, "g")) {
+          summary.group_name = parse_name(line);
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  return summary;
+}
+
+/**
+ * Convert a one-based, possibly relative (negative) OBJ index into a zero-based index.
+ * \return -1 for invalid indices.
+ */
+static int resolve_index(const int index, const int count_so_far, const int total)
+{
+  if (index > 0) {
+    return index <= total ? index - 1 : -1;
+  }
+  if (index < 0) {
+    return count_so_far + index >= 0 ? count_so_far + index : -1;
+  }
+  return -1;
+}
+
+static bool has_duplicate_vertices(Span<PolyCorner> corners)
+{
+  if (corners.size() <= 16) {
+    for (const int i : corners.index_range()) {
+      for (const int j : IndexRange(i + 1, corners.size() - i - 1)) {
+        if (corners[i].vert_index == corners[j].vert_index) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+  Vector<int> sorted_verts;
+  sorted_verts.reserve(corners.size());
+  for (const PolyCorner &corner : corners) {
+    sorted_verts.append(corner.vert_index);
+  }
+  std::sort(sorted_verts.begin(), sorted_verts.end());
+  return std::adjacent_find(sorted_verts.begin(), sorted_verts.end()) != sorted_verts.end();
+}
+
+static void geom_add_polygon(GeometryPart &part,
+                             StringRef line,
+                             const ParserState &state,
+                             const VertexTotals &totals,
+                             const int material_index,
+                             const int group_index)
+{
+  PolyElem face;
+  face.material_index = material_index;
+  face.vertex_group_index = group_index;
+  face.shaded_smooth = state.shaded_smooth;
+  face.start_index = part.face_corners_.size();
+
+  bool face_valid = true;
+  bool face_has_uv = false;
+  bool face_has_normal = false;
+  line = drop_whitespace(line);
+  while (!line.is_empty()) {
+    int vert = 0;
+    int uv = 0;
+    int normal = 0;
+    line = parse_int(line, 0, vert, false);
+    if (!line.is_empty() && line[0] == '/') {
+      line = line.drop_prefix(1);
+      if (!line.is_empty() && line[0] != '/') {
+        line = parse_int(line, 0, uv, false);
+      }
+      if (!line.is_empty() && line[0] == '/') {
+        line = parse_int(line.drop_prefix(1), 0, normal, false);
+      }
+    }
+    if (!line.is_empty() && !is_whitespace(line[0])) {
+      /* Garbage in the corner definition, e.g. "f 1/2/3x". */
+      face_valid = false;
+      break;
+    }
+    line = drop_whitespace(line);
+
+    PolyCorner corner;
+    corner.vert_index = resolve_index(vert, state.vertex_offset, totals.vertices);
+    if (corner.vert_index < 0) {
+      face_valid = false;
+      break;
+    }
+    if (uv != 0) {
+      corner.uv_vert_index = resolve_index(uv, state.uv_offset, totals.uv_vertices);
+      face_has_uv |= corner.uv_vert_index >= 0;
+    }
+    if (normal != 0) {
+      corner.vertex_normal_index = resolve_index(normal, state.normal_offset, totals.normals);
+      face_has_normal |= corner.vertex_normal_index >= 0;
+    }
+    part.face_corners_.append(corner);
+  }
+
+  face.corner_count = int(part.face_corners_.size() - face.start_index);
+  const Span<PolyCorner> corners = part.face_corners_.as_span().drop_front(face.start_index);
+  if (face_valid && (face.corner_count < 3 || has_duplicate_vertices(corners))) {
+    face_valid = false;
+  }
+  if (!face_valid) {
+    part.face_corners_.resize(face.start_index);
+    part.has_invalid_polys_ = true;
+    return;
+  }
+  for (const PolyCorner &corner : corners) {
+    part.track_vertex_index(corner.vert_index);
+  }
+  part.has_uv_ |= face_has_uv;
+  part.has_vertex_normals_ |= face_has_normal;
+  part.face_elements_.append(face);
+}
+
+static void geom_add_edges(GeometryPart &part,
+                           StringRef line,
+                           const ParserState &state,
+                           const VertexTotals &totals)
+{
+  int prev_vert = -1;
+  line = drop_whitespace(line);
+  while (!line.is_empty()) {
+    int index = 0;
+    line = parse_int(line, 0, index, false);
+    /* Skip the optional texture vertex index ("l 1/1 2/2"). */
+    line = drop_whitespace(drop_non_whitespace(line));
+    const int vert = resolve_index(index, state.vertex_offset, totals.vertices);
+    if (vert < 0) {
+      part.has_invalid_polys_ = true;
+      prev_vert = -1;
+      continue;
+    }
+    if (prev_vert >= 0 && prev_vert != vert) {
+      part.edges_.append({prev_vert, vert});
+      part.track_vertex_index(prev_vert);
+      part.track_vertex_index(vert);
+    }
+    prev_vert = vert;
+  }
+}
+
+/**
+ * Second pass: parse all elements of the chunk, starting from the given state.
+ * Vertex data is written directly into the global arrays at the offsets from the state.
+ */
+static void parse_chunk(StringRef chunk,
+                        ParserState state,
+                        const VertexTotals &totals,
+                        const OBJImportParams &import_params,
+                        GlobalVertices &r_global_vertices,
+                        ChunkResult &r_result)
+{
+  GeometryPart *part = nullptr;
+  int material_index = -1;
+  int group_index = -1;
+
+  auto start_part = [&](const bool starts_object, StringRef object_name) {
+    r_result.parts.append_as();
+    ChunkPart &chunk_part = r_result.parts.last();
+    chunk_part.starts_object = starts_object;
+    chunk_part.object_name = object_name;
+    part = &chunk_part.part;
+    /* The grouping state is inherited, but names are local to each part. */
+    material_index = -1;
+    group_index = -1;
+  };
+  /* Names are only added to the part once a face uses them, so that the result does not depend
+   * on where the file is split into chunks. */
+  auto resolve_state_names = [&]() {
+    if (material_index < 0 && !state.material_name.empty()) {
+      material_index = part->material_names_.index_of_or_add(state.material_name);
+    }
+    if (group_index < 0 && !state.group_name.empty()) {
+      group_index = part->group_names_.index_of_or_add(state.group_name);
+    }
+  };
+  start_part(false, "");
+
+  std::string line_storage;
+  while (!chunk.is_empty()) {
+    StringRef line = next_line(chunk, line_storage);
+    if (line.is_empty()) {
+      continue;
+    }
+    switch (line[0]) {
+      case 'v':
+        if (line.size() == 1 || is_whitespace(line[1])) {
+          float3 &co = r_global_vertices.vertices[state.vertex_offset];
+          parse_floats(line.drop_prefix(1), 0.0f, co, 3);
+          part->declared_vertex_min_ = std::min(part->declared_vertex_min_, state.vertex_offset);
+          part->declared_vertex_max_ = std::max(part->declared_vertex_max_, state.vertex_offset);
+          state.vertex_offset++;
+        }
+        else if (parse_keyword(line, "vt")) {
+          float2 &uv = r_global_vertices.uv_vertices[state.uv_offset];
+          parse_floats(line, 0.0f, uv, 2);
+          state.uv_offset++;
+        }
+        else if (parse_keyword(line, "vn")) {
+          float3 &normal = r_global_vertices.vertex_normals[state.normal_offset];
+          parse_floats(line, 0.0f, normal, 3);
+          state.normal_offset++;
+        }
+        break;
+      case 'f':
+        if (parse_keyword(line, "f")) {
+          resolve_state_names();
+          geom_add_polygon(*part, line, state, totals, material_index, group_index);
+        }
+        break;
+      case 'l':
+        if (parse_keyword(line, "l")) {
+          geom_add_edges(*part, line, state, totals);
+        }
+        break;
+      case 'o':
+        if (parse_keyword(line, "o")) {
+          start_part(true, parse_name(line));
+        }
+        break;
+      case 'g':
+        if (parse_keyword(line, "g")) {
+          state.group_name = parse_name(line);
+          group_index = -1;
+        }
+        break;
+      case 's':
+        if (parse_keyword(line, "s")) {
+          state.shaded_smooth = parse_smooth_shading(line);
+        }
+        break;
+      case 'u':
+        if (parse_keyword(line, "usemtl")) {
+          state.material_name = parse_name(line);
+          material_index = -1;
+        }
+        break;
+      case 'm':
+        if (parse_keyword(line, "mtllib")) {
+          /* Several libraries may be given on one line, but file names with spaces are more
+           * common in the wild than that, so the whole line is used as one file name. */
+          r_result.mtl_libraries.append(parse_name(line));
+        }
+        break;
+      default:
+        /* Comments, free-form geometry and other unsupported elements. */
+        break;
+    }
+  }
+  if (!import_params.import_vertex_groups) {
+    for (ChunkPart &chunk_part : r_result.parts) {
+      chunk_part.part.group_names_.clear();
+      for (PolyElem &face : chunk_part.part.face_elements_) {
+        face.vertex_group_index = -1;
+      }
+    }
+  }
+}
+
+OBJParser::OBJParser(const OBJImportParams &import_params, const int64_t chunk_size)
+    : import_params_(import_params), chunk_size_(std::max<int64_t>(chunk_size, 1))
+{
+  const int file = BLI_open(import_params_.filepath, O_BINARY | O_RDONLY, 0);
+  if (file == -1) {
+    fprintf(stderr, "Cannot read from OBJ file:'%s'.\n", import_params_.filepath);
+    return;
+  }
+  if (BLI_file_descriptor_size(file) == 0) {
+    /* Mapping an empty file fails; treat it as a valid file without any content. */
+    close(file);
+    buffer_ = "";
+    return;
+  }
+  mmap_file_ = BLI_mmap_open(file);
+  /* The mapping stays valid after the file is closed. */
+  close(file);
+  if (mmap_file_ == nullptr) {
+    fprintf(stderr, "Cannot map OBJ file:'%s'.\n", import_params_.filepath);
+    return;
+  }
+  buffer_ = StringRef(static_cast<const char *>(BLI_mmap_get_pointer(mmap_file_)),
+                      int64_t(BLI_mmap_get_length(mmap_file_)));
+}
+
+OBJParser::~OBJParser()
+{
+  if (mmap_file_) {
+    BLI_mmap_free(mmap_file_);
+  }
+}
+
+bool OBJParser::is_open() const
+{
+  return mmap_file_ != nullptr || buffer_.data() != nullptr;
+}
+
+static std::string default_object_name(const char *filepath)
+{
+  std::string name = BLI_path_basename(filepath);
+  const size_t extension_start = name.find_last_of('.');
+  if (extension_start != std::string::npos && extension_start > 0) {
+    name.resize(extension_start);
+  }
+  return name;
+}
+
+void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
+                      GlobalVertices &r_global_vertices)
+{
+  if (!is_open()) {
+    return;
+  }
+  const Vector<StringRef> chunks = split_into_chunks(buffer_, chunk_size_);
+
+  /* First pass: count vertex elements and collect the state at the end of every chunk. */
+  Array<ChunkSummary> summaries(chunks.size());
+  threading::parallel_for(chunks.index_range(), 1, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      summaries[i] = summarize_chunk(chunks[i]);
+    }
+  });
+
+  Array<ParserState> start_states(chunks.size());
+  ParserState state;
+  int64_t total_vertices = 0;
+  int64_t total_uv_vertices = 0;
+  int64_t total_normals = 0;
+  for (const int64_t i : chunks.index_range()) {
+    start_states[i] = state;
+    const ChunkSummary &summary = summaries[i];
+    total_vertices += summary.vertex_count;
+    total_uv_vertices += summary.uv_count;
+    total_normals += summary.normal_count;
+    if (std::max({total_vertices, total_uv_vertices, total_normals}) > INT_MAX) {
+      fprintf(stderr, "OBJ file '%s' has too many vertices.\n", import_params_.filepath);
+      return;
+    }
+    state.vertex_offset = int(total_vertices);
+    state.uv_offset = int(total_uv_vertices);
+    state.normal_offset = int(total_normals);
+    if (summary.material_name) {
+      state.material_name = *summary.material_name;
+    }
+    if (summary.group_name) {
+      state.group_name = *summary.group_name;
+    }
+    if (summary.shaded_smooth) {
+      state.shaded_smooth = *summary.shaded_smooth;
+    }
+  }
+  const VertexTotals totals{int(total_vertices), int(total_uv_vertices), int(total_normals)};
+  r_global_vertices.vertices.resize(totals.vertices);
+  r_global_vertices.uv_vertices.resize(totals.uv_vertices);
+  r_global_vertices.vertex_normals.resize(totals.normals);
+
+  /* Second pass: parse everything, with every chunk knowing its starting offsets & state. */
+  Array<ChunkResult> results(chunks.size());
+  threading::parallel_for(chunks.index_range(), 1, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      parse_chunk(
+          chunks[i], start_states[i], totals, import_params_, r_global_vertices, results[i]);
+    }
+  });
+  if (mmap_file_ && BLI_mmap_any_io_error(mmap_file_)) {
+    fprintf(stderr, "Error reading OBJ file:'%s'.\n", import_params_.filepath);
+  }
+
+  /* Stitch the parts into objects. */
+  Geometry *geometry = nullptr;
+  bool geometry_has_topology = false;
+  for (ChunkResult &result : results) {
+    mtl_libraries_.extend(result.mtl_libraries);
+    for (ChunkPart &chunk_part : result.parts) {
+      const GeometryPart &part = chunk_part.part;
+      const bool part_has_topology = !part.face_elements_.is_empty() || !part.edges_.is_empty();
+      if (geometry == nullptr || (chunk_part.starts_object && geometry_has_topology)) {
+        r_all_geometries.append(std::make_unique<Geometry>());
+        geometry = r_all_geometries.last().get();
+        geometry->geometry_name_ = default_object_name(import_params_.filepath);
+        geometry_has_topology = false;
+      }
+      if (chunk_part.starts_object) {
+        /* Vertices declared before the first element of an object belong to it. So an object
+         * without faces or edges so far is taken over by the new one, only renamed. */
+        geometry->geometry_name_ = chunk_part.object_name;
+      }
+      if (part_has_topology || part.declared_vertex_max_ >= 0) {
+        geometry->parts_.append(std::move(chunk_part.part));
+      }
+      else {
+        /* A part with only invalid faces is dropped, but the object still has invalid faces. */
+        geometry->has_invalid_polys_ |= part.has_invalid_polys_;
+      }
+      geometry_has_topology |= part_has_topology;
+    }
+  }
+  /* The last object of the file may not have any content. */
+  if (geometry && geometry->parts_.is_empty()) {
+    r_all_geometries.remove_last();
+  }
+
+  threading::parallel_for(r_all_geometries.index_range(), 1, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      r_all_geometries[i]->finalize();
+    }
+  });
+}
+
+Span<std::string> OBJParser::mtl_libraries() const
+{
+  return mtl_libraries_;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name MTL Parsing
+ * \{ */
+
+/**
+ * Parse the texture map options and file-path of a `map_*` line into `r_tex_map`.
+ */
+static void parse_texture_map(StringRef line,
+                              const StringRef map_type,
+                              MTLMaterial &r_mtl_material,
+                              tex_map_XX &r_tex_map)
+{
+  line = drop_whitespace(line);
+  while (!line.is_empty() && line[0] == '-') {
+    if (parse_keyword(line, "-o")) {
+      line = parse_floats(line, 0.0f, r_tex_map.translation, 3);
+    }
+    else if (parse_keyword(line, "-s")) {
+      line = parse_floats(line, 1.0f, r_tex_map.scale, 3);
+    }
+    else if (parse_keyword(line, "-bm")) {
+      line = parse_float(line, 1.0f, r_mtl_material.map_Bump_strength);
+    }
+    else if (parse_keyword(line, "-type")) {
+      line = drop_whitespace(line);
+      if (line.startswith("sphere")) {
+        r_tex_map.projection_type = SHD_PROJ_SPHERE;
+      }
+      line = drop_non_whitespace(line);
+    }
+    else {
+      /* Unsupported option: skip it and its (single) value. */
+      std::cerr << "OBJ import: unsupported texture map option in " << map_type << std::endl;
+      line = drop_non_whitespace(line);
+      line = drop_whitespace(line);
+      line = drop_non_whitespace(line);
+    }
+    line = drop_whitespace(line);
+  }
+  /* The remaining text is the file path, which may contain spaces. */
+  r_tex_map.image_path = parse_name(line);
+}
+
+MTLParser::MTLParser(StringRefNull mtl_library, StringRefNull obj_filepath)
+{
+  char obj_file_dir[FILE_MAXDIR];
+  BLI_split_dir_part(obj_filepath.data(), obj_file_dir, FILE_MAXDIR);
+  BLI_path_join(mtl_file_path_, FILE_MAX, obj_file_dir, mtl_library.data(), nullptr);
+  BLI_split_dir_part(mtl_file_path_, mtl_dir_path_, FILE_MAXDIR);
+}
+
+void MTLParser::parse_and_store(Map<std::string, std::unique_ptr<MTLMaterial>> &r_mtl_materials)
+{
+  size_t buffer_len;
+  void *buffer = BLI_file_read_text_as_mem(mtl_file_path_, 0, &buffer_len);
+  if (buffer == nullptr) {
+    fprintf(stderr, "OBJ import: cannot read from MTL file: '%s'\n", mtl_file_path_);
+    return;
+  }
+
+  static const std::pair<StringRef, eMTLSyntaxElement> texture_keywords[] = {
+      {"map_Kd", eMTLSyntaxElement::map_Kd},
+      {"map_Ks", eMTLSyntaxElement::map_Ks},
+      {"map_Ns", eMTLSyntaxElement::map_Ns},
+      {"map_d", eMTLSyntaxElement::map_d},
+      {"map_refl", eMTLSyntaxElement::map_refl},
+      {"refl", eMTLSyntaxElement::map_refl},
+      {"map_Ke", eMTLSyntaxElement::map_Ke},
+      {"map_Bump", eMTLSyntaxElement::map_Bump},
+      {"map_bump", eMTLSyntaxElement::map_Bump},
+      {"bump", eMTLSyntaxElement::map_Bump},
+  };
+
+  MTLMaterial *material = nullptr;
+  StringRef buffer_str{static_cast<const char *>(buffer), int64_t(buffer_len)};
+  std::string line_storage;
+  while (!buffer_str.is_empty()) {
+    StringRef line = next_line(buffer_str, line_storage);
+    if (line.is_empty() || line[0] == '#') {
+      continue;
+    }
+    if (parse_keyword(line, "newmtl")) {
+      const std::string name = parse_name(line);
+      if (r_mtl_materials.contains(name)) {
+        /* The first definition wins, like in the legacy Python importer. */
+        material = nullptr;
+        continue;
+      }
+      material = r_mtl_materials.lookup_or_add(name, std::make_unique<MTLMaterial>()).get();
+      material->name = name;
+      continue;
+    }
+    if (material == nullptr) {
+      continue;
+    }
+
+    if (parse_keyword(line, "Ns")) {
+      parse_float(line, 324.0f, material->Ns);
+    }
+    else if (parse_keyword(line, "Ka")) {
+      parse_floats(line, 0.0f, material->Ka, 3);
+    }
+    else if (parse_keyword(line, "Kd")) {
+      parse_floats(line, 0.8f, material->Kd, 3);
+    }
+    else if (parse_keyword(line, "Ks")) {
+      parse_floats(line, 0.5f, material->Ks, 3);
+    }
+    else if (parse_keyword(line, "Ke")) {
+      parse_floats(line, 0.0f, material->Ke, 3);
+    }
+    else if (parse_keyword(line, "Ni")) {
+      parse_float(line, 1.45f, material->Ni);
+    }
+    else if (parse_keyword(line, "d")) {
+      parse_float(line, 1.0f, material->d);
+    }
+    else if (parse_keyword(line, "Tr")) {
+      float transparency;
+      parse_float(line, 0.0f, transparency);
+      material->d = 1.0f - transparency;
+    }
+    else if (parse_keyword(line, "illum")) {
+      /* Some files use a float value here. */
+      float illum;
+      parse_float(line, 1.0f, illum);
+      material->illum = int(illum);
+    }
+    else {
+      for (const auto &[keyword, key] : texture_keywords) {
+        if (parse_keyword(line, keyword)) {
+          tex_map_XX &tex_map = material->tex_map_of_type(key);
+          tex_map.mtl_dir_path = mtl_dir_path_;
+          parse_texture_map(line, keyword, *material, tex_map);
+          break;
+        }
+      }
+    }
+  }
+
+  MEM_freeN(buffer);
+}
+
+/** \} */
+
+}  // namespace blender::io::obj
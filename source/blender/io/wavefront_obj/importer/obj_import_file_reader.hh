@@ -0,0 +1,88 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup obj
+ */
+
+#pragma once
+
+#include "BLI_map.hh"
+#include "BLI_string_ref.hh"
+#include "BLI_utility_mixins.hh"
+#include "BLI_vector.hh"
+
+#include "IO_wavefront_obj.h"
+#include "obj_export_mtl.hh"
+#include "obj_import_objects.hh"
+
+struct BLI_mmap_file;
+
+namespace blender::io::obj {
+
+/**
+ * Reads an OBJ file into #Geometry objects and #GlobalVertices.
+ *
+ * The file is memory-mapped and split into line-aligned chunks which are parsed in parallel.
+ * A cheap first pass over every chunk counts the vertex elements and records the grouping state
+ * (`usemtl`, `s`, `g`) that is active at its end, so that the second, full pass can start every
+ * chunk with the right global vertex offsets and state, writing vertex data directly into the
+ * final arrays. Objects that span several chunks are stitched together afterwards, which only
+ * moves the per-chunk #GeometryPart containers.
+ *
+ * Only polygonal geometry is read: `v`, `vt`, `vn`, `f`, `l`, `o`, `g`, `s`, `usemtl` and
+ * `mtllib`. Free-form geometry (`cstype`, `curv`, ...) is skipped.
+ */
+class OBJParser : NonCopyable, NonMovable {
+ private:
+  const OBJImportParams &import_params_;
+  BLI_mmap_file *mmap_file_ = nullptr;
+  StringRef buffer_;
+  /** Target size of the chunks that are parsed in parallel. */
+  int64_t chunk_size_;
+  Vector<std::string> mtl_libraries_;
+
+ public:
+  static constexpr int64_t default_chunk_size = 1024 * 1024;
+
+  /**
+   * Open and map the OBJ file given in the import parameters.
+   * Check #is_open afterwards; failure is reported on the console.
+   */
+  OBJParser(const OBJImportParams &import_params, int64_t chunk_size = default_chunk_size);
+  ~OBJParser();
+
+  bool is_open() const;
+
+  /**
+   * Parse the whole file and fill in the geometries & global vertex data. Objects without any
+   * geometry are dropped.
+   */
+  void parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
+             GlobalVertices &r_global_vertices);
+  /**
+   * Return a list of all material library filepaths referenced by the OBJ file.
+   */
+  Span<std::string> mtl_libraries() const;
+};
+
+class MTLParser : NonCopyable, NonMovable {
+ private:
+  char mtl_file_path_[FILE_MAX];
+  /**
+   * Directory in which the MTL file is found.
+   */
+  char mtl_dir_path_[FILE_MAX];
+
+ public:
+  /**
+   * Make a file path for the MTL library relative to the OBJ file's directory.
+   */
+  MTLParser(StringRefNull mtl_library_, StringRefNull obj_filepath);
+
+  /**
+   * Read MTL file(s) and add MTLMaterial instances to the given Map reference.
+   */
+  void parse_and_store(Map<std::string, std::unique_ptr<MTLMaterial>> &r_mtl_materials);
+};
+
+}  // namespace blender::io::obj
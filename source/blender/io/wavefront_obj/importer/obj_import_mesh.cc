@@ -0,0 +1,284 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup obj
+ */
+
+#include "DNA_material_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_customdata.h"
+#include "BKE_deform.h"
+#include "BKE_material.h"
+#include "BKE_mesh.h"
+#include "BKE_node_tree_update.h"
+#include "BKE_object.h"
+#include "BKE_object_deform.h"
+
+#include "BLI_array.hh"
+#include "BLI_math_vector.h"
+#include "BLI_task.hh"
+
+#include "MEM_guardedalloc.h"
+
+#include "IO_wavefront_obj.h"
+#include "obj_import_mesh.hh"
+#include "obj_import_mtl.hh"
+
+namespace blender::io::obj {
+
+template<typename Fn> void MeshFromGeometry::foreach_face_parallel(const Fn &fn) const
+{
+  const Span<GeometryPart> parts = mesh_geometry_.parts_;
+  threading::parallel_for(parts.index_range(), 1, [&](const IndexRange part_range) {
+    for (const int part_index : part_range) {
+      const GeometryPart &part = parts[part_index];
+      const int face_offset = mesh_geometry_.part_face_offsets_[part_index];
+      threading::parallel_for(
+          part.face_elements_.index_range(), 4096, [&](const IndexRange face_range) {
+            for (const int face : face_range) {
+              fn(part_index, face, face_offset + face);
+            }
+          });
+    }
+  });
+}
+
+Mesh *MeshFromGeometry::create_mesh(const OBJImportParams &import_params) const
+{
+  const int64_t tot_verts_object{mesh_geometry_.get_vertex_count()};
+  if (tot_verts_object <= 0) {
+    /* Empty mesh */
+    return nullptr;
+  }
+
+  Mesh *mesh = BKE_mesh_new_nomain(tot_verts_object,
+                                   mesh_geometry_.total_edges_,
+                                   0,
+                                   mesh_geometry_.total_corners_,
+                                   mesh_geometry_.total_faces_);
+  create_vertices(mesh);
+  create_polys_loops(mesh);
+  create_edges(mesh);
+  create_uv_verts(mesh);
+  create_normals(mesh);
+
+  if (import_params.validate_meshes) {
+    BKE_mesh_validate(mesh, false, true);
+  }
+  return mesh;
+}
+
+Object *MeshFromGeometry::create_object(
+    Main *bmain,
+    Mesh *mesh,
+    Map<std::string, std::unique_ptr<MTLMaterial>> &materials,
+    Map<std::string, Material *> &created_materials,
+    const OBJImportParams & /*import_params*/) const
+{
+  std::string ob_name{mesh_geometry_.geometry_name_};
+  if (ob_name.empty()) {
+    ob_name = "Untitled";
+  }
+  Object *obj = BKE_object_add_only_object(bmain, OB_MESH, ob_name.c_str());
+  Mesh *mesh_in_bmain{
+      static_cast<Mesh *>(BKE_object_obdata_add_from_type(bmain, OB_MESH, ob_name.c_str()))};
+  /* `mesh->flag` is not copied by #BKE_mesh_nomain_to_mesh. */
+  const short autosmooth = (mesh->flag & ME_AUTOSMOOTH);
+  BKE_mesh_nomain_to_mesh(mesh, mesh_in_bmain, obj, &CD_MASK_EVERYTHING, true);
+  mesh_in_bmain->flag |= autosmooth;
+  obj->data = mesh_in_bmain;
+
+  /* Vertex group names are stored in the mesh in the order of the group indices used by the
+   * deform-vert layer. */
+  for (const std::string &name : mesh_geometry_.group_names_) {
+    BKE_object_defgroup_add_name(obj, name.c_str());
+  }
+  create_materials(bmain, materials, created_materials, obj);
+  return obj;
+}
+
+void MeshFromGeometry::create_vertices(Mesh *mesh) const
+{
+  const int vertex_offset = mesh_geometry_.vertex_index_min_;
+  const Span<float3> vertices = global_vertices_.vertices.as_span().slice(vertex_offset,
+                                                                         mesh->totvert);
+  MutableSpan<MVert> mverts{mesh->mvert, mesh->totvert};
+  threading::parallel_for(mverts.index_range(), 8192, [&](const IndexRange range) {
+    for (const int i : range) {
+      copy_v3_v3(mverts[i].co, vertices[i]);
+    }
+  });
+}
+
+void MeshFromGeometry::create_polys_loops(Mesh *mesh) const
+{
+  const int vertex_offset = mesh_geometry_.vertex_index_min_;
+  const bool use_vertex_groups = !mesh_geometry_.group_names_.is_empty();
+  MDeformVert *dverts = nullptr;
+  if (use_vertex_groups) {
+    dverts = static_cast<MDeformVert *>(
+        CustomData_add_layer(&mesh->vdata, CD_MDEFORMVERT, CD_CALLOC, nullptr, mesh->totvert));
+  }
+
+  const Span<GeometryPart> parts = mesh_geometry_.parts_;
+  foreach_face_parallel([&](const int part_index, const int face_index, const int mesh_face) {
+    const GeometryPart &part = parts[part_index];
+    const PolyElem &face = part.face_elements_[face_index];
+    const int loopstart = mesh_geometry_.part_corner_offsets_[part_index] +
+                          int(face.start_index);
+    MPoly &mpoly = mesh->mpoly[mesh_face];
+    mpoly.loopstart = loopstart;
+    mpoly.totloop = face.corner_count;
+    mpoly.flag = face.shaded_smooth ? ME_SMOOTH : 0;
+    mpoly.mat_nr = face.material_index < 0 ?
+                       0 :
+                       mesh_geometry_.part_material_maps_[part_index][face.material_index];
+
+    const Span<PolyCorner> corners = part.face_corners_.as_span().slice(face.start_index,
+                                                                        face.corner_count);
+    for (const int i : corners.index_range()) {
+      mesh->mloop[loopstart + i].v = corners[i].vert_index - vertex_offset;
+    }
+  });
+
+  if (dverts) {
+    /* Serial, since vertices are shared between faces. The last group that uses a vertex wins,
+     * like in the legacy Python importer. */
+    Array<int> vertex_group(mesh->totvert, -1);
+    for (const int part_index : parts.index_range()) {
+      const GeometryPart &part = parts[part_index];
+      for (const PolyElem &face : part.face_elements_) {
+        if (face.vertex_group_index < 0) {
+          continue;
+        }
+        const int group = mesh_geometry_.part_group_maps_[part_index][face.vertex_group_index];
+        for (const PolyCorner &corner :
+             part.face_corners_.as_span().slice(face.start_index, face.corner_count)) {
+          vertex_group[corner.vert_index - vertex_offset] = group;
+        }
+      }
+    }
+    threading::parallel_for(vertex_group.index_range(), 4096, [&](const IndexRange range) {
+      for (const int i : range) {
+        if (vertex_group[i] >= 0) {
+          BKE_defvert_add_index_notest(&dverts[i], vertex_group[i], 1.0f);
+        }
+      }
+    });
+  }
+}
+
+void MeshFromGeometry::create_edges(Mesh *mesh) const
+{
+  const int vertex_offset = mesh_geometry_.vertex_index_min_;
+  int edge_index = 0;
+  for (const GeometryPart &part : mesh_geometry_.parts_) {
+    for (const int2 &edge : part.edges_) {
+      MEdge &medge = mesh->medge[edge_index++];
+      medge.v1 = edge[0] - vertex_offset;
+      medge.v2 = edge[1] - vertex_offset;
+      medge.flag = ME_LOOSEEDGE;
+    }
+  }
+
+  /* Keep the existing, explicitly imported edges so they can be merged with the new ones created
+   * from polygons. */
+  BKE_mesh_calc_edges(mesh, true, false);
+  BKE_mesh_calc_edges_loose(mesh);
+}
+
+void MeshFromGeometry::create_uv_verts(Mesh *mesh) const
+{
+  if (!mesh_geometry_.has_uv_ || global_vertices_.uv_vertices.is_empty()) {
+    return;
+  }
+  MLoopUV *mluv_dst = static_cast<MLoopUV *>(CustomData_add_layer(
+      &mesh->ldata, CD_MLOOPUV, CD_DEFAULT, nullptr, mesh_geometry_.total_corners_));
+
+  const Span<GeometryPart> parts = mesh_geometry_.parts_;
+  const Span<float2> uv_vertices = global_vertices_.uv_vertices;
+  threading::parallel_for(parts.index_range(), 1, [&](const IndexRange part_range) {
+    for (const int part_index : part_range) {
+      const Span<PolyCorner> corners = parts[part_index].face_corners_;
+      MLoopUV *part_uvs = mluv_dst + mesh_geometry_.part_corner_offsets_[part_index];
+      threading::parallel_for(corners.index_range(), 8192, [&](const IndexRange range) {
+        for (const int i : range) {
+          const int uv_index = corners[i].uv_vert_index;
+          const float2 uv = uv_index >= 0 ? uv_vertices[uv_index] : float2(0.0f);
+          copy_v2_v2(part_uvs[i].uv, uv);
+        }
+      });
+    }
+  });
+}
+
+void MeshFromGeometry::create_normals(Mesh *mesh) const
+{
+  if (!mesh_geometry_.has_vertex_normals_ || global_vertices_.vertex_normals.is_empty()) {
+    return;
+  }
+
+  /* Zero vectors make #BKE_mesh_set_custom_normals use the automatically computed normal. */
+  float(*loop_normals)[3] = static_cast<float(*)[3]>(
+      MEM_malloc_arrayN(mesh_geometry_.total_corners_, sizeof(float[3]), __func__));
+  const Span<GeometryPart> parts = mesh_geometry_.parts_;
+  const Span<float3> normals = global_vertices_.vertex_normals;
+  threading::parallel_for(parts.index_range(), 1, [&](const IndexRange part_range) {
+    for (const int part_index : part_range) {
+      const Span<PolyCorner> corners = parts[part_index].face_corners_;
+      float(*part_normals)[3] = loop_normals + mesh_geometry_.part_corner_offsets_[part_index];
+      threading::parallel_for(corners.index_range(), 8192, [&](const IndexRange range) {
+        for (const int i : range) {
+          const int normal_index = corners[i].vertex_normal_index;
+          const float3 normal = normal_index >= 0 ? normals[normal_index] : float3(0.0f);
+          copy_v3_v3(part_normals[i], normal);
+        }
+      });
+    }
+  });
+  mesh->flag |= ME_AUTOSMOOTH;
+  BKE_mesh_set_custom_normals(mesh, loop_normals);
+  MEM_freeN(loop_normals);
+}
+
+/**
+ * Create a material from the MTL definition with the given name, or a default one when the
+ * name is not defined in any MTL library.
+ */
+static Material *get_or_create_material(Main *bmain,
+                                        const std::string &name,
+                                        Map<std::string, std::unique_ptr<MTLMaterial>> &materials,
+                                        Map<std::string, Material *> &created_materials)
+{
+  return created_materials.lookup_or_add_cb(name, [&]() {
+    Material *mat = BKE_material_add(bmain, name.c_str());
+    const std::unique_ptr<MTLMaterial> *mtl = materials.lookup_ptr(name);
+    if (mtl == nullptr) {
+      return mat;
+    }
+    ShaderNodetreeWrap mat_wrap{bmain, **mtl, mat};
+    mat->use_nodes = true;
+    mat->nodetree = mat_wrap.get_nodetree();
+    BKE_ntree_update_main_tree(bmain, mat->nodetree, nullptr);
+    return mat;
+  });
+}
+
+void MeshFromGeometry::create_materials(
+    Main *bmain,
+    Map<std::string, std::unique_ptr<MTLMaterial>> &materials,
+    Map<std::string, Material *> &created_materials,
+    Object *obj) const
+{
+  for (const std::string &name : mesh_geometry_.material_names_) {
+    Material *mat = get_or_create_material(bmain, name, materials, created_materials);
+    BKE_object_material_slot_add(bmain, obj);
+    BKE_object_material_assign(bmain, obj, mat, obj->actcol, BKE_MAT_ASSIGN_USERPREF);
+  }
+}
+
+}  // namespace blender::io::obj
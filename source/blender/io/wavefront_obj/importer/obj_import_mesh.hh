@@ -0,0 +1,73 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup obj
+ */
+
+#pragma once
+
+#include "BLI_map.hh"
+#include "BLI_utility_mixins.hh"
+
+#include "obj_export_mtl.hh"
+#include "obj_import_objects.hh"
+
+struct Main;
+struct Material;
+struct Mesh;
+struct Object;
+struct OBJImportParams;
+
+namespace blender::io::obj {
+
+/**
+ * Make a Blender Mesh Object from a Geometry of GEOM_MESH type.
+ *
+ * Building the mesh data does not touch #Main, so #create_mesh can run for several geometries in
+ * parallel; #create_object then adds the result to #Main and must be called from one thread.
+ */
+class MeshFromGeometry : NonMovable, NonCopyable {
+ private:
+  const Geometry &mesh_geometry_;
+  const GlobalVertices &global_vertices_;
+
+ public:
+  MeshFromGeometry(const Geometry &mesh_geometry, const GlobalVertices &global_vertices)
+      : mesh_geometry_(mesh_geometry), global_vertices_(global_vertices)
+  {
+  }
+
+  /**
+   * Create a mesh that is not in #Main from the geometry.
+   */
+  Mesh *create_mesh(const OBJImportParams &import_params) const;
+
+  /**
+   * Create an object in #Main that takes ownership of the given `mesh` (from #create_mesh),
+   * and assign the materials used by the geometry.
+   */
+  Object *create_object(Main *bmain,
+                        Mesh *mesh,
+                        Map<std::string, std::unique_ptr<MTLMaterial>> &materials,
+                        Map<std::string, Material *> &created_materials,
+                        const OBJImportParams &import_params) const;
+
+ private:
+  void create_vertices(Mesh *mesh) const;
+  /**
+   * Create polygons and loops, and a vertex deform layer when the faces use vertex groups.
+   */
+  void create_polys_loops(Mesh *mesh) const;
+  void create_edges(Mesh *mesh) const;
+  void create_uv_verts(Mesh *mesh) const;
+  void create_normals(Mesh *mesh) const;
+  void create_materials(Main *bmain,
+                        Map<std::string, std::unique_ptr<MTLMaterial>> &materials,
+                        Map<std::string, Material *> &created_materials,
+                        Object *obj) const;
+
+  /** Call `fn(part_index, face_index_in_part, mesh_face_index)` for all faces, in parallel. */
+  template<typename Fn> void foreach_face_parallel(const Fn &fn) const;
+};
+
+}  // namespace blender::io::obj
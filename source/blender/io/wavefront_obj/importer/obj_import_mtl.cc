@@ -0,0 +1,248 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup obj
+ */
+
+#include <iostream>
+
+#include "BKE_image.h"
+#include "BKE_node.h"
+
+#include "BLI_math_vector.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+
+#include "DNA_image_types.h"
+#include "DNA_material_types.h"
+#include "DNA_node_types.h"
+
+#include "IMB_colormanagement.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "NOD_shader.h"
+
+#include "obj_import_mtl.hh"
+
+namespace blender::io::obj {
+
+/** Horizontal & vertical distance between nodes of the created tree. */
+static const float node_size = 300.0f;
+
+/**
+ * Set the default value of the input socket with the given identifier.
+ */
+static void set_property_of_socket(const eNodeSocketDatatype property_type,
+                                   const char *identifier,
+                                   Span<float> value,
+                                   bNode *r_node)
+{
+  bNodeSocket *socket{nodeFindSocket(r_node, SOCK_IN, identifier)};
+  BLI_assert(socket && socket->type == property_type);
+  if (!socket) {
+    return;
+  }
+  switch (property_type) {
+    case SOCK_FLOAT: {
+      BLI_assert(value.size() == 1);
+      static_cast<bNodeSocketValueFloat *>(socket->default_value)->value = value[0];
+      break;
+    }
+    case SOCK_RGBA: {
+      /* Alpha will be added manually. It is not read from the MTL file either. */
+      BLI_assert(value.size() == 3);
+      copy_v3_v3(static_cast<bNodeSocketValueRGBA *>(socket->default_value)->value, value.data());
+      static_cast<bNodeSocketValueRGBA *>(socket->default_value)->value[3] = 1.0f;
+      break;
+    }
+    case SOCK_VECTOR: {
+      BLI_assert(value.size() == 3);
+      copy_v3_v3(static_cast<bNodeSocketValueVector *>(socket->default_value)->value,
+                 value.data());
+      break;
+    }
+    default: {
+      BLI_assert(0);
+      break;
+    }
+  }
+}
+
+/**
+ * Load the image of a texture map; relative paths are relative to the MTL file.
+ */
+static Image *load_texture_image(Main *bmain, const tex_map_XX &tex_map)
+{
+  char image_path[FILE_MAX];
+  BLI_path_join(image_path,
+                sizeof(image_path),
+                tex_map.mtl_dir_path.c_str(),
+                tex_map.image_path.c_str(),
+                nullptr);
+  Image *image = nullptr;
+  if (BLI_exists(image_path)) {
+    image = BKE_image_load_exists(bmain, image_path);
+  }
+  /* Absolute paths. */
+  if (image == nullptr && BLI_exists(tex_map.image_path.c_str())) {
+    image = BKE_image_load_exists(bmain, tex_map.image_path.c_str());
+  }
+  if (image == nullptr) {
+    std::cerr << "OBJ import: cannot load image file: '" << tex_map.image_path << "'"
+              << std::endl;
+  }
+  return image;
+}
+
+ShaderNodetreeWrap::ShaderNodetreeWrap(Main *bmain, const MTLMaterial &mtl_mat, Material *mat)
+    : mtl_mat_(mtl_mat)
+{
+  nodetree_ = ntreeAddTree(nullptr, "Shader Nodetree", ntreeType_Shader->idname);
+  shader_output_ = add_node(SH_NODE_OUTPUT_MATERIAL, 0);
+  bsdf_ = add_node(SH_NODE_BSDF_PRINCIPLED, 1);
+  link_sockets(bsdf_, "BSDF", shader_output_, "Surface");
+
+  set_bsdf_socket_values(mat);
+  add_image_textures(bmain, mat);
+  nodeSetActive(nodetree_, shader_output_);
+}
+
+ShaderNodetreeWrap::~ShaderNodetreeWrap()
+{
+  if (nodetree_) {
+    /* In case the node tree wasn't claimed by a material. */
+    ntreeFreeEmbeddedTree(nodetree_);
+    MEM_freeN(nodetree_);
+  }
+}
+
+bNodeTree *ShaderNodetreeWrap::get_nodetree()
+{
+  bNodeTree *nodetree = nodetree_;
+  nodetree_ = nullptr;
+  return nodetree;
+}
+
+bNode *ShaderNodetreeWrap::add_node(const int node_type, const int column)
+{
+  BLI_assert(column >= 0 && column < ARRAY_SIZE(column_node_count_));
+  bNode *node = nodeAddStaticNode(nullptr, nodetree_, node_type);
+  node->locx = -column * node_size;
+  node->locy = -column_node_count_[column] * node_size;
+  column_node_count_[column]++;
+  return node;
+}
+
+void ShaderNodetreeWrap::link_sockets(bNode *from_node,
+                                      const char *from_id,
+                                      bNode *to_node,
+                                      const char *to_id)
+{
+  bNodeSocket *from_sock{nodeFindSocket(from_node, SOCK_OUT, from_id)};
+  bNodeSocket *to_sock{nodeFindSocket(to_node, SOCK_IN, to_id)};
+  BLI_assert(from_sock && to_sock);
+  nodeAddLink(nodetree_, from_node, from_sock, to_node, to_sock);
+}
+
+void ShaderNodetreeWrap::set_bsdf_socket_values(Material *mat)
+{
+  /* Negative values mean the property was not given in the MTL file: keep the defaults of the
+   * Principled BSDF node then. */
+  if (mtl_mat_.Kd.x >= 0.0f) {
+    set_property_of_socket(SOCK_RGBA, "Base Color", {mtl_mat_.Kd, 3}, bsdf_);
+    copy_v3_v3(&mat->r, mtl_mat_.Kd);
+  }
+  if (mtl_mat_.Ns >= 0.0f) {
+    /* Inverse of the approximation used by the exporter. */
+    const float roughness = 1.0f - sqrtf(std::min(mtl_mat_.Ns, 1000.0f) / 1000.0f);
+    set_property_of_socket(SOCK_FLOAT, "Roughness", {roughness}, bsdf_);
+    mat->roughness = roughness;
+  }
+  if (mtl_mat_.Ks.x >= 0.0f) {
+    const float specular = std::clamp(
+        (mtl_mat_.Ks.x + mtl_mat_.Ks.y + mtl_mat_.Ks.z) / 3.0f, 0.0f, 1.0f);
+    set_property_of_socket(SOCK_FLOAT, "Specular", {specular}, bsdf_);
+    mat->spec = specular;
+  }
+  /* The exporter writes the metallic value as ambient color, with a reflection illumination
+   * model. For other models, `Ka` is a plain ambient color which has no equivalent. */
+  if (ELEM(mtl_mat_.illum, 3, 6) && mtl_mat_.Ka.x >= 0.0f) {
+    const float metallic = std::clamp(
+        (mtl_mat_.Ka.x + mtl_mat_.Ka.y + mtl_mat_.Ka.z) / 3.0f, 0.0f, 1.0f);
+    set_property_of_socket(SOCK_FLOAT, "Metallic", {metallic}, bsdf_);
+    mat->metallic = metallic;
+  }
+  if (mtl_mat_.Ke.x > 0.0f || mtl_mat_.Ke.y > 0.0f || mtl_mat_.Ke.z > 0.0f) {
+    set_property_of_socket(SOCK_RGBA, "Emission", {mtl_mat_.Ke, 3}, bsdf_);
+    set_property_of_socket(SOCK_FLOAT, "Emission Strength", {1.0f}, bsdf_);
+  }
+  if (mtl_mat_.Ni >= 0.0f) {
+    set_property_of_socket(SOCK_FLOAT, "IOR", {mtl_mat_.Ni}, bsdf_);
+  }
+  if (mtl_mat_.d >= 0.0f && mtl_mat_.d < 1.0f) {
+    set_property_of_socket(SOCK_FLOAT, "Alpha", {mtl_mat_.d}, bsdf_);
+    mat->a = mtl_mat_.d;
+    mat->blend_method = MA_BM_BLEND;
+  }
+}
+
+void ShaderNodetreeWrap::add_image_textures(Main *bmain, Material *mat)
+{
+  for (const Map<const eMTLSyntaxElement, tex_map_XX>::Item texture_map :
+       mtl_mat_.texture_maps.items()) {
+    if (texture_map.value.image_path.empty()) {
+      /* No Image texture node of this map type can be added to this material. */
+      continue;
+    }
+    Image *image = load_texture_image(bmain, texture_map.value);
+    if (image == nullptr) {
+      continue;
+    }
+
+    const bool is_bump = texture_map.key == eMTLSyntaxElement::map_Bump;
+    bNode *normal_map = nullptr;
+    if (is_bump) {
+      normal_map = add_node(SH_NODE_NORMAL_MAP, 2);
+      const float bump_strength = mtl_mat_.map_Bump_strength >= 0.0f ?
+                                      mtl_mat_.map_Bump_strength :
+                                      1.0f;
+      set_property_of_socket(SOCK_FLOAT, "Strength", {bump_strength}, normal_map);
+    }
+
+    bNode *image_texture = add_node(SH_NODE_TEX_IMAGE, 3);
+    image_texture->id = &image->id;
+    static_cast<NodeTexImage *>(image_texture->storage)->projection =
+        texture_map.value.projection_type;
+    if (!ELEM(texture_map.key, eMTLSyntaxElement::map_Kd, eMTLSyntaxElement::map_Ke)) {
+      /* Only base and emission color maps contain color, the others are data. */
+      STRNCPY(image->colorspace_settings.name,
+              IMB_colormanagement_role_colorspace_name_get(COLOR_ROLE_DATA));
+    }
+
+    const bool has_transform = !equals_v3v3(texture_map.value.translation, float3(0.0f)) ||
+                               !equals_v3v3(texture_map.value.scale, float3(1.0f));
+    if (has_transform) {
+      bNode *mapping = add_node(SH_NODE_MAPPING, 4);
+      bNode *texture_coordinate = add_node(SH_NODE_TEX_COORD, 5);
+      set_property_of_socket(SOCK_VECTOR, "Location", {texture_map.value.translation, 3}, mapping);
+      set_property_of_socket(SOCK_VECTOR, "Scale", {texture_map.value.scale, 3}, mapping);
+      link_sockets(texture_coordinate, "UV", mapping, "Vector");
+      link_sockets(mapping, "Vector", image_texture, "Vector");
+    }
+
+    if (normal_map) {
+      link_sockets(image_texture, "Color", normal_map, "Color");
+      link_sockets(normal_map, "Normal", bsdf_, "Normal");
+    }
+    else if (texture_map.key == eMTLSyntaxElement::map_d) {
+      link_sockets(image_texture, "Alpha", bsdf_, texture_map.value.dest_socket_id.c_str());
+      mat->blend_method = MA_BM_BLEND;
+    }
+    else {
+      link_sockets(image_texture, "Color", bsdf_, texture_map.value.dest_socket_id.c_str());
+    }
+  }
+}
+
+}  // namespace blender::io::obj
@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup obj
+ */
+
+#pragma once
+
+#include "BLI_utility_mixins.hh"
+
+#include "DNA_node_types.h"
+
+#include "obj_export_mtl.hh"
+
+struct Main;
+struct Material;
+
+namespace blender::io::obj {
+
+/**
+ * Creates a Principled-BSDF based node tree for a material from its MTL definition.
+ * The created tree is laid out the way `mtlmaterial_for_material` in the exporter reads it:
+ *
+ * Texture Coordinates -> Mapping -> Image Texture -> (Normal Map) -> Principled BSDF
+ * -> Material Output.
+ */
+class ShaderNodetreeWrap : NonCopyable, NonMovable {
+ private:
+  bNodeTree *nodetree_ = nullptr;
+  bNode *bsdf_ = nullptr;
+  bNode *shader_output_ = nullptr;
+  const MTLMaterial &mtl_mat_;
+  /** Number of nodes placed in each column of the layout, counted from the output node. */
+  int column_node_count_[6] = {0};
+
+ public:
+  ShaderNodetreeWrap(Main *bmain, const MTLMaterial &mtl_mat, Material *mat);
+  ~ShaderNodetreeWrap();
+
+  /**
+   * Release the node tree for the material to own it.
+   */
+  bNodeTree *get_nodetree();
+
+ private:
+  /**
+   * Add a node of the given type in the given layout column (0 is the output node column).
+   */
+  bNode *add_node(int node_type, int column);
+  void link_sockets(bNode *from_node, const char *from_id, bNode *to_node, const char *to_id);
+  void set_bsdf_socket_values(Material *mat);
+  /**
+   * Create image texture, mapping and normal map nodes for the texture maps of the material,
+   * linked to the Principled BSDF node.
+   */
+  void add_image_textures(Main *bmain, Material *mat);
+};
+
+}  // namespace blender::io::obj
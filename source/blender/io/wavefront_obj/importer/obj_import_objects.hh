@@ -0,0 +1,115 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup obj
+ */
+
+#pragma once
+
+#include "BLI_math_vec_types.hh"
+#include "BLI_utility_mixins.hh"
+#include "BLI_vector.hh"
+#include "BLI_vector_set.hh"
+
+#include <string>
+
+namespace blender::io::obj {
+
+/**
+ * All vertex positions, UV vertices and vertex normals of an OBJ file.
+ * OBJ indices refer to these file-wide arrays, not to per-object ones.
+ */
+struct GlobalVertices {
+  Vector<float3> vertices;
+  Vector<float2> uv_vertices;
+  Vector<float3> vertex_normals;
+};
+
+/**
+ * A face corner: zero-based indices into the #GlobalVertices arrays.
+ * UV and normal indices are -1 when the corner does not reference them.
+ */
+struct PolyCorner {
+  int vert_index;
+  int uv_vert_index = -1;
+  int vertex_normal_index = -1;
+};
+
+struct PolyElem {
+  /** Index into #GeometryPart::group_names_, or -1. */
+  int vertex_group_index = -1;
+  /** Index into #GeometryPart::material_names_, or -1. */
+  int material_index = -1;
+  bool shaded_smooth = false;
+  /** First corner of the face in #GeometryPart::face_corners_. */
+  int64_t start_index = 0;
+  int corner_count = 0;
+};
+
+/**
+ * Faces and edges of one object, parsed from a single line-aligned chunk of the file.
+ * Chunks are parsed in parallel, so all names referenced by the elements are local to the part;
+ * the owning #Geometry maps them to object-wide indices once all chunks are done.
+ */
+struct GeometryPart {
+  Vector<PolyElem> face_elements_;
+  Vector<PolyCorner> face_corners_;
+  /** Loose edges from `l` lines, as global vertex indices. */
+  Vector<int2> edges_;
+  VectorSet<std::string> material_names_;
+  VectorSet<std::string> group_names_;
+  /** Range of global vertices used by faces and edges of this part. */
+  int vertex_index_min_ = INT32_MAX;
+  int vertex_index_max_ = -1;
+  /** Range of global vertices declared (`v` lines) in this part. */
+  int declared_vertex_min_ = INT32_MAX;
+  int declared_vertex_max_ = -1;
+  bool has_uv_ = false;
+  bool has_vertex_normals_ = false;
+  /** Corners of some faces were out of range or too few; such faces were skipped. */
+  bool has_invalid_polys_ = false;
+
+  void track_vertex_index(const int index)
+  {
+    vertex_index_min_ = std::min(vertex_index_min_, index);
+    vertex_index_max_ = std::max(vertex_index_max_, index);
+  }
+};
+
+/**
+ * An object of the OBJ file (started by an `o` line, or implicitly at the top of the file).
+ * The data is kept in the per-chunk parts, in file order.
+ */
+struct Geometry : NonCopyable {
+  std::string geometry_name_;
+  Vector<GeometryPart> parts_;
+
+  /** Object-wide names, in order of first use. Filled by #finalize. */
+  VectorSet<std::string> material_names_;
+  VectorSet<std::string> group_names_;
+  /** For every part, maps its local material/group indices to the object-wide ones. */
+  Vector<Vector<int>> part_material_maps_;
+  Vector<Vector<int>> part_group_maps_;
+  /** For every part, the first face and corner in the object-wide arrays. */
+  Vector<int> part_face_offsets_;
+  Vector<int> part_corner_offsets_;
+
+  int vertex_index_min_ = INT32_MAX;
+  int vertex_index_max_ = -1;
+  int total_faces_ = 0;
+  int total_corners_ = 0;
+  int total_edges_ = 0;
+  bool has_uv_ = false;
+  bool has_vertex_normals_ = false;
+  bool has_invalid_polys_ = false;
+
+  /** Build the object-wide name tables and offsets from the parts. */
+  void finalize();
+
+  int get_vertex_count() const
+  {
+    return vertex_index_max_ < vertex_index_min_ ? 0 : vertex_index_max_ - vertex_index_min_ + 1;
+  }
+};
+
+}  // namespace blender::io::obj
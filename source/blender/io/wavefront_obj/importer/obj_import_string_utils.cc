@@ -0,0 +1,267 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup obj
+ */
+
+#include "obj_import_string_utils.hh"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace blender::io::obj {
+
+static bool is_continuation_at(const char *p, const char *end)
+{
+  /* Backslash followed by "\n" or "\r\n". */
+  if (*p != '\\') {
+    return false;
+  }
+  if (p + 1 < end && p[1] == '\n') {
+    return true;
+  }
+  return p + 2 < end && p[1] == '\r' && p[2] == '\n';
+}
+
+StringRef read_next_line(StringRef &buffer)
+{
+  const char *start = buffer.begin();
+  const char *end = buffer.end();
+  const char *ptr = start;
+  while (ptr < end) {
+    const char *newline = static_cast<const char *>(memchr(ptr, '\n', end - ptr));
+    if (newline == nullptr) {
+      ptr = end;
+      break;
+    }
+    /* Skip over line continuations. */
+    if (newline > start && (newline[-1] == '\\' ||
+                            (newline[-1] == '\r' && newline - 1 > start && newline[-2] == '\\'))) {
+      ptr = newline + 1;
+      continue;
+    }
+    ptr = newline;
+    break;
+  }
+  StringRef line(start, ptr);
+  if (ptr < end) {
+    ++ptr; /* Skip the newline. */
+  }
+  buffer = StringRef(ptr, end);
+  return line;
+}
+
+bool line_has_continuation(StringRef line)
+{
+  /* #read_next_line stops at the first newline that is not part of a continuation,
+   * so any newline inside the line means there was one. */
+  return line.find_first_of('\n') != StringRef::not_found;
+}
+
+StringRef fixup_line_continuations(StringRef line, std::string &r_storage)
+{
+  r_storage.assign(line.data(), line.size());
+  char *p = r_storage.data();
+  char *end = p + r_storage.size();
+  for (; p < end; ++p) {
+    if (is_continuation_at(p, end)) {
+      *p = ' ';
+      if (p[1] == '\r') {
+        *++p = ' ';
+      }
+      *++p = ' ';
+    }
+  }
+  return r_storage;
+}
+
+static bool is_whitespace(char c)
+{
+  return c > 0 && c <= ' ';
+}
+
+StringRef drop_whitespace(StringRef str)
+{
+  const char *p = str.begin();
+  const char *end = str.end();
+  while (p < end && is_whitespace(*p)) {
+    ++p;
+  }
+  return StringRef(p, end);
+}
+
+StringRef drop_non_whitespace(StringRef str)
+{
+  const char *p = str.begin();
+  const char *end = str.end();
+  while (p < end && *p != '\0' && !is_whitespace(*p)) {
+    ++p;
+  }
+  return StringRef(p, end);
+}
+
+static StringRef drop_plus(StringRef str)
+{
+  if (!str.is_empty() && str[0] == '+') {
+    return str.drop_prefix(1);
+  }
+  return str;
+}
+
+StringRef parse_int(StringRef str, int fallback, int &dst, bool skip_space)
+{
+  if (skip_space) {
+    str = drop_whitespace(str);
+  }
+  str = drop_plus(str);
+  const char *p = str.begin();
+  const char *end = str.end();
+  bool negative = false;
+  if (p < end && *p == '-') {
+    negative = true;
+    ++p;
+  }
+  const char *digits_start = p;
+  int64_t value = 0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    if (value < std::numeric_limits<int>::max()) {
+      value = value * 10 + (*p - '0');
+    }
+    ++p;
+  }
+  if (p == digits_start) {
+    dst = fallback;
+    return str;
+  }
+  if (value > std::numeric_limits<int>::max()) {
+    dst = fallback;
+    return StringRef(p, end);
+  }
+  dst = int(negative ? -value : value);
+  return StringRef(p, end);
+}
+
+/** Case insensitive check whether `str` starts with the lower-case `prefix`. */
+static bool startswith_nocase(const char *p, const char *end, const char *prefix)
+{
+  for (; *prefix; ++prefix, ++p) {
+    if (p >= end || (*p | 0x20) != *prefix) {
+      return false;
+    }
+  }
+  return true;
+}
+
+StringRef parse_float(StringRef str, const float fallback, float &dst, bool skip_space)
+{
+  if (skip_space) {
+    str = drop_whitespace(str);
+  }
+  str = drop_plus(str);
+  const char *p = str.begin();
+  const char *end = str.end();
+  bool negative = false;
+  if (p < end && *p == '-') {
+    negative = true;
+    ++p;
+  }
+
+  if (startswith_nocase(p, end, "inf")) {
+    p += startswith_nocase(p, end, "infinity") ? 8 : 3;
+    dst = negative ? -std::numeric_limits<float>::infinity() :
+                     std::numeric_limits<float>::infinity();
+    return StringRef(p, end);
+  }
+  if (startswith_nocase(p, end, "nan")) {
+    dst = std::numeric_limits<float>::quiet_NaN();
+    return StringRef(p + 3, end);
+  }
+
+  /* Accumulate up to 19 significant digits, which fit into 64 bits. Further digits only
+   * contribute to the exponent; they are far below float precision anyway. */
+  uint64_t mantissa = 0;
+  int significant_digits = 0;
+  int exponent = 0;
+  bool any_digits = false;
+  while (p < end && *p >= '0' && *p <= '9') {
+    any_digits = true;
+    if (significant_digits < 19) {
+      mantissa = mantissa * 10 + uint64_t(*p - '0');
+      significant_digits += mantissa != 0;
+    }
+    else {
+      exponent++;
+    }
+    ++p;
+  }
+  if (p < end && *p == '.') {
+    ++p;
+    while (p < end && *p >= '0' && *p <= '9') {
+      any_digits = true;
+      if (significant_digits < 19) {
+        mantissa = mantissa * 10 + uint64_t(*p - '0');
+        significant_digits += mantissa != 0;
+        exponent--;
+      }
+      ++p;
+    }
+  }
+  if (!any_digits) {
+    dst = fallback;
+    return str;
+  }
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    const char *exp_start = p;
+    ++p;
+    bool exp_negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+      exp_negative = *p == '-';
+      ++p;
+    }
+    if (p < end && *p >= '0' && *p <= '9') {
+      int exp_value = 0;
+      while (p < end && *p >= '0' && *p <= '9') {
+        if (exp_value < 10000) {
+          exp_value = exp_value * 10 + (*p - '0');
+        }
+        ++p;
+      }
+      exponent += exp_negative ? -exp_value : exp_value;
+    }
+    else {
+      /* Not an exponent after all, e.g. "1.0e" at the end of the line. */
+      p = exp_start;
+    }
+  }
+
+  /* Powers of ten up to 22 are exactly representable as doubles, so a single multiplication
+   * or division gives a correctly rounded double in the common case. */
+  static const double powers_of_ten[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                         1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                         1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  double value = double(mantissa);
+  if (mantissa != 0) {
+    if (exponent >= 0 && exponent <= 22) {
+      value *= powers_of_ten[exponent];
+    }
+    else if (exponent < 0 && exponent >= -22) {
+      value /= powers_of_ten[-exponent];
+    }
+    else {
+      value *= std::pow(10.0, double(exponent));
+    }
+  }
+  dst = float(negative ? -value : value);
+  return StringRef(p, end);
+}
+
+StringRef parse_floats(StringRef str, const float fallback, float *dst, const int count)
+{
+  for (int i = 0; i < count; ++i) {
+    str = parse_float(str, fallback, dst[i]);
+  }
+  return str;
+}
+
+}  // namespace blender::io::obj
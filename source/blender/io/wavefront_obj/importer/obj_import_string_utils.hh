@@ -0,0 +1,83 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup obj
+ */
+
+#pragma once
+
+#include "BLI_string_ref.hh"
+
+/*
+ * Various text parsing utilities used by OBJ & MTL importer.
+ * They all work on a #StringRef that is a view into (a part of) the file buffer,
+ * and return the remaining part of the string after the parsed element.
+ */
+
+namespace blender::io::obj {
+
+/**
+ * Fetches next line from an input string buffer.
+ *
+ * The returned line will not have '\n' characters at the end;
+ * the `buffer` is modified to contain remaining text without
+ * the input line.
+ *
+ * Note that backslash (\) character is treated as a line
+ * continuation: the newline that follows it is not a line end.
+ * Use #line_has_continuation and #fixup_line_continuations to get the
+ * joined line.
+ */
+StringRef read_next_line(StringRef &buffer);
+
+/** Whether the line contains a backslash-newline continuation. */
+bool line_has_continuation(StringRef line);
+
+/**
+ * Copy `line` into `r_storage` with every backslash-newline continuation
+ * replaced by spaces, and return a reference to the result.
+ */
+StringRef fixup_line_continuations(StringRef line, std::string &r_storage);
+
+/**
+ * Drop leading white-space from a string part.
+ * Note that "white-space" here is anything in the ASCII range 1 to 32 (inclusive).
+ */
+StringRef drop_whitespace(StringRef str);
+
+/**
+ * Drop leading non-white-space from a string part.
+ */
+StringRef drop_non_whitespace(StringRef str);
+
+/**
+ * Parse an integer number from an input string.
+ * The parser stops when it encounters a non-digit character.
+ * Leading white-space is skipped.
+ *
+ * \param str: input string.
+ * \param fallback: value to use if parsing fails.
+ * \param dst: parsed value is stored here.
+ * \return Remaining part of the input string after the parsed number.
+ */
+StringRef parse_int(StringRef str, int fallback, int &dst, bool skip_space = true);
+
+/**
+ * Parse a float number from an input string.
+ * Handles an optional sign, decimal fraction and exponent; also accepts
+ * "inf"/"nan" spelled in any case. Leading white-space is skipped.
+ *
+ * \param str: input string.
+ * \param fallback: value to use if parsing fails.
+ * \param dst: parsed value is stored here.
+ * \return Remaining part of the input string after the parsed number.
+ */
+StringRef parse_float(StringRef str, float fallback, float &dst, bool skip_space = true);
+
+/**
+ * Parse a number of white-space separated floats from an input string.
+ * Elements that fail to parse get the `fallback` value.
+ */
+StringRef parse_floats(StringRef str, float fallback, float *dst, int count);
+
+}  // namespace blender::io::obj
@@ -0,0 +1,162 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup obj
+ */
+
+#include <string>
+
+#include "BLI_array.hh"
+#include "BLI_math_base.h"
+#include "BLI_math_matrix.h"
+#include "BLI_math_rotation.h"
+#include "BLI_math_vector.h"
+#include "BLI_task.hh"
+
+#include "BKE_collection.h"
+#include "BKE_context.h"
+#include "BKE_layer.h"
+#include "BKE_mesh.h"
+#include "BKE_object.h"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+
+#include "DNA_collection_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "obj_import_file_reader.hh"
+#include "obj_import_mesh.hh"
+#include "obj_importer.hh"
+
+namespace blender::io::obj {
+
+/**
+ * Apply the axis conversion and size clamping of the import parameters to the object.
+ */
+static void transform_object(Object *object, const OBJImportParams &import_params)
+{
+  float axes_transform[3][3];
+  unit_m3(axes_transform);
+  float obmat[4][4];
+  unit_m4(obmat);
+  /* +Y-forward and +Z-up are the default Blender axis settings. */
+  mat3_from_axis_conversion(import_params.forward_axis,
+                            import_params.up_axis,
+                            OBJ_AXIS_Y_FORWARD,
+                            OBJ_AXIS_Z_UP,
+                            axes_transform);
+  copy_m4_m3(obmat, axes_transform);
+  BKE_object_apply_mat4(object, obmat, true, false);
+
+  if (import_params.clamp_size != 0.0f) {
+    float min[3], max[3];
+    INIT_MINMAX(min, max);
+    if (!BKE_mesh_minmax(static_cast<const Mesh *>(object->data), min, max)) {
+      return;
+    }
+    const float max_diff = max_fff(max[0] - min[0], max[1] - min[1], max[2] - min[2]);
+    float scale = 1.0f;
+    while (import_params.clamp_size < max_diff * scale) {
+      scale = scale / 10;
+    }
+    copy_v3_fl(object->scale, scale);
+  }
+}
+
+/**
+ * Make Blender Mesh objects from the geometries and add them to the active collection.
+ * The mesh data of all objects is built in parallel; only adding them to #Main is serial.
+ */
+static void geometry_to_blender_objects(
+    Main *bmain,
+    Scene *scene,
+    ViewLayer *view_layer,
+    const OBJImportParams &import_params,
+    Vector<std::unique_ptr<Geometry>> &all_geometries,
+    const GlobalVertices &global_vertices,
+    Map<std::string, std::unique_ptr<MTLMaterial>> &materials)
+{
+  BKE_view_layer_base_deselect_all(view_layer);
+  LayerCollection *lc = BKE_layer_collection_get_active(view_layer);
+
+  Array<Mesh *> meshes(all_geometries.size(), nullptr);
+  threading::parallel_for(all_geometries.index_range(), 1, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      MeshFromGeometry mesh_ob_from_geometry{*all_geometries[i], global_vertices};
+      meshes[i] = mesh_ob_from_geometry.create_mesh(import_params);
+    }
+  });
+
+  /* Don't do collection syncs for each object, will do once after the loop. */
+  BKE_layer_collection_resync_forbid();
+  Map<std::string, Material *> created_materials;
+  Vector<Object *> objects;
+  for (const int64_t i : all_geometries.index_range()) {
+    if (meshes[i] == nullptr) {
+      continue;
+    }
+    MeshFromGeometry mesh_ob_from_geometry{*all_geometries[i], global_vertices};
+    Object *obj = mesh_ob_from_geometry.create_object(
+        bmain, meshes[i], materials, created_materials, import_params);
+    transform_object(obj, import_params);
+    BKE_collection_object_add(bmain, lc->collection, obj);
+    objects.append(obj);
+  }
+
+  /* Sync the collection after all objects are created. */
+  BKE_layer_collection_resync_allow();
+  BKE_main_collection_sync(bmain);
+
+  /* After collection sync, select objects in the view layer and do DEG updates. */
+  for (Object *obj : objects) {
+    Base *base = BKE_view_layer_base_find(view_layer, obj);
+    BKE_view_layer_base_select_and_set_active(view_layer, base);
+
+    int flags = ID_RECALC_TRANSFORM | ID_RECALC_GEOMETRY | ID_RECALC_ANIMATION |
+                ID_RECALC_BASE_FLAGS;
+    DEG_id_tag_update_ex(bmain, &obj->id, flags);
+  }
+  DEG_id_tag_update(&lc->collection->id, ID_RECALC_COPY_ON_WRITE);
+
+  DEG_id_tag_update(&scene->id, ID_RECALC_BASE_FLAGS);
+  DEG_relations_tag_update(bmain);
+}
+
+void importer_main(bContext *C, const OBJImportParams &import_params)
+{
+  Main *bmain = CTX_data_main(C);
+  Scene *scene = CTX_data_scene(C);
+  ViewLayer *view_layer = CTX_data_view_layer(C);
+  importer_main(bmain, scene, view_layer, import_params);
+}
+
+void importer_main(Main *bmain,
+                   Scene *scene,
+                   ViewLayer *view_layer,
+                   const OBJImportParams &import_params)
+{
+  /* List of Geometry instances to be parsed from OBJ file. */
+  Vector<std::unique_ptr<Geometry>> all_geometries;
+  /* Container for vertex and UV vertex coordinates. */
+  GlobalVertices global_vertices;
+  /* List of MTLMaterial instances to be parsed from MTL file. */
+  Map<std::string, std::unique_ptr<MTLMaterial>> materials;
+
+  OBJParser obj_parser{import_params};
+  if (!obj_parser.is_open()) {
+    return;
+  }
+  obj_parser.parse(all_geometries, global_vertices);
+
+  for (StringRefNull mtl_library : obj_parser.mtl_libraries()) {
+    MTLParser mtl_parser{mtl_library, import_params.filepath};
+    mtl_parser.parse_and_store(materials);
+  }
+
+  geometry_to_blender_objects(
+      bmain, scene, view_layer, import_params, all_geometries, global_vertices, materials);
+}
+}  // namespace blender::io::obj
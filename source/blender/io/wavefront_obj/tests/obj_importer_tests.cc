@@ -0,0 +1,492 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+
+#include "testing/testing.h"
+
+#include "BKE_appdir.h"
+
+#include "BLI_fileops.h"
+#include "BLI_string.h"
+#include "BLI_vector.hh"
+
+#include "obj_import_file_reader.hh"
+#include "obj_import_string_utils.hh"
+
+namespace blender::io::obj {
+
+/* -------------------------------------------------------------------- */
+/** \name String Utilities
+ * \{ */
+
+TEST(obj_import_string_utils, read_next_line)
+{
+  std::string str = "abc\n  \n\nline with \\\n continuation\nCRLF ending:\\\r\na";
+  StringRef s = str;
+  EXPECT_EQ(read_next_line(s), "abc");
+  EXPECT_EQ(read_next_line(s), "  ");
+  EXPECT_EQ(read_next_line(s), "");
+  StringRef line = read_next_line(s);
+  EXPECT_EQ(line, "line with \\\n continuation");
+  EXPECT_TRUE(line_has_continuation(line));
+  std::string storage;
+  EXPECT_EQ(fixup_line_continuations(line, storage), "line with    continuation");
+  line = read_next_line(s);
+  EXPECT_EQ(line, "CRLF ending:\\\r\na");
+  EXPECT_EQ(fixup_line_continuations(line, storage), "CRLF ending:   a");
+  EXPECT_TRUE(s.is_empty());
+  EXPECT_FALSE(line_has_continuation("abc"));
+}
+
+TEST(obj_import_string_utils, drop_whitespace)
+{
+  /* Also there are some control characters that should get dropped too. */
+  std::string str = " \t abc def \v \f \x07";
+  StringRef s = str;
+  s = drop_whitespace(s);
+  EXPECT_EQ(s, "abc def \v \f \x07");
+  s = drop_non_whitespace(s);
+  EXPECT_EQ(s, " def \v \f \x07");
+  s = drop_whitespace(s);
+  EXPECT_EQ(s, "def \v \f \x07");
+  s = drop_non_whitespace(drop_whitespace(drop_non_whitespace(s)));
+  EXPECT_EQ(s, "");
+}
+
+TEST(obj_import_string_utils, parse_int_valid)
+{
+  std::string str = "1 -10 \t  1234 1234567890 +7 123a";
+  StringRef s = str;
+  int val;
+  s = parse_int(s, 0, val);
+  EXPECT_EQ(val, 1);
+  s = parse_int(s, 0, val);
+  EXPECT_EQ(val, -10);
+  s = parse_int(s, 0, val);
+  EXPECT_EQ(val, 1234);
+  s = parse_int(s, 0, val);
+  EXPECT_EQ(val, 1234567890);
+  s = parse_int(s, 0, val);
+  EXPECT_EQ(val, 7);
+  s = parse_int(s, 0, val);
+  EXPECT_EQ(val, 123);
+  EXPECT_EQ(s, "a");
+}
+
+TEST(obj_import_string_utils, parse_int_invalid)
+{
+  int val;
+  /* Invalid syntax. */
+  EXPECT_EQ(parse_int("--123", -1, val), "--123");
+  EXPECT_EQ(val, -1);
+  EXPECT_EQ(parse_int("foobar", -2, val), "foobar");
+  EXPECT_EQ(val, -2);
+  /* Out of integer range. */
+  EXPECT_EQ(parse_int("1234567890123", -3, val), "");
+  EXPECT_EQ(val, -3);
+  /* Leading white-space is only skipped when asked for. */
+  EXPECT_EQ(parse_int(" 1", -4, val, false), " 1");
+  EXPECT_EQ(val, -4);
+}
+
+TEST(obj_import_string_utils, parse_float_valid)
+{
+  std::string str = "1 -10 123.5 -17.125 0.1 1e6 50.0e-1 -inf NaN 1.5x";
+  StringRef s = str;
+  float val;
+  s = parse_float(s, 0, val);
+  EXPECT_EQ(val, 1.0f);
+  s = parse_float(s, 0, val);
+  EXPECT_EQ(val, -10.0f);
+  s = parse_float(s, 0, val);
+  EXPECT_EQ(val, 123.5f);
+  s = parse_float(s, 0, val);
+  EXPECT_EQ(val, -17.125f);
+  s = parse_float(s, 0, val);
+  EXPECT_EQ(val, 0.1f);
+  s = parse_float(s, 0, val);
+  EXPECT_EQ(val, 1.0e6f);
+  s = parse_float(s, 0, val);
+  EXPECT_EQ(val, 5.0f);
+  s = parse_float(s, 0, val);
+  EXPECT_EQ(val, -INFINITY);
+  s = parse_float(s, 0, val);
+  EXPECT_TRUE(isnan(val));
+  s = parse_float(s, 0, val);
+  EXPECT_EQ(val, 1.5f);
+  EXPECT_EQ(s, "x");
+}
+
+TEST(obj_import_string_utils, parse_float_invalid)
+{
+  float val;
+  /* Invalid syntax. */
+  EXPECT_EQ(parse_float("_0", -1.0f, val), "_0");
+  EXPECT_EQ(val, -1.0f);
+  EXPECT_EQ(parse_float("..5", -2.0f, val), "..5");
+  EXPECT_EQ(val, -2.0f);
+  /* Out of float range. Current float parsing code results in "inf" for this case. */
+  EXPECT_EQ(parse_float("1.0e500", -3.0f, val), "");
+  EXPECT_EQ(val, INFINITY);
+}
+
+TEST(obj_import_string_utils, parse_floats)
+{
+  float vals[3];
+  EXPECT_EQ(parse_floats(" 1 2.5 -3\n", 0.0f, vals, 3), "\n");
+  EXPECT_EQ(vals[0], 1.0f);
+  EXPECT_EQ(vals[1], 2.5f);
+  EXPECT_EQ(vals[2], -3.0f);
+  /* Missing elements get the fallback value. */
+  parse_floats(" 4", 7.0f, vals, 3);
+  EXPECT_EQ(vals[0], 4.0f);
+  EXPECT_EQ(vals[1], 7.0f);
+  EXPECT_EQ(vals[2], 7.0f);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name OBJ & MTL Parsing
+ * \{ */
+
+/**
+ * Writes the given contents to a file in the temporary directory and parses it.
+ * Every test file is parsed both as a whole and split into tiny chunks, which must give the same
+ * result as long as chunking works correctly.
+ */
+class obj_importer_parser_test : public testing::Test {
+ protected:
+  OBJImportParams params_{};
+  std::string obj_path_;
+
+  void SetUp() override
+  {
+    BKE_tempdir_init(nullptr);
+    params_.forward_axis = OBJ_AXIS_NEGATIVE_Z_FORWARD;
+    params_.up_axis = OBJ_AXIS_Y_UP;
+    params_.import_vertex_groups = true;
+  }
+
+  void TearDown() override
+  {
+    if (!obj_path_.empty()) {
+      BLI_delete(obj_path_.c_str(), false, false);
+    }
+  }
+
+  std::string write_temp_file(const char *name, const std::string &contents)
+  {
+    const std::string path = std::string(BKE_tempdir_base()) + name;
+    FILE *file = BLI_fopen(path.c_str(), "wb");
+    EXPECT_NE(file, nullptr);
+    if (file) {
+      fwrite(contents.data(), 1, contents.size(), file);
+      fclose(file);
+    }
+    return path;
+  }
+
+  void parse(const std::string &contents,
+             const int64_t chunk_size,
+             Vector<std::unique_ptr<Geometry>> &r_geometries,
+             GlobalVertices &r_vertices)
+  {
+    obj_path_ = write_temp_file("obj_importer_test.obj", contents);
+    STRNCPY(params_.filepath, obj_path_.c_str());
+    OBJParser parser{params_, chunk_size};
+    ASSERT_TRUE(parser.is_open());
+    parser.parse(r_geometries, r_vertices);
+  }
+
+  /**
+   * Parse the contents with the default and with a tiny chunk size and compare the results.
+   */
+  Vector<std::unique_ptr<Geometry>> parse_and_compare_chunked(const std::string &contents,
+                                                              GlobalVertices &r_vertices)
+  {
+    Vector<std::unique_ptr<Geometry>> geometries;
+    parse(contents, OBJParser::default_chunk_size, geometries, r_vertices);
+
+    for (const int64_t chunk_size : {1, 7, 32}) {
+      Vector<std::unique_ptr<Geometry>> chunked_geometries;
+      GlobalVertices chunked_vertices;
+      parse(contents, chunk_size, chunked_geometries, chunked_vertices);
+      EXPECT_EQ(chunked_vertices.vertices.as_span(), r_vertices.vertices.as_span());
+      EXPECT_EQ(chunked_vertices.uv_vertices.as_span(), r_vertices.uv_vertices.as_span());
+      EXPECT_EQ(chunked_vertices.vertex_normals.as_span(), r_vertices.vertex_normals.as_span());
+      EXPECT_EQ(chunked_geometries.size(), geometries.size());
+      if (chunked_geometries.size() != geometries.size()) {
+        continue;
+      }
+      for (const int64_t i : geometries.index_range()) {
+        expect_geometries_equal(*geometries[i], *chunked_geometries[i]);
+      }
+    }
+    return geometries;
+  }
+
+  /** Compare the object-wide content, which does not depend on how faces are split in parts. */
+  static void expect_geometries_equal(const Geometry &a, const Geometry &b)
+  {
+    EXPECT_EQ(a.geometry_name_, b.geometry_name_);
+    EXPECT_EQ(a.vertex_index_min_, b.vertex_index_min_);
+    EXPECT_EQ(a.vertex_index_max_, b.vertex_index_max_);
+    EXPECT_EQ(a.total_faces_, b.total_faces_);
+    EXPECT_EQ(a.total_corners_, b.total_corners_);
+    EXPECT_EQ(a.total_edges_, b.total_edges_);
+    EXPECT_EQ(a.has_uv_, b.has_uv_);
+    EXPECT_EQ(a.has_vertex_normals_, b.has_vertex_normals_);
+    EXPECT_EQ(a.has_invalid_polys_, b.has_invalid_polys_);
+    EXPECT_EQ(a.material_names_.as_span(), b.material_names_.as_span());
+    EXPECT_EQ(a.group_names_.as_span(), b.group_names_.as_span());
+    EXPECT_EQ(flatten_faces(a), flatten_faces(b));
+  }
+
+  /**
+   * All faces of the geometry as text, with object-wide material and group indices:
+   * "material group smooth: v/vt/vn ...".
+   */
+  static Vector<std::string> flatten_faces(const Geometry &geometry)
+  {
+    Vector<std::string> faces;
+    for (const int part_index : geometry.parts_.index_range()) {
+      const GeometryPart &part = geometry.parts_[part_index];
+      for (const PolyElem &face : part.face_elements_) {
+        const int material = face.material_index < 0 ?
+                                 -1 :
+                                 geometry.part_material_maps_[part_index][face.material_index];
+        const int group = face.vertex_group_index < 0 ?
+                              -1 :
+                              geometry.part_group_maps_[part_index][face.vertex_group_index];
+        std::string str = std::to_string(material) + " " + std::to_string(group) + " " +
+                          std::to_string(face.shaded_smooth) + ":";
+        for (const PolyCorner &corner :
+             part.face_corners_.as_span().slice(face.start_index, face.corner_count)) {
+          str += " " + std::to_string(corner.vert_index) + "/" +
+                 std::to_string(corner.uv_vert_index) + "/" +
+                 std::to_string(corner.vertex_normal_index);
+        }
+        faces.append(str);
+      }
+    }
+    return faces;
+  }
+};
+
+TEST_F(obj_importer_parser_test, cube)
+{
+  const std::string obj =
+      "# Comment\n"
+      "mtllib cube.mtl\n"
+      "o Cube\n"
+      "v 1 1 -1\nv 1 -1 -1\nv 1 1 1\nv 1 -1 1\n"
+      "v -1 1 -1\nv -1 -1 -1\nv -1 1 1\nv -1 -1 1\n"
+      "vt 0.625 0.5\nvt 0.875 0.5\nvt 0.875 0.75\nvt 0.625 0.75\n"
+      "vn 0 1 0\nvn 0 0 1\n"
+      "usemtl Material\n"
+      "s off\n"
+      "f 1/1/1 5/2/1 7/3/1 3/4/1\n"
+      "f 4/1/2 3/2/2 7/3/2 8/4/2\n"
+      "f 8 7 5 6\n"
+      "f 6 2 4 8\n"
+      "f 2 1 3 4\n"
+      "f 6 5 1 2\n";
+  GlobalVertices vertices;
+  Vector<std::unique_ptr<Geometry>> geometries = parse_and_compare_chunked(obj, vertices);
+  ASSERT_EQ(geometries.size(), 1);
+  const Geometry &cube = *geometries[0];
+  EXPECT_EQ(cube.geometry_name_, "Cube");
+  EXPECT_EQ(cube.get_vertex_count(), 8);
+  EXPECT_EQ(cube.total_faces_, 6);
+  EXPECT_EQ(cube.total_corners_, 24);
+  EXPECT_EQ(cube.total_edges_, 0);
+  EXPECT_TRUE(cube.has_uv_);
+  EXPECT_TRUE(cube.has_vertex_normals_);
+  EXPECT_FALSE(cube.has_invalid_polys_);
+  ASSERT_EQ(cube.material_names_.size(), 1);
+  EXPECT_EQ(cube.material_names_[0], "Material");
+  EXPECT_EQ(vertices.vertices.size(), 8);
+  EXPECT_EQ(vertices.vertices[6], float3(-1, 1, 1));
+  EXPECT_EQ(vertices.uv_vertices[2], float2(0.875f, 0.75f));
+  EXPECT_EQ(vertices.vertex_normals[1], float3(0, 0, 1));
+  const Vector<std::string> faces = flatten_faces(cube);
+  EXPECT_EQ(faces[0], "0 -1 0: 0/0/0 4/1/0 6/2/0 2/3/0");
+  EXPECT_EQ(faces[2], "0 -1 0: 7/-1/-1 6/-1/-1 4/-1/-1 5/-1/-1");
+}
+
+TEST_F(obj_importer_parser_test, relative_indices_and_objects)
+{
+  const std::string obj =
+      "v 0 0 0\nv 1 0 0\nv 1 1 0\n"
+      "vt 0 0\nvt 1 0\nvt 1 1\n"
+      "f -3/-3 -2/-2 -1/-1\n"
+      "o Second\n"
+      "v 0 0 1\nv 1 0 1\nv 1 1 1\nv 0 1 1\n"
+      "f -4 -3 -2 -1\n"
+      "l 4 5 6\n"
+      "o Points\n"
+      "v 5 5 5\nv 6 6 6\n";
+  GlobalVertices vertices;
+  Vector<std::unique_ptr<Geometry>> geometries = parse_and_compare_chunked(obj, vertices);
+  ASSERT_EQ(geometries.size(), 3);
+
+  /* The object before the first `o` line is named after the file. */
+  EXPECT_EQ(geometries[0]->geometry_name_, "obj_importer_test");
+  EXPECT_EQ(geometries[0]->get_vertex_count(), 3);
+  EXPECT_EQ(flatten_faces(*geometries[0])[0], "-1 -1 0: 0/0/-1 1/1/-1 2/2/-1");
+
+  EXPECT_EQ(geometries[1]->geometry_name_, "Second");
+  EXPECT_EQ(geometries[1]->vertex_index_min_, 3);
+  EXPECT_EQ(geometries[1]->get_vertex_count(), 4);
+  EXPECT_EQ(geometries[1]->total_edges_, 2);
+  EXPECT_FALSE(geometries[1]->has_uv_);
+  EXPECT_EQ(flatten_faces(*geometries[1])[0], "-1 -1 0: 3/-1/-1 4/-1/-1 5/-1/-1 6/-1/-1");
+
+  /* Objects without faces and edges keep all of their vertices. */
+  EXPECT_EQ(geometries[2]->geometry_name_, "Points");
+  EXPECT_EQ(geometries[2]->vertex_index_min_, 7);
+  EXPECT_EQ(geometries[2]->get_vertex_count(), 2);
+  EXPECT_EQ(geometries[2]->total_faces_, 0);
+}
+
+TEST_F(obj_importer_parser_test, state_across_objects)
+{
+  /* Material, group and smooth state carry over to the following objects. */
+  const std::string obj =
+      "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+      "o A\n"
+      "g group_a\n"
+      "usemtl red\n"
+      "s 1\n"
+      "f 1 2 3\n"
+      "usemtl blue\n"
+      "f 1 3 4\n"
+      "o B\n"
+      "f 1 2 4\n"
+      "g group_b\n"
+      "s off\n"
+      "usemtl red\n"
+      "f 2 3 4\n";
+  GlobalVertices vertices;
+  Vector<std::unique_ptr<Geometry>> geometries = parse_and_compare_chunked(obj, vertices);
+  ASSERT_EQ(geometries.size(), 2);
+
+  const Geometry &a = *geometries[0];
+  EXPECT_EQ(a.geometry_name_, "A");
+  ASSERT_EQ(a.material_names_.size(), 2);
+  EXPECT_EQ(a.material_names_[0], "red");
+  EXPECT_EQ(a.material_names_[1], "blue");
+  ASSERT_EQ(a.group_names_.size(), 1);
+  const Vector<std::string> faces_a = flatten_faces(a);
+  EXPECT_EQ(faces_a[0], "0 0 1: 0/-1/-1 1/-1/-1 2/-1/-1");
+  EXPECT_EQ(faces_a[1], "1 0 1: 0/-1/-1 2/-1/-1 3/-1/-1");
+
+  const Geometry &b = *geometries[1];
+  EXPECT_EQ(b.geometry_name_, "B");
+  ASSERT_EQ(b.material_names_.size(), 2);
+  EXPECT_EQ(b.material_names_[0], "blue");
+  EXPECT_EQ(b.material_names_[1], "red");
+  ASSERT_EQ(b.group_names_.size(), 2);
+  EXPECT_EQ(b.group_names_[0], "group_a");
+  EXPECT_EQ(b.group_names_[1], "group_b");
+  const Vector<std::string> faces_b = flatten_faces(b);
+  EXPECT_EQ(faces_b[0], "0 0 1: 0/-1/-1 1/-1/-1 3/-1/-1");
+  EXPECT_EQ(faces_b[1], "1 1 0: 1/-1/-1 2/-1/-1 3/-1/-1");
+}
+
+TEST_F(obj_importer_parser_test, invalid_faces)
+{
+  const std::string obj =
+      "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+      "f 1 2 3 4\n"
+      "f 1 2\n"
+      "f 1 2 2\n"
+      "f 1 2 9\n"
+      "f 0 1 2\n"
+      "f 1 2 3x\n"
+      "f -9 1 2\n"
+      "f 1 3 4\n";
+  GlobalVertices vertices;
+  Vector<std::unique_ptr<Geometry>> geometries = parse_and_compare_chunked(obj, vertices);
+  ASSERT_EQ(geometries.size(), 1);
+  EXPECT_TRUE(geometries[0]->has_invalid_polys_);
+  EXPECT_EQ(geometries[0]->total_faces_, 2);
+  EXPECT_EQ(geometries[0]->total_corners_, 7);
+}
+
+TEST_F(obj_importer_parser_test, line_continuations)
+{
+  const std::string obj =
+      "v 0 0 0\r\nv 1 0 0\r\nv 1 \\\r\n 1 0\r\nv \\\n0 1 0\r\n"
+      "o Quad\\\nName\r\n"
+      "f 1 2\\\n 3 \\\n4\r\n";
+  GlobalVertices vertices;
+  Vector<std::unique_ptr<Geometry>> geometries = parse_and_compare_chunked(obj, vertices);
+  ASSERT_EQ(geometries.size(), 1);
+  EXPECT_EQ(geometries[0]->geometry_name_, "Quad  Name");
+  EXPECT_EQ(vertices.vertices.size(), 4);
+  EXPECT_EQ(vertices.vertices[2], float3(1, 1, 0));
+  EXPECT_EQ(vertices.vertices[3], float3(0, 1, 0));
+  EXPECT_EQ(geometries[0]->total_corners_, 4);
+}
+
+TEST_F(obj_importer_parser_test, empty_file)
+{
+  GlobalVertices vertices;
+  Vector<std::unique_ptr<Geometry>> geometries;
+  parse("", OBJParser::default_chunk_size, geometries, vertices);
+  EXPECT_TRUE(geometries.is_empty());
+  EXPECT_TRUE(vertices.vertices.is_empty());
+}
+
+TEST_F(obj_importer_parser_test, mtl)
+{
+  const std::string mtl =
+      "newmtl Red\n"
+      "Ns 250\n"
+      "Kd 1 0 0\n"
+      "Ks 0.5 0.5 0.5\n"
+      "d 0.25\n"
+      "illum 2\n"
+      "map_Kd -o 1 2 3 -s 2 2 2 textures/red image.png\n"
+      "map_Bump -bm 0.5 bump.png\n"
+      "newmtl Red\n"
+      "Kd 0 1 0\n"
+      "newmtl Metal\n"
+      "Ka 1 1 1\n"
+      "illum 3\n";
+  const std::string mtl_path = write_temp_file("obj_importer_test.mtl", mtl);
+  const std::string obj_path = std::string(BKE_tempdir_base()) + "obj_importer_test.obj";
+
+  Map<std::string, std::unique_ptr<MTLMaterial>> materials;
+  MTLParser parser{"obj_importer_test.mtl", obj_path};
+  parser.parse_and_store(materials);
+  BLI_delete(mtl_path.c_str(), false, false);
+
+  ASSERT_EQ(materials.size(), 2);
+  const MTLMaterial &red = *materials.lookup("Red");
+  EXPECT_EQ(red.Ns, 250.0f);
+  /* The first definition of a material is used. */
+  EXPECT_EQ(red.Kd, float3(1, 0, 0));
+  EXPECT_EQ(red.Ks, float3(0.5f));
+  EXPECT_EQ(red.d, 0.25f);
+  EXPECT_EQ(red.illum, 2);
+  EXPECT_EQ(red.map_Bump_strength, 0.5f);
+  const tex_map_XX &kd = red.texture_maps.lookup(eMTLSyntaxElement::map_Kd);
+  EXPECT_EQ(kd.image_path, "textures/red image.png");
+  EXPECT_EQ(float3(kd.translation), float3(1, 2, 3));
+  EXPECT_EQ(float3(kd.scale), float3(2, 2, 2));
+  EXPECT_EQ(red.texture_maps.lookup(eMTLSyntaxElement::map_Bump).image_path, "bump.png");
+
+  const MTLMaterial &metal = *materials.lookup("Metal");
+  EXPECT_EQ(metal.Ka, float3(1, 1, 1));
+  EXPECT_EQ(metal.illum, 3);
+  EXPECT_LT(metal.Ns, 0.0f);
+}
+
+/** \} */
+
+}  // namespace blender::io::obj
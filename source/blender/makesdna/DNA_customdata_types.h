@@ -16,6 +16,7 @@ extern "C" {
 #endif
 
 struct AnonymousAttributeID;
+struct ImplicitSharingInfoHandle;
 
 /** Descriptor and storage for a custom data layer. */
 typedef struct CustomDataLayer {
@@ -46,6 +47,12 @@ typedef struct CustomDataLayer {
    * automatically.
    */
   const struct AnonymousAttributeID *anonymous_id;
+  /**
+   * Run-time data that allows sharing `data` with other #CustomData, e.g. between an original
+   * mesh and the meshes evaluated from it. When set, it owns the data and the layer is one of its
+   * users. See `BLI_implicit_sharing.hh`.
+   */
+  const struct ImplicitSharingInfoHandle *sharing_info;
 } CustomDataLayer;
 
 #define MAX_CUSTOMDATA_LAYER_NAME 64
@@ -639,6 +639,8 @@ typedef struct UserDef_Experimental {
   char use_cycles_debug;
   char show_asset_debug_info;
   char no_asset_indexing;
+  char use_mmap_file_read;
+  char use_undo_compression;
   char SANITIZE_AFTER_HERE;
   /* The following options are automatically sanitized (set to 0)
    * when the release cycle is not alpha. */
@@ -652,7 +654,7 @@ typedef struct UserDef_Experimental {
   char use_named_attribute_nodes;
   char use_select_nearest_on_first_click;
   char enable_eevee_next;
-  // char _pad[0];
+  char _pad[6];
   /** `makesdna` does not allow empty structs. */
 } UserDef_Experimental;
 
@@ -800,7 +802,8 @@ typedef struct UserDef {
   int prefetchframes;
   /** Control the rotation step of the view when PAD2, PAD4, PAD6&PAD8 is use. */
   float pad_rot_angle;
-  char _pad12[4];
+  /** Memory limit for outputs of geometry nodes kept between evaluations (in megabytes). */
+  int geometry_nodes_cache_limit;
   /** Rotating view icon size. */
   short rvisize;
   /** Rotating view icon brightness. */
@@ -257,6 +257,27 @@ static void rna_Depsgraph_debug_stats(Depsgraph *depsgraph, char *result)
                outer);
 }
 
+static void rna_Depsgraph_debug_eval_benchmark(Depsgraph *depsgraph,
+                                               ReportList *reports,
+                                               int iterations)
+{
+  if (DEG_is_evaluating(depsgraph)) {
+    BKE_report(reports, RPT_ERROR, "Dependency graph benchmark requested during evaluation");
+    return;
+  }
+
+#  ifdef WITH_PYTHON
+  /* Allow drivers to be evaluated */
+  BPy_BEGIN_ALLOW_THREADS;
+#  endif
+
+  DEG_debug_eval_benchmark(depsgraph, iterations, stdout);
+
+#  ifdef WITH_PYTHON
+  BPy_END_ALLOW_THREADS;
+#  endif
+}
+
 static void rna_Depsgraph_update(Depsgraph *depsgraph, Main *bmain, ReportList *reports)
 {
   if (DEG_is_evaluating(depsgraph)) {
@@ -662,6 +683,22 @@ static void rna_def_depsgraph(BlenderRNA *brna)
   RNA_def_parameter_flags(parm, PROP_THICK_WRAP, 0); /* needed for string return value */
   RNA_def_function_output(func, parm);
 
+  func = RNA_def_function(srna, "debug_eval_benchmark", "rna_Depsgraph_debug_eval_benchmark");
+  RNA_def_function_ui_description(
+      func,
+      "Evaluate all operations of the dependency graph multiple times and print how well the "
+      "evaluation is parallelized");
+  RNA_def_function_flag(func, FUNC_USE_REPORTS);
+  RNA_def_int(func,
+              "iterations",
+              10,
+              1,
+              INT_MAX,
+              "Iterations",
+              "Number of times to evaluate the dependency graph",
+              1,
+              100);
+
   /* Updates. */
 
   func = RNA_def_function(srna, "update", "rna_Depsgraph_update");
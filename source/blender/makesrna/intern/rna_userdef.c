@@ -187,6 +187,8 @@ static const EnumPropertyItem rna_enum_userdef_viewport_aa_items[] = {
 #  include "MEM_CacheLimiterC-Api.h"
 #  include "MEM_guardedalloc.h"
 
+#  include "MOD_nodes.h"
+
 #  include "UI_interface.h"
 
 #  ifdef WITH_OPENSUBDIV
@@ -589,6 +591,14 @@ static void rna_Userdef_memcache_update(Main *UNUSED(bmain),
   USERDEF_TAG_DIRTY;
 }
 
+static void rna_Userdef_geometry_nodes_cache_update(Main *UNUSED(bmain),
+                                                    Scene *UNUSED(scene),
+                                                    PointerRNA *UNUSED(ptr))
+{
+  MOD_nodes_cache_update_limit();
+  USERDEF_TAG_DIRTY;
+}
+
 static void rna_Userdef_disk_cache_dir_update(Main *UNUSED(bmain),
                                               Scene *UNUSED(scene),
                                               PointerRNA *UNUSED(ptr))
@@ -5488,6 +5498,15 @@ static void rna_def_userdef_system(BlenderRNA *brna)
   RNA_def_property_ui_text(prop, "Memory Cache Limit", "Memory cache limit (in megabytes)");
   RNA_def_property_update(prop, 0, "rna_Userdef_memcache_update");
 
+  prop = RNA_def_property(srna, "geometry_nodes_cache_limit", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, NULL, "geometry_nodes_cache_limit");
+  RNA_def_property_range(prop, 0, max_memory_in_megabytes_int());
+  RNA_def_property_ui_text(prop,
+                           "Geometry Nodes Cache Limit",
+                           "Memory limit for outputs of expensive geometry nodes that are reused "
+                           "when their inputs don't change (in megabytes, 0 disables the cache)");
+  RNA_def_property_update(prop, 0, "rna_Userdef_geometry_nodes_cache_update");
+
   /* Sequencer disk cache */
 
   prop = RNA_def_property(srna, "use_sequencer_disk_cache", PROP_BOOLEAN, PROP_NONE);
@@ -6428,6 +6447,21 @@ static void rna_def_userdef_experimental(BlenderRNA *brna)
                            "completely reread assets from disk");
   RNA_def_property_update(prop, 0, "rna_userdef_ui_update");
 
+  prop = RNA_def_property(srna, "use_mmap_file_read", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "use_mmap_file_read", 1);
+  RNA_def_property_ui_text(prop,
+                           "Memory Mapped File Reading",
+                           "Map large data of uncompressed .blend files into memory instead of "
+                           "reading it, only loading the parts that are used. The files must not "
+                           "be modified by other applications while they are open");
+
+  prop = RNA_def_property(srna, "use_undo_compression", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "use_undo_compression", 1);
+  RNA_def_property_ui_text(prop,
+                           "Undo Compression",
+                           "Compress the data of global undo steps that are not among the last "
+                           "ones, using less memory but making undoing to them slower");
+
   prop = RNA_def_property(srna, "use_override_templates", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_sdna(prop, NULL, "use_override_templates", 1);
   RNA_def_property_ui_text(
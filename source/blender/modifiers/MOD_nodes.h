@@ -17,6 +17,16 @@ extern "C" {
  */
 void MOD_nodes_update_interface(struct Object *object, struct NodesModifierData *nmd);
 
+/**
+ * Free the outputs of geometry nodes that are cached between evaluations.
+ */
+void MOD_nodes_cache_free(void);
+
+/**
+ * Free cached outputs that exceed a changed limit, or all of them when the cache was disabled.
+ */
+void MOD_nodes_cache_update_limit(void);
+
 #ifdef __cplusplus
 }
 #endif
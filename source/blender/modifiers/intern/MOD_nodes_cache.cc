@@ -0,0 +1,830 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup modifiers
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+#include "MOD_nodes.h"
+#include "MOD_nodes_cache.hh"
+
+#include "BKE_customdata.h"
+#include "BKE_geometry_set.hh"
+#include "BKE_node.h"
+
+#include "BLI_array.hh"
+#include "BLI_hash_mm2a.h"
+#include "BLI_map.hh"
+#include "BLI_task.hh"
+
+#include "DNA_curves_types.h"
+#include "DNA_genfile.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_node_types.h"
+#include "DNA_pointcloud_types.h"
+#include "DNA_sdna_types.h"
+#include "DNA_userdef_types.h"
+
+#include "FN_field_cpp_type.hh"
+
+#include "MEM_guardedalloc.h"
+
+namespace blender::modifiers::geometry_nodes::node_cache {
+
+using fn::GField;
+using fn::ValueOrFieldCPPType;
+using nodes::DTreeContext;
+using nodes::InputSocketRef;
+using nodes::NodeRef;
+using nodes::OutputSocketRef;
+
+/** Nodes that took less time than this are not cached, because hashing their inputs would take
+ * about as long as executing them. */
+static constexpr std::chrono::microseconds min_cached_node_duration{1000};
+/** The durations of nodes that were used least recently are forgotten beyond this number. */
+static constexpr int64_t max_node_durations = 1 << 16;
+
+/* -------------------------------------------------------------------- */
+/** \name Hashing
+ * \{ */
+
+/**
+ * Combine hashes of many values. #get_default_hash_2 is not good enough for that, because it
+ * doesn't mix the bits of the existing hash.
+ */
+static uint64_t hash_combine(const uint64_t hash, const uint64_t value)
+{
+  return hash ^ (value + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2));
+}
+
+static uint64_t hash_buffer(const void *data, const int64_t size)
+{
+  if (size == 0) {
+    return 0;
+  }
+  /* Hash chunks in parallel. Every chunk is hashed with two seeds to get a 64 bit hash. */
+  const int64_t chunk_size = 1 << 18;
+  const int64_t chunks_num = (size + chunk_size - 1) / chunk_size;
+  Array<uint64_t> chunk_hashes(chunks_num);
+  threading::parallel_for(IndexRange(chunks_num), 4, [&](const IndexRange range) {
+    for (const int64_t chunk : range) {
+      const unsigned char *chunk_data = static_cast<const unsigned char *>(data) +
+                                        chunk * chunk_size;
+      const size_t chunk_len = size_t(std::min(chunk_size, size - chunk * chunk_size));
+      chunk_hashes[chunk] = (uint64_t(BLI_hash_mm2(chunk_data, chunk_len, 0)) << 32) |
+                            BLI_hash_mm2(chunk_data, chunk_len, 1);
+    }
+  });
+  uint64_t hash = uint64_t(size);
+  for (const uint64_t chunk_hash : chunk_hashes) {
+    hash = hash_combine(hash, chunk_hash);
+  }
+  return hash;
+}
+
+/** The content of a geometry: small values and the arrays of the geometry. */
+struct GeometryContent {
+  Vector<uint64_t> values;
+  Vector<Span<char>> buffers;
+
+  void add_buffer(const void *data, const int64_t size)
+  {
+    buffers.append({static_cast<const char *>(data), size});
+  }
+
+  uint64_t hash() const
+  {
+    uint64_t hash = uint64_t(values.size());
+    for (const uint64_t value : values) {
+      hash = hash_combine(hash, value);
+    }
+    for (const Span<char> buffer : buffers) {
+      hash = hash_combine(hash, hash_buffer(buffer.data(), buffer.size()));
+    }
+    return hash;
+  }
+};
+
+static bool gather_custom_data(const CustomData &data, const int size, GeometryContent &r_content)
+{
+  r_content.values.append(uint64_t(size));
+  r_content.values.append(uint64_t(data.totlayer));
+  for (const CustomDataLayer &layer : Span(data.layers, data.totlayer)) {
+    r_content.values.append(uint64_t(layer.type));
+    r_content.add_buffer(layer.name, int64_t(strlen(layer.name)));
+    /* Anonymous attributes are identified by their address. The layer keeps the identifier
+     * alive, so the address can't be reused while the layer exists. */
+    r_content.values.append(uint64_t(uintptr_t(layer.anonymous_id)));
+    switch (layer.type) {
+      case CD_MDEFORMVERT: {
+        const Span<MDeformVert> dverts{static_cast<const MDeformVert *>(layer.data), size};
+        for (const MDeformVert &dvert : dverts) {
+          r_content.add_buffer(dvert.dw, int64_t(sizeof(MDeformWeight)) * dvert.totweight);
+        }
+        break;
+      }
+      case CD_MDISPS:
+      case CD_GRID_PAINT_MASK:
+      case CD_BM_ELEM_PYPTR: {
+        /* These layers reference other data that isn't part of the content. */
+        return false;
+      }
+      default: {
+        r_content.add_buffer(layer.data, int64_t(CustomData_sizeof(layer.type)) * size);
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+static void gather_materials(Material *const *materials,
+                             const int materials_num,
+                             GeometryContent &r_content)
+{
+  r_content.add_buffer(materials, int64_t(sizeof(Material *)) * materials_num);
+}
+
+static bool gather_geometry_set(const GeometrySet &geometry_set, GeometryContent &r_content);
+
+static bool gather_mesh(const Mesh &mesh, GeometryContent &r_content)
+{
+  r_content.values.append(uint64_t(mesh.flag));
+  r_content.values.append(uint64_t(mesh.cd_flag));
+  r_content.add_buffer(&mesh.smoothresh, sizeof(mesh.smoothresh));
+  gather_materials(mesh.mat, mesh.totcol, r_content);
+  return gather_custom_data(mesh.vdata, mesh.totvert, r_content) &&
+         gather_custom_data(mesh.edata, mesh.totedge, r_content) &&
+         gather_custom_data(mesh.ldata, mesh.totloop, r_content) &&
+         gather_custom_data(mesh.pdata, mesh.totpoly, r_content);
+}
+
+static bool gather_pointcloud(const PointCloud &pointcloud, GeometryContent &r_content)
+{
+  gather_materials(pointcloud.mat, pointcloud.totcol, r_content);
+  return gather_custom_data(pointcloud.pdata, pointcloud.totpoint, r_content);
+}
+
+static bool gather_curves(const Curves &curves, GeometryContent &r_content)
+{
+  const CurvesGeometry &geometry = curves.geometry;
+  gather_materials(curves.mat, curves.totcol, r_content);
+  if (geometry.curve_size > 0) {
+    r_content.add_buffer(geometry.curve_offsets, int64_t(sizeof(int)) * (geometry.curve_size + 1));
+  }
+  return gather_custom_data(geometry.point_data, geometry.point_size, r_content) &&
+         gather_custom_data(geometry.curve_data, geometry.curve_size, r_content);
+}
+
+static bool gather_instances(const InstancesComponent &instances, GeometryContent &r_content)
+{
+  for (const InstanceReference &reference : instances.references()) {
+    r_content.values.append(uint64_t(reference.type()));
+    switch (reference.type()) {
+      case InstanceReference::Type::None: {
+        break;
+      }
+      case InstanceReference::Type::GeometrySet: {
+        if (!gather_geometry_set(reference.geometry_set(), r_content)) {
+          return false;
+        }
+        break;
+      }
+      case InstanceReference::Type::Object:
+      case InstanceReference::Type::Collection: {
+        /* The data of objects and collections can change without changing the reference. */
+        return false;
+      }
+    }
+  }
+  const Span<int> handles = instances.instance_reference_handles();
+  const Span<float4x4> transforms = instances.instance_transforms();
+  r_content.add_buffer(handles.data(), handles.size_in_bytes());
+  r_content.add_buffer(transforms.data(), transforms.size_in_bytes());
+  return gather_custom_data(
+      instances.attributes().data, instances.instances_amount(), r_content);
+}
+
+/** \return False when the content of the component is not supported. */
+static bool gather_component(const GeometryComponent &component, GeometryContent &r_content)
+{
+  r_content.values.append(uint64_t(component.type()));
+  switch (component.type()) {
+    case GEO_COMPONENT_TYPE_MESH: {
+      const Mesh *mesh = static_cast<const MeshComponent &>(component).get_for_read();
+      return mesh == nullptr || gather_mesh(*mesh, r_content);
+    }
+    case GEO_COMPONENT_TYPE_POINT_CLOUD: {
+      const PointCloud *pointcloud =
+          static_cast<const PointCloudComponent &>(component).get_for_read();
+      return pointcloud == nullptr || gather_pointcloud(*pointcloud, r_content);
+    }
+    case GEO_COMPONENT_TYPE_CURVE: {
+      const CurveComponent *curve_component = dynamic_cast<const CurveComponent *>(&component);
+      if (curve_component == nullptr) {
+        /* The legacy curve component is not supported. */
+        return false;
+      }
+      const Curves *curves = curve_component->get_for_read();
+      return curves == nullptr || gather_curves(*curves, r_content);
+    }
+    case GEO_COMPONENT_TYPE_INSTANCES: {
+      return gather_instances(static_cast<const InstancesComponent &>(component), r_content);
+    }
+    case GEO_COMPONENT_TYPE_VOLUME: {
+      /* Volume grids are not supported. */
+      return false;
+    }
+  }
+  return false;
+}
+
+static bool gather_geometry_set(const GeometrySet &geometry_set, GeometryContent &r_content)
+{
+  for (const GeometryComponent *component : geometry_set.get_components_for_read()) {
+    if (!gather_component(*component, r_content)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static std::optional<uint64_t> hash_component_content(const GeometryComponent &component)
+{
+  GeometryContent content;
+  if (!gather_component(component, content)) {
+    return std::nullopt;
+  }
+  return content.hash();
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Cache Storage
+ * \{ */
+
+struct CacheEntry {
+  /** Compared to the key of a lookup, because different keys can have the same hash. */
+  NodeCacheKey key;
+  /** Copies of the outputs of the node. The pointer is null for outputs that were not used. */
+  Vector<GMutablePointer> outputs;
+  /** Geometry components of the outputs whose hash has been registered in the cache. */
+  Vector<const GeometryComponent *> known_components;
+  int64_t memory = 0;
+  uint64_t last_use = 0;
+
+  ~CacheEntry()
+  {
+    for (GMutablePointer &value : outputs) {
+      if (value.get() != nullptr) {
+        value.destruct();
+        MEM_freeN(value.get());
+      }
+    }
+  }
+};
+
+struct NodeDuration {
+  std::chrono::microseconds duration;
+  uint64_t last_use;
+};
+
+struct KnownComponent {
+  uint64_t hash;
+  /** Number of cache entries that contain the component. */
+  int users;
+};
+
+class NodeOutputCache {
+ public:
+  /** Entries are shared, so that their key can be compared without locking the cache. */
+  Map<uint64_t, std::shared_ptr<CacheEntry>> entries;
+  /**
+   * Hashes of geometry components that are part of cached outputs. The cache keeps these
+   * components alive and they can't be modified while they are shared, so the address identifies
+   * the content. When the outputs of a cached node are passed to another node, hashing its
+   * inputs is very cheap.
+   */
+  Map<const GeometryComponent *, KnownComponent> known_components;
+  /** Last execution time of nodes that ran since the cache was cleared. */
+  Map<uint64_t, NodeDuration> node_durations;
+  int64_t memory = 0;
+  uint64_t use_counter = 0;
+
+  void remove_entry(const uint64_t hash)
+  {
+    std::shared_ptr<CacheEntry> entry = entries.pop(hash);
+    for (const GeometryComponent *component : entry->known_components) {
+      KnownComponent &known_component = known_components.lookup(component);
+      if (--known_component.users == 0) {
+        known_components.remove_contained(component);
+      }
+    }
+    memory -= entry->memory;
+  }
+
+  void remove_least_recently_used_entries(const int64_t memory_limit)
+  {
+    while (memory > memory_limit && !entries.is_empty()) {
+      uint64_t oldest_hash = 0;
+      uint64_t oldest_use = UINT64_MAX;
+      for (const auto item : entries.items()) {
+        if (item.value->last_use < oldest_use) {
+          oldest_hash = item.key;
+          oldest_use = item.value->last_use;
+        }
+      }
+      this->remove_entry(oldest_hash);
+    }
+  }
+
+  /**
+   * Forget the durations of the least recently used half of the nodes. The durations of nodes
+   * that were not used for a long time would otherwise accumulate, e.g. when a value of a node
+   * is animated.
+   */
+  void remove_least_recently_used_node_durations()
+  {
+    Vector<uint64_t> last_uses;
+    last_uses.reserve(node_durations.size());
+    for (const NodeDuration &node_duration : node_durations.values()) {
+      last_uses.append(node_duration.last_use);
+    }
+    uint64_t *middle = last_uses.begin() + last_uses.size() / 2;
+    std::nth_element(last_uses.begin(), middle, last_uses.end());
+    const uint64_t min_last_use = *middle;
+
+    Vector<uint64_t> hashes_to_remove;
+    for (const auto item : node_durations.items()) {
+      if (item.value.last_use < min_last_use) {
+        hashes_to_remove.append(item.key);
+      }
+    }
+    for (const uint64_t hash : hashes_to_remove) {
+      node_durations.remove_contained(hash);
+    }
+  }
+};
+
+/** Protects all access to the cache, it is used by multiple threads during evaluation. */
+static std::mutex g_cache_mutex;
+/**
+ * Allocated when the cache is used first, so that nothing is left at exit after #clear. The
+ * pointer is only checked without locking the mutex in #is_enabled.
+ */
+static std::atomic<NodeOutputCache *> g_cache = nullptr;
+
+static int64_t memory_limit()
+{
+  return int64_t(U.geometry_nodes_cache_limit) * 1024 * 1024;
+}
+
+bool is_enabled()
+{
+  if (memory_limit() > 0) {
+    return true;
+  }
+  if (g_cache != nullptr) {
+    /* The cache has been disabled in the preferences. */
+    clear();
+  }
+  return false;
+}
+
+void clear()
+{
+  std::lock_guard lock{g_cache_mutex};
+  delete g_cache.load();
+  g_cache = nullptr;
+}
+
+void update_limit()
+{
+  const int64_t limit = memory_limit();
+  if (limit == 0) {
+    clear();
+    return;
+  }
+  std::lock_guard lock{g_cache_mutex};
+  if (g_cache != nullptr) {
+    g_cache.load()->remove_least_recently_used_entries(limit);
+  }
+}
+
+static std::optional<uint64_t> hash_component(const GeometryComponent &component)
+{
+  {
+    std::lock_guard lock{g_cache_mutex};
+    if (g_cache != nullptr) {
+      if (const KnownComponent *known_component = g_cache.load()->known_components.lookup_ptr(
+              &component)) {
+        return known_component->hash;
+      }
+    }
+  }
+  return hash_component_content(component);
+}
+
+static std::optional<uint64_t> hash_geometry_set(const GeometrySet &geometry_set)
+{
+  uint64_t hash = 0;
+  for (const GeometryComponent *component : geometry_set.get_components_for_read()) {
+    const std::optional<uint64_t> component_hash = hash_component(*component);
+    if (!component_hash) {
+      return std::nullopt;
+    }
+    hash = hash_combine(hash, *component_hash);
+  }
+  return hash;
+}
+
+static int64_t custom_data_memory(const CustomData &data, const int size)
+{
+  int64_t memory = 0;
+  for (const CustomDataLayer &layer : Span(data.layers, data.totlayer)) {
+    memory += int64_t(CustomData_sizeof(layer.type)) * size;
+  }
+  return memory;
+}
+
+static int64_t geometry_set_memory(const GeometrySet &geometry_set)
+{
+  int64_t memory = sizeof(GeometrySet);
+  if (const Mesh *mesh = geometry_set.get_mesh_for_read()) {
+    memory += custom_data_memory(mesh->vdata, mesh->totvert);
+    memory += custom_data_memory(mesh->edata, mesh->totedge);
+    memory += custom_data_memory(mesh->ldata, mesh->totloop);
+    memory += custom_data_memory(mesh->pdata, mesh->totpoly);
+  }
+  if (const PointCloud *pointcloud = geometry_set.get_pointcloud_for_read()) {
+    memory += custom_data_memory(pointcloud->pdata, pointcloud->totpoint);
+  }
+  if (const Curves *curves = geometry_set.get_curves_for_read()) {
+    memory += custom_data_memory(curves->geometry.point_data, curves->geometry.point_size);
+    memory += custom_data_memory(curves->geometry.curve_data, curves->geometry.curve_size);
+  }
+  if (const InstancesComponent *instances =
+          geometry_set.get_component_for_read<InstancesComponent>()) {
+    memory += int64_t(sizeof(float4x4) + sizeof(int)) * instances->instances_amount();
+    memory += custom_data_memory(instances->attributes().data, instances->instances_amount());
+    instances->foreach_referenced_geometry([&](const GeometrySet &instance_geometry) {
+      memory += geometry_set_memory(instance_geometry);
+    });
+  }
+  return memory;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Cache Keys
+ * \{ */
+
+/**
+ * Check whether a DNA struct only contains plain values, so that it can be compared by value.
+ * Data that is referenced with pointers would have to be compared too.
+ */
+static bool dna_struct_is_plain_data(const SDNA &sdna, const int struct_nr)
+{
+  const SDNA_Struct &sdna_struct = *sdna.structs[struct_nr];
+  for (const int i : IndexRange(sdna_struct.members_len)) {
+    const SDNA_StructMember &member = sdna_struct.members[i];
+    if (strchr(sdna.names[member.name], '*') != nullptr) {
+      return false;
+    }
+    const int member_struct_nr = DNA_struct_find_nr(&sdna, sdna.types[member.type]);
+    if (member_struct_nr != -1 && !dna_struct_is_plain_data(sdna, member_struct_nr)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/** \return The size of the node storage, or nothing when it can't be compared by value. */
+static std::optional<int64_t> node_storage_size(const bNode &bnode)
+{
+  if (bnode.storage == nullptr) {
+    return 0;
+  }
+  const SDNA *sdna = DNA_sdna_current_get();
+  const int struct_nr = DNA_struct_find_nr(sdna, bnode.typeinfo->storagename);
+  if (struct_nr == -1 || !dna_struct_is_plain_data(*sdna, struct_nr)) {
+    return std::nullopt;
+  }
+  return sdna->types_size[sdna->structs[struct_nr]->type];
+}
+
+static bool node_supports_caching(const DNode node)
+{
+  const bNodeType &typeinfo = *node->typeinfo();
+  if (typeinfo.geometry_node_execute == nullptr ||
+      typeinfo.geometry_node_execute_supports_laziness) {
+    return false;
+  }
+  /* The data of a referenced ID can change without changing the node. */
+  if (node->bnode()->id != nullptr || !node_storage_size(*node->bnode())) {
+    return false;
+  }
+  /* Only nodes that compute a geometry based on another geometry are cached. Other nodes are
+   * either cheap or depend on data that isn't passed in as input. */
+  bool has_geometry_input = false;
+  for (const InputSocketRef *socket : node->inputs()) {
+    if (!socket->is_available()) {
+      continue;
+    }
+    switch (socket->bsocket()->type) {
+      case SOCK_GEOMETRY:
+        has_geometry_input = true;
+        break;
+      case SOCK_OBJECT:
+      case SOCK_COLLECTION:
+      case SOCK_IMAGE:
+      case SOCK_TEXTURE:
+        /* The referenced data can change without changing the input value. */
+        return false;
+    }
+  }
+  if (!has_geometry_input) {
+    return false;
+  }
+  for (const OutputSocketRef *socket : node->outputs()) {
+    if (socket->is_available() && socket->bsocket()->type == SOCK_GEOMETRY) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template<typename T> static void append_value(Vector<char> &data, const T &value)
+{
+  data.extend(Span(reinterpret_cast<const char *>(&value), sizeof(T)));
+}
+
+static void append_string(Vector<char> &data, const StringRef str)
+{
+  append_value(data, str.size());
+  data.extend(Span(str.data(), str.size()));
+}
+
+/** Append the settings of the node and its context in node groups to the key data. */
+static void append_node_data(const DNode node, Vector<char> &data)
+{
+  const bNode &bnode = *node->bnode();
+  append_string(data, bnode.idname);
+  append_string(data, bnode.name);
+  append_value(data, bnode.custom1);
+  append_value(data, bnode.custom2);
+  append_value(data, bnode.custom3);
+  append_value(data, bnode.custom4);
+  /* The storage is compared by value, it is allocated cleared, so padding is zero. */
+  const int64_t storage_size = *node_storage_size(bnode);
+  data.extend(Span(static_cast<const char *>(bnode.storage), storage_size));
+  /* Identify the node group instance that contains the node. */
+  for (const DTreeContext *context = node.context(); context != nullptr;
+       context = context->parent_context()) {
+    append_value(data, context->tree().btree()->id.session_uuid);
+    if (const NodeRef *parent_node = context->parent_node()) {
+      append_string(data, parent_node->bnode()->name);
+    }
+  }
+}
+
+bool operator==(const NodeCacheKey &a, const NodeCacheKey &b)
+{
+  if (a.hash != b.hash || a.node_hash != b.node_hash || a.data != b.data ||
+      a.fields != b.fields || a.geometry_hashes != b.geometry_hashes ||
+      a.values.size() != b.values.size()) {
+    return false;
+  }
+  for (const int i : a.values.index_range()) {
+    const CPPType &type = a.values[i].type();
+    if (type != b.values[i].type() || !type.is_equal(a.values[i][0], b.values[i][0])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+NodeCacheKeyBuilder::NodeCacheKeyBuilder(const DNode node) : node_(node)
+{
+  is_valid_ = node_supports_caching(node);
+  if (is_valid_) {
+    append_node_data(node, key_.data);
+    key_.node_hash = hash_buffer(key_.data.data(), key_.data.size());
+    key_.hash = key_.node_hash;
+  }
+}
+
+bool NodeCacheKeyBuilder::is_valid() const
+{
+  return is_valid_;
+}
+
+DNode NodeCacheKeyBuilder::node() const
+{
+  return node_;
+}
+
+uint64_t NodeCacheKeyBuilder::node_hash() const
+{
+  return key_.node_hash;
+}
+
+void NodeCacheKeyBuilder::add_input(const DInputSocket socket, const GPointer value)
+{
+  if (!is_valid_) {
+    return;
+  }
+  const CPPType &type = *value.type();
+  append_value(key_.data, socket->index());
+  key_.hash = hash_combine(key_.hash, uint64_t(socket->index()));
+  if (socket->bsocket()->type == SOCK_GEOMETRY) {
+    const GeometrySet &geometry_set = *static_cast<const GeometrySet *>(value.get());
+    const std::optional<uint64_t> geometry_hash = hash_geometry_set(geometry_set);
+    if (!geometry_hash) {
+      is_valid_ = false;
+      return;
+    }
+    key_.hash = hash_combine(key_.hash, *geometry_hash);
+    key_.geometry_hashes.append(*geometry_hash);
+    return;
+  }
+  const CPPType *value_type = &type;
+  const void *value_ptr = value.get();
+  if (const ValueOrFieldCPPType *value_or_field_type = dynamic_cast<const ValueOrFieldCPPType *>(
+          &type)) {
+    if (value_or_field_type->is_field(value.get())) {
+      const GField &field = *value_or_field_type->get_field_ptr(value.get());
+      key_.hash = hash_combine(key_.hash, field.hash());
+      key_.fields.append(field);
+      return;
+    }
+    value_type = &value_or_field_type->base_type();
+    value_ptr = value_or_field_type->get_value_ptr(value.get());
+  }
+  if (!value_type->is_hashable() || !value_type->is_equality_comparable()) {
+    is_valid_ = false;
+    return;
+  }
+  key_.hash = hash_combine(key_.hash, value_type->hash(value_ptr));
+  key_.values.append(GArray<>(GSpan(*value_type, value_ptr, 1)));
+}
+
+void NodeCacheKeyBuilder::add_output_is_used(const bool is_used)
+{
+  append_value(key_.data, is_used);
+  key_.hash = hash_combine(key_.hash, uint64_t(is_used));
+}
+
+std::optional<NodeCacheKey> NodeCacheKeyBuilder::build()
+{
+  if (!is_valid_) {
+    return std::nullopt;
+  }
+  return std::move(key_);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Cache Access
+ * \{ */
+
+bool node_is_worth_caching(const uint64_t node_hash)
+{
+  std::lock_guard lock{g_cache_mutex};
+  if (g_cache == nullptr) {
+    return false;
+  }
+  NodeOutputCache &cache = *g_cache.load();
+  NodeDuration *node_duration = cache.node_durations.lookup_ptr(node_hash);
+  if (node_duration == nullptr) {
+    return false;
+  }
+  node_duration->last_use = ++cache.use_counter;
+  return node_duration->duration >= min_cached_node_duration;
+}
+
+void log_node_duration(const uint64_t node_hash, const std::chrono::microseconds duration)
+{
+  std::lock_guard lock{g_cache_mutex};
+  if (g_cache == nullptr) {
+    g_cache = new NodeOutputCache();
+  }
+  NodeOutputCache &cache = *g_cache.load();
+  cache.node_durations.add_overwrite(node_hash, {duration, ++cache.use_counter});
+  if (cache.node_durations.size() > max_node_durations) {
+    cache.remove_least_recently_used_node_durations();
+  }
+}
+
+bool lookup(const NodeCacheKey &key, FunctionRef<void(int output_index, GPointer value)> fn)
+{
+  std::shared_ptr<CacheEntry> entry;
+  {
+    std::lock_guard lock{g_cache_mutex};
+    if (g_cache == nullptr) {
+      return false;
+    }
+    entry = g_cache.load()->entries.lookup_default(key.hash, nullptr);
+  }
+  /* Comparing geometries can take a while, so it is done without locking the cache. The entry is
+   * kept alive by the shared pointer, and its key and outputs are not modified once it has been
+   * added. */
+  if (!entry || !(entry->key == key)) {
+    return false;
+  }
+  {
+    std::lock_guard lock{g_cache_mutex};
+    if (g_cache != nullptr) {
+      entry->last_use = ++g_cache.load()->use_counter;
+    }
+  }
+  for (const int i : entry->outputs.index_range()) {
+    if (entry->outputs[i].get() != nullptr) {
+      fn(i, entry->outputs[i]);
+    }
+  }
+  return true;
+}
+
+void add(NodeCacheKey key, const Span<GPointer> outputs)
+{
+  const int64_t limit = memory_limit();
+
+  /* Copy the outputs and hash the output geometry before locking the cache. */
+  std::shared_ptr<CacheEntry> entry = std::make_shared<CacheEntry>();
+  Vector<std::pair<const GeometryComponent *, uint64_t>> component_hashes;
+  for (const GPointer value : outputs) {
+    if (value.get() == nullptr) {
+      entry->outputs.append({});
+      continue;
+    }
+    const CPPType &type = *value.type();
+    void *buffer = MEM_mallocN_aligned(type.size(), type.alignment(), __func__);
+    type.copy_construct(value.get(), buffer);
+    entry->outputs.append({type, buffer});
+    entry->memory += type.size();
+
+    if (type.is<GeometrySet>()) {
+      GeometrySet &geometry_set = *static_cast<GeometrySet *>(buffer);
+      /* Data that is owned by something else (e.g. an object) may be freed. */
+      geometry_set.ensure_owns_direct_data();
+      entry->memory += geometry_set_memory(geometry_set);
+      for (const GeometryComponent *component : geometry_set.get_components_for_read()) {
+        if (const std::optional<uint64_t> hash = hash_component(*component)) {
+          component_hashes.append({component, *hash});
+        }
+      }
+    }
+  }
+  const uint64_t hash = key.hash;
+  entry->key = std::move(key);
+
+  std::lock_guard lock{g_cache_mutex};
+  if (g_cache == nullptr) {
+    g_cache = new NodeOutputCache();
+  }
+  NodeOutputCache &cache = *g_cache.load();
+  if (entry->memory > limit) {
+    return;
+  }
+  if (cache.entries.contains(hash)) {
+    /* Another thread may have added the same entry in the mean time, or a different key has the
+     * same hash. The new entry replaces the existing one either way. */
+    cache.remove_entry(hash);
+  }
+  for (const auto &[component, component_hash] : component_hashes) {
+    cache.known_components.lookup_or_add(component, {component_hash, 0}).users++;
+    entry->known_components.append(component);
+  }
+  entry->last_use = ++cache.use_counter;
+  cache.memory += entry->memory;
+  cache.entries.add_new(hash, std::move(entry));
+  cache.remove_least_recently_used_entries(limit);
+}
+
+int64_t entries_num()
+{
+  std::lock_guard lock{g_cache_mutex};
+  return g_cache == nullptr ? 0 : g_cache.load()->entries.size();
+}
+
+/** \} */
+
+}  // namespace blender::modifiers::geometry_nodes::node_cache
+
+void MOD_nodes_cache_free()
+{
+  blender::modifiers::geometry_nodes::node_cache::clear();
+}
+
+void MOD_nodes_cache_update_limit()
+{
+  blender::modifiers::geometry_nodes::node_cache::update_limit();
+}
@@ -0,0 +1,114 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup modifiers
+ *
+ * Cache for the outputs of expensive geometry nodes that is kept between evaluations of node
+ * trees. An entry is identified by a hash of the node, its settings and all of its input values,
+ * so unchanged parts of a node tree don't have to be recomputed when only a later node changes
+ * or when a frame is evaluated again.
+ *
+ * Geometry inputs are hashed by their content, unless they were output by another cached node.
+ * Their hash is known already in that case. Nodes that depend on data that isn't part of their
+ * inputs (like objects or collections) are never cached. On a cache hit, the key is compared by
+ * value as well. Only the content hash of input geometries is part of the key, keeping a
+ * reference to them would make nodes copy geometry that they could otherwise modify in place.
+ *
+ * The cache is disabled when #UserDef.geometry_nodes_cache_limit is zero. Least recently used
+ * entries are removed when the limit is exceeded.
+ */
+
+#include <chrono>
+#include <optional>
+
+#include "BLI_function_ref.hh"
+#include "BLI_generic_array.hh"
+#include "BLI_generic_pointer.hh"
+#include "BLI_vector.hh"
+
+#include "BKE_geometry_set.hh"
+
+#include "FN_field.hh"
+
+#include "NOD_derived_node_tree.hh"
+
+namespace blender::modifiers::geometry_nodes::node_cache {
+
+using nodes::DInputSocket;
+using nodes::DNode;
+
+/**
+ * Identifies one evaluation of a node. The hash is used to find cache entries, the other data is
+ * compared to the key of an entry as well, so that a hash collision can't give wrong outputs.
+ */
+struct NodeCacheKey {
+  /** Hash of the node and its settings. */
+  uint64_t node_hash = 0;
+  /** Hash of all data below. */
+  uint64_t hash = 0;
+  /** Settings of the node, its context in node groups and the layout of the inputs. */
+  Vector<char> data;
+  /** Copies of the input values that are not geometries or fields. */
+  Vector<GArray<>> values;
+  /** Fields are compared by identity. They are kept alive, so that the address isn't reused. */
+  Vector<fn::GField> fields;
+  /** Content hashes of the geometry inputs. */
+  Vector<uint64_t> geometry_hashes;
+};
+
+bool operator==(const NodeCacheKey &a, const NodeCacheKey &b);
+
+class NodeCacheKeyBuilder {
+ private:
+  DNode node_;
+  NodeCacheKey key_;
+  bool is_valid_ = true;
+
+ public:
+  /** Start building a key for the node. Check #is_valid before adding inputs. */
+  NodeCacheKeyBuilder(DNode node);
+
+  bool is_valid() const;
+  DNode node() const;
+  uint64_t node_hash() const;
+
+  void add_input(DInputSocket socket, GPointer value);
+  void add_output_is_used(bool is_used);
+
+  /** \return Nothing when one of the inputs can't be hashed. */
+  std::optional<NodeCacheKey> build();
+};
+
+/** The cache does nothing when this is false. */
+bool is_enabled();
+
+/**
+ * Hashing the inputs of a node costs time, so only nodes that were expensive before are cached.
+ */
+bool node_is_worth_caching(uint64_t node_hash);
+void log_node_duration(uint64_t node_hash, std::chrono::microseconds duration);
+
+/**
+ * Call the callback with a copy of every output that was cached for the key.
+ * \return False if there is no cache entry for the key.
+ */
+bool lookup(const NodeCacheKey &key, FunctionRef<void(int output_index, GPointer value)> fn);
+
+/**
+ * Add the outputs of a node to the cache. The values are copied. Outputs that are not used can be
+ * null.
+ */
+void add(NodeCacheKey key, Span<GPointer> outputs);
+
+/** Free all cache entries. */
+void clear();
+
+/** Apply a changed #UserDef.geometry_nodes_cache_limit to the existing entries. */
+void update_limit();
+
+/** Number of cache entries, for testing. */
+int64_t entries_num();
+
+}  // namespace blender::modifiers::geometry_nodes::node_cache
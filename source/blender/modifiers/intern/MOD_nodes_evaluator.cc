@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: GPL-2.0-or-later */
 
+#include "MOD_nodes_cache.hh"
 #include "MOD_nodes_evaluator.hh"
 
 #include "BKE_type_conversions.hh"
@@ -23,6 +24,7 @@
 #include "BLI_vector_set.hh"
 
 #include <chrono>
+#include <optional>
 
 namespace blender::modifiers::geometry_nodes {
 
@@ -413,6 +415,12 @@ class NodeParamsProvider : public nodes::GeoNodeExecParamsProvider {
   NodeTaskRunState *run_state_;
 
  public:
+  /**
+   * When not empty, a copy of every output value is stored here before it is forwarded, so that
+   * the outputs can be added to the node cache after the node has been executed.
+   */
+  Vector<GMutablePointer> captured_outputs;
+
   NodeParamsProvider(GeometryNodesEvaluator &evaluator,
                      DNode dnode,
                      NodeState &node_state,
@@ -432,6 +440,9 @@ class NodeParamsProvider : public nodes::GeoNodeExecParamsProvider {
   bool lazy_output_is_required(StringRef identifier) const override;
 
   void set_default_remaining_outputs() override;
+
+ private:
+  void capture_output(int index, GPointer value);
 };
 
 class GeometryNodesEvaluator {
@@ -981,6 +992,33 @@ class GeometryNodesEvaluator {
     const bNode &bnode = *node->bnode();
 
     NodeParamsProvider params_provider{*this, node, node_state, run_state};
+
+    /* The cache only contains nodes whose last execution was expensive, so the duration of
+     * cacheable nodes is logged even when the inputs are not hashed. */
+    std::optional<uint64_t> node_hash;
+    std::optional<node_cache::NodeCacheKey> cache_key;
+    if (node_cache::is_enabled()) {
+      node_cache::NodeCacheKeyBuilder cache_key_builder{node};
+      if (cache_key_builder.is_valid()) {
+        node_hash = cache_key_builder.node_hash();
+        if (node_cache::node_is_worth_caching(*node_hash)) {
+          cache_key = this->build_node_cache_key(cache_key_builder, node_state);
+        }
+      }
+      if (cache_key) {
+        if (this->try_use_cached_outputs(*cache_key, params_provider)) {
+          return;
+        }
+        params_provider.captured_outputs.resize(node->outputs().size());
+      }
+    }
+
+    /* Only measure field inputs separately when the timings are shown in the node editor. */
+    std::optional<fn::FieldInputTimings> field_input_timings;
+    if (params_.geo_logger != nullptr) {
+      field_input_timings.emplace();
+    }
+
     GeoNodeExecParams params{params_provider};
     Clock::time_point begin = Clock::now();
     bnode.typeinfo->geometry_node_execute(params);
@@ -988,8 +1026,70 @@ class GeometryNodesEvaluator {
     const std::chrono::microseconds duration =
         std::chrono::duration_cast<std::chrono::microseconds>(end - begin);
     if (params_.geo_logger != nullptr) {
-      params_.geo_logger->local().log_execution_time(node, duration);
+      geo_log::LocalGeoLogger &local_logger = params_.geo_logger->local();
+      local_logger.log_execution_time(node, duration);
+      for (const fn::FieldInputTimings::Item &item : field_input_timings->items()) {
+        local_logger.log_field_input_time(
+            node, item.name, std::chrono::duration_cast<std::chrono::microseconds>(item.duration));
+      }
+    }
+
+    if (node_hash) {
+      node_cache::log_node_duration(*node_hash, duration);
+    }
+    if (cache_key) {
+      Vector<GPointer> outputs;
+      for (const GMutablePointer value : params_provider.captured_outputs) {
+        outputs.append(value);
+      }
+      node_cache::add(std::move(*cache_key), outputs);
+      for (GMutablePointer value : params_provider.captured_outputs) {
+        if (value.get() != nullptr) {
+          value.destruct();
+        }
+      }
+    }
+  }
+
+  std::optional<node_cache::NodeCacheKey> build_node_cache_key(
+      node_cache::NodeCacheKeyBuilder &builder, const NodeState &node_state)
+  {
+    const DNode node = builder.node();
+    for (const int i : node->inputs().index_range()) {
+      const InputState &input_state = node_state.inputs[i];
+      if (input_state.type == nullptr) {
+        continue;
+      }
+      const DInputSocket socket = node.input(i);
+      if (socket->is_multi_input_socket()) {
+        for (const void *value : input_state.value.multi->values) {
+          builder.add_input(socket, {input_state.type, value});
+        }
+      }
+      else {
+        builder.add_input(socket, {input_state.type, input_state.value.single->value});
+      }
     }
+    for (const OutputState &output_state : node_state.outputs) {
+      builder.add_output_is_used(output_state.output_usage_for_execution != ValueUsage::Unused);
+    }
+    return builder.build();
+  }
+
+  /**
+   * Set the outputs of the node to the values from the node cache.
+   * \return False when the cache contains no outputs for the key.
+   */
+  bool try_use_cached_outputs(const node_cache::NodeCacheKey &cache_key,
+                              NodeParamsProvider &params_provider)
+  {
+    const DNode node = params_provider.dnode;
+    return node_cache::lookup(cache_key, [&](const int output_index, const GPointer value) {
+      const DOutputSocket socket = node.output(output_index);
+      GMutablePointer output = params_provider.alloc_output_value(*value.type());
+      value.type()->copy_construct(value.get(), output.get());
+      params_provider.set_output(socket->identifier(), output);
+    });
   }
 
   void execute_multi_function_node(const DNode node,
@@ -1839,6 +1939,7 @@ void NodeParamsProvider::set_output(StringRef identifier, GMutablePointer value)
 
   OutputState &output_state = node_state_.outputs[socket->index()];
   BLI_assert(!output_state.has_been_computed);
+  this->capture_output(socket->index(), value);
   evaluator_.forward_output(socket, value, run_state_);
   output_state.has_been_computed = true;
 }
@@ -1916,11 +2017,23 @@ void NodeParamsProvider::set_default_remaining_outputs()
     BLI_assert(type != nullptr);
     void *buffer = allocator.allocate(type->size(), type->alignment());
     type->value_initialize(buffer);
+    this->capture_output(i, {type, buffer});
     evaluator_.forward_output(socket, {type, buffer}, run_state_);
     output_state.has_been_computed = true;
   }
 }
 
+void NodeParamsProvider::capture_output(const int index, const GPointer value)
+{
+  if (captured_outputs.is_empty()) {
+    return;
+  }
+  const CPPType &type = *value.type();
+  GMutablePointer copy = this->alloc_output_value(type);
+  type.copy_construct(value.get(), copy.get());
+  captured_outputs[index] = copy;
+}
+
 void evaluate_geometry_nodes(GeometryNodesEvaluationParams &params)
 {
   GeometryNodesEvaluator evaluator{params};
@@ -0,0 +1,162 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+
+#include "BKE_idtype.h"
+#include "BKE_mesh.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_userdef_types.h"
+
+#include "MOD_nodes_cache.hh"
+
+namespace blender::modifiers::geometry_nodes::node_cache::tests {
+
+class node_cache : public testing::Test {
+ protected:
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+
+  void SetUp() override
+  {
+    U.geometry_nodes_cache_limit = 1;
+  }
+
+  void TearDown() override
+  {
+    clear();
+    U.geometry_nodes_cache_limit = 0;
+  }
+};
+
+/** A mesh with vertices at the given X coordinates. */
+static GeometrySet create_geometry(const Span<float> xs)
+{
+  Mesh *mesh = BKE_mesh_new_nomain(xs.size(), 0, 0, 0, 0);
+  for (const int i : xs.index_range()) {
+    mesh->mvert[i].co[0] = xs[i];
+  }
+  return GeometrySet::create_with_mesh(mesh);
+}
+
+static NodeCacheKey create_key(const uint64_t hash,
+                               const int value,
+                               const uint64_t geometry_hash = 0)
+{
+  NodeCacheKey key;
+  key.node_hash = 1;
+  key.hash = hash;
+  key.data.append('a');
+  key.values.append(GArray<>(GSpan(CPPType::get<int>(), &value, 1)));
+  key.geometry_hashes.append(geometry_hash);
+  return key;
+}
+
+static void add_int(NodeCacheKey key, const int output)
+{
+  const Array<GPointer> outputs = {GPointer(&output)};
+  add(std::move(key), outputs);
+}
+
+/** Add an entry whose outputs contain a geometry, which uses most of the memory of the entry. */
+static void add_int_with_geometry(NodeCacheKey key, const int output, const GeometrySet &geometry)
+{
+  const Array<GPointer> outputs = {GPointer(&output), GPointer(&geometry)};
+  add(std::move(key), outputs);
+}
+
+static std::optional<int> lookup_int(const NodeCacheKey &key)
+{
+  std::optional<int> result;
+  if (!lookup(key, [&](const int index, const GPointer value) {
+        if (index == 0) {
+          result = *value.get<int>();
+        }
+      })) {
+    return std::nullopt;
+  }
+  return result;
+}
+
+TEST_F(node_cache, Hit)
+{
+  add_int(create_key(10, 3, 5), 42);
+  EXPECT_EQ(entries_num(), 1);
+  EXPECT_EQ(lookup_int(create_key(10, 3, 5)), 42);
+}
+
+TEST_F(node_cache, Miss)
+{
+  add_int(create_key(10, 3, 5), 42);
+  EXPECT_EQ(lookup_int(create_key(11, 3, 5)), std::nullopt);
+  /* The keys are compared on a hit, a hash collision must not return the outputs. */
+  EXPECT_EQ(lookup_int(create_key(10, 4, 5)), std::nullopt);
+  EXPECT_EQ(lookup_int(create_key(10, 3, 6)), std::nullopt);
+  NodeCacheKey key = create_key(10, 3, 5);
+  key.data.append('b');
+  EXPECT_EQ(lookup_int(key), std::nullopt);
+
+  /* A colliding key replaces the existing entry. */
+  add_int(create_key(10, 4, 5), 43);
+  EXPECT_EQ(entries_num(), 1);
+  EXPECT_EQ(lookup_int(create_key(10, 4, 5)), 43);
+  EXPECT_EQ(lookup_int(create_key(10, 3, 5)), std::nullopt);
+}
+
+TEST_F(node_cache, EvictLeastRecentlyUsed)
+{
+  /* Every entry keeps a geometry of about 0.4 MB, only two fit into the limit of 1 MB. */
+  const Array<float> xs(25000, 0.0f);
+  add_int_with_geometry(create_key(1, 0), 1, create_geometry(xs));
+  add_int_with_geometry(create_key(2, 0), 2, create_geometry(xs));
+  EXPECT_EQ(entries_num(), 2);
+  EXPECT_EQ(lookup_int(create_key(1, 0)), 1);
+
+  add_int_with_geometry(create_key(3, 0), 3, create_geometry(xs));
+  EXPECT_EQ(entries_num(), 2);
+  EXPECT_EQ(lookup_int(create_key(1, 0)), 1);
+  EXPECT_EQ(lookup_int(create_key(2, 0)), std::nullopt);
+  EXPECT_EQ(lookup_int(create_key(3, 0)), 3);
+}
+
+TEST_F(node_cache, Disabled)
+{
+  add_int(create_key(10, 3), 42);
+  U.geometry_nodes_cache_limit = 0;
+  EXPECT_FALSE(is_enabled());
+  EXPECT_EQ(entries_num(), 0);
+}
+
+TEST_F(node_cache, UpdateLimit)
+{
+  const Array<float> xs(25000, 0.0f);
+  add_int_with_geometry(create_key(1, 0), 1, create_geometry(xs));
+  add_int_with_geometry(create_key(2, 0), 2, create_geometry(xs));
+  EXPECT_EQ(entries_num(), 2);
+
+  /* Disabling the cache frees the entries right away, not only when a node is evaluated. */
+  U.geometry_nodes_cache_limit = 0;
+  update_limit();
+  EXPECT_EQ(entries_num(), 0);
+}
+
+TEST_F(node_cache, NodeDurationsAreBounded)
+{
+  const std::chrono::microseconds duration{10000};
+  log_node_duration(0, duration);
+  for (const int i : IndexRange(1, 1 << 16)) {
+    log_node_duration(uint64_t(i), duration);
+    /* Nodes that are checked on every evaluation are not forgotten. */
+    EXPECT_TRUE(node_is_worth_caching(0));
+  }
+  EXPECT_TRUE(node_is_worth_caching(1 << 16));
+  /* The nodes that were used least recently are forgotten. */
+  EXPECT_FALSE(node_is_worth_caching(1));
+}
+
+}  // namespace blender::modifiers::geometry_nodes::node_cache::tests
@@ -162,6 +162,17 @@ struct NodeWithDebugMessage {
   std::string message;
 };
 
+/** Time it took to retrieve a field input while the node was executed. */
+struct FieldInputTime {
+  std::string name;
+  std::chrono::microseconds exec_time;
+};
+
+struct NodeWithFieldInputTime {
+  DNode node;
+  FieldInputTime time;
+};
+
 /** The same value can be referenced by multiple sockets when they are linked. */
 struct ValueOfSockets {
   Span<DSocket> sockets;
@@ -184,6 +195,7 @@ class LocalGeoLogger {
   Vector<NodeWithWarning> node_warnings_;
   Vector<NodeWithExecutionTime> node_exec_times_;
   Vector<NodeWithDebugMessage> node_debug_messages_;
+  Vector<NodeWithFieldInputTime> node_field_input_times_;
 
   friend ModifierLog;
 
@@ -197,6 +209,7 @@ class LocalGeoLogger {
   void log_multi_value_socket(DSocket socket, Span<GPointer> values);
   void log_node_warning(DNode node, NodeWarningType type, std::string message);
   void log_execution_time(DNode node, std::chrono::microseconds exec_time);
+  void log_field_input_time(DNode node, std::string name, std::chrono::microseconds exec_time);
   /**
    * Log a message that will be displayed in the node editor next to the node.
    * This should only be used for debugging purposes and not to display information to users.
@@ -276,6 +289,7 @@ class NodeLog {
   Vector<SocketLog> output_logs_;
   Vector<NodeWarning, 0> warnings_;
   Vector<std::string, 0> debug_messages_;
+  Vector<FieldInputTime, 0> field_input_times_;
   std::chrono::microseconds exec_time_;
 
   friend ModifierLog;
@@ -310,6 +324,11 @@ class NodeLog {
     return exec_time_;
   }
 
+  Span<FieldInputTime> field_input_times() const
+  {
+    return field_input_times_;
+  }
+
   Vector<const GeometryAttributeInfo *> lookup_available_attributes() const;
 };
 
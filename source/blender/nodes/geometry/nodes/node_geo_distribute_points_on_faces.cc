@@ -1,10 +1,8 @@
 /* SPDX-License-Identifier: GPL-2.0-or-later */
 
-#include "BLI_kdtree.h"
 #include "BLI_noise.hh"
 #include "BLI_rand.hh"
 #include "BLI_task.hh"
-#include "BLI_timeit.hh"
 
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
@@ -17,6 +15,8 @@
 #include "BKE_mesh_sample.hh"
 #include "BKE_pointcloud.h"
 
+#include "GEO_point_elimination.hh"
+
 #include "UI_interface.h"
 #include "UI_resources.h"
 
@@ -97,6 +97,11 @@ static float3 normal_to_euler_rotation(const float3 normal)
   return rotation;
 }
 
+/**
+ * Every triangle has its own random number generator, seeded with its index. That makes the points
+ * independent of the order in which triangles are sampled, so they can be sampled in parallel.
+ * The number of points of every triangle is computed first, to find where its points are stored.
+ */
 static void sample_mesh_surface(const Mesh &mesh,
                                 const float base_density,
                                 const Span<float> density_factors,
@@ -108,17 +113,15 @@ static void sample_mesh_surface(const Mesh &mesh,
   const Span<MLoopTri> looptris{BKE_mesh_runtime_looptri_ensure(&mesh),
                                 BKE_mesh_runtime_looptri_len(&mesh)};
 
-  for (const int looptri_index : looptris.index_range()) {
+  /* Initialize the random number generator of the triangle and return its number of points. */
+  auto looptri_points_num = [&](const int looptri_index, RandomNumberGenerator &r_rng) {
     const MLoopTri &looptri = looptris[looptri_index];
     const int v0_loop = looptri.tri[0];
     const int v1_loop = looptri.tri[1];
     const int v2_loop = looptri.tri[2];
-    const int v0_index = mesh.mloop[v0_loop].v;
-    const int v1_index = mesh.mloop[v1_loop].v;
-    const int v2_index = mesh.mloop[v2_loop].v;
-    const float3 v0_pos = float3(mesh.mvert[v0_index].co);
-    const float3 v1_pos = float3(mesh.mvert[v1_index].co);
-    const float3 v2_pos = float3(mesh.mvert[v2_index].co);
+    const float3 v0_pos = float3(mesh.mvert[mesh.mloop[v0_loop].v].co);
+    const float3 v1_pos = float3(mesh.mvert[mesh.mloop[v1_loop].v].co);
+    const float3 v2_pos = float3(mesh.mvert[mesh.mloop[v2_loop].v].co);
 
     float looptri_density_factor = 1.0f;
     if (!density_factors.is_empty()) {
@@ -129,70 +132,49 @@ static void sample_mesh_surface(const Mesh &mesh,
     }
     const float area = area_tri_v3(v0_pos, v1_pos, v2_pos);
 
-    const int looptri_seed = noise::hash(looptri_index, seed);
-    RandomNumberGenerator looptri_rng(looptri_seed);
-
-    const int point_amount = looptri_rng.round_probabilistic(area * base_density *
-                                                             looptri_density_factor);
+    r_rng.seed(noise::hash(looptri_index, seed));
+    return r_rng.round_probabilistic(area * base_density * looptri_density_factor);
+  };
 
-    for (int i = 0; i < point_amount; i++) {
-      const float3 bary_coord = looptri_rng.get_barycentric_coordinates();
-      float3 point_pos;
-      interp_v3_v3v3v3(point_pos, v0_pos, v1_pos, v2_pos, bary_coord);
-      r_positions.append(point_pos);
-      r_bary_coords.append(bary_coord);
-      r_looptri_indices.append(looptri_index);
+  Array<int> offsets(looptris.size() + 1);
+  threading::parallel_for(looptris.index_range(), 1024, [&](const IndexRange range) {
+    RandomNumberGenerator looptri_rng;
+    for (const int looptri_index : range) {
+      offsets[looptri_index] = looptri_points_num(looptri_index, looptri_rng);
     }
+  });
+  int points_num = 0;
+  for (const int looptri_index : looptris.index_range()) {
+    const int looptri_points_num = offsets[looptri_index];
+    offsets[looptri_index] = points_num;
+    points_num += looptri_points_num;
   }
-}
-
-BLI_NOINLINE static KDTree_3d *build_kdtree(Span<float3> positions)
-{
-  KDTree_3d *kdtree = BLI_kdtree_3d_new(positions.size());
-
-  int i_point = 0;
-  for (const float3 position : positions) {
-    BLI_kdtree_3d_insert(kdtree, i_point, position);
-    i_point++;
-  }
-
-  BLI_kdtree_3d_balance(kdtree);
-  return kdtree;
-}
-
-BLI_NOINLINE static void update_elimination_mask_for_close_points(
-    Span<float3> positions, const float minimum_distance, MutableSpan<bool> elimination_mask)
-{
-  if (minimum_distance <= 0.0f) {
-    return;
-  }
-
-  KDTree_3d *kdtree = build_kdtree(positions);
-  BLI_SCOPED_DEFER([&]() { BLI_kdtree_3d_free(kdtree); });
-
-  for (const int i : positions.index_range()) {
-    if (elimination_mask[i]) {
-      continue;
+  offsets.last() = points_num;
+
+  r_positions.resize(points_num);
+  r_bary_coords.resize(points_num);
+  r_looptri_indices.resize(points_num);
+
+  threading::parallel_for(looptris.index_range(), 1024, [&](const IndexRange range) {
+    RandomNumberGenerator looptri_rng;
+    for (const int looptri_index : range) {
+      const MLoopTri &looptri = looptris[looptri_index];
+      const float3 v0_pos = float3(mesh.mvert[mesh.mloop[looptri.tri[0]].v].co);
+      const float3 v1_pos = float3(mesh.mvert[mesh.mloop[looptri.tri[1]].v].co);
+      const float3 v2_pos = float3(mesh.mvert[mesh.mloop[looptri.tri[2]].v].co);
+
+      /* Generate the same random numbers as when counting the points. */
+      looptri_points_num(looptri_index, looptri_rng);
+
+      for (const int i : IndexRange(offsets[looptri_index],
+                                    offsets[looptri_index + 1] - offsets[looptri_index])) {
+        const float3 bary_coord = looptri_rng.get_barycentric_coordinates();
+        interp_v3_v3v3v3(r_positions[i], v0_pos, v1_pos, v2_pos, bary_coord);
+        r_bary_coords[i] = bary_coord;
+        r_looptri_indices[i] = looptri_index;
+      }
     }
-
-    struct CallbackData {
-      int index;
-      MutableSpan<bool> elimination_mask;
-    } callback_data = {i, elimination_mask};
-
-    BLI_kdtree_3d_range_search_cb(
-        kdtree,
-        positions[i],
-        minimum_distance,
-        [](void *user_data, int index, const float *UNUSED(co), float UNUSED(dist_sq)) {
-          CallbackData &callback_data = *static_cast<CallbackData *>(user_data);
-          if (index != callback_data.index) {
-            callback_data.elimination_mask[index] = true;
-          }
-          return true;
-        },
-        &callback_data);
-  }
+  });
 }
 
 BLI_NOINLINE static void update_elimination_mask_based_on_density_factors(
@@ -204,44 +186,71 @@ BLI_NOINLINE static void update_elimination_mask_based_on_density_factors(
 {
   const Span<MLoopTri> looptris{BKE_mesh_runtime_looptri_ensure(&mesh),
                                 BKE_mesh_runtime_looptri_len(&mesh)};
-  for (const int i : bary_coords.index_range()) {
-    if (elimination_mask[i]) {
-      continue;
-    }
+  threading::parallel_for(bary_coords.index_range(), 2048, [&](const IndexRange range) {
+    for (const int i : range) {
+      if (elimination_mask[i]) {
+        continue;
+      }
 
-    const MLoopTri &looptri = looptris[looptri_indices[i]];
-    const float3 bary_coord = bary_coords[i];
+      const MLoopTri &looptri = looptris[looptri_indices[i]];
+      const float3 bary_coord = bary_coords[i];
 
-    const int v0_loop = looptri.tri[0];
-    const int v1_loop = looptri.tri[1];
-    const int v2_loop = looptri.tri[2];
+      const int v0_loop = looptri.tri[0];
+      const int v1_loop = looptri.tri[1];
+      const int v2_loop = looptri.tri[2];
+
+      const float v0_density_factor = std::max(0.0f, density_factors[v0_loop]);
+      const float v1_density_factor = std::max(0.0f, density_factors[v1_loop]);
+      const float v2_density_factor = std::max(0.0f, density_factors[v2_loop]);
 
-    const float v0_density_factor = std::max(0.0f, density_factors[v0_loop]);
-    const float v1_density_factor = std::max(0.0f, density_factors[v1_loop]);
-    const float v2_density_factor = std::max(0.0f, density_factors[v2_loop]);
+      const float probablity = v0_density_factor * bary_coord.x +
+                               v1_density_factor * bary_coord.y +
+                               v2_density_factor * bary_coord.z;
 
-    const float probablity = v0_density_factor * bary_coord.x + v1_density_factor * bary_coord.y +
-                             v2_density_factor * bary_coord.z;
+      const float hash = noise::hash_float_to_float(bary_coord);
+      if (hash > probablity) {
+        elimination_mask[i] = true;
+      }
+    }
+  });
+}
 
-    const float hash = noise::hash_float_to_float(bary_coord);
-    if (hash > probablity) {
-      elimination_mask[i] = true;
+template<typename T>
+static void gather_values(const Span<int> indices, Vector<T> &values)
+{
+  Vector<T> new_values(indices.size());
+  threading::parallel_for(indices.index_range(), 4096, [&](const IndexRange range) {
+    for (const int i : range) {
+      new_values[i] = values[indices[i]];
     }
-  }
+  });
+  values = std::move(new_values);
 }
 
+/**
+ * Remove the eliminated points by moving the last point into their place, starting at the end.
+ * Only the new order is computed that way, the values are moved in parallel afterwards.
+ */
 BLI_NOINLINE static void eliminate_points_based_on_mask(const Span<bool> elimination_mask,
                                                         Vector<float3> &positions,
                                                         Vector<float3> &bary_coords,
                                                         Vector<int> &looptri_indices)
 {
+  Vector<int> indices(positions.size());
+  for (const int i : indices.index_range()) {
+    indices[i] = i;
+  }
   for (int i = positions.size() - 1; i >= 0; i--) {
     if (elimination_mask[i]) {
-      positions.remove_and_reorder(i);
-      bary_coords.remove_and_reorder(i);
-      looptri_indices.remove_and_reorder(i);
+      indices.remove_and_reorder(i);
     }
   }
+  if (indices.size() == positions.size()) {
+    return;
+  }
+  gather_values(indices.as_span(), positions);
+  gather_values(indices.as_span(), bary_coords);
+  gather_values(indices.as_span(), looptri_indices);
 }
 
 BLI_NOINLINE static void interpolate_attribute(const Mesh &mesh,
@@ -356,31 +365,33 @@ BLI_NOINLINE static void compute_attribute_outputs(const MeshComponent &mesh_com
   const Span<MLoopTri> looptris{BKE_mesh_runtime_looptri_ensure(&mesh),
                                 BKE_mesh_runtime_looptri_len(&mesh)};
 
-  for (const int i : bary_coords.index_range()) {
-    const int looptri_index = looptri_indices[i];
-    const MLoopTri &looptri = looptris[looptri_index];
-    const float3 &bary_coord = bary_coords[i];
-
-    const int v0_index = mesh.mloop[looptri.tri[0]].v;
-    const int v1_index = mesh.mloop[looptri.tri[1]].v;
-    const int v2_index = mesh.mloop[looptri.tri[2]].v;
-    const float3 v0_pos = float3(mesh.mvert[v0_index].co);
-    const float3 v1_pos = float3(mesh.mvert[v1_index].co);
-    const float3 v2_pos = float3(mesh.mvert[v2_index].co);
-
-    ids[i] = noise::hash(noise::hash_float(bary_coord), looptri_index);
-
-    float3 normal;
-    if (!normals.is_empty() || !rotations.is_empty()) {
-      normal_tri_v3(normal, v0_pos, v1_pos, v2_pos);
-    }
-    if (!normals.is_empty()) {
-      normals[i] = normal;
+  threading::parallel_for(bary_coords.index_range(), 2048, [&](const IndexRange range) {
+    for (const int i : range) {
+      const int looptri_index = looptri_indices[i];
+      const MLoopTri &looptri = looptris[looptri_index];
+      const float3 &bary_coord = bary_coords[i];
+
+      const int v0_index = mesh.mloop[looptri.tri[0]].v;
+      const int v1_index = mesh.mloop[looptri.tri[1]].v;
+      const int v2_index = mesh.mloop[looptri.tri[2]].v;
+      const float3 v0_pos = float3(mesh.mvert[v0_index].co);
+      const float3 v1_pos = float3(mesh.mvert[v1_index].co);
+      const float3 v2_pos = float3(mesh.mvert[v2_index].co);
+
+      ids[i] = noise::hash(noise::hash_float(bary_coord), looptri_index);
+
+      float3 normal;
+      if (!normals.is_empty() || !rotations.is_empty()) {
+        normal_tri_v3(normal, v0_pos, v1_pos, v2_pos);
+      }
+      if (!normals.is_empty()) {
+        normals[i] = normal;
+      }
+      if (!rotations.is_empty()) {
+        rotations[i] = normal_to_euler_rotation(normal);
+      }
     }
-    if (!rotations.is_empty()) {
-      rotations[i] = normal_to_euler_rotation(normal);
-    }
-  }
+  });
 
   id_attribute.save();
 
@@ -436,8 +447,9 @@ static void distribute_points_poisson_disk(const MeshComponent &mesh_component,
   const Mesh &mesh = *mesh_component.get_for_read();
   sample_mesh_surface(mesh, max_density, {}, seed, positions, bary_coords, looptri_indices);
 
+  /* Sampling is multi-threaded, but most of the elimination is not, see its description. */
   Array<bool> elimination_mask(positions.size(), false);
-  update_elimination_mask_for_close_points(positions, minimum_distance, elimination_mask);
+  geometry::eliminate_close_points(positions, minimum_distance, elimination_mask);
 
   const Array<float> density_factors = calc_full_density_factors_with_selection(
       mesh_component, density_factor_field, selection_field);
@@ -1,5 +1,8 @@
 /* SPDX-License-Identifier: GPL-2.0-or-later */
 
+#include "BLI_array.hh"
+#include "BLI_task.hh"
+
 #include "DNA_mesh_types.h"
 
 #include "BKE_attribute_math.hh"
@@ -140,7 +143,8 @@ static void raycast_to_mesh(IndexMask mask,
                             int &hit_count)
 {
   BVHTreeFromMesh tree_data;
-  BKE_bvhtree_from_mesh_get(&tree_data, &mesh, BVHTREE_FROM_LOOPTRI, 4);
+  /* Ray-casts are usually done for many rays, so a slower build is worth it. */
+  BKE_bvhtree_from_mesh_get_ex(&tree_data, &mesh, BVHTREE_FROM_LOOPTRI, 4, BVH_BALANCE_SAH);
   BLI_SCOPED_DEFER([&]() { free_bvhtree_from_mesh(&tree_data); });
 
   if (tree_data.tree == nullptr) {
@@ -149,21 +153,36 @@ static void raycast_to_mesh(IndexMask mask,
   /* We shouldn't be rebuilding the BVH tree when calling this function in parallel. */
   BLI_assert(tree_data.cached);
 
-  for (const int i : mask) {
-    const float ray_length = ray_lengths[i];
-    const float3 ray_origin = ray_origins[i];
-    const float3 ray_direction = math::normalize(ray_directions[i]);
-
-    BVHTreeRayHit hit;
-    hit.index = -1;
-    hit.dist = ray_length;
-    if (BLI_bvhtree_ray_cast(tree_data.tree,
-                             ray_origin,
-                             ray_direction,
+  /* Cast all rays together, which is faster than casting them one by one because rays with
+   * similar origins and directions share the traversal of the tree. */
+  const int rays_num = mask.size();
+  Array<float3> origins(rays_num);
+  Array<float3> directions(rays_num);
+  Array<BVHTreeRayHit> hits(rays_num);
+  threading::parallel_for(IndexRange(rays_num), 4096, [&](const IndexRange range) {
+    for (const int64_t mask_index : range) {
+      const int i = mask[mask_index];
+      origins[mask_index] = ray_origins[i];
+      directions[mask_index] = math::normalize(ray_directions[i]);
+      hits[mask_index].index = -1;
+      hits[mask_index].dist = ray_lengths[i];
+    }
+  });
+
+  BLI_bvhtree_ray_cast_batch(tree_data.tree,
+                             reinterpret_cast<const float(*)[3]>(origins.data()),
+                             reinterpret_cast<const float(*)[3]>(directions.data()),
+                             rays_num,
                              0.0f,
-                             &hit,
+                             hits.data(),
                              tree_data.raycast_callback,
-                             &tree_data) != -1) {
+                             &tree_data,
+                             BVH_RAYCAST_DEFAULT);
+
+  for (const int64_t mask_index : IndexRange(rays_num)) {
+    const int i = mask[mask_index];
+    const BVHTreeRayHit &hit = hits[mask_index];
+    if (hit.index != -1) {
       hit_count++;
       if (!r_hit.is_empty()) {
         r_hit[i] = hit.index >= 0;
@@ -196,7 +215,7 @@ static void raycast_to_mesh(IndexMask mask,
         r_hit_normals[i] = float3(0.0f, 0.0f, 0.0f);
       }
       if (!r_hit_distances.is_empty()) {
-        r_hit_distances[i] = ray_length;
+        r_hit_distances[i] = ray_lengths[i];
       }
     }
   }
@@ -184,7 +184,7 @@ static void scale_vertex_islands_uniformly(Mesh &mesh,
   });
 
   /* Positions have changed, so the normals will have to be recomputed. */
-  BKE_mesh_normals_tag_dirty(&mesh);
+  BKE_mesh_tag_coords_changed(&mesh);
 }
 
 static void scale_vertex_islands_on_axis(Mesh &mesh,
@@ -229,7 +229,7 @@ static void scale_vertex_islands_on_axis(Mesh &mesh,
   });
 
   /* Positions have changed, so the normals will have to be recomputed. */
-  BKE_mesh_normals_tag_dirty(&mesh);
+  BKE_mesh_tag_coords_changed(&mesh);
 }
 
 static Vector<ElementIsland> prepare_face_islands(const Mesh &mesh, const IndexMask face_selection)
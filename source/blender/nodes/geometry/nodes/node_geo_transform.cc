@@ -37,13 +37,14 @@ static void translate_mesh(Mesh &mesh, const float3 translation)
 {
   if (!math::is_zero(translation)) {
     BKE_mesh_translate(&mesh, translation, false);
+    BKE_mesh_tag_coords_changed_uniformly(&mesh);
   }
 }
 
 static void transform_mesh(Mesh &mesh, const float4x4 &transform)
 {
   BKE_mesh_transform(&mesh, transform.values, false);
-  BKE_mesh_normals_tag_dirty(&mesh);
+  BKE_mesh_tag_coords_changed(&mesh);
 }
 
 static void translate_pointcloud(PointCloud &pointcloud, const float3 translation)
@@ -62,6 +62,12 @@ ModifierLog::ModifierLog(GeoLogger &logger)
       NodeLog &node_log = this->lookup_or_add_node_log(log_by_tree_context, debug_message.node);
       node_log.debug_messages_.append(debug_message.message);
     }
+
+    for (NodeWithFieldInputTime &field_input_time : local_logger.node_field_input_times_) {
+      NodeLog &node_log = this->lookup_or_add_node_log(log_by_tree_context,
+                                                       field_input_time.node);
+      node_log.field_input_times_.append(std::move(field_input_time.time));
+    }
   }
 }
 
@@ -486,6 +492,13 @@ void LocalGeoLogger::log_execution_time(DNode node, std::chrono::microseconds ex
   node_exec_times_.append({node, exec_time});
 }
 
+void LocalGeoLogger::log_field_input_time(DNode node,
+                                          std::string name,
+                                          std::chrono::microseconds exec_time)
+{
+  node_field_input_times_.append({node, {std::move(name), exec_time}});
+}
+
 void LocalGeoLogger::log_debug_message(DNode node, std::string message)
 {
   node_debug_messages_.append({node, std::move(message)});
@@ -917,3 +917,10 @@ bool seq_cache_is_full(void)
 {
   return seq_cache_get_mem_total() < MEM_get_memory_in_use();
 }
+
+size_t seq_cache_get_mem_available(void)
+{
+  const size_t mem_total = seq_cache_get_mem_total();
+  const size_t mem_in_use = MEM_get_memory_in_use();
+  return (mem_in_use < mem_total) ? mem_total - mem_in_use : 0;
+}
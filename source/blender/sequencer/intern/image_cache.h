@@ -69,6 +69,10 @@ void seq_cache_cleanup_sequence(struct Scene *scene,
                                 bool force_seq_changed_range);
 void seq_cache_thumbnail_cleanup(Scene *scene, rctf *view_area);
 bool seq_cache_is_full(void);
+/**
+ * Memory which can still be allocated before the cache is full and items have to be recycled.
+ */
+size_t seq_cache_get_mem_available(void);
 float seq_cache_frame_index_to_timeline_frame(struct Sequence *seq, float frame_index);
 
 #ifdef __cplusplus
@@ -22,6 +22,7 @@
 #include "BLI_listbase.h"
 #include "BLI_path_util.h"
 #include "BLI_rect.h"
+#include "BLI_task.h"
 
 #include "BKE_anim_data.h"
 #include "BKE_animsys.h"
@@ -1777,6 +1778,203 @@ static int seq_get_early_out_for_blend_mode(Sequence *seq)
   return early_out;
 }
 
+/**
+ * Strips which only read their own media can be rendered at the same time as other strips of the
+ * stack. Modifiers which use a mask strip render that strip as well. Effect strips can be rendered
+ * at the same time when all of their inputs can be, they render their inputs themselves.
+ *
+ * The strips which are read are added to \a r_strips. A strip must not be rendered by multiple
+ * threads at the same time, e.g. because its movie is opened on first use.
+ */
+static bool seq_render_strip_can_use_threads(Sequence *seq, Sequence **r_strips, int *r_strips_num)
+{
+  LISTBASE_FOREACH (SequenceModifierData *, smd, &seq->modifiers) {
+    if (smd->mask_sequence != NULL) {
+      return false;
+    }
+  }
+  if (*r_strips_num == MAXSEQ) {
+    return false;
+  }
+  r_strips[(*r_strips_num)++] = seq;
+
+  if (ELEM(seq->type, SEQ_TYPE_IMAGE, SEQ_TYPE_MOVIE)) {
+    return true;
+  }
+  /* Multi-camera and adjustment strips render other channels. Speed strips build their frame map
+   * and text strips use the shared state of their font while rendering. */
+  if (!(seq->type & SEQ_TYPE_EFFECT) ||
+      ELEM(seq->type, SEQ_TYPE_MULTICAM, SEQ_TYPE_ADJUSTMENT, SEQ_TYPE_SPEED, SEQ_TYPE_TEXT)) {
+    return false;
+  }
+  /* Loading the effect modifies the strip, do it before the threads start. */
+  SEQ_effect_handle_get(seq);
+
+  Sequence *inputs[3] = {seq->seq1, seq->seq2, seq->seq3};
+  for (int i = 0; i < 3; i++) {
+    if (inputs[i] != NULL &&
+        !seq_render_strip_can_use_threads(inputs[i], r_strips, r_strips_num)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool seq_render_strips_contain(Sequence **strips, const int strips_num, Sequence *seq)
+{
+  for (int i = 0; i < strips_num; i++) {
+    if (strips[i] == seq) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Number of strips which can be rendered at the same time without exceeding the cache memory
+ * limit. Every strip holds at least its raw and its preprocessed image until the stack is
+ * composited, assume float images of the render size for both. The inputs of effect strips are
+ * counted as well. */
+static int seq_render_strip_stack_max_threaded_strips(const SeqRenderData *context)
+{
+  const size_t ibuf_size = (size_t)context->rectx * (size_t)context->recty * 4 * sizeof(float);
+  const size_t strip_size = max_zz(2 * ibuf_size, 1);
+  return (int)min_zz(seq_cache_get_mem_available() / strip_size, MAXSEQ);
+}
+
+typedef struct RenderStripStackInputsData {
+  const SeqRenderData *context;
+  SeqRenderState *state;
+  Sequence **seq_arr;
+  const int *input_indices;
+  float timeline_frame;
+  ImBuf **r_ibufs;
+} RenderStripStackInputsData;
+
+static void render_strip_stack_input_fn(void *__restrict userdata,
+                                        const int iter,
+                                        const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  RenderStripStackInputsData *data = (RenderStripStackInputsData *)userdata;
+  const int index = data->input_indices[iter];
+  data->r_ibufs[index] = seq_render_strip(
+      data->context, data->state, data->seq_arr[index], data->timeline_frame);
+}
+
+/**
+ * Render strips which #seq_render_strip_stack is going to use in parallel, before the stack is
+ * composited. The images are stored in \a r_ibufs at the index of their strip, strips which are
+ * not rendered here are rendered when compositing.
+ *
+ * This follows the same order and early outs as #seq_render_strip_stack, but stops at the first
+ * strip which may hide the strips below it. That includes alpha over strips with full opacity:
+ * whether they hide the strips below is only known once their image is rendered, so strips
+ * below them are not rendered here even when they turn out to be needed. This renders fewer
+ * strips ahead than possible by design, it never renders a strip which isn't used.
+ */
+static void seq_render_strip_stack_inputs_threaded(const SeqRenderData *context,
+                                                   SeqRenderState *state,
+                                                   Sequence **seq_arr,
+                                                   const int count,
+                                                   const float timeline_frame,
+                                                   ImBuf **r_ibufs)
+{
+  const int max_strips = seq_render_strip_stack_max_threaded_strips(context);
+  int input_indices[MAXSEQ + 1];
+  int inputs_num = 0;
+  /* All strips which are read by the inputs rendered in parallel, including inputs of effects. */
+  Sequence *used_strips[MAXSEQ];
+  int used_strips_num = 0;
+
+  for (int i = count - 1; i >= 0; i--) {
+    Sequence *seq = seq_arr[i];
+
+    ImBuf *composite = seq_cache_get(context, seq, timeline_frame, SEQ_CACHE_STORE_COMPOSITE);
+    if (composite) {
+      IMB_freeImBuf(composite);
+      break;
+    }
+
+    bool is_rendered = false;
+    bool is_last = false;
+    /* Alpha over with full opacity hides the strips below if the image has no alpha, stop
+     * conservatively because that isn't known before rendering. */
+    if (seq->blend_mode == SEQ_BLEND_REPLACE ||
+        (seq->blend_mode == SEQ_TYPE_ALPHAOVER && seq->blend_opacity == 100.0f)) {
+      is_rendered = true;
+      is_last = true;
+    }
+    else {
+      switch (seq_get_early_out_for_blend_mode(seq)) {
+        case EARLY_NO_INPUT:
+        case EARLY_USE_INPUT_2:
+          is_rendered = true;
+          is_last = true;
+          break;
+        case EARLY_DO_EFFECT:
+          is_rendered = true;
+          break;
+        case EARLY_USE_INPUT_1:
+          break;
+      }
+    }
+
+    if (is_rendered) {
+      Sequence *strips[MAXSEQ];
+      int strips_num = 0;
+      if (seq_render_strip_can_use_threads(seq, strips, &strips_num) &&
+          used_strips_num + strips_num <= min_ii(max_strips, MAXSEQ)) {
+        bool is_used = false;
+        for (int j = 0; j < strips_num; j++) {
+          is_used |= seq_render_strips_contain(used_strips, used_strips_num, strips[j]);
+        }
+        /* Strips which are read by a strip rendered in parallel already are rendered when
+         * compositing instead. */
+        if (!is_used) {
+          memcpy(&used_strips[used_strips_num], strips, sizeof(*strips) * strips_num);
+          used_strips_num += strips_num;
+          input_indices[inputs_num++] = i;
+        }
+      }
+    }
+    if (is_last) {
+      break;
+    }
+  }
+
+  /* A single strip is rendered when compositing, it can use threads for its effects. */
+  if (inputs_num < 2) {
+    return;
+  }
+
+  RenderStripStackInputsData data = {
+      .context = context,
+      .state = state,
+      .seq_arr = seq_arr,
+      .input_indices = input_indices,
+      .timeline_frame = timeline_frame,
+      .r_ibufs = r_ibufs,
+  };
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, inputs_num, &data, render_strip_stack_input_fn, &settings);
+}
+
+/* Use the image rendered by #seq_render_strip_stack_inputs_threaded, or render the strip. */
+static ImBuf *seq_render_strip_stack_input(const SeqRenderData *context,
+                                           SeqRenderState *state,
+                                           Sequence *seq,
+                                           float timeline_frame,
+                                           ImBuf **prerendered_ibuf)
+{
+  if (*prerendered_ibuf != NULL) {
+    ImBuf *ibuf = *prerendered_ibuf;
+    *prerendered_ibuf = NULL;
+    return ibuf;
+  }
+  return seq_render_strip(context, state, seq, timeline_frame);
+}
+
 static ImBuf *seq_render_strip_stack_apply_effect(
     const SeqRenderData *context, Sequence *seq, float timeline_frame, ImBuf *ibuf1, ImBuf *ibuf2)
 {
@@ -1824,6 +2022,10 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
     return NULL;
   }
 
+  ImBuf *prerendered_ibufs[MAXSEQ + 1] = {NULL};
+  seq_render_strip_stack_inputs_threaded(
+      context, state, seq_arr, count, timeline_frame, prerendered_ibufs);
+
   for (i = count - 1; i >= 0; i--) {
     int early_out;
     Sequence *seq = seq_arr[i];
@@ -1834,7 +2036,8 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
       break;
     }
     if (seq->blend_mode == SEQ_BLEND_REPLACE) {
-      out = seq_render_strip(context, state, seq, timeline_frame);
+      out = seq_render_strip_stack_input(
+          context, state, seq, timeline_frame, &prerendered_ibufs[i]);
       break;
     }
 
@@ -1843,21 +2046,23 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
     /* Early out for alpha over. It requires image to be rendered, so it can't use
      * `seq_get_early_out_for_blend_mode`. */
     if (out == NULL && seq->blend_mode == SEQ_TYPE_ALPHAOVER && seq->blend_opacity == 100.0f) {
-      ImBuf *test = seq_render_strip(context, state, seq, timeline_frame);
+      ImBuf *test = seq_render_strip_stack_input(
+          context, state, seq, timeline_frame, &prerendered_ibufs[i]);
       if (ELEM(test->planes, R_IMF_PLANES_BW, R_IMF_PLANES_RGB)) {
         early_out = EARLY_USE_INPUT_2;
       }
       else {
         early_out = EARLY_DO_EFFECT;
       }
-      /* Free the image. It is stored in cache, so this doesn't affect performance. */
-      IMB_freeImBuf(test);
+      /* Keep the image for compositing, it is not necessarily stored in cache. */
+      prerendered_ibufs[i] = test;
     }
 
     switch (early_out) {
       case EARLY_NO_INPUT:
       case EARLY_USE_INPUT_2:
-        out = seq_render_strip(context, state, seq, timeline_frame);
+        out = seq_render_strip_stack_input(
+            context, state, seq, timeline_frame, &prerendered_ibufs[i]);
         break;
       case EARLY_USE_INPUT_1:
         if (i == 0) {
@@ -1867,7 +2072,8 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
       case EARLY_DO_EFFECT:
         if (i == 0) {
           ImBuf *ibuf1 = IMB_allocImBuf(context->rectx, context->recty, 32, IB_rect);
-          ImBuf *ibuf2 = seq_render_strip(context, state, seq, timeline_frame);
+          ImBuf *ibuf2 = seq_render_strip_stack_input(
+              context, state, seq, timeline_frame, &prerendered_ibufs[i]);
 
           out = seq_render_strip_stack_apply_effect(context, seq, timeline_frame, ibuf1, ibuf2);
 
@@ -1890,7 +2096,8 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
 
     if (seq_get_early_out_for_blend_mode(seq) == EARLY_DO_EFFECT) {
       ImBuf *ibuf1 = out;
-      ImBuf *ibuf2 = seq_render_strip(context, state, seq, timeline_frame);
+      ImBuf *ibuf2 = seq_render_strip_stack_input(
+          context, state, seq, timeline_frame, &prerendered_ibufs[i]);
 
       out = seq_render_strip_stack_apply_effect(context, seq, timeline_frame, ibuf1, ibuf2);
 
@@ -1901,6 +2108,13 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
     seq_cache_put(context, seq_arr[i], timeline_frame, SEQ_CACHE_STORE_COMPOSITE, out);
   }
 
+  /* Free images which were rendered ahead of compositing but ended up not being used. */
+  for (i = 0; i < count; i++) {
+    if (prerendered_ibufs[i] != NULL) {
+      IMB_freeImBuf(prerendered_ibufs[i]);
+    }
+  }
+
   return out;
 }
 
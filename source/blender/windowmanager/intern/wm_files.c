@@ -1838,6 +1838,7 @@ static bool wm_file_write(bContext *C,
     }
 
     SET_FLAG_FROM_TEST(G.fileflags, fileflags & G_FILE_COMPRESS, G_FILE_COMPRESS);
+    SET_FLAG_FROM_TEST(G.fileflags, fileflags & G_FILE_BLOCK_INDEX, G_FILE_BLOCK_INDEX);
 
     /* prevent background mode scripts from clobbering history */
     if (do_history_file_update) {
@@ -3020,6 +3021,16 @@ static void save_set_compress(wmOperator *op)
   }
 }
 
+static void save_set_block_index(wmOperator *op)
+{
+  PropertyRNA *prop = RNA_struct_find_property(op->ptr, "block_index");
+  if (!RNA_property_is_set(op->ptr, prop)) {
+    /* Keep the option of the last save in this session. The flag isn't stored in the file, so
+     * it's off for files that were just opened. */
+    RNA_property_boolean_set(op->ptr, prop, (G.fileflags & G_FILE_BLOCK_INDEX) != 0);
+  }
+}
+
 static void save_set_filepath(bContext *C, wmOperator *op)
 {
   Main *bmain = CTX_data_main(C);
@@ -3047,6 +3058,7 @@ static int wm_save_as_mainfile_invoke(bContext *C, wmOperator *op, const wmEvent
 {
 
   save_set_compress(op);
+  save_set_block_index(op);
   save_set_filepath(C, op);
 
   WM_event_add_fileselect(C, op);
@@ -3070,6 +3082,7 @@ static int wm_save_as_mainfile_exec(bContext *C, wmOperator *op)
                                              BLO_WRITE_PATH_REMAP_RELATIVE :
                                              BLO_WRITE_PATH_REMAP_NONE;
   save_set_compress(op);
+  save_set_block_index(op);
 
   const bool is_filepath_set = RNA_struct_property_is_set(op->ptr, "filepath");
   if (is_filepath_set) {
@@ -3104,6 +3117,7 @@ static int wm_save_as_mainfile_exec(bContext *C, wmOperator *op)
 
   /* set compression flag */
   SET_FLAG_FROM_TEST(fileflags, RNA_boolean_get(op->ptr, "compress"), G_FILE_COMPRESS);
+  SET_FLAG_FROM_TEST(fileflags, RNA_boolean_get(op->ptr, "block_index"), G_FILE_BLOCK_INDEX);
 
   const bool ok = wm_file_write(C, path, fileflags, remap_mode, use_save_as_copy, op->reports);
 
@@ -3184,6 +3198,11 @@ void WM_OT_save_as_mainfile(wmOperatorType *ot)
                                  FILE_DEFAULTDISPLAY,
                                  FILE_SORT_DEFAULT);
   RNA_def_boolean(ot->srna, "compress", false, "Compress", "Write compressed .blend file");
+  RNA_def_boolean(ot->srna,
+                  "block_index",
+                  false,
+                  "Block Index",
+                  "Write an index of the file's blocks, to link and append from it faster");
   RNA_def_boolean(ot->srna,
                   "relative_remap",
                   true,
@@ -3208,6 +3227,7 @@ static int wm_save_mainfile_invoke(bContext *C, wmOperator *op, const wmEvent *U
   }
 
   save_set_compress(op);
+  save_set_block_index(op);
   save_set_filepath(C, op);
 
   /* if we're saving for the first time and prefer relative paths -
@@ -3255,6 +3275,11 @@ void WM_OT_save_mainfile(wmOperatorType *ot)
                                  FILE_DEFAULTDISPLAY,
                                  FILE_SORT_DEFAULT);
   RNA_def_boolean(ot->srna, "compress", false, "Compress", "Write compressed .blend file");
+  RNA_def_boolean(ot->srna,
+                  "block_index",
+                  false,
+                  "Block Index",
+                  "Write an index of the file's blocks, to link and append from it faster");
   RNA_def_boolean(ot->srna,
                   "relative_remap",
                   false,
@@ -575,6 +575,7 @@ static int arg_handle_print_help(int UNUSED(argc), const char **UNUSED(argv), vo
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-time");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-pretty");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-uuid");
+  BLI_args_print_arg_doc(ba, "--debug-depsgraph-profile");
   BLI_args_print_arg_doc(ba, "--debug-ghost");
   BLI_args_print_arg_doc(ba, "--debug-gpu");
   BLI_args_print_arg_doc(ba, "--debug-gpu-force-workarounds");
@@ -992,6 +993,23 @@ static int arg_handle_debug_mode_generic_set(int UNUSED(argc),
   return 0;
 }
 
+static const char arg_handle_debug_depsgraph_profile_set_doc[] =
+    "<filepath>\n"
+    "\tRecord the evaluation time of all depsgraph operations per thread and write it to the\n"
+    "\tfile on exit, in the Chrome trace event format (see 'chrome://tracing' or Perfetto).";
+static int arg_handle_debug_depsgraph_profile_set(int argc,
+                                                  const char **argv,
+                                                  void *UNUSED(data))
+{
+  const char *arg_id = "--debug-depsgraph-profile";
+  if (argc > 1) {
+    DEG_debug_profile_begin(argv[1]);
+    return 1;
+  }
+  printf("\nError: '%s' no args given.\n", arg_id);
+  return 0;
+}
+
 static const char arg_handle_debug_mode_io_doc[] =
     "\n\t"
     "Enable debug messages for I/O (Collada, ...).";
@@ -2195,6 +2213,11 @@ void main_args_setup(bContext *C, bArgs *ba)
                "--debug-depsgraph-uuid",
                CB_EX(arg_handle_debug_mode_generic_set, depsgraph_uuid),
                (void *)G_DEBUG_DEPSGRAPH_UUID);
+  BLI_args_add(ba,
+               NULL,
+               "--debug-depsgraph-profile",
+               CB(arg_handle_debug_depsgraph_profile_set),
+               NULL);
   BLI_args_add(ba,
                NULL,
                "--debug-gpu-force-workarounds",
@@ -0,0 +1,57 @@
+# SPDX-License-Identifier: Apache-2.0
+
+import api
+import glob
+import pathlib
+
+
+def _run(args):
+    import bpy
+    import time
+
+    filepath = args['filepath']
+    importer = args['importer']
+
+    if importer == 'python':
+        import addon_utils
+        addon_utils.enable("io_scene_obj", default_set=True)
+        import_op = bpy.ops.import_scene.obj
+    else:
+        import_op = bpy.ops.wm.obj_import
+
+    # Import once to ensure the file is cached by OS.
+    import_op(filepath=filepath)
+    bpy.ops.wm.read_homefile(use_empty=True)
+
+    start_time = time.time()
+    import_op(filepath=filepath)
+    elapsed_time = time.time() - start_time
+
+    result = {'time': elapsed_time}
+    return result
+
+
+class OBJImportTest(api.Test):
+    def __init__(self, filepath, importer):
+        self.filepath = filepath
+        self.importer = importer
+
+    def name(self):
+        return f"{self.filepath.stem}_{self.importer}"
+
+    def category(self):
+        return "io_obj"
+
+    def run(self, env, device_id):
+        args = {'filepath': str(self.filepath), 'importer': self.importer}
+        result, _ = env.run_in_blender(_run, args, ['--factory-startup'])
+        return result
+
+
+def generate(env):
+    # Compare the C++ importer to the legacy Python add-on on the same files.
+    dirpath = env.benchmarks_dir / 'io_obj'
+    filepaths = [pathlib.Path(filename) for filename in glob.iglob(str(dirpath / '*.obj'))]
+    return [OBJImportTest(filepath, importer)
+            for filepath in filepaths
+            for importer in ('cpp', 'python')]